@@ -19,6 +19,7 @@ include $(CLEAR_VARS)
 include $(CLEAR_VARS)
 minikin_src_files := \
     CmapCoverage.cpp \
+    CoverageCache.cpp \
     Emoji.cpp \
     FontCollection.cpp \
     FontFamily.cpp \
@@ -29,11 +30,14 @@ minikin_src_files := \
     HbFontCache.cpp \
     Hyphenator.cpp \
     Layout.cpp \
+    LayoutCache.cpp \
     LayoutUtils.cpp \
     LineBreaker.cpp \
     Measurement.cpp \
     MinikinInternal.cpp \
     MinikinFont.cpp \
+    PersistentFile.cpp \
+    ShapingCache.cpp \
     SparseBitSet.cpp \
     WordBreaker.cpp
 
@@ -50,18 +54,11 @@ minikin_shared_libraries := \
     libicuuc \
     libutils
 
-ifneq (,$(filter userdebug eng, $(TARGET_BUILD_VARIANT)))
-# Enable race detection on eng and userdebug build.
-enable_race_detection := -DENABLE_RACE_DETECTION
-else
-enable_race_detection :=
-endif
-
 LOCAL_MODULE := libminikin
 LOCAL_EXPORT_C_INCLUDE_DIRS := frameworks/minikin/include
 LOCAL_SRC_FILES := $(minikin_src_files)
 LOCAL_C_INCLUDES := $(minikin_c_includes)
-LOCAL_CPPFLAGS += -Werror -Wall -Wextra $(enable_race_detection)
+LOCAL_CPPFLAGS += -Werror -Wall -Wextra
 LOCAL_SHARED_LIBRARIES := $(minikin_shared_libraries)
 LOCAL_CLANG := true
 LOCAL_SANITIZE := signed-integer-overflow
@@ -77,7 +74,7 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_EXPORT_C_INCLUDE_DIRS := frameworks/minikin/include
 LOCAL_SRC_FILES := $(minikin_src_files)
 LOCAL_C_INCLUDES := $(minikin_c_includes)
-LOCAL_CPPFLAGS += -Werror -Wall -Wextra $(enable_race_detection)
+LOCAL_CPPFLAGS += -Werror -Wall -Wextra
 LOCAL_SHARED_LIBRARIES := $(minikin_shared_libraries)
 LOCAL_CLANG := true
 LOCAL_SANITIZE := signed-integer-overflow
@@ -94,7 +91,7 @@ LOCAL_MODULE := libminikin_host
 LOCAL_MODULE_TAGS := optional
 LOCAL_EXPORT_C_INCLUDE_DIRS := frameworks/minikin/include
 LOCAL_C_INCLUDES := $(minikin_c_includes)
-LOCAL_CPPFLAGS += -Werror -Wall -Wextra $(enable_race_detection)
+LOCAL_CPPFLAGS += -Werror -Wall -Wextra
 LOCAL_SHARED_LIBRARIES := liblog libicuuc
 
 LOCAL_SRC_FILES := Hyphenator.cpp
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Minikin"
+
+#include "CoverageCache.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "MinikinInternal.h"
+
+namespace minikin {
+
+static const uint32_t kMagic = 0x56434b4d;  // "MKCV"
+// Must be bumped when the format, or the way coverage is computed, changes
+static const uint32_t kVersion = 2;
+
+// Bounds of the file. Fonts loaded since the file was mapped are kept first.
+static const size_t kMaxEntries = 1024;
+static const size_t kMaxFileSize = 16 * 1024 * 1024;
+
+// Fonts loaded before the next write
+static const size_t kMaxPending = 256;
+
+// The set index of the coverage of the base characters, rather than of a variation selector
+static const uint32_t kBaseSet = 0xFFFFFFFF;
+
+/*
+ * The file is a header, entries sorted by fingerprint pointing at the records, and the records.
+ * A record is the number of sets, then a SetHeader and a serialized SparseBitSet for each.
+ * Everything is 4-byte aligned, so that the sets are read in place from the mapping, and is in
+ * the byte order of the device. Each entry has a checksum of its record, since a damaged set
+ * would silently change which font characters fall back to.
+ */
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+
+struct Entry {
+    uint64_t fingerprint;
+    uint32_t offset;
+    uint32_t size;
+    uint64_t checksum;
+};
+
+struct SetHeader {
+    uint32_t index;  // variation selector index, or kBaseSet
+    uint32_t size;
+};
+
+struct CoverageCache::MappedFile : public PersistentFile::Mapping {
+    Entry entryAt(size_t index) const {
+        Entry entry;
+        memcpy(&entry, data + sizeof(FileHeader) + index * sizeof(Entry), sizeof(entry));
+        return entry;
+    }
+
+    bool isValid(const Entry& entry) const {
+        return entry.offset >= recordsOffset && entry.offset % 4 == 0
+                && entry.size >= sizeof(uint32_t) && uint64_t(entry.offset) + entry.size <= size
+                && hashBytes(FNV_HASH_SEED, data + entry.offset, entry.size) == entry.checksum;
+    }
+
+    uint32_t entryCount;
+    size_t recordsOffset;
+};
+
+std::unique_ptr<PersistentFile::Mapping> CoverageCache::openMapping(const uint8_t* data,
+        size_t size) {
+    FileHeader header;
+    if (size < sizeof(header)) {
+        return nullptr;
+    }
+    memcpy(&header, data, sizeof(header));
+    const uint64_t recordsOffset = sizeof(FileHeader)
+            + uint64_t(header.entryCount) * sizeof(Entry);
+    if (header.magic != kMagic || header.version != kVersion || header.fileSize != size
+            || recordsOffset > size) {
+        return nullptr;
+    }
+
+    MappedFile* file = new MappedFile();
+    file->entryCount = header.entryCount;
+    file->recordsOffset = recordsOffset;
+    return std::unique_ptr<Mapping>(file);
+}
+
+CoverageCache& CoverageCache::getInstance() {
+    static CoverageCache* sInstance = new CoverageCache();
+    return *sInstance;
+}
+
+void CoverageCache::clearPending() {
+    mPending.clear();
+}
+
+bool CoverageCache::hasPending() {
+    return !mPending.empty();
+}
+
+uint64_t CoverageCache::getFingerprint(const MinikinFont* font) const {
+    if (!isEnabled()) {
+        return 0;
+    }
+    // The font revision, checksum of the whole file, and creation and modification dates.
+    // Variations don't change the cmap table, so instances share the coverage of their font.
+    HbBlob head(getFontTable(font, MinikinFont::MakeTag('h', 'e', 'a', 'd')));
+    if (head.get() == nullptr || head.size() < 36) {
+        return 0;
+    }
+    const uint64_t fontSize = font->GetFontSize();
+    const int32_t fontIndex = font->GetFontIndex();
+    uint64_t hash = hashBytes(FNV_HASH_SEED, &fontSize, sizeof(fontSize));
+    hash = hashBytes(hash, &fontIndex, sizeof(fontIndex));
+    hash = hashBytes(hash, head.get() + 4, 32);
+    // 0 means no fingerprint
+    return hash != 0 ? hash : 1;
+}
+
+bool CoverageCache::find(uint64_t fingerprint, SparseBitSet* coverage,
+        std::vector<std::unique_ptr<SparseBitSet>>* vsCoverage) {
+    if (fingerprint == 0 || !isEnabled()) {
+        return false;
+    }
+    std::shared_ptr<MappedFile> file = std::static_pointer_cast<MappedFile>(getMapping());
+    if (file == nullptr) {
+        return false;
+    }
+    size_t low = 0;
+    size_t high = file->entryCount;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if (file->entryAt(middle).fingerprint < fingerprint) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == file->entryCount) {
+        return false;
+    }
+    const Entry entry = file->entryAt(low);
+    if (entry.fingerprint != fingerprint || !file->isValid(entry)) {
+        return false;
+    }
+
+    const uint8_t* record = file->data + entry.offset;
+    const uint8_t* end = record + entry.size;
+    uint32_t setCount;
+    memcpy(&setCount, record, sizeof(setCount));
+    const uint8_t* p = record + sizeof(setCount);
+    SparseBitSet base;
+    bool hasBase = false;
+    std::vector<std::unique_ptr<SparseBitSet>> sets;
+    for (uint32_t i = 0; i < setCount; i++) {
+        SetHeader header;
+        if (size_t(end - p) < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, p, sizeof(header));
+        p += sizeof(header);
+        if (size_t(end - p) < header.size || (header.index != kBaseSet && header.index > 0xFF)) {
+            return false;
+        }
+        std::unique_ptr<SparseBitSet> set(new SparseBitSet());
+        if (!set->initFromBuffer(file, p, header.size)) {
+            return false;
+        }
+        p += header.size;
+        if (header.index == kBaseSet) {
+            base = std::move(*set);
+            hasBase = true;
+        } else {
+            if (sets.size() < header.index + 1) {
+                sets.resize(header.index + 1);
+            }
+            sets[header.index] = std::move(set);
+        }
+    }
+    if (!hasBase) {
+        return false;
+    }
+    *coverage = std::move(base);
+    *vsCoverage = std::move(sets);
+    mHits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void CoverageCache::add(uint64_t fingerprint, const SparseBitSet& coverage,
+        const std::vector<std::unique_ptr<SparseBitSet>>& vsCoverage) {
+    if (fingerprint == 0 || !isEnabled()) {
+        return;
+    }
+    std::vector<std::pair<uint32_t, const SparseBitSet*>> sets;
+    sets.emplace_back(kBaseSet, &coverage);
+    for (size_t i = 0; i < vsCoverage.size(); i++) {
+        if (vsCoverage[i]) {
+            sets.emplace_back(i, vsCoverage[i].get());
+        }
+    }
+    size_t size = sizeof(uint32_t);
+    for (const auto& set : sets) {
+        size += sizeof(SetHeader) + set.second->serializedSize();
+    }
+    std::vector<uint8_t> data(size);
+    uint8_t* p = data.data();
+    const uint32_t setCount = sets.size();
+    memcpy(p, &setCount, sizeof(setCount));
+    p += sizeof(setCount);
+    for (const auto& set : sets) {
+        const SetHeader header = { set.first, uint32_t(set.second->serializedSize()) };
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        set.second->serialize(p);
+        p += header.size;
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mPending.size() >= kMaxPending) {
+        return;
+    }
+    mPending[fingerprint] = std::move(data);
+    scheduleWrite();
+}
+
+bool CoverageCache::buildFile(const std::shared_ptr<Mapping>& current,
+        std::vector<uint8_t>* contents) {
+    std::shared_ptr<MappedFile> file = std::static_pointer_cast<MappedFile>(current);
+    std::unordered_map<uint64_t, std::vector<uint8_t>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        pending.swap(mPending);
+    }
+    if (pending.empty()) {
+        return false;
+    }
+
+    // New fonts first, then the rest of the file
+    struct Record {
+        uint64_t fingerprint;
+        const uint8_t* data;
+        uint32_t size;
+        uint64_t checksum;
+    };
+    std::vector<Record> records;
+    size_t dataSize = 0;
+    auto addRecord = [&](uint64_t fingerprint, const uint8_t* data, size_t size,
+            uint64_t checksum) {
+        if (records.size() < kMaxEntries && dataSize + size <= kMaxFileSize) {
+            records.push_back({ fingerprint, data, uint32_t(size), checksum });
+            dataSize += size;
+        }
+    };
+    for (const auto& record : pending) {
+        addRecord(record.first, record.second.data(), record.second.size(),
+                hashBytes(FNV_HASH_SEED, record.second.data(), record.second.size()));
+    }
+    if (file != nullptr) {
+        for (uint32_t i = 0; i < file->entryCount; i++) {
+            const Entry entry = file->entryAt(i);
+            if (pending.find(entry.fingerprint) == pending.end() && file->isValid(entry)) {
+                addRecord(entry.fingerprint, file->data + entry.offset, entry.size,
+                        entry.checksum);
+            }
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        return a.fingerprint < b.fingerprint;
+    });
+
+    std::vector<Entry> entries;
+    size_t offset = sizeof(FileHeader) + records.size() * sizeof(Entry);
+    for (const Record& record : records) {
+        entries.push_back({ record.fingerprint, uint32_t(offset), record.size, record.checksum });
+        offset += record.size;
+    }
+    const FileHeader header = { kMagic, kVersion, uint32_t(records.size()), 0, offset };
+
+    contents->resize(offset);
+    uint8_t* p = contents->data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, entries.data(), entries.size() * sizeof(Entry));
+    p += entries.size() * sizeof(Entry);
+    for (const Record& record : records) {
+        memcpy(p, record.data, record.size);
+        p += record.size;
+    }
+    return true;
+}
+
+}  // namespace minikin
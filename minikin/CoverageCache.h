@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MINIKIN_COVERAGE_CACHE_H
+#define MINIKIN_COVERAGE_CACHE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <minikin/SparseBitSet.h>
+#include "PersistentFile.h"
+
+namespace minikin {
+
+class MinikinFont;
+
+/*
+ * The coverage of fonts, serialized in a file that later processes map, so that loading a font
+ * reads its coverage in place rather than building it from the cmap table again. Fonts missing
+ * from the file are added to it as described in PersistentFile.
+ *
+ * Fonts are identified by their size, index and 'head' table checksum and dates, so a font
+ * that changed is parsed again and its old coverage ages out of the file.
+ */
+class CoverageCache : public PersistentFile {
+public:
+    static CoverageCache& getInstance();
+
+    // Returns the key of the font in the file, or 0 if it can't be identified or the cache is off
+    uint64_t getFingerprint(const MinikinFont* font) const;
+
+    // Reads the coverage of the font from the file, along with the coverage of its variation
+    // sequences, indexed by variation selector index as CmapCoverage::getCoverage makes them.
+    bool find(uint64_t fingerprint, SparseBitSet* coverage,
+            std::vector<std::unique_ptr<SparseBitSet>>* vsCoverage);
+
+    // Queues the coverage of a font that was just parsed to be written to the file
+    void add(uint64_t fingerprint, const SparseBitSet& coverage,
+            const std::vector<std::unique_ptr<SparseBitSet>>& vsCoverage);
+
+    uint64_t getHitCount() const { return mHits.load(std::memory_order_relaxed); }
+
+private:
+    struct MappedFile;
+
+    CoverageCache() : PersistentFile("coverage cache") {}
+
+    std::unique_ptr<Mapping> openMapping(const uint8_t* data, size_t size) override;
+    void clearPending() override;
+    bool hasPending() override;
+    bool buildFile(const std::shared_ptr<Mapping>& current,
+            std::vector<uint8_t>* contents) override;
+
+    // Guarded by mLock
+    std::unordered_map<uint64_t, std::vector<uint8_t>> mPending;
+
+    std::atomic<uint64_t> mHits{0};
+};
+
+}  // namespace minikin
+
+#endif  // MINIKIN_COVERAGE_CACHE_H
@@ -42,21 +42,25 @@ static inline T max(T a, T b) {
 const uint32_t EMOJI_STYLE_VS = 0xFE0F;
 const uint32_t TEXT_STYLE_VS = 0xFE0E;
 
-uint32_t FontCollection::sNextId = 0;
+std::atomic<uint32_t> FontCollection::sNextId(0);
 
-FontCollection::FontCollection(std::shared_ptr<FontFamily>&& typeface) : mMaxChar(0) {
+FontCollection::FontCollection(std::shared_ptr<FontFamily>&& typeface)
+        : mMaxChar(0), mFamilyMemo(nullptr) {
     std::vector<std::shared_ptr<FontFamily>> typefaces;
     typefaces.push_back(typeface);
     init(typefaces);
 }
 
 FontCollection::FontCollection(const vector<std::shared_ptr<FontFamily>>& typefaces) :
-    mMaxChar(0) {
+    mMaxChar(0), mFamilyMemo(nullptr) {
     init(typefaces);
 }
 
+FontCollection::~FontCollection() {
+    delete[] mFamilyMemo.load(std::memory_order_relaxed);
+}
+
 void FontCollection::init(const vector<std::shared_ptr<FontFamily>>& typefaces) {
-    android::AutoMutex _l(gMinikinLock);
     mId = sNextId++;
     vector<uint32_t> lastChar;
     size_t nTypefaces = typefaces.size();
@@ -114,6 +118,38 @@ void FontCollection::init(const vector<std::shared_ptr<FontFamily>>& typefaces)
     // See the comment in Range for more details.
     LOG_ALWAYS_FATAL_IF(mFamilyVec.size() >= 0xFFFF,
         "Exceeded the maximum indexable cmap coverage.");
+
+    // Without variation selector, the first family wins if it has the character, and a family
+    // that is the only one to have it wins whatever the style. Other characters are memoized
+    // per style on lookup.
+    uint16_t latin1[kLatin1Size];
+    for (uint32_t ch = 0; ch < kLatin1Size; ch++) {
+        latin1[ch] = ch;
+        mLatin1Families[ch] = kNoFamilyIndex;
+    }
+    uint32_t coveringCounts[kLatin1Size] = {};
+    for (size_t first = 0; first < nTypefaces; first += SparseBitSet::kMaxMaskSets) {
+        const size_t count = std::min(nTypefaces - first, SparseBitSet::kMaxMaskSets);
+        const SparseBitSet* coverages[SparseBitSet::kMaxMaskSets];
+        for (size_t j = 0; j < count; j++) {
+            coverages[j] = &mFamilies[first + j]->getCoverage();
+        }
+        uint32_t masks[kLatin1Size];
+        SparseBitSet::getCoverageMasks(coverages, count, latin1, kLatin1Size, masks);
+        for (uint32_t ch = 0; ch < kLatin1Size; ch++) {
+            if (masks[ch] != 0 && coveringCounts[ch] == 0) {
+                mLatin1Families[ch] = first + __builtin_ctz(masks[ch]);
+            }
+            coveringCounts[ch] += __builtin_popcount(masks[ch]);
+        }
+    }
+    for (uint32_t ch = 0; ch < kLatin1Size; ch++) {
+        if (ch >= mMaxChar) {
+            mLatin1Families[ch] = 0;
+        } else if (mLatin1Families[ch] != 0 && coveringCounts[ch] != 1) {
+            mLatin1Families[ch] = kNoFamilyIndex;
+        }
+    }
 }
 
 // Special scores for the font fallback.
@@ -247,11 +283,10 @@ uint32_t FontCollection::calcVariantMatchingScore(int variant, const FontFamily&
 // 1. If first font in the collection has the character, it wins.
 // 2. Calculate a score for the font family. See comments in calcFamilyScore for the detail.
 // 3. Highest score wins, with ties resolved to the first font.
-// This method never returns nullptr.
-const std::shared_ptr<FontFamily>& FontCollection::getFamilyForChar(uint32_t ch, uint32_t vs,
+uint8_t FontCollection::calcFamilyIndexForChar(uint32_t ch, uint32_t vs,
             uint32_t langListId, int variant) const {
     if (ch >= mMaxChar) {
-        return mFamilies[0];
+        return 0;
     }
 
     Range range = mRanges[ch >> kLogCharsPerPage];
@@ -263,20 +298,24 @@ const std::shared_ptr<FontFamily>& FontCollection::getFamilyForChar(uint32_t ch,
 #ifdef VERBOSE_DEBUG
     ALOGD("querying range %zd:%zd\n", range.start, range.end);
 #endif
+    // Coverage is checked one family at a time rather than with SparseBitSet::getCoverageMasks,
+    // as init() does for Latin-1: this only runs when the memo misses, for one character, and
+    // the range already holds just the families that cover its page, so the time goes into
+    // scoring their languages and variants rather than into coverage lookups
     int bestFamilyIndex = -1;
     uint32_t bestScore = kUnsupportedFontScore;
     for (size_t i = range.start; i < range.end; i++) {
-        const std::shared_ptr<FontFamily>& family =
-                vs == 0 ? mFamilies[mFamilyVec[i]] : mFamilies[i];
-        const uint32_t score = calcFamilyScore(ch, vs, variant, langListId, family);
+        const uint8_t familyIndex = vs == 0 ? mFamilyVec[i] : i;
+        const uint32_t score = calcFamilyScore(ch, vs, variant, langListId,
+                mFamilies[familyIndex]);
         if (score == kFirstFontScore) {
             // If the first font family supports the given character or variation sequence, always
             // use it.
-            return family;
+            return familyIndex;
         }
         if (score > bestScore) {
             bestScore = score;
-            bestFamilyIndex = i;
+            bestFamilyIndex = familyIndex;
         }
     }
     if (bestFamilyIndex == -1) {
@@ -288,12 +327,69 @@ const std::shared_ptr<FontFamily>& FontCollection::getFamilyForChar(uint32_t ch,
             if (U_SUCCESS(errorCode) && len > 0) {
                 int off = 0;
                 U16_NEXT_UNSAFE(decomposed, off, ch);
-                return getFamilyForChar(ch, vs, langListId, variant);
+                return getFamilyIndexForChar(ch, vs, langListId, variant);
             }
         }
-        return mFamilies[0];
+        return 0;
     }
-    return vs == 0 ? mFamilies[mFamilyVec[bestFamilyIndex]] : mFamilies[bestFamilyIndex];
+    return bestFamilyIndex;
+}
+
+// Memo entries hold the code point in the low 21 bits, then the variation selector as its index
+// plus one (0 for none) in 9 bits, the variant in 2 bits, the language list id in 16 bits and
+// the family index in 8 bits. The top bit tells a valid entry from an empty one.
+static const int kMemoVsShift = 21;
+static const int kMemoVariantShift = 30;
+static const int kMemoLangShift = 32;
+static const int kMemoFamilyShift = 48;
+static const uint64_t kMemoKeyMask = (1ULL << kMemoFamilyShift) - 1;
+static const uint64_t kMemoValid = 1ULL << 63;
+static const uint32_t kMemoMaxLangListId = 0xFFFF;
+static const int kMemoMaxVariant = 3;
+
+uint8_t FontCollection::getFamilyIndexForChar(uint32_t ch, uint32_t vs,
+            uint32_t langListId, int variant) const {
+    if (vs == 0 && ch < kLatin1Size && mLatin1Families[ch] != kNoFamilyIndex) {
+        return mLatin1Families[ch];
+    }
+    if (ch >= mMaxChar) {
+        return 0;
+    }
+    const uint16_t vsIndex = vs == 0 ? 0 : getVsIndex(vs);
+    if (vsIndex == INVALID_VS_INDEX || langListId > kMemoMaxLangListId ||
+            variant < 0 || variant > kMemoMaxVariant) {
+        return calcFamilyIndexForChar(ch, vs, langListId, variant);
+    }
+    const uint64_t key = kMemoValid | static_cast<uint64_t>(langListId) << kMemoLangShift
+            | static_cast<uint64_t>(variant) << kMemoVariantShift
+            | static_cast<uint64_t>(vs == 0 ? 0 : vsIndex + 1) << kMemoVsShift | ch;
+    // Fibonacci hashing spreads consecutive code points and styles over the whole memo. The
+    // entry may be in either way of its set, which share a cache line.
+    const size_t set = ((key * 0x9E3779B97F4A7C15ULL) >> (64 - kFamilyMemoBits)) & ~1;
+
+    std::atomic<uint64_t>* memo = mFamilyMemo.load(std::memory_order_acquire);
+    if (memo == nullptr) {
+        std::atomic<uint64_t>* newMemo = new std::atomic<uint64_t>[kFamilyMemoSize]();
+        if (mFamilyMemo.compare_exchange_strong(memo, newMemo, std::memory_order_acq_rel)) {
+            memo = newMemo;
+        } else {
+            delete[] newMemo;
+        }
+    }
+    const uint64_t first = memo[set].load(std::memory_order_relaxed);
+    if ((first & (kMemoValid | kMemoKeyMask)) == key) {
+        return static_cast<uint8_t>(first >> kMemoFamilyShift);
+    }
+    const uint64_t second = memo[set + 1].load(std::memory_order_relaxed);
+    if ((second & (kMemoValid | kMemoKeyMask)) == key) {
+        return static_cast<uint8_t>(second >> kMemoFamilyShift);
+    }
+    // The new entry goes first and the previous first one replaces the older second one.
+    const uint8_t familyIndex = calcFamilyIndexForChar(ch, vs, langListId, variant);
+    memo[set + 1].store(first, std::memory_order_relaxed);
+    memo[set].store(key | static_cast<uint64_t>(familyIndex) << kMemoFamilyShift,
+            std::memory_order_relaxed);
+    return familyIndex;
 }
 
 const uint32_t NBSP = 0x00A0;
@@ -336,9 +432,6 @@ bool FontCollection::hasVariationSelector(uint32_t baseCodepoint,
         }
     }
 
-    // TODO: We can remove this lock by precomputing color emoji information.
-    android::AutoMutex _l(gMinikinLock);
-
     // Even if there is no cmap format 14 subtable entry for the given sequence, should return true
     // for <char, text presentation selector> case since we have special fallback rule for the
     // sequence. Note that we don't need to restrict this to already standardized variation
@@ -17,6 +17,7 @@
 #ifndef MINIKIN_FONT_COLLECTION_H
 #define MINIKIN_FONT_COLLECTION_H
 
+#include <atomic>
 #include <memory>
 #include <unordered_set>
 #include <vector>
@@ -30,6 +31,7 @@ class FontCollection {
 public:
     explicit FontCollection(const std::vector<std::shared_ptr<FontFamily>>& typefaces);
     explicit FontCollection(std::shared_ptr<FontFamily>&& typeface);
+    ~FontCollection();
 
     struct Run {
         FakedFont fakedFont;
@@ -59,6 +61,11 @@ public:
 
     uint32_t getId() const;
 
+    size_t getFamilyCount() const { return mFamilies.size(); }
+    const std::shared_ptr<FontFamily>& getFamilyAt(size_t index) const {
+        return mFamilies[index];
+    }
+
 private:
     static const int kLogCharsPerPage = 8;
     static const int kPageMask = (1 << kLogCharsPerPage) - 1;
@@ -73,11 +80,30 @@ private:
         uint16_t end;
     };
 
+    // mFamilyMemo has 4096 entries, 32KB.
+    static const int kFamilyMemoBits = 12;
+    static const size_t kFamilyMemoSize = 1 << kFamilyMemoBits;
+    // Code points below this are looked up in mLatin1Families.
+    static const uint32_t kLatin1Size = 0x100;
+    // Marks entries of mLatin1Families which depend on the style.
+    static const uint8_t kNoFamilyIndex = 0xFF;
+
     // Initialize the FontCollection.
     void init(const std::vector<std::shared_ptr<FontFamily>>& typefaces);
 
     const std::shared_ptr<FontFamily>& getFamilyForChar(uint32_t ch, uint32_t vs,
-            uint32_t langListId, int variant) const;
+            uint32_t langListId, int variant) const {
+        return mFamilies[getFamilyIndexForChar(ch, vs, langListId, variant)];
+    }
+
+    // Returns the index in mFamilies of the family getFamilyForChar returns, from the tables
+    // below if it was already chosen for the same arguments.
+    uint8_t getFamilyIndexForChar(uint32_t ch, uint32_t vs, uint32_t langListId,
+            int variant) const;
+
+    // Chooses the family for getFamilyIndexForChar by scoring all the candidates.
+    uint8_t calcFamilyIndexForChar(uint32_t ch, uint32_t vs, uint32_t langListId,
+            int variant) const;
 
     uint32_t calcFamilyScore(uint32_t ch, uint32_t vs, int variant, uint32_t langListId,
             const std::shared_ptr<FontFamily>& fontFamily) const;
@@ -91,7 +117,7 @@ private:
     static uint32_t calcVariantMatchingScore(int variant, const FontFamily& fontFamily);
 
     // static for allocating unique id's
-    static uint32_t sNextId;
+    static std::atomic<uint32_t> sNextId;
 
     // unique id for this font collection (suitable for cache key)
     uint32_t mId;
@@ -117,6 +143,16 @@ private:
 
     // Set of supported axes in this collection.
     std::unordered_set<AxisTag> mSupportedAxes;
+
+    // The family of each Latin-1 code point without variation selector, computed at init. It
+    // is kNoFamilyIndex when the choice depends on the language or variant of the style.
+    uint8_t mLatin1Families[kLatin1Size];
+
+    // Families chosen by getFamilyIndexForChar for other arguments, direct mapped. Each entry
+    // packs the arguments and the family index in a single word, so threads read and write it
+    // without locking, and a reader sees either a whole entry or a miss. Allocated by the first
+    // lookup, since most collections never itemize anything but Latin-1.
+    mutable std::atomic<std::atomic<uint64_t>*> mFamilyMemo;
 };
 
 }  // namespace minikin
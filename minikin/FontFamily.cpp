@@ -26,6 +26,7 @@
 #include <hb.h>
 #include <hb-ot.h>
 
+#include "CoverageCache.h"
 #include "FontLanguage.h"
 #include "FontLanguageListCache.h"
 #include "FontUtils.h"
@@ -56,7 +57,6 @@ android::hash_t FontStyle::hash() const {
 
 // static
 uint32_t FontStyle::registerLanguageList(const std::string& languages) {
-    android::AutoMutex _l(gMinikinLock);
     return FontLanguageListCache::getId(languages);
 }
 
@@ -73,7 +73,7 @@ Font::Font(std::shared_ptr<MinikinFont>&& typeface, FontStyle style)
     : typeface(typeface), style(style) {
 }
 
-std::unordered_set<AxisTag> Font::getSupportedAxesLocked() const {
+std::unordered_set<AxisTag> Font::getSupportedAxes() const {
     const uint32_t fvarTag = MinikinFont::MakeTag('f', 'v', 'a', 'r');
     HbBlob fvarTable(getFontTable(typeface.get(), fvarTag));
     if (fvarTable.size() == 0) {
@@ -111,7 +111,6 @@ FontFamily::FontFamily(uint32_t langId, int variant, std::vector<Font>&& fonts)
 
 bool FontFamily::analyzeStyle(const std::shared_ptr<MinikinFont>& typeface, int* weight,
         bool* italic) {
-    android::AutoMutex _l(gMinikinLock);
     const uint32_t os2Tag = MinikinFont::MakeTag('O', 'S', '/', '2');
     HbBlob os2Table(getFontTable(typeface.get(), os2Tag));
     if (os2Table.get() == nullptr) return false;
@@ -166,19 +165,24 @@ bool FontFamily::isColorEmojiFamily() const {
 }
 
 void FontFamily::computeCoverage() {
-    android::AutoMutex _l(gMinikinLock);
     const FontStyle defaultStyle;
     const MinikinFont* typeface = getClosestMatch(defaultStyle).font;
-    const uint32_t cmapTag = MinikinFont::MakeTag('c', 'm', 'a', 'p');
-    HbBlob cmapTable(getFontTable(typeface, cmapTag));
-    if (cmapTable.get() == nullptr) {
-        ALOGE("Could not get cmap table size!\n");
-        return;
+    CoverageCache& coverageCache = CoverageCache::getInstance();
+    const uint64_t fingerprint = coverageCache.getFingerprint(typeface);
+    if (!coverageCache.find(fingerprint, &mCoverage, &mCmapFmt14Coverage)) {
+        const uint32_t cmapTag = MinikinFont::MakeTag('c', 'm', 'a', 'p');
+        HbBlob cmapTable(getFontTable(typeface, cmapTag));
+        if (cmapTable.get() == nullptr) {
+            ALOGE("Could not get cmap table size!\n");
+            return;
+        }
+        mCoverage = CmapCoverage::getCoverage(cmapTable.get(), cmapTable.size(),
+                &mCmapFmt14Coverage);
+        coverageCache.add(fingerprint, mCoverage, mCmapFmt14Coverage);
     }
-    mCoverage = CmapCoverage::getCoverage(cmapTable.get(), cmapTable.size(), &mCmapFmt14Coverage);
 
     for (size_t i = 0; i < mFonts.size(); ++i) {
-        std::unordered_set<AxisTag> supportedAxes = mFonts[i].getSupportedAxesLocked();
+        std::unordered_set<AxisTag> supportedAxes = mFonts[i].getSupportedAxes();
         mSupportedAxes.insert(supportedAxes.begin(), supportedAxes.end());
     }
 }
@@ -229,8 +233,7 @@ std::shared_ptr<FontFamily> FontFamily::createFamilyWithVariation(
     std::vector<Font> fonts;
     for (const Font& font : mFonts) {
         bool supportedVariations = false;
-        android::AutoMutex _l(gMinikinLock);
-        std::unordered_set<AxisTag> supportedAxes = font.getSupportedAxesLocked();
+        std::unordered_set<AxisTag> supportedAxes = font.getSupportedAxes();
         if (!supportedAxes.empty()) {
             for (const FontVariation& variation : variations) {
                 if (supportedAxes.find(variation.axisTag) != supportedAxes.end()) {
@@ -252,4 +255,16 @@ std::shared_ptr<FontFamily> FontFamily::createFamilyWithVariation(
     return std::shared_ptr<FontFamily>(new FontFamily(mLangId, mVariant, std::move(fonts)));
 }
 
+void FontFamily::setCoverageCachePath(const std::string& path) {
+    CoverageCache::getInstance().setPath(path);
+}
+
+void FontFamily::flushCoverageCache() {
+    CoverageCache::getInstance().flush();
+}
+
+uint64_t FontFamily::getCoverageCacheHitCount() {
+    return CoverageCache::getInstance().getHitCount();
+}
+
 }  // namespace minikin
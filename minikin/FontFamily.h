@@ -111,7 +111,7 @@ struct Font {
     std::shared_ptr<MinikinFont> typeface;
     FontStyle style;
 
-    std::unordered_set<AxisTag> getSupportedAxesLocked() const;
+    std::unordered_set<AxisTag> getSupportedAxes() const;
 };
 
 struct FontVariation {
@@ -158,6 +158,17 @@ public:
     std::shared_ptr<FontFamily> createFamilyWithVariation(
             const std::vector<FontVariation>& variations) const;
 
+    // Sets the file that the coverage of fonts is kept in across processes, so that families
+    // of fonts it has don't parse their cmap table. An empty path, the default, keeps none.
+    static void setCoverageCachePath(const std::string& path);
+
+    // Writes the coverage of the fonts loaded since the file was read now, rather than from a
+    // background thread later.
+    static void flushCoverageCache();
+
+    // The number of families whose coverage was read from the file
+    static uint64_t getCoverageCacheHitCount();
+
 private:
     void computeCoverage();
 
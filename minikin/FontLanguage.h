@@ -133,6 +133,7 @@ public:
     explicit FontLanguages(std::vector<FontLanguage>&& languages);
     FontLanguages() : mUnionOfSubScriptBits(0), mIsAllTheSameLanguage(false) {}
     FontLanguages(FontLanguages&&) = default;
+    FontLanguages& operator=(FontLanguages&&) = default;
 
     size_t size() const { return mLanguages.size(); }
     bool empty() const { return mLanguages.empty(); }
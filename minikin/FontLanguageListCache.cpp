@@ -111,9 +111,18 @@ static std::vector<FontLanguage> parseLanguageList(const std::string& input) {
     return result;
 }
 
+FontLanguageListCache::FontLanguageListCache() : mCount(0) {
+    // Insert an empty language list for mapping default language list to kEmptyListId.
+    // The default language list has only one FontLanguage and it is the unsupported language.
+    mChunks[0].reset(new FontLanguages[kChunkSize]);
+    mCount.store(1, std::memory_order_release);
+    mLanguageListLookupTable.insert(std::make_pair("", kEmptyListId));
+}
+
 // static
 uint32_t FontLanguageListCache::getId(const std::string& languages) {
     FontLanguageListCache* inst = FontLanguageListCache::getInstance();
+    std::lock_guard<std::mutex> lock(inst->mLock);
     std::unordered_map<std::string, uint32_t>::const_iterator it =
             inst->mLanguageListLookupTable.find(languages);
     if (it != inst->mLanguageListLookupTable.end()) {
@@ -121,12 +130,18 @@ uint32_t FontLanguageListCache::getId(const std::string& languages) {
     }
 
     // Given language list is not in cache. Insert it and return newly assigned ID.
-    const uint32_t nextId = inst->mLanguageLists.size();
+    const uint32_t nextId = inst->mCount.load(std::memory_order_relaxed);
     FontLanguages fontLanguages(parseLanguageList(languages));
     if (fontLanguages.empty()) {
         return kEmptyListId;
     }
-    inst->mLanguageLists.push_back(std::move(fontLanguages));
+    const uint32_t chunk = nextId >> kLogChunkSize;
+    LOG_ALWAYS_FATAL_IF(chunk >= kMaxChunks, "Too many language lists.");
+    if (!inst->mChunks[chunk]) {
+        inst->mChunks[chunk].reset(new FontLanguages[kChunkSize]);
+    }
+    inst->mChunks[chunk][nextId & (kChunkSize - 1)] = std::move(fontLanguages);
+    inst->mCount.store(nextId + 1, std::memory_order_release);
     inst->mLanguageListLookupTable.insert(std::make_pair(languages, nextId));
     return nextId;
 }
@@ -134,22 +149,14 @@ uint32_t FontLanguageListCache::getId(const std::string& languages) {
 // static
 const FontLanguages& FontLanguageListCache::getById(uint32_t id) {
     FontLanguageListCache* inst = FontLanguageListCache::getInstance();
-    LOG_ALWAYS_FATAL_IF(id >= inst->mLanguageLists.size(), "Lookup by unknown language list ID.");
-    return inst->mLanguageLists[id];
+    LOG_ALWAYS_FATAL_IF(id >= inst->mCount.load(std::memory_order_acquire),
+            "Lookup by unknown language list ID.");
+    return inst->mChunks[id >> kLogChunkSize][id & (kChunkSize - 1)];
 }
 
 // static
 FontLanguageListCache* FontLanguageListCache::getInstance() {
-    assertMinikinLocked();
-    static FontLanguageListCache* instance = nullptr;
-    if (instance == nullptr) {
-        instance = new FontLanguageListCache();
-
-        // Insert an empty language list for mapping default language list to kEmptyListId.
-        // The default language list has only one FontLanguage and it is the unsupported language.
-        instance->mLanguageLists.push_back(FontLanguages());
-        instance->mLanguageListLookupTable.insert(std::make_pair("", kEmptyListId));
-    }
+    static FontLanguageListCache* instance = new FontLanguageListCache();
     return instance;
 }
 
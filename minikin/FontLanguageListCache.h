@@ -17,6 +17,9 @@
 #ifndef MINIKIN_FONT_LANGUAGE_LIST_CACHE_H
 #define MINIKIN_FONT_LANGUAGE_LIST_CACHE_H
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include <minikin/FontFamily.h>
@@ -32,20 +35,27 @@ public:
     const static uint32_t kEmptyListId = 0;
 
     // Returns language list ID for the given string representation of FontLanguages.
-    // Caller should acquire a lock before calling the method.
     static uint32_t getId(const std::string& languages);
 
-    // Caller should acquire a lock before calling the method.
+    // Doesn't lock, this is called for every run laid out.
     static const FontLanguages& getById(uint32_t id);
 
 private:
-    FontLanguageListCache() {}  // Singleton
+    FontLanguageListCache();  // Singleton
     ~FontLanguageListCache() {}
 
-    // Caller should acquire a lock before calling the method.
     static FontLanguageListCache* getInstance();
 
-    std::vector<FontLanguages> mLanguageLists;
+    // Lists are stored in fixed size chunks that never move, so that they can be read while
+    // others are added. A list is only read once its ID was handed out, after mCount covers it.
+    static const uint32_t kLogChunkSize = 6;
+    static const uint32_t kChunkSize = 1 << kLogChunkSize;
+    static const uint32_t kMaxChunks = 1024;
+    std::unique_ptr<FontLanguages[]> mChunks[kMaxChunks];
+    std::atomic<uint32_t> mCount;
+
+    // Guards adding lists, and the lookup table.
+    std::mutex mLock;
 
     // A map from string representation of the font language list to the ID.
     std::unordered_map<std::string, uint32_t> mLanguageListLookupTable;
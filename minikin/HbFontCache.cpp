@@ -20,6 +20,7 @@
 
 #include <log/log.h>
 #include <utils/LruCache.h>
+#include <utils/Mutex.h>
 
 #include <hb.h>
 #include <hb-ot.h>
@@ -29,6 +30,8 @@
 
 namespace minikin {
 
+// Fonts are created without holding the lock, and handed out as new references, so that one
+// evicted while in use stays alive until its last user releases it.
 class HbFontCache : private android::OnEntryRemoved<int32_t, hb_font_t*> {
 public:
     HbFontCache() : mCache(kMaxEntries) {
@@ -40,66 +43,75 @@ public:
         hb_font_destroy(value);
     }
 
+    // Returns a new reference, or nullptr
     hb_font_t* get(int32_t fontId) {
-        return mCache.get(fontId);
+        android::AutoMutex _l(mLock);
+        hb_font_t* font = mCache.get(fontId);
+        return font != nullptr ? hb_font_reference(font) : nullptr;
     }
 
-    void put(int32_t fontId, hb_font_t* font) {
+    // Takes the given reference, and returns a new reference to the cached font, which is a
+    // different one if another thread added it first
+    hb_font_t* put(int32_t fontId, hb_font_t* font) {
+        android::AutoMutex _l(mLock);
+        hb_font_t* cached = mCache.get(fontId);
+        if (cached != nullptr) {
+            hb_font_destroy(font);
+            return hb_font_reference(cached);
+        }
         mCache.put(fontId, font);
+        return hb_font_reference(font);
     }
 
     void clear() {
+        android::AutoMutex _l(mLock);
         mCache.clear();
     }
 
     void remove(int32_t fontId) {
+        android::AutoMutex _l(mLock);
         mCache.remove(fontId);
     }
 
 private:
     static const size_t kMaxEntries = 100;
 
+    android::Mutex mLock;
     android::LruCache<int32_t, hb_font_t*> mCache;
 };
 
-HbFontCache* getFontCacheLocked() {
-    assertMinikinLocked();
-    static HbFontCache* cache = nullptr;
-    if (cache == nullptr) {
-        cache = new HbFontCache();
-    }
-    return cache;
+static HbFontCache& getFontCache() {
+    static HbFontCache* cache = new HbFontCache();
+    return *cache;
+}
+
+static hb_font_t* getNullFaceFont() {
+    // TODO: get rid of nullFaceFont
+    static hb_font_t* nullFaceFont = hb_font_create(nullptr);
+    return nullFaceFont;
 }
 
-void purgeHbFontCacheLocked() {
-    assertMinikinLocked();
-    getFontCacheLocked()->clear();
+void purgeHbFontCache() {
+    getFontCache().clear();
 }
 
-void purgeHbFontLocked(const MinikinFont* minikinFont) {
-    assertMinikinLocked();
+void purgeHbFont(const MinikinFont* minikinFont) {
     const int32_t fontId = minikinFont->GetUniqueId();
-    getFontCacheLocked()->remove(fontId);
+    getFontCache().remove(fontId);
 }
 
 // Returns a new reference to a hb_font_t object, caller is
 // responsible for calling hb_font_destroy() on it.
-hb_font_t* getHbFontLocked(const MinikinFont* minikinFont) {
-    assertMinikinLocked();
-    // TODO: get rid of nullFaceFont
-    static hb_font_t* nullFaceFont = nullptr;
+hb_font_t* getHbFont(const MinikinFont* minikinFont) {
     if (minikinFont == nullptr) {
-        if (nullFaceFont == nullptr) {
-            nullFaceFont = hb_font_create(nullptr);
-        }
-        return hb_font_reference(nullFaceFont);
+        return hb_font_reference(getNullFaceFont());
     }
 
-    HbFontCache* fontCache = getFontCacheLocked();
+    HbFontCache& fontCache = getFontCache();
     const int32_t fontId = minikinFont->GetUniqueId();
-    hb_font_t* font = fontCache->get(fontId);
+    hb_font_t* font = fontCache.get(fontId);
     if (font != nullptr) {
-        return hb_font_reference(font);
+        return font;
     }
 
     hb_face_t* face;
@@ -109,7 +121,6 @@ hb_font_t* getHbFontLocked(const MinikinFont* minikinFont) {
         HB_MEMORY_MODE_READONLY, nullptr, nullptr);
     face = hb_face_create(blob, minikinFont->GetFontIndex());
     hb_blob_destroy(blob);
-
     hb_font_t* parent_font = hb_font_create(face);
     hb_ot_font_set_funcs(parent_font);
 
@@ -122,10 +133,11 @@ hb_font_t* getHbFontLocked(const MinikinFont* minikinFont) {
         variations.push_back({variation.axisTag, variation.value});
     }
     hb_font_set_variations(font, variations.data(), variations.size());
+    // Only read from here on, by any thread
+    hb_font_make_immutable(font);
     hb_font_destroy(parent_font);
     hb_face_destroy(face);
-    fontCache->put(fontId, font);
-    return hb_font_reference(font);
+    return fontCache.put(fontId, font);
 }
 
 }  // namespace minikin
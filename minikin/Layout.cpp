@@ -18,17 +18,16 @@
 
 #include <algorithm>
 #include <fstream>
+#include <inttypes.h>
 #include <iostream>  // for debugging
 #include <math.h>
+#include <stdio.h>
 #include <string>
 #include <unicode/ubidi.h>
 #include <unicode/utf16.h>
 #include <vector>
 
 #include <log/log.h>
-#include <utils/JenkinsHash.h>
-#include <utils/LruCache.h>
-#include <utils/Singleton.h>
 #include <utils/String16.h>
 
 #include <hb-icu.h>
@@ -37,8 +36,10 @@
 #include "FontLanguage.h"
 #include "FontLanguageListCache.h"
 #include "HbFontCache.h"
+#include "LayoutCache.h"
 #include "LayoutUtils.h"
 #include "MinikinInternal.h"
+#include "ShapingCache.h"
 #include <minikin/Emoji.h>
 #include <minikin/Layout.h>
 
@@ -52,170 +53,62 @@ const int kDirection_Mask = 0x1;
 struct LayoutContext {
     MinikinPaint paint;
     FontStyle style;
-    std::vector<hb_font_t*> hbFonts;  // parallel to mFaces
+    std::vector<hb_font_t*> hbFonts;  // parallel to mFaces, owned by the context
 
     void clearHbFonts() {
         for (size_t i = 0; i < hbFonts.size(); i++) {
-            hb_font_set_funcs(hbFonts[i], nullptr, nullptr, nullptr);
             hb_font_destroy(hbFonts[i]);
         }
         hbFonts.clear();
     }
 };
 
-// Layout cache datatypes
+static unsigned int disabledDecomposeCompatibility(hb_unicode_funcs_t*, hb_codepoint_t,
+                                                   hb_codepoint_t*, void*) {
+    return 0;
+}
 
-class LayoutCacheKey {
+class LayoutEngine {
 public:
-    LayoutCacheKey(const std::shared_ptr<FontCollection>& collection, const MinikinPaint& paint,
-            FontStyle style, const uint16_t* chars, size_t start, size_t count, size_t nchars,
-            bool dir)
-            : mChars(chars), mNchars(nchars),
-            mStart(start), mCount(count), mId(collection->getId()), mStyle(style),
-            mSize(paint.size), mScaleX(paint.scaleX), mSkewX(paint.skewX),
-            mLetterSpacing(paint.letterSpacing),
-            mPaintFlags(paint.paintFlags), mHyphenEdit(paint.hyphenEdit), mIsRtl(dir),
-            mHash(computeHash()) {
-    }
-    bool operator==(const LayoutCacheKey &other) const;
-
-    android::hash_t hash() const {
-        return mHash;
+    static LayoutEngine& getInstance() {
+        // Never deleted, since other threads may still be laying out text while exiting
+        static LayoutEngine* sInstance = new LayoutEngine();
+        return *sInstance;
     }
 
-    void copyText() {
-        uint16_t* charsCopy = new uint16_t[mNchars];
-        memcpy(charsCopy, mChars, mNchars * sizeof(uint16_t));
-        mChars = charsCopy;
-    }
-    void freeText() {
-        delete[] mChars;
-        mChars = NULL;
-    }
-
-    void doLayout(Layout* layout, LayoutContext* ctx,
-            const std::shared_ptr<FontCollection>& collection) const {
-        layout->mAdvances.resize(mCount, 0);
-        ctx->clearHbFonts();
-        layout->doLayoutRun(mChars, mStart, mCount, mNchars, mIsRtl, ctx, collection);
-    }
+    hb_unicode_funcs_t* unicodeFunctions;
+    LayoutCache layoutCache;
 
 private:
-    const uint16_t* mChars;
-    size_t mNchars;
-    size_t mStart;
-    size_t mCount;
-    uint32_t mId;  // for the font collection
-    FontStyle mStyle;
-    float mSize;
-    float mScaleX;
-    float mSkewX;
-    float mLetterSpacing;
-    int32_t mPaintFlags;
-    HyphenEdit mHyphenEdit;
-    bool mIsRtl;
-    // Note: any fields added to MinikinPaint must also be reflected here.
-    // TODO: language matching (possibly integrate into style)
-    android::hash_t mHash;
-
-    android::hash_t computeHash() const;
+    LayoutEngine() {
+        unicodeFunctions = hb_unicode_funcs_create(hb_icu_get_unicode_funcs());
+        /* Disable the function used for compatibility decomposition */
+        hb_unicode_funcs_set_decompose_compatibility_func(
+                unicodeFunctions, disabledDecomposeCompatibility, NULL, NULL);
+        hb_unicode_funcs_make_immutable(unicodeFunctions);
+    }
 };
 
-class LayoutCache : private android::OnEntryRemoved<LayoutCacheKey, Layout*> {
+// Shaping fills a buffer, so each thread shapes into its own
+class ThreadHbBuffer {
 public:
-    LayoutCache() : mCache(kMaxEntries) {
-        mCache.setOnEntryRemovedListener(this);
-    }
-
-    void clear() {
-        mCache.clear();
-    }
-
-    Layout* get(LayoutCacheKey& key, LayoutContext* ctx,
-            const std::shared_ptr<FontCollection>& collection) {
-        Layout* layout = mCache.get(key);
-        if (layout == NULL) {
-            key.copyText();
-            layout = new Layout();
-            key.doLayout(layout, ctx, collection);
-            mCache.put(key, layout);
-        }
-        return layout;
+    static hb_buffer_t* get() {
+        static thread_local ThreadHbBuffer sBuffer;
+        return sBuffer.mBuffer;
     }
 
 private:
-    // callback for OnEntryRemoved
-    void operator()(LayoutCacheKey& key, Layout*& value) {
-        key.freeText();
-        delete value;
+    ThreadHbBuffer() : mBuffer(hb_buffer_create()) {
+        hb_buffer_set_unicode_funcs(mBuffer, LayoutEngine::getInstance().unicodeFunctions);
     }
 
-    android::LruCache<LayoutCacheKey, Layout*> mCache;
-
-    //static const size_t kMaxEntries = LruCache<LayoutCacheKey, Layout*>::kUnlimitedCapacity;
-
-    // TODO: eviction based on memory footprint; for now, we just use a constant
-    // number of strings
-    static const size_t kMaxEntries = 5000;
-};
-
-static unsigned int disabledDecomposeCompatibility(hb_unicode_funcs_t*, hb_codepoint_t,
-                                                   hb_codepoint_t*, void*) {
-    return 0;
-}
-
-class LayoutEngine : public ::android::Singleton<LayoutEngine> {
-public:
-    LayoutEngine() {
-        unicodeFunctions = hb_unicode_funcs_create(hb_icu_get_unicode_funcs());
-        /* Disable the function used for compatibility decomposition */
-        hb_unicode_funcs_set_decompose_compatibility_func(
-                unicodeFunctions, disabledDecomposeCompatibility, NULL, NULL);
-        hbBuffer = hb_buffer_create();
-        hb_buffer_set_unicode_funcs(hbBuffer, unicodeFunctions);
+    ~ThreadHbBuffer() {
+        hb_buffer_destroy(mBuffer);
     }
 
-    hb_buffer_t* hbBuffer;
-    hb_unicode_funcs_t* unicodeFunctions;
-    LayoutCache layoutCache;
+    hb_buffer_t* mBuffer;
 };
 
-bool LayoutCacheKey::operator==(const LayoutCacheKey& other) const {
-    return mId == other.mId
-            && mStart == other.mStart
-            && mCount == other.mCount
-            && mStyle == other.mStyle
-            && mSize == other.mSize
-            && mScaleX == other.mScaleX
-            && mSkewX == other.mSkewX
-            && mLetterSpacing == other.mLetterSpacing
-            && mPaintFlags == other.mPaintFlags
-            && mHyphenEdit == other.mHyphenEdit
-            && mIsRtl == other.mIsRtl
-            && mNchars == other.mNchars
-            && !memcmp(mChars, other.mChars, mNchars * sizeof(uint16_t));
-}
-
-android::hash_t LayoutCacheKey::computeHash() const {
-    uint32_t hash = android::JenkinsHashMix(0, mId);
-    hash = android::JenkinsHashMix(hash, mStart);
-    hash = android::JenkinsHashMix(hash, mCount);
-    hash = android::JenkinsHashMix(hash, hash_type(mStyle));
-    hash = android::JenkinsHashMix(hash, hash_type(mSize));
-    hash = android::JenkinsHashMix(hash, hash_type(mScaleX));
-    hash = android::JenkinsHashMix(hash, hash_type(mSkewX));
-    hash = android::JenkinsHashMix(hash, hash_type(mLetterSpacing));
-    hash = android::JenkinsHashMix(hash, hash_type(mPaintFlags));
-    hash = android::JenkinsHashMix(hash, hash_type(mHyphenEdit.getHyphen()));
-    hash = android::JenkinsHashMix(hash, hash_type(mIsRtl));
-    hash = android::JenkinsHashMixShorts(hash, mChars, mNchars);
-    return android::JenkinsHashWhiten(hash);
-}
-
-android::hash_t hash_type(const LayoutCacheKey& key) {
-    return key.hash();
-}
-
 void MinikinRect::join(const MinikinRect& r) {
     if (isEmpty()) {
         set(r);
@@ -250,30 +143,28 @@ static hb_bool_t harfbuzzGetGlyphHorizontalOrigin(hb_font_t* /* hbFont */, void*
     return true;
 }
 
-hb_font_funcs_t* getHbFontFuncs(bool forColorBitmapFont) {
-    assertMinikinLocked();
-
-    static hb_font_funcs_t* hbFuncs = nullptr;
-    static hb_font_funcs_t* hbFuncsForColorBitmap = nullptr;
-
-    hb_font_funcs_t** funcs = forColorBitmapFont ? &hbFuncs : &hbFuncsForColorBitmap;
-    if (*funcs == nullptr) {
-        *funcs = hb_font_funcs_create();
-        if (forColorBitmapFont) {
-            // Don't override the h_advance function since we use HarfBuzz's implementation for
-            // emoji for performance reasons.
-            // Note that it is technically possible for a TrueType font to have outline and embedded
-            // bitmap at the same time. We ignore modified advances of hinted outline glyphs in that
-            // case.
-        } else {
-            // Override the h_advance function since we can't use HarfBuzz's implemenation. It may
-            // return the wrong value if the font uses hinting aggressively.
-            hb_font_funcs_set_glyph_h_advance_func(*funcs, harfbuzzGetGlyphHorizontalAdvance, 0, 0);
-        }
-        hb_font_funcs_set_glyph_h_origin_func(*funcs, harfbuzzGetGlyphHorizontalOrigin, 0, 0);
-        hb_font_funcs_make_immutable(*funcs);
+static hb_font_funcs_t* createHbFontFuncs(bool forColorBitmapFont) {
+    hb_font_funcs_t* funcs = hb_font_funcs_create();
+    if (forColorBitmapFont) {
+        // Don't override the h_advance function since we use HarfBuzz's implementation for
+        // emoji for performance reasons.
+        // Note that it is technically possible for a TrueType font to have outline and embedded
+        // bitmap at the same time. We ignore modified advances of hinted outline glyphs in that
+        // case.
+    } else {
+        // Override the h_advance function since we can't use HarfBuzz's implemenation. It may
+        // return the wrong value if the font uses hinting aggressively.
+        hb_font_funcs_set_glyph_h_advance_func(funcs, harfbuzzGetGlyphHorizontalAdvance, 0, 0);
     }
-    return *funcs;
+    hb_font_funcs_set_glyph_h_origin_func(funcs, harfbuzzGetGlyphHorizontalOrigin, 0, 0);
+    hb_font_funcs_make_immutable(funcs);
+    return funcs;
+}
+
+hb_font_funcs_t* getHbFontFuncs(bool forColorBitmapFont) {
+    static hb_font_funcs_t* hbFuncs = createHbFontFuncs(false);
+    static hb_font_funcs_t* hbFuncsForColorBitmap = createHbFontFuncs(true);
+    return forColorBitmapFont ? hbFuncsForColorBitmap : hbFuncs;
 }
 
 static bool isColorBitmapFont(hb_font_t* font) {
@@ -310,7 +201,10 @@ int Layout::findFace(const FakedFont& face, LayoutContext* ctx) {
     // Note: ctx == NULL means we're copying from the cache, no need to create
     // corresponding hb_font object.
     if (ctx != NULL) {
-        hb_font_t* font = getHbFontLocked(face.font);
+        // The cached font is shared between threads, scale and paint are set on a child of it
+        hb_font_t* parent = getHbFont(face.font);
+        hb_font_t* font = hb_font_create_sub_font(parent);
+        hb_font_destroy(parent);
         hb_font_set_funcs(font, getHbFontFuncs(isColorBitmapFont(font)), &ctx->paint, 0);
         ctx->hbFonts.push_back(font);
     }
@@ -318,10 +212,7 @@ int Layout::findFace(const FakedFont& face, LayoutContext* ctx) {
 }
 
 static hb_script_t codePointToScript(hb_codepoint_t codepoint) {
-    static hb_unicode_funcs_t* u = 0;
-    if (!u) {
-        u = LayoutEngine::getInstance().unicodeFunctions;
-    }
+    static hb_unicode_funcs_t* u = LayoutEngine::getInstance().unicodeFunctions;
     return hb_unicode_script(u, codepoint);
 }
 
@@ -556,8 +447,6 @@ BidiText::BidiText(const uint16_t* buf, size_t start, size_t count, size_t bufSi
 void Layout::doLayout(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         int bidiFlags, const FontStyle &style, const MinikinPaint &paint,
         const std::shared_ptr<FontCollection>& collection) {
-    android::AutoMutex _l(gMinikinLock);
-
     LayoutContext ctx;
     ctx.style = style;
     ctx.paint = paint;
@@ -576,8 +465,6 @@ void Layout::doLayout(const uint16_t* buf, size_t start, size_t count, size_t bu
 float Layout::measureText(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         int bidiFlags, const FontStyle &style, const MinikinPaint &paint,
         const std::shared_ptr<FontCollection>& collection, float* advances) {
-    android::AutoMutex _l(gMinikinLock);
-
     LayoutContext ctx;
     ctx.style = style;
     ctx.paint = paint;
@@ -649,31 +536,45 @@ float Layout::doLayoutRunCached(const uint16_t* buf, size_t start, size_t count,
 float Layout::doLayoutWord(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         bool isRtl, LayoutContext* ctx, size_t bufStart,
         const std::shared_ptr<FontCollection>& collection, Layout* layout, float* advances) {
-    LayoutCache& cache = LayoutEngine::getInstance().layoutCache;
-    LayoutCacheKey key(collection, ctx->paint, ctx->style, buf, start, count, bufSize, isRtl);
-
     float wordSpacing = count == 1 && isWordSpace(buf[start]) ? ctx->paint.wordSpacing : 0;
 
     float advance;
-    if (ctx->paint.skipCache()) {
-        Layout layoutForWord;
-        key.doLayout(&layoutForWord, ctx, collection);
+    auto appendWord = [&](const LayoutPiece& word) {
         if (layout) {
-            layout->appendLayout(&layoutForWord, bufStart, wordSpacing);
+            layout->appendLayout(word, bufStart, wordSpacing);
         }
         if (advances) {
-            layoutForWord.getAdvances(advances);
+            memcpy(advances, word.advances, word.advanceCount * sizeof(float));
         }
-        advance = layoutForWord.getAdvance();
+        advance = word.advance;
+    };
+    auto layoutWord = [&](Layout* layoutForWord) {
+        layoutForWord->mAdvances.resize(count, 0);
+        ctx->clearHbFonts();
+        layoutForWord->doLayoutRun(buf, start, count, bufSize, isRtl, ctx, collection);
+    };
+    if (ctx->paint.skipCache()) {
+        Layout layoutForWord;
+        layoutWord(&layoutForWord);
+        appendWord(LayoutPiece(layoutForWord));
     } else {
-        Layout* layoutForWord = cache.get(key, ctx, collection);
-        if (layout) {
-            layout->appendLayout(layoutForWord, bufStart, wordSpacing);
-        }
-        if (advances) {
-            layoutForWord->getAdvances(advances);
+        LayoutCache& cache = LayoutEngine::getInstance().layoutCache;
+        LayoutCacheKey key(collection, ctx->paint, ctx->style, buf, start, count, bufSize, isRtl);
+        if (!cache.find(key, appendWord)) {
+            ShapingCache& shapingCache = ShapingCache::getInstance();
+            ShapedWord shapedWord;
+            Layout layoutForWord;
+            LayoutPiece word;
+            if (shapingCache.find(collection, key, &shapedWord)) {
+                word = shapedWord.piece();
+            } else {
+                layoutWord(&layoutForWord);
+                word = LayoutPiece(layoutForWord);
+                shapingCache.add(collection, key, word);
+            }
+            appendWord(word);
+            cache.put(key, word);
         }
-        advance = layoutForWord->getAdvance();
     }
 
     if (wordSpacing != 0) {
@@ -693,7 +594,7 @@ static void addFeatures(const string &str, vector<hb_feature_t>* features) {
     const char* end = start + str.size();
 
     while (start < end) {
-        static hb_feature_t feature;
+        hb_feature_t feature;
         const char* p = strchr(start, ',');
         if (!p)
             p = end;
@@ -846,7 +747,7 @@ static inline uint32_t addToHbBuffer(hb_buffer_t* buffer,
 
 void Layout::doLayoutRun(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         bool isRtl, LayoutContext* ctx, const std::shared_ptr<FontCollection>& collection) {
-    hb_buffer_t* buffer = LayoutEngine::getInstance().hbBuffer;
+    hb_buffer_t* buffer = ThreadHbBuffer::get();
     vector<FontCollection::Run> items;
     collection->itemize(buf + start, count, ctx->style, &items);
 
@@ -1024,21 +925,21 @@ void Layout::doLayoutRun(const uint16_t* buf, size_t start, size_t count, size_t
     mAdvance = x;
 }
 
-void Layout::appendLayout(Layout* src, size_t start, float extraAdvance) {
+void Layout::appendLayout(const LayoutPiece& src, size_t start, float extraAdvance) {
     int fontMapStack[16];
     int* fontMap;
-    if (src->mFaces.size() < sizeof(fontMapStack) / sizeof(fontMapStack[0])) {
+    if (src.faceCount < sizeof(fontMapStack) / sizeof(fontMapStack[0])) {
         fontMap = fontMapStack;
     } else {
-        fontMap = new int[src->mFaces.size()];
+        fontMap = new int[src.faceCount];
     }
-    for (size_t i = 0; i < src->mFaces.size(); i++) {
-        int font_ix = findFace(src->mFaces[i], NULL);
+    for (size_t i = 0; i < src.faceCount; i++) {
+        int font_ix = findFace(src.faces[i], NULL);
         fontMap[i] = font_ix;
     }
     int x0 = mAdvance;
-    for (size_t i = 0; i < src->mGlyphs.size(); i++) {
-        LayoutGlyph& srcGlyph = src->mGlyphs[i];
+    for (size_t i = 0; i < src.glyphCount; i++) {
+        const LayoutGlyph& srcGlyph = src.glyphs[i];
         int font_ix = fontMap[srcGlyph.font_ix];
         unsigned int glyph_id = srcGlyph.glyph_id;
         float x = x0 + srcGlyph.x;
@@ -1046,15 +947,15 @@ void Layout::appendLayout(Layout* src, size_t start, float extraAdvance) {
         LayoutGlyph glyph = {font_ix, glyph_id, x, y};
         mGlyphs.push_back(glyph);
     }
-    for (size_t i = 0; i < src->mAdvances.size(); i++) {
-        mAdvances[i + start] = src->mAdvances[i];
+    for (size_t i = 0; i < src.advanceCount; i++) {
+        mAdvances[i + start] = src.advances[i];
         if (i == 0)
           mAdvances[i + start] += extraAdvance;
     }
-    MinikinRect srcBounds(src->mBounds);
+    MinikinRect srcBounds(src.bounds);
     srcBounds.offset(x0, 0);
     mBounds.join(srcBounds);
-    mAdvance += src->mAdvance + extraAdvance;
+    mAdvance += src.advance + extraAdvance;
 
     if (fontMap != fontMapStack) {
         delete[] fontMap;
@@ -1094,7 +995,7 @@ float Layout::getAdvance() const {
     return mAdvance;
 }
 
-void Layout::getAdvances(float* advances) {
+void Layout::getAdvances(float* advances) const {
     memcpy(advances, &mAdvances[0], mAdvances.size() * sizeof(float));
 }
 
@@ -1103,17 +1004,35 @@ void Layout::getBounds(MinikinRect* bounds) const {
 }
 
 void Layout::purgeCaches() {
-    android::AutoMutex _l(gMinikinLock);
     LayoutCache& layoutCache = LayoutEngine::getInstance().layoutCache;
     layoutCache.clear();
-    purgeHbFontCacheLocked();
+    purgeHbFontCache();
 }
 
-}  // namespace minikin
+LayoutCacheStats Layout::getCacheStats() {
+    LayoutCacheStats stats = LayoutEngine::getInstance().layoutCache.getStats();
+    stats.fileHits = ShapingCache::getInstance().getHitCount();
+    return stats;
+}
+
+void Layout::dumpCacheStats(int fd) {
+    LayoutCacheStats stats = getCacheStats();
+    const uint64_t lookups = stats.hits + stats.misses;
+    dprintf(fd, "\nLayout cache:\n");
+    dprintf(fd, "  Words: %zu, %zu / %zu bytes\n", stats.entries, stats.bytes, stats.maxBytes);
+    dprintf(fd, "  Hits: %" PRIu64 " (%.2f%%), misses: %" PRIu64 "\n", stats.hits,
+            lookups ? 100.0 * stats.hits / lookups : 0.0, stats.misses);
+    dprintf(fd, "  Rejected: %" PRIu64 ", evicted: %" PRIu64 "\n", stats.rejections,
+            stats.evictions);
+    dprintf(fd, "  Read from the shaping cache file: %" PRIu64 "\n", stats.fileHits);
+}
 
-// Unable to define the static data member outside of android.
-// TODO: introduce our own Singleton to drop android namespace.
-namespace android {
-ANDROID_SINGLETON_STATIC_INSTANCE(minikin::LayoutEngine);
-}  // namespace android
+void Layout::setShapingCachePath(const std::string& path) {
+    ShapingCache::getInstance().setPath(path);
+}
 
+void Layout::flushShapingCache() {
+    ShapingCache::getInstance().flush();
+}
+
+}  // namespace minikin
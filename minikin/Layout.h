@@ -20,6 +20,7 @@
 #include <hb.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <minikin/FontCollection.h>
@@ -42,6 +43,21 @@ struct LayoutGlyph {
 // Internal state used during layout operation
 struct LayoutContext;
 
+// Laid out text as stored in the layout cache
+struct LayoutPiece;
+
+// Activity of the layout cache since the process started, counted in words
+struct LayoutCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t rejections;  // missed words that weren't looked up often enough to be kept
+    uint64_t evictions;
+    size_t entries;
+    size_t bytes;
+    size_t maxBytes;
+    uint64_t fileHits;  // missed words read back from the shaping cache file
+};
+
 enum {
     kBidi_LTR = 0,
     kBidi_RTL = 1,
@@ -91,7 +107,7 @@ public:
 
     // Get advances, copying into caller-provided buffer. The size of this
     // buffer must match the length of the string (count arg to doLayout).
-    void getAdvances(float* advances);
+    void getAdvances(float* advances) const;
 
     // The i parameter is an offset within the buf relative to start, it is < count, where
     // start and count are the parameters to doLayout
@@ -102,8 +118,18 @@ public:
     // Purge all caches, useful in low memory conditions
     static void purgeCaches();
 
+    static LayoutCacheStats getCacheStats();
+    // Writes the layout cache stats to fd, for dumpsys
+    static void dumpCacheStats(int fd);
+
+    // Keeps the shaping of words in a file, for later processes to read instead of shaping the
+    // same text again. Words are written back in the background. Off until a path is set.
+    static void setShapingCachePath(const std::string& path);
+    // Writes the words shaped since the last write now
+    static void flushShapingCache();
+
 private:
-    friend class LayoutCacheKey;
+    friend struct LayoutPiece;
 
     // Find a face in the mFaces vector, or create a new entry
     int findFace(const FakedFont& face, LayoutContext* ctx);
@@ -128,7 +154,7 @@ private:
         bool isRtl, LayoutContext* ctx, const std::shared_ptr<FontCollection>& collection);
 
     // Append another layout (for example, cached value) into this one
-    void appendLayout(Layout* src, size_t start, float extraAdvance);
+    void appendLayout(const LayoutPiece& src, size_t start, float extraAdvance);
 
     std::vector<LayoutGlyph> mGlyphs;
     std::vector<float> mAdvances;
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Minikin"
+
+#include "LayoutCache.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/JenkinsHash.h>
+
+namespace minikin {
+
+LayoutPiece::LayoutPiece(const Layout& layout)
+        : faces(layout.mFaces.data()), faceCount(layout.mFaces.size()),
+        glyphs(layout.mGlyphs.data()), glyphCount(layout.mGlyphs.size()),
+        advances(layout.mAdvances.data()), advanceCount(layout.mAdvances.size()),
+        advance(layout.mAdvance), bounds(layout.mBounds) {
+}
+
+LayoutCacheKey::LayoutCacheKey(const std::shared_ptr<FontCollection>& collection,
+        const MinikinPaint& paint, FontStyle style, const uint16_t* chars, size_t start,
+        size_t count, size_t nchars, bool dir)
+        : mChars(chars) {
+    mFields.id = collection->getId();
+    mFields.style = style;
+    mFields.size = paint.size;
+    mFields.scaleX = paint.scaleX;
+    mFields.skewX = paint.skewX;
+    mFields.letterSpacing = paint.letterSpacing;
+    mFields.paintFlags = paint.paintFlags;
+    mFields.hyphenEdit = paint.hyphenEdit;
+    mFields.start = start;
+    mFields.count = count;
+    mFields.nchars = nchars;
+    mFields.isRtl = dir;
+    mHash = computeHash();
+}
+
+bool LayoutCacheKey::Fields::operator==(const Fields& other) const {
+    return id == other.id
+            && start == other.start
+            && count == other.count
+            && style == other.style
+            && size == other.size
+            && scaleX == other.scaleX
+            && skewX == other.skewX
+            && letterSpacing == other.letterSpacing
+            && paintFlags == other.paintFlags
+            && hyphenEdit == other.hyphenEdit
+            && isRtl == other.isRtl
+            && nchars == other.nchars;
+}
+
+android::hash_t LayoutCacheKey::computeHash() const {
+    uint32_t hash = android::JenkinsHashMix(0, mFields.id);
+    hash = android::JenkinsHashMix(hash, mFields.start);
+    hash = android::JenkinsHashMix(hash, mFields.count);
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.style));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.size));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.scaleX));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.skewX));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.letterSpacing));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.paintFlags));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.hyphenEdit.getHyphen()));
+    hash = android::JenkinsHashMix(hash, hash_type(mFields.isRtl));
+    hash = android::JenkinsHashMixShorts(hash, mChars, mFields.nchars);
+    return android::JenkinsHashWhiten(hash);
+}
+
+static uint32_t alignOffset(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+LayoutCacheEntry* LayoutCacheEntry::create(const LayoutCacheKey& key, const LayoutPiece& piece) {
+    const uint32_t facesOffset = alignOffset(sizeof(LayoutCacheEntry), alignof(FakedFont));
+    const uint32_t glyphsOffset = alignOffset(facesOffset + piece.faceCount * sizeof(FakedFont),
+            alignof(LayoutGlyph));
+    const uint32_t advancesOffset = alignOffset(
+            glyphsOffset + piece.glyphCount * sizeof(LayoutGlyph), alignof(float));
+    const uint32_t charsOffset = alignOffset(advancesOffset + piece.advanceCount * sizeof(float),
+            alignof(uint16_t));
+    const uint32_t size = charsOffset + key.mFields.nchars * sizeof(uint16_t);
+
+    void* memory = malloc(size);
+    if (memory == nullptr) {
+        return nullptr;
+    }
+    LayoutCacheEntry* entry = new (memory) LayoutCacheEntry();
+    entry->mFields = key.mFields;
+    entry->mHash = key.mHash;
+    entry->mSize = size;
+    entry->mFaceCount = piece.faceCount;
+    entry->mGlyphCount = piece.glyphCount;
+    entry->mAdvanceCount = piece.advanceCount;
+    entry->mGlyphsOffset = glyphsOffset;
+    entry->mAdvancesOffset = advancesOffset;
+    entry->mCharsOffset = charsOffset;
+    entry->mAdvance = piece.advance;
+    entry->mBounds = piece.bounds;
+    std::uninitialized_copy(piece.faces, piece.faces + piece.faceCount,
+            entry->at<FakedFont>(facesOffset));
+    std::uninitialized_copy(piece.glyphs, piece.glyphs + piece.glyphCount,
+            entry->at<LayoutGlyph>(glyphsOffset));
+    memcpy(entry->at<float>(advancesOffset), piece.advances, piece.advanceCount * sizeof(float));
+    memcpy(entry->at<uint16_t>(charsOffset), key.mChars, key.mFields.nchars * sizeof(uint16_t));
+    return entry;
+}
+
+void LayoutCacheEntry::destroy(LayoutCacheEntry* entry) {
+    // The faces and glyphs are trivially destructible
+    entry->~LayoutCacheEntry();
+    free(entry);
+}
+
+bool LayoutCacheEntry::matches(const LayoutCacheKey& key) const {
+    return mHash == key.mHash
+            && mFields == key.mFields
+            && !memcmp(at<uint16_t>(mCharsOffset), key.mChars,
+                    mFields.nchars * sizeof(uint16_t));
+}
+
+LayoutPiece LayoutCacheEntry::piece() const {
+    LayoutPiece piece;
+    piece.faces = at<FakedFont>(alignOffset(sizeof(LayoutCacheEntry), alignof(FakedFont)));
+    piece.faceCount = mFaceCount;
+    piece.glyphs = at<LayoutGlyph>(mGlyphsOffset);
+    piece.glyphCount = mGlyphCount;
+    piece.advances = at<float>(mAdvancesOffset);
+    piece.advanceCount = mAdvanceCount;
+    piece.advance = mAdvance;
+    piece.bounds = mBounds;
+    return piece;
+}
+
+FrequencySketch::FrequencySketch() {
+    clear();
+}
+
+size_t FrequencySketch::index(android::hash_t hash, size_t row) {
+    static const uint32_t kSeeds[kDepth] = { 0x9e3779b1, 0x85ebca77, 0xc2b2ae3d, 0x27d4eb2f };
+    uint32_t h = hash * kSeeds[row];
+    h ^= h >> 16;
+    return row * kWidth + (h & (kWidth - 1));
+}
+
+uint32_t FrequencySketch::get(size_t index) const {
+    return (mCounters[index / 2] >> ((index & 1) * 4)) & 0xf;
+}
+
+void FrequencySketch::increment(android::hash_t hash) {
+    for (size_t row = 0; row < kDepth; row++) {
+        const size_t i = index(hash, row);
+        if (get(i) < kMaxCount) {
+            mCounters[i / 2] += 1 << ((i & 1) * 4);
+        }
+    }
+    if (++mAdditions == kSampleSize) {
+        for (uint8_t& counters : mCounters) {
+            counters = (counters >> 1) & 0x77;
+        }
+        mAdditions /= 2;
+    }
+}
+
+uint32_t FrequencySketch::estimate(android::hash_t hash) const {
+    uint32_t count = kMaxCount;
+    for (size_t row = 0; row < kDepth; row++) {
+        count = std::min(count, get(index(hash, row)));
+    }
+    return count;
+}
+
+void FrequencySketch::clear() {
+    memset(mCounters, 0, sizeof(mCounters));
+    mAdditions = 0;
+}
+
+LayoutCacheEntry*& LayoutCache::Shard::bucketFor(android::hash_t hash) {
+    // The low bits picked the shard
+    return buckets[(hash >> kShardBits) & (buckets.size() - 1)];
+}
+
+LayoutCacheEntry* LayoutCache::Shard::find(const LayoutCacheKey& key) const {
+    LayoutCacheEntry* entry = buckets[(key.hash() >> kShardBits) & (buckets.size() - 1)];
+    while (entry != nullptr && !entry->matches(key)) {
+        entry = entry->hashNext;
+    }
+    return entry;
+}
+
+void LayoutCache::Shard::insert(LayoutCacheEntry* entry) {
+    if (entries >= buckets.size()) {
+        rehash(buckets.size() * 2);
+    }
+    LayoutCacheEntry*& bucket = bucketFor(entry->hash());
+    entry->hashNext = bucket;
+    bucket = entry;
+
+    entry->lruPrev = nullptr;
+    entry->lruNext = lruHead;
+    if (lruHead != nullptr) {
+        lruHead->lruPrev = entry;
+    } else {
+        lruTail = entry;
+    }
+    lruHead = entry;
+
+    entries++;
+    bytes += entry->size();
+}
+
+void LayoutCache::Shard::remove(LayoutCacheEntry* entry) {
+    LayoutCacheEntry** link = &bucketFor(entry->hash());
+    while (*link != entry) {
+        link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+
+    if (entry->lruPrev != nullptr) {
+        entry->lruPrev->lruNext = entry->lruNext;
+    } else {
+        lruHead = entry->lruNext;
+    }
+    if (entry->lruNext != nullptr) {
+        entry->lruNext->lruPrev = entry->lruPrev;
+    } else {
+        lruTail = entry->lruPrev;
+    }
+    entry->hashNext = entry->lruPrev = entry->lruNext = nullptr;
+
+    entries--;
+    bytes -= entry->size();
+}
+
+void LayoutCache::Shard::moveToFront(LayoutCacheEntry* entry) {
+    if (entry == lruHead) {
+        return;
+    }
+    entry->lruPrev->lruNext = entry->lruNext;
+    if (entry->lruNext != nullptr) {
+        entry->lruNext->lruPrev = entry->lruPrev;
+    } else {
+        lruTail = entry->lruPrev;
+    }
+    entry->lruPrev = nullptr;
+    entry->lruNext = lruHead;
+    lruHead->lruPrev = entry;
+    lruHead = entry;
+}
+
+void LayoutCache::Shard::rehash(size_t bucketCount) {
+    std::vector<LayoutCacheEntry*> oldBuckets(bucketCount, nullptr);
+    oldBuckets.swap(buckets);
+    for (LayoutCacheEntry* entry : oldBuckets) {
+        while (entry != nullptr) {
+            LayoutCacheEntry* next = entry->hashNext;
+            LayoutCacheEntry*& bucket = bucketFor(entry->hash());
+            entry->hashNext = bucket;
+            bucket = entry;
+            entry = next;
+        }
+    }
+}
+
+void LayoutCache::put(const LayoutCacheKey& key, const LayoutPiece& piece) {
+    // Built before locking, and freed after unlocking along with the words it replaced
+    LayoutCacheEntry* entry = LayoutCacheEntry::create(key, piece);
+    if (entry == nullptr) {
+        return;
+    }
+    LayoutCacheEntry* garbage = nullptr;
+    {
+        Shard& shard = shardFor(key.hash());
+        android::AutoMutex _l(shard.lock);
+        if (entry->size() > kMaxShardBytes || shard.find(key) != nullptr) {
+            // Too big to ever fit, or another thread laid out the same word meanwhile
+            garbage = entry;
+        } else if (shard.bytes + entry->size() > kMaxShardBytes
+                && shard.sketch.estimate(key.hash())
+                        <= shard.sketch.estimate(shard.lruTail->hash())) {
+            shard.rejections++;
+            garbage = entry;
+        } else {
+            while (shard.bytes + entry->size() > kMaxShardBytes) {
+                LayoutCacheEntry* victim = shard.lruTail;
+                shard.remove(victim);
+                shard.evictions++;
+                victim->lruNext = garbage;
+                garbage = victim;
+            }
+            shard.insert(entry);
+        }
+    }
+    while (garbage != nullptr) {
+        LayoutCacheEntry* next = garbage->lruNext;
+        LayoutCacheEntry::destroy(garbage);
+        garbage = next;
+    }
+}
+
+void LayoutCache::clear() {
+    for (Shard& shard : mShards) {
+        LayoutCacheEntry* garbage;
+        {
+            android::AutoMutex _l(shard.lock);
+            garbage = shard.lruHead;
+            std::fill(shard.buckets.begin(), shard.buckets.end(), nullptr);
+            shard.lruHead = shard.lruTail = nullptr;
+            shard.entries = 0;
+            shard.bytes = 0;
+            shard.sketch.clear();
+        }
+        while (garbage != nullptr) {
+            LayoutCacheEntry* next = garbage->lruNext;
+            LayoutCacheEntry::destroy(garbage);
+            garbage = next;
+        }
+    }
+}
+
+LayoutCacheStats LayoutCache::getStats() {
+    LayoutCacheStats stats = {};
+    stats.maxBytes = kMaxBytes;
+    for (Shard& shard : mShards) {
+        android::AutoMutex _l(shard.lock);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.rejections += shard.rejections;
+        stats.evictions += shard.evictions;
+        stats.entries += shard.entries;
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+}  // namespace minikin
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MINIKIN_LAYOUT_CACHE_H
+#define MINIKIN_LAYOUT_CACHE_H
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include <utils/Mutex.h>
+#include <utils/TypeHelpers.h>
+
+#include <minikin/Layout.h>
+
+namespace minikin {
+
+// A read-only view of laid out text, either a Layout or a word in the cache
+struct LayoutPiece {
+    LayoutPiece() {}
+    explicit LayoutPiece(const Layout& layout);
+
+    const FakedFont* faces = nullptr;
+    size_t faceCount = 0;
+    const LayoutGlyph* glyphs = nullptr;
+    size_t glyphCount = 0;
+    const float* advances = nullptr;
+    size_t advanceCount = 0;
+    float advance = 0;
+    MinikinRect bounds = {0, 0, 0, 0};
+};
+
+class LayoutCacheKey {
+public:
+    LayoutCacheKey(const std::shared_ptr<FontCollection>& collection, const MinikinPaint& paint,
+            FontStyle style, const uint16_t* chars, size_t start, size_t count, size_t nchars,
+            bool dir);
+
+    android::hash_t hash() const { return mHash; }
+
+private:
+    friend class LayoutCacheEntry;
+    friend class ShapingCache;
+
+    // Everything the layout depends on but the text, kept as is in cache entries
+    struct Fields {
+        uint32_t id;  // for the font collection
+        FontStyle style;
+        float size;
+        float scaleX;
+        float skewX;
+        float letterSpacing;
+        int32_t paintFlags;
+        HyphenEdit hyphenEdit;
+        uint32_t start;
+        uint32_t count;
+        uint32_t nchars;
+        bool isRtl;
+        // Note: any fields added to MinikinPaint must also be reflected here.
+        // TODO: language matching (possibly integrate into style)
+
+        bool operator==(const Fields& other) const;
+    };
+
+    Fields mFields;
+    const uint16_t* mChars;
+    android::hash_t mHash;
+
+    android::hash_t computeHash() const;
+};
+
+/*
+ * A cached word: the key, the text and the layout are packed in a single allocation, which is
+ * what the cache accounts for. The shard owning the entry links it in its hash chains and LRU
+ * list.
+ */
+class LayoutCacheEntry {
+public:
+    static LayoutCacheEntry* create(const LayoutCacheKey& key, const LayoutPiece& piece);
+    static void destroy(LayoutCacheEntry* entry);
+
+    bool matches(const LayoutCacheKey& key) const;
+    LayoutPiece piece() const;
+
+    android::hash_t hash() const { return mHash; }
+    size_t size() const { return mSize; }
+
+    LayoutCacheEntry* hashNext = nullptr;
+    LayoutCacheEntry* lruPrev = nullptr;
+    LayoutCacheEntry* lruNext = nullptr;
+
+private:
+    LayoutCacheEntry() {}
+
+    template <typename T>
+    T* at(uint32_t offset) const {
+        return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(this) + offset);
+    }
+
+    LayoutCacheKey::Fields mFields;
+    android::hash_t mHash;
+    uint32_t mSize;
+    uint32_t mFaceCount;
+    uint32_t mGlyphCount;
+    uint32_t mAdvanceCount;
+    uint32_t mGlyphsOffset;
+    uint32_t mAdvancesOffset;
+    uint32_t mCharsOffset;
+    float mAdvance;
+    MinikinRect mBounds;
+    // Followed by the faces, glyphs, advances and text
+};
+
+/*
+ * Count-min sketch of how often words were looked up lately, for TinyLFU admission: a word
+ * only replaces the least recently used one if it is looked up more often. Counters are 4 bits
+ * and saturate at 15, and are all halved after a sample of lookups, so that popularity fades
+ * with time.
+ */
+class FrequencySketch {
+public:
+    FrequencySketch();
+
+    void increment(android::hash_t hash);
+    uint32_t estimate(android::hash_t hash) const;
+    void clear();
+
+private:
+    static const size_t kDepth = 4;
+    // Enough counters per row for the noise of a sample to stay well under one per counter
+    static const size_t kWidth = 4096;
+    static const uint32_t kSampleSize = 4096;
+    static const uint32_t kMaxCount = 15;
+
+    static size_t index(android::hash_t hash, size_t row);
+    uint32_t get(size_t index) const;
+
+    uint8_t mCounters[kDepth * kWidth / 2];  // two per byte
+    uint32_t mAdditions;
+};
+
+/*
+ * Words laid out with the same paint, bounded by the memory they use rather than their number,
+ * so that short words of Latin text and long runs of complex scripts share the budget fairly.
+ *
+ * The cache is split into shards by key hash, each with its own lock, LRU list, frequency
+ * sketch and share of the budget, so that threads laying out different words rarely wait for
+ * each other. Cached words are only read with their shard locked, and words missing from the
+ * cache are laid out without holding any lock.
+ */
+class LayoutCache {
+public:
+    static const size_t kMaxBytes = 2 * 1024 * 1024;
+
+    LayoutCache() {}
+    ~LayoutCache() { clear(); }
+
+    // Calls f with the cached layout of the word and returns true, or returns false if the word
+    // isn't cached. The piece must not be used after f returns.
+    template <typename F>
+    bool find(const LayoutCacheKey& key, F f) {
+        Shard& shard = shardFor(key.hash());
+        android::AutoMutex _l(shard.lock);
+        shard.sketch.increment(key.hash());
+        LayoutCacheEntry* entry = shard.find(key);
+        if (entry == nullptr) {
+            shard.misses++;
+            return false;
+        }
+        shard.hits++;
+        shard.moveToFront(entry);
+        f(entry->piece());
+        return true;
+    }
+
+    // Offers the layout of a word that find() missed. It is kept if it fits in the budget, or
+    // is looked up more often than the least recently used word, which it then replaces.
+    void put(const LayoutCacheKey& key, const LayoutPiece& piece);
+
+    void clear();
+
+    LayoutCacheStats getStats();
+
+private:
+    static const size_t kShardBits = 4;
+    static const size_t kShardCount = 1 << kShardBits;
+    static const size_t kMaxShardBytes = kMaxBytes / kShardCount;
+    static const size_t kMinBuckets = 64;
+
+    struct Shard {
+        Shard() : buckets(kMinBuckets, nullptr) {}
+
+        LayoutCacheEntry* find(const LayoutCacheKey& key) const;
+        LayoutCacheEntry*& bucketFor(android::hash_t hash);
+        void insert(LayoutCacheEntry* entry);
+        void remove(LayoutCacheEntry* entry);
+        void moveToFront(LayoutCacheEntry* entry);
+        void rehash(size_t bucketCount);
+
+        android::Mutex lock;
+        std::vector<LayoutCacheEntry*> buckets;  // hash chains, a power of two of them
+        LayoutCacheEntry* lruHead = nullptr;  // most recently used
+        LayoutCacheEntry* lruTail = nullptr;
+        size_t entries = 0;
+        size_t bytes = 0;
+        FrequencySketch sketch;
+
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t rejections = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shardFor(android::hash_t hash) { return mShards[hash & (kShardCount - 1)]; }
+
+    Shard mShards[kShardCount];
+};
+
+}  // namespace minikin
+
+#endif  // MINIKIN_LAYOUT_CACHE_H
@@ -21,8 +21,7 @@
 namespace minikin {
 
 MinikinFont::~MinikinFont() {
-    android::AutoMutex _l(gMinikinLock);
-    purgeHbFontLocked(this);
+    purgeHbFont(this);
 }
 
 }  // namespace minikin
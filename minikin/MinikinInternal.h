@@ -21,25 +21,23 @@
 
 #include <hb.h>
 
-#include <utils/Mutex.h>
 
 #include <minikin/MinikinFont.h>
 
 namespace minikin {
 
 // All external Minikin interfaces are designed to be thread-safe.
-// Presently, that's implemented by through a global lock, and having
-// all external interfaces take that lock.
-
-extern android::Mutex gMinikinLock;
-
-// Aborts if gMinikinLock is not acquired. Do nothing on the release build.
-void assertMinikinLocked();
+// Font collections and families are immutable once built, and the caches
+// shared between threads each synchronize on their own.
 
 hb_blob_t* getFontTable(const MinikinFont* minikinFont, uint32_t tag);
 
 constexpr uint32_t MAX_UNICODE_CODE_POINT = 0x10FFFF;
 
+// FNV-1a, for the keys of files kept across processes, which can't use ids
+constexpr uint64_t FNV_HASH_SEED = 0xcbf29ce484222325ull;
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size);
+
 constexpr uint32_t VS1 = 0xFE00;
 constexpr uint32_t VS16 = 0xFE0F;
 constexpr uint32_t VS17 = 0xE0100;
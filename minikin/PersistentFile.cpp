@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Minikin"
+
+#include "PersistentFile.h"
+
+#include <chrono>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+namespace minikin {
+
+// Data added meanwhile is written in the same batch, at most every kWriteDelay
+static const std::chrono::seconds kWriteDelay(2);
+
+PersistentFile::Mapping::~Mapping() {
+    if (data != nullptr) {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+}
+
+void PersistentFile::setPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (path == mPath) {
+        return;
+    }
+    mPath = path;
+    mLoaded = false;
+    mMapping.reset();
+    clearPending();
+    mEnabled.store(!path.empty(), std::memory_order_relaxed);
+}
+
+void PersistentFile::flush() {
+    write();
+}
+
+std::shared_ptr<PersistentFile::Mapping> PersistentFile::getMapping() {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (!mLoaded && !mPath.empty()) {
+        mMapping = map(mPath);
+        mLoaded = true;
+    }
+    return mMapping;
+}
+
+std::shared_ptr<PersistentFile::Mapping> PersistentFile::map(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = st.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Mapping> mapping = openMapping(static_cast<const uint8_t*>(data), size);
+    if (mapping == nullptr) {
+        ALOGW("Ignoring %s %s, from another version or damaged", mName, path.c_str());
+        munmap(data, size);
+        return nullptr;
+    }
+    mapping->data = static_cast<const uint8_t*>(data);
+    mapping->size = size;
+    return std::shared_ptr<Mapping>(std::move(mapping));
+}
+
+bool PersistentFile::replace(const std::string& path, const std::vector<uint8_t>& contents) {
+    // Each writer has its own file, in the same directory so that it can be renamed over the
+    // old one. Readers of the old file keep their mapping of it.
+    std::string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    if (fd < 0) {
+        ALOGW("Failed to create %s %s", mName, tmpPath.c_str());
+        return false;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    bool ok = true;
+    for (size_t written = 0; ok && written < contents.size(); ) {
+        const ssize_t count = ::write(fd, contents.data() + written, contents.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        ok = count > 0;
+        written += ok ? count : 0;
+    }
+    ok = fsync(fd) == 0 && ok;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ALOGW("Failed to write %s %s", mName, path.c_str());
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void PersistentFile::scheduleWrite() {
+    if (!mWriterScheduled) {
+        mWriterScheduled = true;
+        std::thread(&PersistentFile::writeLater, this).detach();
+    }
+}
+
+void PersistentFile::writeLater() {
+    while (true) {
+        std::this_thread::sleep_for(kWriteDelay);
+        write();
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!hasPending()) {
+            mWriterScheduled = false;
+            return;
+        }
+    }
+}
+
+void PersistentFile::write() {
+    std::lock_guard<std::mutex> writeLock(mWriteLock);
+    std::shared_ptr<Mapping> current = getMapping();
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        path = mPath;
+    }
+    std::vector<uint8_t> contents;
+    if (path.empty() || !buildFile(current, &contents) || !replace(path, contents)) {
+        return;
+    }
+
+    std::shared_ptr<Mapping> written = map(path);
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mPath == path) {
+        mMapping = written;
+        mLoaded = true;
+    }
+}
+
+}  // namespace minikin
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MINIKIN_PERSISTENT_FILE_H
+#define MINIKIN_PERSISTENT_FILE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace minikin {
+
+/*
+ * A cache file shared by processes. It is mapped read only when first needed, and data added
+ * since is written to a new file from a background thread, a little later, in batches. A new
+ * file is written aside under a unique name and renamed over the old one, so that processes
+ * still reading the old mapping are unaffected, and processes writing at the same time each
+ * replace the file as a whole, the last one winning.
+ *
+ * Subclasses define the format: they check and index a mapped file in openMapping(), and build
+ * a new file from the old mapping and their pending data in buildFile().
+ */
+class PersistentFile {
+public:
+    // A read only mapping of the whole file, unmapped when the last reference goes away
+    struct Mapping {
+        virtual ~Mapping();
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // An empty path turns the file off, which is the default
+    void setPath(const std::string& path);
+
+    // Writes the pending data now, on the calling thread
+    void flush();
+
+protected:
+    explicit PersistentFile(const char* name) : mName(name) {}
+    // Instances are never deleted, since their writer thread may still be running while exiting
+    virtual ~PersistentFile() {}
+
+    // Checked without locking on every lookup
+    bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+    // Returns the file mapped by openMapping(), or null if there is none or it was rejected
+    std::shared_ptr<Mapping> getMapping();
+
+    // Writes the file after a short delay, unless a write is already scheduled. Called with
+    // mLock held, after adding pending data.
+    void scheduleWrite();
+
+    // Checks and indexes a newly mapped file, returning null if it is from another version or
+    // damaged. The data and size of the mapping returned are set by the caller.
+    virtual std::unique_ptr<Mapping> openMapping(const uint8_t* data, size_t size) = 0;
+
+    // Called with mLock held: clearPending() when the path changes, and hasPending() after a
+    // write, to write again later if data was added meanwhile
+    virtual void clearPending() = 0;
+    virtual bool hasPending() = 0;
+
+    // Takes the pending data, under mLock, and fills contents with a new file keeping what it
+    // can of the current one. Returns false if there is nothing to write.
+    virtual bool buildFile(const std::shared_ptr<Mapping>& current,
+            std::vector<uint8_t>* contents) = 0;
+
+    // Guards the pending data of subclasses, along with the path and mapping
+    std::mutex mLock;
+
+private:
+    std::shared_ptr<Mapping> map(const std::string& path);
+    bool replace(const std::string& path, const std::vector<uint8_t>& contents);
+    void writeLater();
+    void write();
+
+    const char* mName;
+    std::atomic<bool> mEnabled{false};
+    std::string mPath;
+    bool mLoaded = false;
+    std::shared_ptr<Mapping> mMapping;
+    bool mWriterScheduled = false;
+
+    // Serializes writing the file within the process
+    std::mutex mWriteLock;
+};
+
+}  // namespace minikin
+
+#endif  // MINIKIN_PERSISTENT_FILE_H
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Minikin"
+
+#include "ShapingCache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "FontLanguage.h"
+#include "FontLanguageListCache.h"
+#include "MinikinInternal.h"
+
+namespace minikin {
+
+static const uint32_t kMagic = 0x43534b4d;  // "MKSC"
+// Must be bumped when the format, or the way words are shaped, changes
+static const uint32_t kVersion = 2;
+
+// Bounds of the file. New and recently used words are kept first.
+static const size_t kMaxRecords = 16384;
+static const size_t kMaxFileSize = 4 * 1024 * 1024;
+
+// Words shaped before the next write
+static const size_t kMaxPending = 4096;
+
+// Font collections whose fingerprint is kept
+static const size_t kMaxCollections = 64;
+
+/*
+ * The file is a header, an open addressing table of slots pointing at the records, and the
+ * records. Everything is fixed size and little endian, and read with memcpy since the mapping
+ * may come from an older or damaged file. Each slot has a checksum of its record, so that a
+ * damaged record is never decoded.
+ */
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;  // a power of two
+    uint32_t recordCount;
+    uint64_t fileSize;
+};
+
+struct ShapingCache::Slot {
+    uint64_t hash;
+    uint32_t offset;  // 0 for an empty slot
+    uint32_t size;
+    uint64_t checksum;
+};
+
+struct ShapingCache::RecordHeader {
+    // The key, without padding so that it hashes and compares as bytes
+    uint64_t fingerprint;  // of the fonts of the collection
+    uint64_t languages;
+    uint32_t style;
+    float size;
+    float scaleX;
+    float skewX;
+    float letterSpacing;
+    int32_t paintFlags;
+    uint32_t hyphenEdit;
+    uint32_t start;
+    uint32_t count;
+    uint32_t nchars;
+    uint32_t isRtl;
+
+    uint32_t faceCount;
+    uint32_t glyphCount;
+    float advance;
+    float bounds[4];
+    // Followed by the faces, glyphs, advances and text
+};
+
+static const size_t kKeySize = offsetof(ShapingCache::RecordHeader, faceCount);
+
+struct PackedFace {
+    uint16_t family;
+    uint16_t font;
+    uint8_t fakeBold;
+    uint8_t fakeItalic;
+    uint16_t reserved;
+};
+
+struct PackedGlyph {
+    uint16_t face;
+    uint16_t glyph;
+    float x;
+    float y;
+};
+
+// In 64 bits, since the counts may come from a damaged file and overflow a 32-bit size_t
+static uint64_t recordSize(uint32_t faceCount, uint32_t glyphCount, uint32_t count,
+        uint32_t nchars) {
+    uint64_t size = sizeof(ShapingCache::RecordHeader) + uint64_t(faceCount) * sizeof(PackedFace)
+            + uint64_t(glyphCount) * sizeof(PackedGlyph) + uint64_t(count) * sizeof(float)
+            + uint64_t(nchars) * sizeof(uint16_t);
+    return (size + 7) & ~uint64_t(7);
+}
+
+template <typename T>
+static uint64_t hashValue(uint64_t hash, T value) {
+    return hashBytes(hash, &value, sizeof(value));
+}
+
+static uint64_t hashLanguages(uint64_t hash, uint32_t langListId) {
+    const FontLanguages& languages = FontLanguageListCache::getById(langListId);
+    for (size_t i = 0; i < languages.size(); i++) {
+        hash = hashValue(hash, languages[i].getIdentifier());
+    }
+    return hashValue(hash, uint32_t(languages.size()));
+}
+
+static uint64_t hashFont(uint64_t hash, const MinikinFont* font) {
+    hash = hashValue(hash, uint64_t(font->GetFontSize()));
+    hash = hashValue(hash, int32_t(font->GetFontIndex()));
+    for (const FontVariation& axis : font->GetAxes()) {
+        hash = hashValue(hash, axis.axisTag);
+        hash = hashValue(hash, axis.value);
+    }
+    // The font revision, checksum of the whole file, and creation and modification dates
+    HbBlob head(getFontTable(font, MinikinFont::MakeTag('h', 'e', 'a', 'd')));
+    if (head.get() != nullptr && head.size() >= 36) {
+        hash = hashBytes(hash, head.get() + 4, 32);
+    }
+    return hash;
+}
+
+struct ShapingCache::CollectionInfo {
+    uint64_t fingerprint;
+    // Position of each font in the collection, as family index << 16 | font index
+    std::unordered_map<const MinikinFont*, uint32_t> faces;
+};
+
+struct ShapingCache::MappedFile : public PersistentFile::Mapping {
+    Slot slotAt(size_t index) const {
+        Slot slot;
+        memcpy(&slot, data + sizeof(FileHeader) + index * sizeof(Slot), sizeof(slot));
+        return slot;
+    }
+
+    bool isValid(const Slot& slot) const {
+        return slot.offset >= recordsOffset && slot.size >= sizeof(RecordHeader)
+                && uint64_t(slot.offset) + slot.size <= size
+                && hashBytes(FNV_HASH_SEED, data + slot.offset, slot.size) == slot.checksum;
+    }
+
+    uint32_t slotCount;
+    size_t recordsOffset;
+    // Set for the slots of the words found, which are kept first when writing a new file
+    std::unique_ptr<std::atomic<bool>[]> used;
+};
+
+std::unique_ptr<PersistentFile::Mapping> ShapingCache::openMapping(const uint8_t* data,
+        size_t size) {
+    FileHeader header;
+    if (size < sizeof(header)) {
+        return nullptr;
+    }
+    memcpy(&header, data, sizeof(header));
+    const uint64_t recordsOffset = sizeof(FileHeader)
+            + uint64_t(header.slotCount) * sizeof(Slot);
+    if (header.magic != kMagic || header.version != kVersion || header.fileSize != size
+            || header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0
+            || recordsOffset > size) {
+        return nullptr;
+    }
+
+    MappedFile* file = new MappedFile();
+    file->slotCount = header.slotCount;
+    file->recordsOffset = recordsOffset;
+    file->used.reset(new std::atomic<bool>[header.slotCount]);
+    for (uint32_t i = 0; i < header.slotCount; i++) {
+        file->used[i].store(false, std::memory_order_relaxed);
+    }
+    return std::unique_ptr<Mapping>(file);
+}
+
+LayoutPiece ShapedWord::piece() const {
+    LayoutPiece piece;
+    piece.faces = faces.data();
+    piece.faceCount = faces.size();
+    piece.glyphs = glyphs.data();
+    piece.glyphCount = glyphs.size();
+    piece.advances = advances.data();
+    piece.advanceCount = advances.size();
+    piece.advance = advance;
+    piece.bounds = bounds;
+    return piece;
+}
+
+ShapingCache& ShapingCache::getInstance() {
+    static ShapingCache* sInstance = new ShapingCache();
+    return *sInstance;
+}
+
+void ShapingCache::clearPending() {
+    mPending.clear();
+    mPendingHashes.clear();
+}
+
+bool ShapingCache::hasPending() {
+    return !mPending.empty();
+}
+
+std::shared_ptr<const ShapingCache::CollectionInfo> ShapingCache::getCollectionInfo(
+        const std::shared_ptr<FontCollection>& collection) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mCollections.find(collection->getId());
+        if (it != mCollections.end()) {
+            return it->second;
+        }
+    }
+
+    std::shared_ptr<CollectionInfo> info = std::make_shared<CollectionInfo>();
+    uint64_t hash = FNV_HASH_SEED;
+    for (size_t i = 0; i < collection->getFamilyCount(); i++) {
+        const FontFamily& family = *collection->getFamilyAt(i);
+        hash = hashLanguages(hash, family.langId());
+        hash = hashValue(hash, int32_t(family.variant()));
+        for (size_t j = 0; j < family.getNumFonts(); j++) {
+            const FontStyle style = family.getStyle(j);
+            hash = hashValue(hash, int32_t(style.getWeight()));
+            hash = hashValue(hash, style.getItalic());
+            hash = hashFont(hash, family.getFont(j).get());
+            info->faces[family.getFont(j).get()] = uint32_t(i) << 16 | uint32_t(j);
+        }
+    }
+    info->fingerprint = hash;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mCollections.size() >= kMaxCollections) {
+        mCollections.clear();
+    }
+    mCollections[collection->getId()] = info;
+    return info;
+}
+
+ShapingCache::RecordHeader ShapingCache::makeKey(const CollectionInfo& info,
+        const LayoutCacheKey& key) {
+    const LayoutCacheKey::Fields& fields = key.mFields;
+    RecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.fingerprint = info.fingerprint;
+    header.languages = hashLanguages(FNV_HASH_SEED, fields.style.getLanguageListId());
+    header.style = fields.style.getWeight() | fields.style.getItalic() << 8
+            | fields.style.getVariant() << 16;
+    header.size = fields.size;
+    header.scaleX = fields.scaleX;
+    header.skewX = fields.skewX;
+    header.letterSpacing = fields.letterSpacing;
+    header.paintFlags = fields.paintFlags;
+    header.hyphenEdit = fields.hyphenEdit.getHyphen();
+    header.start = fields.start;
+    header.count = fields.count;
+    header.nchars = fields.nchars;
+    header.isRtl = fields.isRtl;
+    return header;
+}
+
+uint64_t ShapingCache::hashKey(const RecordHeader& header, const uint16_t* text) {
+    return hashBytes(hashBytes(FNV_HASH_SEED, &header, kKeySize), text,
+            header.nchars * sizeof(uint16_t));
+}
+
+bool ShapingCache::decode(const MappedFile& file, const Slot& slot, const RecordHeader& key,
+        const uint16_t* text, const FontCollection& collection, ShapedWord* word) {
+    if (!file.isValid(slot)) {
+        return false;
+    }
+    const uint8_t* record = file.data + slot.offset;
+    RecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    if (memcmp(&header, &key, kKeySize) != 0
+            || recordSize(header.faceCount, header.glyphCount, header.count, header.nchars)
+                    > slot.size) {
+        return false;
+    }
+    const uint8_t* faces = record + sizeof(RecordHeader);
+    const uint8_t* glyphs = faces + header.faceCount * sizeof(PackedFace);
+    const uint8_t* advances = glyphs + header.glyphCount * sizeof(PackedGlyph);
+    const uint8_t* chars = advances + header.count * sizeof(float);
+    if (memcmp(chars, text, header.nchars * sizeof(uint16_t)) != 0) {
+        return false;
+    }
+
+    word->faces.resize(header.faceCount);
+    for (uint32_t i = 0; i < header.faceCount; i++) {
+        PackedFace face;
+        memcpy(&face, faces + i * sizeof(PackedFace), sizeof(face));
+        if (face.family >= collection.getFamilyCount()
+                || face.font >= collection.getFamilyAt(face.family)->getNumFonts()) {
+            return false;
+        }
+        word->faces[i].font = collection.getFamilyAt(face.family)->getFont(face.font).get();
+        word->faces[i].fakery = FontFakery(face.fakeBold, face.fakeItalic);
+    }
+    word->glyphs.resize(header.glyphCount);
+    for (uint32_t i = 0; i < header.glyphCount; i++) {
+        PackedGlyph glyph;
+        memcpy(&glyph, glyphs + i * sizeof(PackedGlyph), sizeof(glyph));
+        if (glyph.face >= header.faceCount) {
+            return false;
+        }
+        word->glyphs[i] = { glyph.face, glyph.glyph, glyph.x, glyph.y };
+    }
+    word->advances.resize(header.count);
+    memcpy(word->advances.data(), advances, header.count * sizeof(float));
+    word->advance = header.advance;
+    word->bounds = { header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3] };
+    return true;
+}
+
+bool ShapingCache::find(const std::shared_ptr<FontCollection>& collection,
+        const LayoutCacheKey& key, ShapedWord* word) {
+    if (!isEnabled()) {
+        return false;
+    }
+    std::shared_ptr<MappedFile> file = std::static_pointer_cast<MappedFile>(getMapping());
+    if (file == nullptr) {
+        return false;
+    }
+    const RecordHeader header = makeKey(*getCollectionInfo(collection), key);
+    const uint64_t hash = hashKey(header, key.mChars);
+    const size_t mask = file->slotCount - 1;
+    for (size_t i = hash & mask, probes = 0; probes < file->slotCount;
+            i = (i + 1) & mask, probes++) {
+        const Slot slot = file->slotAt(i);
+        if (slot.offset == 0) {
+            break;
+        }
+        if (slot.hash == hash && decode(*file, slot, header, key.mChars, *collection, word)) {
+            file->used[i].store(true, std::memory_order_relaxed);
+            mHits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShapingCache::add(const std::shared_ptr<FontCollection>& collection,
+        const LayoutCacheKey& key, const LayoutPiece& piece) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::shared_ptr<const CollectionInfo> info = getCollectionInfo(collection);
+    RecordHeader header = makeKey(*info, key);
+    header.faceCount = piece.faceCount;
+    header.glyphCount = piece.glyphCount;
+    header.advance = piece.advance;
+    header.bounds[0] = piece.bounds.mLeft;
+    header.bounds[1] = piece.bounds.mTop;
+    header.bounds[2] = piece.bounds.mRight;
+    header.bounds[3] = piece.bounds.mBottom;
+
+    std::vector<uint8_t> data(size_t(recordSize(header.faceCount, header.glyphCount,
+            header.count, header.nchars)), 0);
+    uint8_t* p = data.data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (size_t i = 0; i < piece.faceCount; i++) {
+        auto it = info->faces.find(piece.faces[i].font);
+        if (it == info->faces.end()) {
+            return;
+        }
+        FontFakery fakery = piece.faces[i].fakery;
+        PackedFace face = { uint16_t(it->second >> 16), uint16_t(it->second & 0xffff),
+                fakery.isFakeBold(), fakery.isFakeItalic(), 0 };
+        memcpy(p, &face, sizeof(face));
+        p += sizeof(face);
+    }
+    for (size_t i = 0; i < piece.glyphCount; i++) {
+        const LayoutGlyph& glyph = piece.glyphs[i];
+        if (glyph.glyph_id > 0xffff || size_t(glyph.font_ix) >= piece.faceCount) {
+            return;
+        }
+        PackedGlyph packed = { uint16_t(glyph.font_ix), uint16_t(glyph.glyph_id), glyph.x,
+                glyph.y };
+        memcpy(p, &packed, sizeof(packed));
+        p += sizeof(packed);
+    }
+    memcpy(p, piece.advances, header.count * sizeof(float));
+    p += header.count * sizeof(float);
+    memcpy(p, key.mChars, header.nchars * sizeof(uint16_t));
+
+    const uint64_t hash = hashKey(header, key.mChars);
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mPending.size() >= kMaxPending || !mPendingHashes.insert(hash).second) {
+        return;
+    }
+    mPending.push_back({ hash, std::move(data) });
+    scheduleWrite();
+}
+
+bool ShapingCache::buildFile(const std::shared_ptr<Mapping>& current,
+        std::vector<uint8_t>* contents) {
+    std::shared_ptr<MappedFile> file = std::static_pointer_cast<MappedFile>(current);
+    std::vector<PendingRecord> pending;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        pending.swap(mPending);
+        mPendingHashes.clear();
+    }
+    if (pending.empty()) {
+        return false;
+    }
+
+    // New words first, then the ones found in the file, then the rest of the file
+    struct Record {
+        uint64_t hash;
+        const uint8_t* data;
+        uint32_t size;
+        uint64_t checksum;
+    };
+    std::vector<Record> records;
+    std::unordered_set<uint64_t> hashes;
+    size_t dataSize = 0;
+    auto addRecord = [&](uint64_t hash, const uint8_t* data, size_t size, uint64_t checksum) {
+        if (records.size() < kMaxRecords && dataSize + size <= kMaxFileSize
+                && hashes.insert(hash).second) {
+            records.push_back({ hash, data, uint32_t(size), checksum });
+            dataSize += size;
+        }
+    };
+    for (const PendingRecord& record : pending) {
+        addRecord(record.hash, record.data.data(), record.data.size(),
+                hashBytes(FNV_HASH_SEED, record.data.data(), record.data.size()));
+    }
+    if (file != nullptr) {
+        std::vector<Slot> unused;
+        for (uint32_t i = 0; i < file->slotCount; i++) {
+            const Slot slot = file->slotAt(i);
+            if (slot.offset == 0 || !file->isValid(slot)) {
+                continue;
+            }
+            if (file->used[i].load(std::memory_order_relaxed)) {
+                addRecord(slot.hash, file->data + slot.offset, slot.size, slot.checksum);
+            } else {
+                unused.push_back(slot);
+            }
+        }
+        for (const Slot& slot : unused) {
+            addRecord(slot.hash, file->data + slot.offset, slot.size, slot.checksum);
+        }
+    }
+
+    uint32_t slotCount = 64;
+    while (slotCount < records.size() * 2) {
+        slotCount *= 2;
+    }
+    std::vector<Slot> slots(slotCount);
+    memset(slots.data(), 0, slotCount * sizeof(Slot));
+    size_t offset = sizeof(FileHeader) + slotCount * sizeof(Slot);
+    for (const Record& record : records) {
+        size_t i = record.hash & (slotCount - 1);
+        while (slots[i].offset != 0) {
+            i = (i + 1) & (slotCount - 1);
+        }
+        slots[i] = { record.hash, uint32_t(offset), record.size, record.checksum };
+        offset += record.size;
+    }
+    const FileHeader header = { kMagic, kVersion, slotCount, uint32_t(records.size()), offset };
+
+    contents->resize(offset);
+    uint8_t* p = contents->data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, slots.data(), slotCount * sizeof(Slot));
+    p += slotCount * sizeof(Slot);
+    for (const Record& record : records) {
+        memcpy(p, record.data, record.size);
+        p += record.size;
+    }
+    return true;
+}
+
+}  // namespace minikin
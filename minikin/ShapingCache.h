@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MINIKIN_SHAPING_CACHE_H
+#define MINIKIN_SHAPING_CACHE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <minikin/Layout.h>
+#include "LayoutCache.h"
+#include "PersistentFile.h"
+
+namespace minikin {
+
+// A word read back from the shaping cache file, with its fonts found in the current collection
+struct ShapedWord {
+    std::vector<FakedFont> faces;
+    std::vector<LayoutGlyph> glyphs;
+    std::vector<float> advances;
+    float advance = 0;
+    MinikinRect bounds = {0, 0, 0, 0};
+
+    LayoutPiece piece() const;
+};
+
+/*
+ * Shaping results that outlive the process, so that a cold start doesn't shape the same UI
+ * strings again. The file is mapped when the layout cache first misses, and words shaped since
+ * are added to it as described in PersistentFile.
+ *
+ * Font collection ids and language list ids are only meaningful within a process, so records
+ * are keyed by a fingerprint of the fonts of the collection instead: their size, index,
+ * variation and 'head' table checksum and dates. Records of fonts that changed are then never
+ * found again, and age out of the file as new words are written.
+ */
+class ShapingCache : public PersistentFile {
+public:
+    static ShapingCache& getInstance();
+
+    // Fills word and returns true if the file has the shaping of the key
+    bool find(const std::shared_ptr<FontCollection>& collection, const LayoutCacheKey& key,
+            ShapedWord* word);
+
+    // Queues a word that was just shaped to be written to the file
+    void add(const std::shared_ptr<FontCollection>& collection, const LayoutCacheKey& key,
+            const LayoutPiece& piece);
+
+    uint64_t getHitCount() const { return mHits.load(std::memory_order_relaxed); }
+
+    // Start of a record in the file
+    struct RecordHeader;
+
+private:
+    struct MappedFile;
+    struct Slot;
+    struct CollectionInfo;
+    struct PendingRecord {
+        uint64_t hash;
+        std::vector<uint8_t> data;
+    };
+
+    ShapingCache() : PersistentFile("shaping cache") {}
+
+    static RecordHeader makeKey(const CollectionInfo& info, const LayoutCacheKey& key);
+    static uint64_t hashKey(const RecordHeader& header, const uint16_t* text);
+    static bool decode(const MappedFile& file, const Slot& slot, const RecordHeader& key,
+            const uint16_t* text, const FontCollection& collection, ShapedWord* word);
+
+    std::shared_ptr<const CollectionInfo> getCollectionInfo(
+            const std::shared_ptr<FontCollection>& collection);
+
+    std::unique_ptr<Mapping> openMapping(const uint8_t* data, size_t size) override;
+    void clearPending() override;
+    bool hasPending() override;
+    bool buildFile(const std::shared_ptr<Mapping>& current,
+            std::vector<uint8_t>* contents) override;
+
+    // Guarded by mLock
+    std::vector<PendingRecord> mPending;
+    std::unordered_set<uint64_t> mPendingHashes;
+    std::unordered_map<uint32_t, std::shared_ptr<const CollectionInfo>> mCollections;
+
+    std::atomic<uint64_t> mHits{0};
+};
+
+}  // namespace minikin
+
+#endif  // MINIKIN_SHAPING_CACHE_H
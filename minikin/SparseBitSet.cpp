@@ -17,6 +17,7 @@
 #define LOG_TAG "SparseBitSet"
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <log/log.h>
@@ -26,6 +27,17 @@
 namespace minikin {
 
 const uint32_t SparseBitSet::kNotFound;
+const size_t SparseBitSet::kMaxMaskSets;
+
+// Starts a serialized set, followed by the bitmaps, then the indices padded to 4 bytes. Fields
+// are in the byte order of the device.
+struct SerializedHeader {
+    uint32_t magic;
+    uint32_t maxVal;
+    uint32_t bitmapCount;
+    uint16_t zeroPageIndex;
+    uint16_t reserved;
+};
 
 uint32_t SparseBitSet::calcNumPages(const uint32_t* ranges, size_t nRanges) {
     bool haveZeroPage = false;
@@ -59,10 +71,20 @@ void SparseBitSet::initFromRanges(const uint32_t* ranges, size_t nRanges) {
     if (maxVal >= kMaximumCapacity) {
         return;
     }
+    const uint32_t nIndices = (maxVal + kPageMask) >> kLogValuesPerPage;
+    const uint32_t nPages = calcNumPages(ranges, nRanges);
+    const uint32_t bitmapCount = nPages << (kLogValuesPerPage - kLogBitsPerEl);
+    // The bitmaps and then the indices, in a single allocation
+    std::shared_ptr<void> storage(
+            calloc(1, bitmapCount * sizeof(element) + nIndices * sizeof(uint16_t)), free);
+    LOG_ALWAYS_FATAL_IF(storage == nullptr, "Failed to allocate a set of %u pages", nPages);
+    element* bitmaps = static_cast<element*>(storage.get());
+    uint16_t* indices = reinterpret_cast<uint16_t*>(bitmaps + bitmapCount);
     mMaxVal = maxVal;
-    mIndices.reset(new uint16_t[(mMaxVal + kPageMask) >> kLogValuesPerPage]);
-    uint32_t nPages = calcNumPages(ranges, nRanges);
-    mBitmaps.reset(new element[nPages << (kLogValuesPerPage - kLogBitsPerEl)]());
+    mIndices = indices;
+    mBitmaps = bitmaps;
+    mStorage = std::move(storage);
+    mBitmapCount = bitmapCount;
     mZeroPageIndex = noZeroPage;
     uint32_t nonzeroPageEnd = 0;
     uint32_t currentPage = 0;
@@ -78,27 +100,27 @@ void SparseBitSet::initFromRanges(const uint32_t* ranges, size_t nRanges) {
                     mZeroPageIndex = (currentPage++) << (kLogValuesPerPage - kLogBitsPerEl);
                 }
                 for (uint32_t j = nonzeroPageEnd; j < startPage; j++) {
-                    mIndices[j] = mZeroPageIndex;
+                    indices[j] = mZeroPageIndex;
                 }
             }
-            mIndices[startPage] = (currentPage++) << (kLogValuesPerPage - kLogBitsPerEl);
+            indices[startPage] = (currentPage++) << (kLogValuesPerPage - kLogBitsPerEl);
         }
 
         size_t index = ((currentPage - 1) << (kLogValuesPerPage - kLogBitsPerEl)) +
             ((start & kPageMask) >> kLogBitsPerEl);
         size_t nElements = (end - (start & ~kElMask) + kElMask) >> kLogBitsPerEl;
         if (nElements == 1) {
-            mBitmaps[index] |= (kElAllOnes >> (start & kElMask)) &
+            bitmaps[index] |= (kElAllOnes >> (start & kElMask)) &
                 (kElAllOnes << ((~end + 1) & kElMask));
         } else {
-            mBitmaps[index] |= kElAllOnes >> (start & kElMask);
+            bitmaps[index] |= kElAllOnes >> (start & kElMask);
             for (size_t j = 1; j < nElements - 1; j++) {
-                mBitmaps[index + j] = kElAllOnes;
+                bitmaps[index + j] = kElAllOnes;
             }
-            mBitmaps[index + nElements - 1] |= kElAllOnes << ((~end + 1) & kElMask);
+            bitmaps[index + nElements - 1] |= kElAllOnes << ((~end + 1) & kElMask);
         }
         for (size_t j = startPage + 1; j < endPage + 1; j++) {
-            mIndices[j] = (currentPage++) << (kLogValuesPerPage - kLogBitsPerEl);
+            indices[j] = (currentPage++) << (kLogValuesPerPage - kLogBitsPerEl);
         }
         nonzeroPageEnd = endPage + 1;
     }
@@ -143,4 +165,97 @@ uint32_t SparseBitSet::nextSetBit(uint32_t fromIndex) const {
     return kNotFound;
 }
 
+static size_t indicesSize(uint32_t maxVal, int logValuesPerPage) {
+    const size_t pageCount = (size_t(maxVal) + (1 << logValuesPerPage) - 1) >> logValuesPerPage;
+    return (pageCount * sizeof(uint16_t) + 3) & ~size_t(3);
+}
+
+size_t SparseBitSet::serializedSize() const {
+    return sizeof(SerializedHeader) + mBitmapCount * sizeof(element)
+            + indicesSize(mMaxVal, kLogValuesPerPage);
+}
+
+void SparseBitSet::serialize(uint8_t* out) const {
+    const SerializedHeader header = { kSerializedMagic, mMaxVal, mBitmapCount, mZeroPageIndex, 0 };
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, mBitmaps, mBitmapCount * sizeof(element));
+    out += mBitmapCount * sizeof(element);
+    const size_t pageCount = (mMaxVal + kPageMask) >> kLogValuesPerPage;
+    const size_t size = indicesSize(mMaxVal, kLogValuesPerPage);
+    memcpy(out, mIndices, pageCount * sizeof(uint16_t));
+    memset(out + pageCount * sizeof(uint16_t), 0, size - pageCount * sizeof(uint16_t));
+}
+
+bool SparseBitSet::initFromBuffer(std::shared_ptr<const void> storage, const uint8_t* data,
+        size_t size) {
+    *this = SparseBitSet();
+    SerializedHeader header;
+    if (size < sizeof(header) || (reinterpret_cast<uintptr_t>(data) & 3) != 0) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != kSerializedMagic || header.maxVal >= kMaximumCapacity
+            || header.bitmapCount > size / sizeof(element)
+            || size != sizeof(header) + header.bitmapCount * sizeof(element)
+                    + indicesSize(header.maxVal, kLogValuesPerPage)) {
+        return false;
+    }
+    const element* bitmaps = reinterpret_cast<const element*>(data + sizeof(header));
+    const uint16_t* indices = reinterpret_cast<const uint16_t*>(bitmaps + header.bitmapCount);
+    // Every page must be within the bitmaps, since get() doesn't check
+    const uint32_t elementsPerPage = 1 << (kLogValuesPerPage - kLogBitsPerEl);
+    const size_t pageCount = (header.maxVal + kPageMask) >> kLogValuesPerPage;
+    for (size_t i = 0; i < pageCount; i++) {
+        if (indices[i] % elementsPerPage != 0
+                || size_t(indices[i]) + elementsPerPage > header.bitmapCount) {
+            return false;
+        }
+    }
+    mMaxVal = header.maxVal;
+    mIndices = indices;
+    mBitmaps = bitmaps;
+    mStorage = std::move(storage);
+    mBitmapCount = header.bitmapCount;
+    mZeroPageIndex = header.zeroPageIndex;
+    return true;
+}
+
+void SparseBitSet::getCoverageMasks(const SparseBitSet* const* sets, size_t setCount,
+        const uint16_t* text, size_t length, uint32_t* masks) {
+    LOG_ALWAYS_FATAL_IF(setCount > kMaxMaskSets, "Too many sets: %zu", setCount);
+    static const element kEmptyPage[1 << (kLogValuesPerPage - kLogBitsPerEl)] = {};
+
+    // The bitmap of the page of the current code point in each set. Text mostly stays within a
+    // few pages, so they are only looked up again when the page changes.
+    const element* pages[kMaxMaskSets];
+    uint32_t currentPage = kNotFound;
+    size_t i = 0;
+    while (i < length) {
+        const size_t start = i;
+        uint32_t ch = text[i++];
+        if ((ch & 0xFC00) == 0xD800 && i < length && (text[i] & 0xFC00) == 0xDC00) {
+            ch = 0x10000 + ((ch - 0xD800) << 10) + (text[i] - 0xDC00);
+            masks[i++] = 0;
+        }
+        const uint32_t page = ch >> kLogValuesPerPage;
+        if (page != currentPage) {
+            for (size_t j = 0; j < setCount; j++) {
+                const SparseBitSet& set = *sets[j];
+                pages[j] = page < ((set.mMaxVal + kPageMask) >> kLogValuesPerPage)
+                        ? &set.mBitmaps[set.mIndices[page]] : kEmptyPage;
+            }
+            currentPage = page;
+        }
+        // Branch free, so that it vectorizes where gathers are available
+        const uint32_t offset = (ch & kPageMask) >> kLogBitsPerEl;
+        const uint32_t shift = kElMask - (ch & kElMask);
+        uint32_t mask = 0;
+        for (size_t j = 0; j < setCount; j++) {
+            mask |= ((pages[j][offset] >> shift) & 1) << j;
+        }
+        masks[start] = mask;
+    }
+}
+
 }  // namespace minikin
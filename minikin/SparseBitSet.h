@@ -34,7 +34,8 @@ namespace minikin {
 class SparseBitSet {
 public:
     // Create an empty bit set.
-    SparseBitSet() : mMaxVal(0) {}
+    SparseBitSet() : mMaxVal(0), mIndices(nullptr), mBitmaps(nullptr), mBitmapCount(0),
+            mZeroPageIndex(noZeroPage) {}
 
     // Initialize the set to a new value, represented by ranges. For
     // simplicity, these ranges are arranged as pairs of values,
@@ -65,6 +66,25 @@ public:
 
     static const uint32_t kNotFound = ~0u;
 
+    // The size of the serialized set, which is 4-byte aligned
+    size_t serializedSize() const;
+
+    // Writes serializedSize() bytes to out, in the form initFromBuffer reads.
+    void serialize(uint8_t* out) const;
+
+    // Reads a serialized set in place, without copying it, for instance from a mapped file.
+    // The data must be 4-byte aligned, and storage must keep it alive. Returns false, leaving
+    // the set empty, if the data isn't a valid set.
+    bool initFromBuffer(std::shared_ptr<const void> storage, const uint8_t* data, size_t size);
+
+    static const size_t kMaxMaskSets = 32;
+
+    // Tests every code point of the UTF-16 text against up to kMaxMaskSets sets at once: bit j
+    // of masks[i] is set if sets[j] contains the code point that starts at text[i]. The masks
+    // of trailing surrogates are zero. Unpaired surrogates are tested as themselves.
+    static void getCoverageMasks(const SparseBitSet* const* sets, size_t setCount,
+            const uint16_t* text, size_t length, uint32_t* masks);
+
 private:
     void initFromRanges(const uint32_t* ranges, size_t nRanges);
 
@@ -80,13 +100,18 @@ private:
     static const element kElFirst = ((element)1) << kElMask;
     static const uint16_t noZeroPage = 0xFFFF;
 
+    static const uint32_t kSerializedMagic = 0x53425331;  // "SBS1"
+
     static uint32_t calcNumPages(const uint32_t* ranges, size_t nRanges);
     static int CountLeadingZeros(element x);
 
     uint32_t mMaxVal;
 
-    std::unique_ptr<uint16_t[]> mIndices;
-    std::unique_ptr<element[]> mBitmaps;
+    // Point into mStorage, which is either owned by the set or a serialized set
+    const uint16_t* mIndices;
+    const element* mBitmaps;
+    std::shared_ptr<const void> mStorage;
+    uint32_t mBitmapCount;
     uint16_t mZeroPageIndex;
 
     // Forbid copy and assign.
@@ -11,8 +11,10 @@ HWUI_ENABLE_OPENGL_VALIDATION := false
 
 hwui_src_files := \
     hwui/Bitmap.cpp \
+    font/AtlasPacker.cpp \
     font/CacheTexture.cpp \
     font/Font.cpp \
+    font/GlyphRasterTask.cpp \
     hwui/Canvas.cpp \
     hwui/MinikinSkia.cpp \
     hwui/MinikinUtils.cpp \
@@ -36,6 +38,7 @@ hwui_src_files := \
     renderstate/RenderState.cpp \
     renderstate/Scissor.cpp \
     renderstate/Stencil.cpp \
+    renderstate/StreamingBuffer.cpp \
     renderstate/TextureState.cpp \
     renderthread/CanvasContext.cpp \
     renderthread/OpenGLPipeline.cpp \
@@ -63,6 +66,7 @@ hwui_src_files := \
     BakedOpDispatcher.cpp \
     BakedOpRenderer.cpp \
     BakedOpState.cpp \
+    CacheBudgetArbiter.cpp \
     Caches.cpp \
     CanvasState.cpp \
     ClipArea.cpp \
@@ -78,6 +82,7 @@ hwui_src_files := \
     FrameInfoVisualizer.cpp \
     GammaFontRenderer.cpp \
     GlLayer.cpp \
+    GlopBatch.cpp \
     GlopBuilder.cpp \
     GpuMemoryTracker.cpp \
     GradientCache.cpp \
@@ -132,6 +137,7 @@ hwui_test_common_src_files := \
 hwui_debug_common_src_files := \
     debug/wrap_gles.cpp \
     debug/DefaultGlesDriver.cpp \
+    debug/GlesAccountingDriver.cpp \
     debug/GlesErrorCheckWrapper.cpp \
     debug/GlesDriver.cpp \
     debug/FatalBaseDriver.cpp \
@@ -190,7 +196,8 @@ hwui_c_includes += \
     external/skia/src/utils \
     external/icu/icu4c/source/common \
     external/harfbuzz_ng/src \
-    external/freetype/include
+    external/freetype/include \
+    $(LOCAL_PATH)/../util
 
 # enable RENDERSCRIPT
 hwui_c_includes += \
@@ -279,25 +286,34 @@ LOCAL_C_INCLUDES := $(hwui_c_includes)
 
 LOCAL_SRC_FILES += \
     $(hwui_test_common_src_files) \
+    tests/macrobench/FrameReport.cpp \
     tests/unit/main.cpp \
+    tests/unit/AtlasPackerTests.cpp \
     tests/unit/BakedOpDispatcherTests.cpp \
     tests/unit/BakedOpRendererTests.cpp \
     tests/unit/BakedOpStateTests.cpp \
+    tests/unit/BlurTests.cpp \
+    tests/unit/BudgetedCacheTests.cpp \
     tests/unit/BitmapTests.cpp \
+    tests/unit/CacheBudgetArbiterTests.cpp \
     tests/unit/CanvasContextTests.cpp \
     tests/unit/CanvasStateTests.cpp \
     tests/unit/ClipAreaTests.cpp \
+    tests/unit/CoverageCacheTests.cpp \
     tests/unit/DamageAccumulatorTests.cpp \
     tests/unit/DeferredLayerUpdaterTests.cpp \
     tests/unit/DeviceInfoTests.cpp \
     tests/unit/FatVectorTests.cpp \
     tests/unit/FontRendererTests.cpp \
     tests/unit/FrameBuilderTests.cpp \
+    tests/unit/FrameReportTests.cpp \
+    tests/unit/GlesAccountingDriverTests.cpp \
     tests/unit/GlopBuilderTests.cpp \
     tests/unit/GpuMemoryTrackerTests.cpp \
     tests/unit/GradientCacheTests.cpp \
     tests/unit/GraphicsStatsServiceTests.cpp \
     tests/unit/LayerUpdateQueueTests.cpp \
+    tests/unit/LayoutCacheTests.cpp \
     tests/unit/LeakCheckTests.cpp \
     tests/unit/LinearAllocatorTests.cpp \
     tests/unit/MatrixTests.cpp \
@@ -315,10 +331,13 @@ LOCAL_SRC_FILES += \
     tests/unit/SkiaRenderPropertiesTests.cpp \
     tests/unit/SkiaCanvasTests.cpp \
     tests/unit/SnapshotTests.cpp \
+    tests/unit/SparseBitSetTests.cpp \
     tests/unit/StringUtilsTests.cpp \
+    tests/unit/TaskQueueTests.cpp \
     tests/unit/TestUtilsTests.cpp \
     tests/unit/TextDropShadowCacheTests.cpp \
     tests/unit/TextureCacheTests.cpp \
+    tests/unit/TraceTests.cpp \
     tests/unit/TypefaceTests.cpp \
     tests/unit/VectorDrawableTests.cpp \
 
@@ -344,6 +363,36 @@ LOCAL_SHARED_LIBRARIES := libmemunreachable
 
 LOCAL_SRC_FILES += \
     $(hwui_test_common_src_files) \
+    tests/macrobench/FrameReport.cpp \
+    tests/macrobench/TestSceneRunner.cpp \
+    tests/macrobench/main.cpp
+
+include $(LOCAL_PATH)/hwui_static_deps.mk
+include $(BUILD_NATIVE_BENCHMARK)
+
+# ------------------------
+# Headless macro-bench app
+# ------------------------
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/local/tmp
+LOCAL_MODULE:= hwuimacro_headless
+LOCAL_MODULE_TAGS := tests
+LOCAL_MULTILIB := both
+LOCAL_CFLAGS := \
+        $(hwui_cflags) \
+        -include debug/wrap_gles.h \
+        -DHWUI_NULL_GPU
+LOCAL_C_INCLUDES := $(hwui_c_includes)
+
+# Runs the scenes against NullGlesDriver and nullegl, so it doesn't need a GPU
+LOCAL_WHOLE_STATIC_LIBRARIES := libhwui_static_debug
+LOCAL_SHARED_LIBRARIES := libmemunreachable
+
+LOCAL_SRC_FILES += \
+    $(hwui_test_common_src_files) \
+    tests/macrobench/FrameReport.cpp \
     tests/macrobench/TestSceneRunner.cpp \
     tests/macrobench/main.cpp
 
@@ -370,14 +419,19 @@ LOCAL_SHARED_LIBRARIES := libmemunreachable
 LOCAL_SRC_FILES += \
     $(hwui_test_common_src_files) \
     tests/microbench/main.cpp \
+    tests/microbench/BlurBench.cpp \
     tests/microbench/DisplayListCanvasBench.cpp \
     tests/microbench/FontBench.cpp \
     tests/microbench/FrameBuilderBench.cpp \
+    tests/microbench/ItemizeBench.cpp \
+    tests/microbench/LayoutBench.cpp \
     tests/microbench/LinearAllocatorBench.cpp \
+    tests/microbench/MatrixBench.cpp \
     tests/microbench/PathParserBench.cpp \
     tests/microbench/RenderNodeBench.cpp \
     tests/microbench/ShadowBench.cpp \
-    tests/microbench/TaskManagerBench.cpp
+    tests/microbench/TaskManagerBench.cpp \
+    tests/microbench/TaskQueueBench.cpp
 
 
 include $(LOCAL_PATH)/hwui_static_deps.mk
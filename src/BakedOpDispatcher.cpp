@@ -80,7 +80,7 @@ void BakedOpDispatcher::onMergedBitmapOps(BakedOpRenderer& renderer,
             .build();
     ClipRect renderTargetClip(opList.clip);
     const ClipBase* clip = opList.clipSideFlags ? &renderTargetClip : nullptr;
-    renderer.renderGlop(nullptr, clip, glop);
+    renderer.renderBatchableGlop(nullptr, clip, glop);
 }
 
 
@@ -328,7 +328,7 @@ void BakedOpDispatcher::onBitmapOp(BakedOpRenderer& renderer, const BitmapOp& op
             .setTransform(state.computedState.transform, TransformFlags::None)
             .setModelViewMapUnitToRectSnap(Rect(texture->width(), texture->height()))
             .build();
-    renderer.renderGlop(state, glop);
+    renderer.renderBatchableGlop(state, glop);
 }
 
 void BakedOpDispatcher::onBitmapMeshOp(BakedOpRenderer& renderer, const BitmapMeshOp& op, const BakedOpState& state) {
@@ -419,7 +419,7 @@ void BakedOpDispatcher::onBitmapRectOp(BakedOpRenderer& renderer, const BitmapRe
             .setTransform(state.computedState.transform, TransformFlags::None)
             .setModelViewMapUnitToRectOptionalSnap(tryToSnap, op.unmappedBounds)
             .build();
-    renderer.renderGlop(state, glop);
+    renderer.renderBatchableGlop(state, glop);
 }
 
 void BakedOpDispatcher::onColorOp(BakedOpRenderer& renderer, const ColorOp& op, const BakedOpState& state) {
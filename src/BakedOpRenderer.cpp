@@ -42,6 +42,7 @@ void BakedOpRenderer::recycleTemporaryLayer(OffscreenBuffer* offscreenBuffer) {
 }
 
 void BakedOpRenderer::startRepaintLayer(OffscreenBuffer* offscreenBuffer, const Rect& repaintRect) {
+    flushGlopBatch();
     LOG_ALWAYS_FATAL_IF(mRenderTarget.offscreenBuffer, "already has layer...");
 
     // subtract repaintRect from region, since it will be regenerated
@@ -81,6 +82,7 @@ void BakedOpRenderer::startRepaintLayer(OffscreenBuffer* offscreenBuffer, const
 }
 
 void BakedOpRenderer::endLayer() {
+    flushGlopBatch();
     if (mRenderTarget.stencil) {
         // if stencil was used for clipping, detach it and return it to pool
         glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
@@ -101,6 +103,7 @@ void BakedOpRenderer::endLayer() {
 }
 
 OffscreenBuffer* BakedOpRenderer::copyToLayer(const Rect& area) {
+    flushGlopBatch(); // copy must include batched content
     const uint32_t width = area.getWidth();
     const uint32_t height = area.getHeight();
     OffscreenBuffer* buffer = mRenderState.layerPool().get(mRenderState, width, height);
@@ -115,6 +118,7 @@ OffscreenBuffer* BakedOpRenderer::copyToLayer(const Rect& area) {
 }
 
 void BakedOpRenderer::startFrame(uint32_t width, uint32_t height, const Rect& repaintRect) {
+    flushGlopBatch();
     LOG_ALWAYS_FATAL_IF(mRenderTarget.frameBufferId != 0, "primary framebufferId must be 0");
     mRenderState.bindFramebuffer(0);
     setViewport(width, height);
@@ -127,6 +131,7 @@ void BakedOpRenderer::startFrame(uint32_t width, uint32_t height, const Rect& re
 }
 
 void BakedOpRenderer::endFrame(const Rect& repaintRect) {
+    flushGlopBatch();
     if (CC_UNLIKELY(Properties::debugOverdraw)) {
         ClipRect overdrawClip(repaintRect);
         Rect viewportRect(mRenderTarget.viewportWidth, mRenderTarget.viewportHeight);
@@ -343,12 +348,36 @@ void BakedOpRenderer::prepareRender(const Rect* dirtyBounds, const ClipBase* cli
 
 void BakedOpRenderer::renderGlopImpl(const Rect* dirtyBounds, const ClipBase* clip,
         const Glop& glop) {
+    if (mGlopBatchable && Properties::batchGlops && mGlopBatch.canBatch(glop, clip)) {
+        if (!mGlopBatch.isCompatible(glop, clip)) {
+            flushGlopBatch();
+        }
+        if (dirtyBounds) {
+            dirtyRenderTarget(*dirtyBounds);
+        }
+        mGlopBatch.append(glop, clip);
+        return;
+    }
+
+    flushGlopBatch();
     prepareRender(dirtyBounds, clip);
     mRenderState.render(glop, mRenderTarget.orthoMatrix);
     if (!mRenderTarget.frameBufferId) mHasDrawn = true;
 }
 
+void BakedOpRenderer::flushGlopBatch() {
+    if (mGlopBatch.empty()) return;
+
+    // render target was already dirtied as each Glop was batched
+    ClipRect clip(mGlopBatch.getClipRect());
+    prepareRender(nullptr, mGlopBatch.hasClip() ? &clip : nullptr);
+    mRenderState.render(mGlopBatch.getGlop(), mRenderTarget.orthoMatrix);
+    if (!mRenderTarget.frameBufferId) mHasDrawn = true;
+    mGlopBatch.clear();
+}
+
 void BakedOpRenderer::renderFunctor(const FunctorOp& op, const BakedOpState& state) {
+    flushGlopBatch();
     prepareRender(&state.computedState.clippedBounds, state.computedState.getClipIfNeeded());
 
     DrawGlInfo info;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "BakedOpState.h"
+#include "GlopBatch.h"
 #include "Matrix.h"
 #include "utils/Macros.h"
 
@@ -60,6 +61,7 @@ public:
             , mRenderState(renderState)
             , mCaches(caches)
             , mOpaque(opaque)
+            , mGlopBatch(renderState)
             , mLightInfo(lightInfo) {
     }
 
@@ -87,6 +89,24 @@ public:
     void renderGlop(const Rect* dirtyBounds, const ClipBase* clip, const Glop& glop) {
         mGlopReceiver(*this, dirtyBounds, clip, glop);
     }
+
+    /**
+     * Like renderGlop(), but allows the Glop to be held and drawn together with following Glops
+     * of the same state, if it's a textured quad (see GlopBatch).
+     *
+     * Only for Glops with no side effects on other render state before they're drawn, and whose
+     * texture content doesn't change until the end of the frame (e.g. TextureCache bitmaps).
+     */
+    void renderBatchableGlop(const BakedOpState& state, const Glop& glop) {
+        renderBatchableGlop(&state.computedState.clippedBounds,
+                state.computedState.getClipIfNeeded(),
+                glop);
+    }
+    void renderBatchableGlop(const Rect* dirtyBounds, const ClipBase* clip, const Glop& glop) {
+        mGlopBatchable = true;
+        mGlopReceiver(*this, dirtyBounds, clip, glop);
+        mGlopBatchable = false;
+    }
     bool offscreenRenderTarget() { return mRenderTarget.offscreenBuffer != nullptr; }
     void dirtyRenderTarget(const Rect& dirtyRect);
     bool didDraw() const { return mHasDrawn; }
@@ -108,6 +128,7 @@ private:
         renderer.renderGlopImpl(dirtyBounds, clip, glop);
     }
     void renderGlopImpl(const Rect* dirtyBounds, const ClipBase* clip, const Glop& glop);
+    void flushGlopBatch();
     void setViewport(uint32_t width, uint32_t height);
     void clearColorBuffer(const Rect& clearRect);
     void prepareRender(const Rect* dirtyBounds, const ClipBase* clip);
@@ -120,6 +141,12 @@ private:
     bool mOpaque;
     bool mHasDrawn = false;
 
+    // Pending textured quads, drawn before any other rendering or render target change
+    GlopBatch mGlopBatch;
+
+    // True while the Glop being received was submitted with renderBatchableGlop()
+    bool mGlopBatchable = false;
+
     // render target state - setup by start/end layer/frame
     // only valid to use in between start/end pairs.
     struct {
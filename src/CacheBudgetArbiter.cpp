@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CacheBudgetArbiter.h"
+
+#include "GpuMemoryTracker.h"
+
+#include <algorithm>
+
+namespace android {
+namespace uirenderer {
+
+static CacheStats statsSince(const CacheStats& now, const CacheStats& start) {
+    CacheStats stats;
+    stats.hits = now.hits - start.hits;
+    stats.misses = now.misses - start.misses;
+    stats.evictions = now.evictions - start.evictions;
+    stats.ghostHits = now.ghostHits - start.ghostHits;
+    return stats;
+}
+
+float CacheBudgetArbiter::ClientState::getMarginalHitRate() const {
+    return lastWindow.ghostHits / float(std::max(client->getMaxSize(), 1u));
+}
+
+float CacheBudgetArbiter::ClientState::getHitsPerByte() const {
+    return lastWindow.hits / float(std::max(client->getSize(), 1u));
+}
+
+CacheBudgetArbiter::CacheBudgetArbiter(uint32_t totalBudget)
+        : mTotalBudget(totalBudget)
+        , mDerivedTotalBudget(totalBudget == 0) {
+}
+
+void CacheBudgetArbiter::addClient(const char* name, Client* client) {
+    const uint32_t baseBudget = client->getMaxSize();
+    mClients.push_back({ name, client, baseBudget, client->getStats(), CacheStats() });
+    mBaseBudget += baseBudget;
+    if (mDerivedTotalBudget) {
+        mTotalBudget = mBaseBudget + mBaseBudget / 4;
+    }
+}
+
+void CacheBudgetArbiter::frameCompleted() {
+    frameCompleted(std::max(0, GpuMemoryTracker::getTotalSize(GpuObjectType::Texture)));
+}
+
+void CacheBudgetArbiter::frameCompleted(uint32_t textureBytes) {
+    mFrameCount++;
+    mLastTextureBytes = textureBytes;
+
+    if (textureBytes > mTotalBudget) {
+        relievePressure(textureBytes - mTotalBudget);
+    }
+
+    if (mFrameCount % kFramesPerWindow == 0) {
+        for (ClientState& state : mClients) {
+            const CacheStats& stats = state.client->getStats();
+            state.lastWindow = statsSince(stats, state.windowStart);
+            state.windowStart = stats;
+        }
+        if (textureBytes < mTotalBudget) {
+            restoreBudget(mTotalBudget - textureBytes);
+        }
+        rebalance();
+    }
+}
+
+void CacheBudgetArbiter::relievePressure(uint32_t overshoot) {
+    std::vector<ClientState*> clients;
+    for (ClientState& state : mClients) {
+        clients.push_back(&state);
+    }
+    std::stable_sort(clients.begin(), clients.end(), [](ClientState* lhs, ClientState* rhs) {
+        return lhs->getHitsPerByte() < rhs->getHitsPerByte();
+    });
+
+    for (ClientState* state : clients) {
+        if (!overshoot) break;
+
+        const uint32_t size = state->client->getSize();
+        const uint32_t budget = state->client->getMaxSize();
+        if (size <= state->getMinBudget()) continue;
+
+        const uint32_t target = std::min(budget,
+                size - std::min(overshoot, size - state->getMinBudget()));
+        state->client->setMaxSize(target);
+
+        const uint32_t freed = size - std::min(size, state->client->getSize());
+        overshoot -= std::min(overshoot, freed);
+        if (budget > target) {
+            addDecision(DecisionType::Trim, state->name, nullptr, budget - target);
+        }
+    }
+}
+
+void CacheBudgetArbiter::restoreBudget(uint32_t headroom) {
+    const uint32_t allocated = getAllocatedBudget();
+    if (allocated >= mBaseBudget) return;
+
+    // Budget taken under pressure goes to the cache that would hit the most with it, or else
+    // back to the cache that lost the largest share of its base budget
+    ClientState* recipient = findRecipient();
+    if (!recipient) {
+        for (ClientState& state : mClients) {
+            const float share = state.client->getMaxSize() / float(std::max(state.baseBudget, 1u));
+            if (share < 1 && (!recipient || share < recipient->client->getMaxSize()
+                    / float(std::max(recipient->baseBudget, 1u)))) {
+                recipient = &state;
+            }
+        }
+    }
+    if (!recipient) return;
+
+    const uint32_t budget = recipient->client->getMaxSize();
+    const uint32_t bytes = std::min(std::min(mBaseBudget - allocated, headroom),
+            recipient->getMaxBudget() - std::min(budget, recipient->getMaxBudget()));
+    if (!bytes) return;
+
+    recipient->client->setMaxSize(budget + bytes);
+    addDecision(DecisionType::Restore, nullptr, recipient->name, bytes);
+}
+
+void CacheBudgetArbiter::rebalance() {
+    ClientState* recipient = findRecipient();
+    if (!recipient) return;
+
+    ClientState* donor = nullptr;
+    for (ClientState& state : mClients) {
+        if (&state == recipient || state.client->getMaxSize() <= state.getMinBudget()) continue;
+        if (!donor || state.getMarginalHitRate() < donor->getMarginalHitRate()) {
+            donor = &state;
+        }
+    }
+    if (!donor) return;
+
+    // Only move budget when it clearly pays off, so that it doesn't swing back and forth between
+    // caches with similar hit rates
+    if (recipient->getMarginalHitRate() <= 2 * donor->getMarginalHitRate()) return;
+
+    const uint32_t donorBudget = donor->client->getMaxSize();
+    const uint32_t recipientBudget = recipient->client->getMaxSize();
+    const uint32_t bytes = std::min(std::min(recipient->baseBudget / 8,
+            donorBudget - donor->getMinBudget()),
+            recipient->getMaxBudget() - recipientBudget);
+    if (!bytes) return;
+
+    donor->client->setMaxSize(donorBudget - bytes);
+    recipient->client->setMaxSize(recipientBudget + bytes);
+    addDecision(DecisionType::Rebalance, donor->name, recipient->name, bytes);
+}
+
+CacheBudgetArbiter::ClientState* CacheBudgetArbiter::findRecipient() {
+    ClientState* recipient = nullptr;
+    for (ClientState& state : mClients) {
+        if (!state.lastWindow.ghostHits
+                || state.client->getMaxSize() >= state.getMaxBudget()) continue;
+        if (!recipient || state.getMarginalHitRate() > recipient->getMarginalHitRate()) {
+            recipient = &state;
+        }
+    }
+    return recipient;
+}
+
+uint32_t CacheBudgetArbiter::getAllocatedBudget() const {
+    uint32_t allocated = 0;
+    for (const ClientState& state : mClients) {
+        allocated += state.client->getMaxSize();
+    }
+    return allocated;
+}
+
+void CacheBudgetArbiter::addDecision(DecisionType type, const char* from, const char* to,
+        uint32_t bytes) {
+    if (mDecisions.size() == kMaxDecisionCount) {
+        mDecisions.erase(mDecisions.begin());
+    }
+    mDecisions.push_back({ mFrameCount, type, from, to, bytes });
+}
+
+void CacheBudgetArbiter::dump(String8& log) const {
+    log.appendFormat("Cache budgets (textures %u / %u bytes, budgets %u / %u bytes):\n",
+            mLastTextureBytes, mTotalBudget, getAllocatedBudget(), mBaseBudget);
+    for (const ClientState& state : mClients) {
+        log.appendFormat("  %-20s %8u / %8u (base %u; last window: %u hits, %u misses,"
+                " %u ghost hits)\n", state.name, state.client->getSize(),
+                state.client->getMaxSize(), state.baseBudget, state.lastWindow.hits,
+                state.lastWindow.misses, state.lastWindow.ghostHits);
+    }
+    if (mDecisions.empty()) return;
+
+    log.appendFormat("  Recent decisions:\n");
+    for (const Decision& decision : mDecisions) {
+        switch (decision.type) {
+        case DecisionType::Rebalance:
+            log.appendFormat("    frame %u: moved %u bytes from %s to %s\n",
+                    decision.frame, decision.bytes, decision.from, decision.to);
+            break;
+        case DecisionType::Trim:
+            log.appendFormat("    frame %u: took %u bytes from %s, textures over budget\n",
+                    decision.frame, decision.bytes, decision.from);
+            break;
+        case DecisionType::Restore:
+            log.appendFormat("    frame %u: gave %u bytes back to %s\n",
+                    decision.frame, decision.bytes, decision.to);
+            break;
+        }
+    }
+}
+
+} // namespace uirenderer
+} // namespace android
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "utils/BudgetedCache.h"
+
+#include <utils/String8.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Shares a texture memory budget between caches.
+ *
+ * Every kFramesPerWindow frames, budget moves from the cache with the lowest marginal hit rate to
+ * the one with the highest. The marginal hit rate of a cache is estimated from its ghost hits per
+ * byte of budget: misses on recently evicted keys, which a larger budget would have turned into
+ * hits.
+ *
+ * When the textures tracked by GpuMemoryTracker go over the total budget, caches are shrunk,
+ * starting with the one holding the fewest hits per byte, and get their budget back once there
+ * is room again.
+ */
+class CacheBudgetArbiter {
+public:
+    class Client {
+    public:
+        virtual ~Client() {}
+
+        /**
+         * Returns the current size of the cache in bytes.
+         */
+        virtual uint32_t getSize() = 0;
+        /**
+         * Returns the budget of the cache in bytes.
+         */
+        virtual uint32_t getMaxSize() = 0;
+        /**
+         * Changes the budget of the cache, evicting entries to fit in it.
+         */
+        virtual void setMaxSize(uint32_t maxSize) = 0;
+        /**
+         * Returns the smallest budget the cache works with, which must hold its largest entry.
+         */
+        virtual uint32_t getMinSize() { return 0; }
+        virtual const CacheStats& getStats() = 0;
+    };
+
+    static const uint32_t kFramesPerWindow = 30;
+    static const size_t kMaxDecisionCount = 16;
+
+    /**
+     * The total budget covers all textures tracked by GpuMemoryTracker. If 0, it's the sum of
+     * the clients' budgets when added, plus a quarter for textures they don't own.
+     */
+    explicit CacheBudgetArbiter(uint32_t totalBudget = 0);
+
+    /**
+     * Adds a cache to arbitrate. Its budget when added is its base budget, and it stays between
+     * a quarter and four times that, but never below the cache's minimum size.
+     */
+    void addClient(const char* name, Client* client);
+
+    /**
+     * Call once per frame, after the frame's cache trimming.
+     */
+    void frameCompleted();
+    void frameCompleted(uint32_t textureBytes);
+
+    uint32_t getTotalBudget() const { return mTotalBudget; }
+
+    void dump(String8& log) const;
+
+private:
+    struct ClientState {
+        const char* name;
+        Client* client;
+        uint32_t baseBudget;
+        CacheStats windowStart;
+        CacheStats lastWindow;
+
+        uint32_t getMinBudget() const { return std::max(baseBudget / 4, client->getMinSize()); }
+        uint32_t getMaxBudget() const { return std::max(baseBudget * 4, client->getMinSize()); }
+        float getMarginalHitRate() const;
+        float getHitsPerByte() const;
+    };
+
+    enum class DecisionType {
+        Rebalance,
+        Trim,
+        Restore,
+    };
+
+    struct Decision {
+        uint32_t frame;
+        DecisionType type;
+        const char* from;
+        const char* to;
+        uint32_t bytes;
+    };
+
+    void relievePressure(uint32_t overshoot);
+    void restoreBudget(uint32_t headroom);
+    void rebalance();
+    ClientState* findRecipient();
+    uint32_t getAllocatedBudget() const;
+    void addDecision(DecisionType type, const char* from, const char* to, uint32_t bytes);
+
+    std::vector<ClientState> mClients;
+    uint32_t mTotalBudget;
+    const bool mDerivedTotalBudget;
+    // Sum of the clients' base budgets, which their budgets add up to unless under pressure
+    uint32_t mBaseBudget = 0;
+
+    uint32_t mFrameCount = 0;
+    uint32_t mLastTextureBytes = 0;
+    std::vector<Decision> mDecisions;
+};
+
+} // namespace uirenderer
+} // namespace android
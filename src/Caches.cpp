@@ -52,9 +52,14 @@ Caches* Caches::sInstance = nullptr;
 Caches::Caches(RenderState& renderState)
         : gradientCache(mExtensions)
         , programCache(mExtensions)
+        , budgetArbiter(Properties::textureBudget)
         , mRenderState(&renderState)
         , mInitialized(false) {
     INIT_LOGD("Creating OpenGL renderer caches");
+    budgetArbiter.addClient("TextureCache", &textureCache);
+    budgetArbiter.addClient("PathCache", &pathCache);
+    budgetArbiter.addClient("GradientCache", &gradientCache);
+    budgetArbiter.addClient("TextDropShadowCache", &dropShadowCache);
     init();
     initConstraints();
     initStaticProperties();
@@ -130,6 +135,7 @@ void Caches::setProgram(Program* program) {
         }
         if (program) {
             program->use();
+            mProgramSwitchCount++;
         }
         mProgram = program;
     }
@@ -160,8 +166,9 @@ void Caches::dumpMemoryUsage() {
 void Caches::dumpMemoryUsage(String8 &log) {
     uint32_t total = 0;
     log.appendFormat("Current memory usage / total memory usage (bytes):\n");
-    log.appendFormat("  TextureCache         %8d / %8d\n",
-            textureCache.getSize(), textureCache.getMaxSize());
+    log.appendFormat("  TextureCache         %8d / %8d (%u hits, %u misses)\n",
+            textureCache.getSize(), textureCache.getMaxSize(),
+            textureCache.getStats().hits, textureCache.getStats().misses);
     if (mRenderState) {
         int memused = 0;
         for (std::set<Layer*>::iterator it = mRenderState->mActiveLayers.begin();
@@ -178,13 +185,21 @@ void Caches::dumpMemoryUsage(String8 &log) {
         log.appendFormat("  Layers total   %8d (numLayers = %zu)\n",
                 memused, mRenderState->mActiveLayers.size());
         total += memused;
+
+        OffscreenBufferPool& layerPool = mRenderState->layerPool();
+        const OffscreenBufferPool::Stats& layerPoolStats = layerPool.getLastFrameStats();
+        log.appendFormat("  OffscreenBufferPool  %8d / %8d (last frame: %u hits, %u misses)\n",
+                layerPool.getSize(), layerPool.getMaxSize(),
+                layerPoolStats.hits, layerPoolStats.misses);
+        total += layerPool.getSize();
     }
     log.appendFormat("  RenderBufferCache    %8d / %8d\n",
             renderBufferCache.getSize(), renderBufferCache.getMaxSize());
     log.appendFormat("  GradientCache        %8d / %8d\n",
             gradientCache.getSize(), gradientCache.getMaxSize());
-    log.appendFormat("  PathCache            %8d / %8d\n",
-            pathCache.getSize(), pathCache.getMaxSize());
+    log.appendFormat("  PathCache            %8d / %8d (%u hits, %u misses)\n",
+            pathCache.getSize(), pathCache.getMaxSize(),
+            pathCache.getStats().hits, pathCache.getStats().misses);
     log.appendFormat("  TessellationCache    %8d / %8d\n",
             tessellationCache.getSize(), tessellationCache.getMaxSize());
     log.appendFormat("  TextDropShadowCache  %8d / %8d\n", dropShadowCache.getSize(),
@@ -192,6 +207,8 @@ void Caches::dumpMemoryUsage(String8 &log) {
 
     fontRenderer.dumpMemoryUsage(log);
 
+    budgetArbiter.dump(log);
+
     log.appendFormat("Other:\n");
     log.appendFormat("  FboCache             %8d / %8d\n",
             fboCache.getSize(), fboCache.getMaxSize());
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "CacheBudgetArbiter.h"
 #include "Extensions.h"
 #include "FboCache.h"
 #include "GammaFontRenderer.h"
@@ -158,6 +159,8 @@ public:
     TextDropShadowCache dropShadowCache;
     FboCache fboCache;
 
+    CacheBudgetArbiter budgetArbiter;
+
     GammaFontRenderer fontRenderer;
 
     TaskManager tasks;
@@ -172,6 +175,9 @@ public:
     void setProgram(const ProgramDescription& description);
     void setProgram(Program* program);
 
+    // Number of times setProgram() has changed the program in use
+    uint64_t getProgramSwitchCount() const { return mProgramSwitchCount; }
+
     const Extensions& extensions() const { return mExtensions; }
     Program& program() { return *mProgram; }
     PixelBufferState& pixelBufferState() { return *mPixelBufferState; }
@@ -200,6 +206,7 @@ private:
     PixelBufferState* mPixelBufferState = nullptr;
     TextureState* mTextureState = nullptr;
     Program* mProgram = nullptr; // note: object owned by ProgramCache
+    uint64_t mProgramSwitchCount = 0;
 
 }; // class Caches
 
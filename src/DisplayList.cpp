@@ -95,7 +95,11 @@ void DisplayList::updateChildren(std::function<void(RenderNode*)> updateFn) {
 
 bool DisplayList::prepareListAndChildren(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer,
         std::function<void(RenderNode*, TreeObserver&, TreeInfo&, bool)> childFn) {
-    info.prepareTextures = info.canvasContext.pinImages(bitmapResources);
+    if (info.deferImageUploads) {
+        info.prepareTextures = info.canvasContext.deferPinImages(bitmapResources);
+    } else {
+        info.prepareTextures = info.canvasContext.pinImages(bitmapResources);
+    }
 
     for (auto&& op : children) {
         RenderNode* childNode = op->renderNode;
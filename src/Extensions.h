@@ -38,6 +38,8 @@ public:
     inline bool hasPixelBufferObjects() const { return mVersionMajor >= 3; }
     inline bool hasOcclusionQueries() const { return mVersionMajor >= 3; }
     inline bool hasFloatTextures() const { return mVersionMajor >= 3; }
+    inline bool hasMapBufferRange() const { return mVersionMajor >= 3; }
+    inline bool hasBufferStorage() const { return hasMapBufferRange() && mHasBufferStorage; }
     inline bool hasSRGB() const { return mHasSRGB; }
     inline bool hasSRGBWriteControl() const { return hasSRGB() && mHasSRGBWriteControl; }
     inline bool hasLinearBlending() const { return hasSRGB() && mHasLinearBlending; }
@@ -53,6 +55,7 @@ private:
     bool mHas1BitStencil;
     bool mHas4BitStencil;
     bool mHasUnpackSubImage;
+    bool mHasBufferStorage;
     bool mHasSRGB;
     bool mHasSRGBWriteControl;
     bool mHasLinearBlending;
@@ -43,6 +43,15 @@ namespace uirenderer {
 // blur inputs smaller than this constant will bypass renderscript
 #define RS_MIN_INPUT_CUTOFF 10000
 
+// Glyphs not drawn for this many frames are evicted first when the cache fills up
+static const uint32_t kColdGlyphFrames = 60;
+
+// How often, in frames, nearly full cache textures are compacted
+static const uint32_t kCompactionInterval = 30;
+
+// Cache textures with less than this fraction of free space are considered nearly full
+static const float kCompactionFreeThreshold = 0.1f;
+
 ///////////////////////////////////////////////////////////////////////////////
 // TextSetupFunctor
 ///////////////////////////////////////////////////////////////////////////////
@@ -193,6 +202,134 @@ void FontRenderer::flushLargeCaches() {
     flushLargeCaches(mRGBACacheTextures);
 }
 
+bool FontRenderer::compactCacheTexture(CacheTexture* cacheTexture, uint32_t minLastUsedFrame) {
+    if (!cacheTexture->getPixelBuffer() || !cacheTexture->getGlyphCount()) {
+        return false;
+    }
+
+    std::vector<CachedGlyphInfo*> liveGlyphs;
+    bool evicted = false;
+    LruCache<Font::FontDescription, Font*>::Iterator it(mActiveFonts);
+    while (it.next()) {
+        const auto& cachedGlyphs = it.value()->mCachedGlyphs;
+        for (size_t i = 0; i < cachedGlyphs.size(); i++) {
+            CachedGlyphInfo* cachedGlyph = cachedGlyphs.valueAt(i);
+            if (!cachedGlyph->mIsValid || cachedGlyph->mCacheTexture != cacheTexture) continue;
+
+            if (cachedGlyph->mLastUsedFrame >= minLastUsedFrame) {
+                liveGlyphs.push_back(cachedGlyph);
+            } else {
+                cachedGlyph->mIsValid = false;
+                evicted = true;
+            }
+        }
+    }
+    if (!evicted) {
+        return false;
+    }
+
+    // Quads already in the mesh refer to the current glyph positions
+    issueDrawCommand();
+
+    // Copy the live glyphs out, then repack them into the emptied texture, tallest first
+    std::sort(liveGlyphs.begin(), liveGlyphs.end(),
+            [](const CachedGlyphInfo* lhs, const CachedGlyphInfo* rhs) {
+        return lhs->mBitmapHeight > rhs->mBitmapHeight;
+    });
+
+    PixelBuffer* pixelBuffer = cacheTexture->getPixelBuffer();
+    const uint32_t formatSize = PixelBuffer::formatSize(cacheTexture->getFormat());
+    size_t liveSize = 0;
+    for (const CachedGlyphInfo* cachedGlyph : liveGlyphs) {
+        liveSize += cachedGlyph->mBitmapWidth * cachedGlyph->mBitmapHeight * formatSize;
+    }
+    std::unique_ptr<uint8_t[]> liveImages(new uint8_t[liveSize]);
+
+    uint8_t* cacheBuffer = pixelBuffer->map();
+    uint8_t* image = liveImages.get();
+    for (const CachedGlyphInfo* cachedGlyph : liveGlyphs) {
+        const size_t rowSize = cachedGlyph->mBitmapWidth * formatSize;
+        for (uint32_t y = 0; y < cachedGlyph->mBitmapHeight; y++) {
+            memcpy(image, &cacheBuffer[cacheTexture->getOffset(cachedGlyph->mStartX,
+                    cachedGlyph->mStartY + y)], rowSize);
+            image += rowSize;
+        }
+    }
+
+    // clearing the buffer also writes the glyph borders
+    memset(cacheBuffer, 0, pixelBuffer->getSize());
+    cacheTexture->reset();
+#ifdef BUGREPORT_FONT_CACHE_USAGE
+    mHistoryTracker.glyphsCleared(cacheTexture);
+#endif
+
+    const float cacheWidth = cacheTexture->getWidth();
+    const float cacheHeight = cacheTexture->getHeight();
+    image = liveImages.get();
+    for (CachedGlyphInfo* cachedGlyph : liveGlyphs) {
+        const size_t rowSize = cachedGlyph->mBitmapWidth * formatSize;
+        uint32_t startX = 0;
+        uint32_t startY = 0;
+        if (cacheTexture->fitRect(cachedGlyph->mBitmapWidth + TEXTURE_BORDER_SIZE,
+                cachedGlyph->mBitmapHeight + TEXTURE_BORDER_SIZE, &startX, &startY)) {
+            for (uint32_t y = 0; y < cachedGlyph->mBitmapHeight; y++) {
+                memcpy(&cacheBuffer[cacheTexture->getOffset(startX, startY + y)],
+                        image + y * rowSize, rowSize);
+            }
+            cachedGlyph->mStartX = startX;
+            cachedGlyph->mStartY = startY;
+            cachedGlyph->mBitmapMinU = startX / cacheWidth;
+            cachedGlyph->mBitmapMinV = startY / cacheHeight;
+            cachedGlyph->mBitmapMaxU = (startX + cachedGlyph->mBitmapWidth) / cacheWidth;
+            cachedGlyph->mBitmapMaxV = (startY + cachedGlyph->mBitmapHeight) / cacheHeight;
+#ifdef BUGREPORT_FONT_CACHE_USAGE
+            mHistoryTracker.glyphUploaded(cacheTexture, startX, startY,
+                    cachedGlyph->mBitmapWidth, cachedGlyph->mBitmapHeight);
+#endif
+        } else {
+            // packed in a different order, the live glyphs may no longer all fit
+            cachedGlyph->mIsValid = false;
+        }
+        image += rowSize * cachedGlyph->mBitmapHeight;
+    }
+
+    cacheTexture->markDirty();
+    setTextureDirty();
+    return true;
+}
+
+bool FontRenderer::evictGlyphs(std::vector<CacheTexture*>& cacheTextures,
+        uint32_t minLastUsedFrame) {
+    bool evicted = false;
+    for (CacheTexture* cacheTexture : cacheTextures) {
+        evicted |= compactCacheTexture(cacheTexture, minLastUsedFrame);
+    }
+    return evicted;
+}
+
+void FontRenderer::frameCompleted() {
+    mFrameCount++;
+#ifdef BUGREPORT_FONT_CACHE_USAGE
+    mHistoryTracker.frameCompleted();
+#endif
+
+    if (!mInitialized || mFrameCount < kColdGlyphFrames || mFrameCount % kCompactionInterval) {
+        return;
+    }
+
+    // Make room ahead of time in nearly full textures, so that drawing new glyphs doesn't
+    // have to evict glyphs mid-frame
+    for (auto cacheTextures : { &mACacheTextures, &mRGBACacheTextures }) {
+        for (CacheTexture* cacheTexture : *cacheTextures) {
+            PixelBuffer* pixelBuffer = cacheTexture->getPixelBuffer();
+            if (pixelBuffer && cacheTexture->calculateFreeMemory()
+                    < pixelBuffer->getSize() * kCompactionFreeThreshold) {
+                compactCacheTexture(cacheTexture, mFrameCount - kColdGlyphFrames);
+            }
+        }
+    }
+}
+
 CacheTexture* FontRenderer::cacheBitmapInTexture(std::vector<CacheTexture*>& cacheTextures,
         const SkGlyph& glyph, uint32_t* startX, uint32_t* startY) {
     for (uint32_t i = 0; i < cacheTextures.size(); i++) {
@@ -252,10 +389,21 @@ void FontRenderer::cacheBitmap(const SkGlyph& glyph, CachedGlyphInfo* cachedGlyp
 
     if (!cacheTexture) {
         if (!precaching) {
-            // If the new glyph didn't fit and we are not just trying to precache it,
-            // clear out the cache and try again
-            flushAllAndInvalidate();
-            cacheTexture = cacheBitmapInTexture(*cacheTextures, glyph, &startX, &startY);
+            // If the new glyph didn't fit and we are not just trying to precache it, evict cold
+            // glyphs, then any glyphs not drawn in this frame, and try again. Only if the frame's
+            // own glyphs don't fit, clear out the cache.
+            const uint32_t coldFrame = mFrameCount > kColdGlyphFrames
+                    ? mFrameCount - kColdGlyphFrames : 0;
+            for (uint32_t minLastUsedFrame : { coldFrame, mFrameCount }) {
+                if (evictGlyphs(*cacheTextures, minLastUsedFrame)) {
+                    cacheTexture = cacheBitmapInTexture(*cacheTextures, glyph, &startX, &startY);
+                    if (cacheTexture) break;
+                }
+            }
+            if (!cacheTexture) {
+                flushAllAndInvalidate();
+                cacheTexture = cacheBitmapInTexture(*cacheTextures, glyph, &startX, &startY);
+            }
         }
 
         if (!cacheTexture) {
@@ -678,6 +826,11 @@ bool FontRenderer::renderTextOnPath(const SkPaint* paint, const Rect* clip, cons
 
 void FontRenderer::blurImage(uint8_t** image, int32_t width, int32_t height, float radius) {
     uint32_t intRadius = Blur::convertRadiusToInt(radius);
+    if (intRadius >= Blur::kMinTripleBoxRadius) {
+        Blur::tripleBox(radius, *image, width, height);
+        return;
+    }
+
     std::unique_ptr<float[]> gaussian(new float[2 * intRadius + 1]);
     Blur::generateGaussianWeights(gaussian.get(), radius);
 
@@ -731,7 +884,10 @@ static void dumpTextures(String8& log, const char* tag,
         if (cacheTexture && cacheTexture->getPixelBuffer()) {
             uint32_t free = cacheTexture->calculateFreeMemory();
             uint32_t total = cacheTexture->getPixelBuffer()->getSize();
-            log.appendFormat("    %-4s texture %d     %8d / %8d\n", tag, i, total - free, total);
+            log.appendFormat("    %-4s texture %d     %8d / %8d, %4d glyphs, %.2f%% occupied,"
+                    " %.2f%% fragmented\n", tag, i, total - free, total,
+                    cacheTexture->getGlyphCount(), cacheTexture->getOccupancy() * 100.0f,
+                    cacheTexture->getFragmentation() * 100.0f);
         }
     }
 }
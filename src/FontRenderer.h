@@ -20,6 +20,7 @@
 #include "font/CacheTexture.h"
 #include "font/CachedGlyphInfo.h"
 #include "font/Font.h"
+#include "font/GlyphRasterTask.h"
 #ifdef BUGREPORT_FONT_CACHE_USAGE
 #include "font/FontCacheHistoryTracker.h"
 #endif
@@ -121,12 +122,19 @@ public:
     uint32_t getSize() const;
     void dumpMemoryUsage(String8& log) const;
 
+    /**
+     * Ages cached glyphs, and compacts nearly full cache textures by evicting glyphs that haven't
+     * been drawn recently. Called once the frame has been drawn.
+     */
+    void frameCompleted();
+
 #ifdef BUGREPORT_FONT_CACHE_USAGE
     FontCacheHistoryTracker& historyTracker() { return mHistoryTracker; }
 #endif
 
 private:
     friend class Font;
+    friend class TestUtils; // allow TestUtils to look up cached glyphs and compact textures
 
     const uint8_t* mGammaTable;
 
@@ -140,6 +148,8 @@ private:
             uint32_t* startX, uint32_t* startY);
 
     void flushAllAndInvalidate();
+    bool evictGlyphs(std::vector<CacheTexture*>& cacheTextures, uint32_t minLastUsedFrame);
+    bool compactCacheTexture(CacheTexture* cacheTexture, uint32_t minLastUsedFrame);
 
     void checkInit();
     void initRender(const Rect* clip, Rect* bounds, TextDrawFunctor* functor);
@@ -194,6 +204,12 @@ private:
 
     bool mLinearFiltering;
 
+    // Number of frames completed, which CachedGlyphInfo::mLastUsedFrame is relative to
+    uint32_t mFrameCount = 0;
+
+    // Rasterizes glyphs for Font::precache() on the TaskManager, created on first use
+    sp<GlyphRasterProcessor> mGlyphRasterProcessor;
+
 #ifdef BUGREPORT_FONT_CACHE_USAGE
     FontCacheHistoryTracker mHistoryTracker;
 #endif
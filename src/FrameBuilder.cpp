@@ -16,12 +16,16 @@
 
 #include "FrameBuilder.h"
 
+#include "Caches.h"
 #include "DeferredLayerUpdater.h"
 #include "LayerUpdateQueue.h"
+#include "Properties.h"
 #include "RenderNode.h"
 #include "VectorDrawable.h"
 #include "renderstate/OffscreenBufferPool.h"
 #include "hwui/Canvas.h"
+#include "thread/Task.h"
+#include "thread/TaskProcessor.h"
 #include "utils/FatVector.h"
 #include "utils/PaintUtils.h"
 #include "utils/TraceUtils.h"
@@ -74,7 +78,57 @@ FrameBuilder::FrameBuilder(const LayerUpdateQueue& layers,
     deferLayers(layers);
 }
 
+FrameBuilder::FrameBuilder(const LightGeometry& lightGeometry, Caches& caches,
+        Mutex& sharedStateLock)
+        : mStdAllocator(mAllocator)
+        , mLayerBuilders(mStdAllocator)
+        , mLayerStack(mStdAllocator)
+        , mCanvasState(*this)
+        , mCaches(caches)
+        , mLightRadius(lightGeometry.radius)
+        , mDrawFbo0(false)
+        , mSharedStateLock(&sharedStateLock) {
+    // Prepare to defer Fbo0 (which will be empty, and is dropped when joining)
+    auto fbo0 = mAllocator.create<LayerBuilder>(1, 1, Rect(1, 1));
+    mLayerBuilders.push_back(fbo0);
+    mLayerStack.push_back(0);
+    mCanvasState.initializeSaveStack(1, 1,
+            0, 0, 1, 1,
+            lightGeometry.center);
+}
+
+class FrameBuilder::LayerDeferTask : public Task<bool> {
+public:
+    LayerDeferTask(FrameBuilder* builder, RenderNode* layerNode, const Rect& damage)
+            : builder(builder)
+            , layerNode(layerNode)
+            , damage(damage) {}
+
+    FrameBuilder* builder;
+    RenderNode* layerNode;
+    Rect damage;
+};
+
+class FrameBuilder::LayerDeferProcessor : public TaskProcessor<bool> {
+public:
+    explicit LayerDeferProcessor(TaskManager* taskManager)
+            : TaskProcessor<bool>(taskManager) {}
+
+    virtual void onProcess(const sp<Task<bool> >& task) override {
+        LayerDeferTask* t = static_cast<LayerDeferTask*>(task.get());
+        t->builder->deferLayer(*(t->layerNode), t->damage);
+        t->setResult(true);
+    }
+};
+
 void FrameBuilder::deferLayers(const LayerUpdateQueue& layers) {
+    if (Properties::parallelLayerDeferral
+            && layers.entries().size() > 1
+            && mCaches.tasks.canRunTasks()) {
+        deferLayersConcurrently(layers);
+        return;
+    }
+
     // Render all layers to be updated, in order. Defer in reverse order, so that they'll be
     // updated in the order they're passed in (mLayerBuilders are issued to Renderer in reverse)
     for (int i = layers.entries().size() - 1; i >= 0; i--) {
@@ -82,28 +136,69 @@ void FrameBuilder::deferLayers(const LayerUpdateQueue& layers) {
         // only schedule repaint if node still on layer - possible it may have been
         // removed during a dropped frame, but layers may still remain scheduled so
         // as not to lose info on what portion is damaged
-        OffscreenBuffer* layer = layerNode->getLayer();
-        if (CC_LIKELY(layer)) {
-            ATRACE_FORMAT("Optimize HW Layer DisplayList %s %ux%u",
-                    layerNode->getName(), layerNode->getWidth(), layerNode->getHeight());
-
-            Rect layerDamage = layers.entries()[i].damage;
-            // TODO: ensure layer damage can't be larger than layer
-            layerDamage.doIntersect(0, 0, layer->viewportWidth, layer->viewportHeight);
+        if (CC_LIKELY(layerNode->getLayer())) {
             layerNode->computeOrdering();
+            deferLayer(*layerNode, layers.entries()[i].damage);
+        }
+    }
+}
 
-            // map current light center into RenderNode's coordinate space
-            Vector3 lightCenter = mCanvasState.currentSnapshot()->getRelativeLightCenter();
-            layer->inverseTransformInWindow.mapPoint3d(lightCenter);
+void FrameBuilder::deferLayer(RenderNode& layerNode, const Rect& damage) {
+    OffscreenBuffer* layer = layerNode.getLayer();
+    ATRACE_FORMAT("Optimize HW Layer DisplayList %s %ux%u",
+            layerNode.getName(), layerNode.getWidth(), layerNode.getHeight());
 
-            saveForLayer(layerNode->getWidth(), layerNode->getHeight(), 0, 0,
-                    layerDamage, lightCenter, nullptr, layerNode);
+    Rect layerDamage = damage;
+    // TODO: ensure layer damage can't be larger than layer
+    layerDamage.doIntersect(0, 0, layer->viewportWidth, layer->viewportHeight);
 
-            if (layerNode->getDisplayList()) {
-                deferNodeOps(*layerNode);
-            }
-            restoreForLayer();
+    // map current light center into RenderNode's coordinate space
+    Vector3 lightCenter = mCanvasState.currentSnapshot()->getRelativeLightCenter();
+    layer->inverseTransformInWindow.mapPoint3d(lightCenter);
+
+    saveForLayer(layerNode.getWidth(), layerNode.getHeight(), 0, 0,
+            layerDamage, lightCenter, nullptr, &layerNode);
+
+    if (layerNode.getDisplayList()) {
+        deferNodeOps(layerNode);
+    }
+    restoreForLayer();
+}
+
+void FrameBuilder::deferLayersConcurrently(const LayerUpdateQueue& layers) {
+    ATRACE_NAME("Defer HW Layers Concurrently");
+    LightGeometry lightGeometry = {
+            mCanvasState.currentSnapshot()->getRelativeLightCenter(), mLightRadius };
+    Mutex sharedStateLock;
+    sp<LayerDeferProcessor> processor = new LayerDeferProcessor(&mCaches.tasks);
+    std::vector<sp<LayerDeferTask>> tasks;
+
+    // Each layer is deferred by its own FrameBuilder, in the order deferLayers() would use.
+    // Ordering mutates the RenderNodes, so it is computed up front on this thread.
+    for (int i = layers.entries().size() - 1; i >= 0; i--) {
+        RenderNode* layerNode = layers.entries()[i].renderNode.get();
+        if (CC_LIKELY(layerNode->getLayer())) {
+            layerNode->computeOrdering();
+            mWorkerBuilders.emplace_back(new FrameBuilder(lightGeometry, mCaches, sharedStateLock));
+            tasks.emplace_back(new LayerDeferTask(mWorkerBuilders.back().get(),
+                    layerNode, layers.entries()[i].damage));
+        }
+    }
+    for (auto& task : tasks) {
+        processor->add(task);
+    }
+
+    // Join, appending each worker's layers (but not its empty Fbo0) in deferral order
+    for (auto& task : tasks) {
+        task->getResult();
+        FrameBuilder& builder = *(task->builder);
+        for (size_t i = 1; i < builder.mLayerBuilders.size(); i++) {
+            mLayerBuilders.push_back(builder.mLayerBuilders[i]);
         }
+        for (auto& request : builder.mPendingCacheRequests) {
+            request(mCaches);
+        }
+        builder.mPendingCacheRequests.clear();
     }
 }
 
@@ -449,15 +544,18 @@ void FrameBuilder::deferShadow(const ClipBase* reorderClip, const RenderNodeOp&
         node.applyViewPropertyTransforms(shadowMatrixXY, false);
         node.applyViewPropertyTransforms(shadowMatrixZ, true);
 
-        sp<TessellationCache::ShadowTask> task = mCaches.tessellationCache.getShadowTask(
-                mCanvasState.currentTransform(),
-                mCanvasState.getLocalClipBounds(),
-                casterAlpha >= 1.0f,
-                casterPath,
-                &shadowMatrixXY, &shadowMatrixZ,
-                mCanvasState.currentSnapshot()->getRelativeLightCenter(),
-                mLightRadius);
+        // shadow task is resolved by requestCaches, possibly after the op has been deferred
+        sp<TessellationCache::ShadowTask> task;
         ShadowOp* shadowOp = mAllocator.create<ShadowOp>(task, casterAlpha);
+        const Matrix4 drawTransform(*mCanvasState.currentTransform());
+        const Rect localClip = mCanvasState.getLocalClipBounds();
+        const Vector3 lightCenter = mCanvasState.currentSnapshot()->getRelativeLightCenter();
+        const float lightRadius = mLightRadius;
+        requestCaches([=](Caches& caches) {
+            shadowOp->shadowTask = caches.tessellationCache.getShadowTask(
+                    &drawTransform, localClip, casterAlpha >= 1.0f, casterPath,
+                    &shadowMatrixXY, &shadowMatrixZ, lightCenter, lightRadius);
+        });
         BakedOpState* bakedOpState = BakedOpState::tryShadowOpConstruct(
                 mAllocator, *mCanvasState.writableSnapshot(), shadowOp);
         if (CC_LIKELY(bakedOpState)) {
@@ -638,7 +736,10 @@ void FrameBuilder::deferBitmapRectOp(const BitmapRectOp& op) {
 }
 
 void FrameBuilder::deferVectorDrawableOp(const VectorDrawableOp& op) {
+    // VectorDrawables may be drawn by several layers being deferred concurrently
+    if (CC_UNLIKELY(mSharedStateLock)) mSharedStateLock->lock();
     Bitmap& bitmap = op.vectorDrawable->getBitmapUpdateIfDirty();
+    if (CC_UNLIKELY(mSharedStateLock)) mSharedStateLock->unlock();
     SkPaint* paint = op.vectorDrawable->getPaint();
     const BitmapRectOp* resolvedOp = mAllocator.create_trivial<BitmapRectOp>(op.unmappedBounds,
             op.localMatrix,
@@ -688,7 +789,9 @@ void FrameBuilder::deferOvalOp(const OvalOp& op) {
 void FrameBuilder::deferPathOp(const PathOp& op) {
     auto state = deferStrokeableOp(op, OpBatchType::AlphaMaskTexture);
     if (CC_LIKELY(state)) {
-        mCaches.pathCache.precache(op.path, op.paint);
+        requestCaches([&op](Caches& caches) {
+            caches.pathCache.precache(op.path, op.paint);
+        });
     }
 }
 
@@ -705,8 +808,10 @@ void FrameBuilder::deferRoundRectOp(const RoundRectOp& op) {
     auto state = deferStrokeableOp(op, tessBatchId(op));
     if (CC_LIKELY(state && !op.paint->getPathEffect())) {
         // TODO: consider storing tessellation task in BakedOpState
-        mCaches.tessellationCache.precacheRoundRect(state->computedState.transform, *(op.paint),
-                op.unmappedBounds.getWidth(), op.unmappedBounds.getHeight(), op.rx, op.ry);
+        requestCaches([&op, state](Caches& caches) {
+            caches.tessellationCache.precacheRoundRect(state->computedState.transform, *(op.paint),
+                    op.unmappedBounds.getWidth(), op.unmappedBounds.getHeight(), op.rx, op.ry);
+        });
     }
 }
 
@@ -748,18 +853,20 @@ void FrameBuilder::deferTextOp(const TextOp& op) {
         currentLayer().deferUnmergeableOp(mAllocator, bakedState, batchId);
     }
 
-    FontRenderer& fontRenderer = mCaches.fontRenderer.getFontRenderer();
     auto& totalTransform = bakedState->computedState.transform;
-    if (totalTransform.isPureTranslate() || totalTransform.isPerspective()) {
-        fontRenderer.precache(op.paint, op.glyphs, op.glyphCount, SkMatrix::I());
-    } else {
+    SkMatrix precacheMatrix = SkMatrix::I();
+    if (!totalTransform.isPureTranslate() && !totalTransform.isPerspective()) {
         // Partial transform case, see BakedOpDispatcher::renderTextOp
         float sx, sy;
         totalTransform.decomposeScale(sx, sy);
-        fontRenderer.precache(op.paint, op.glyphs, op.glyphCount, SkMatrix::MakeScale(
+        precacheMatrix = SkMatrix::MakeScale(
                 roundf(std::max(1.0f, sx)),
-                roundf(std::max(1.0f, sy))));
+                roundf(std::max(1.0f, sy)));
     }
+    requestCaches([&op, precacheMatrix](Caches& caches) {
+        caches.fontRenderer.getFontRenderer().precache(
+                op.paint, op.glyphs, op.glyphCount, precacheMatrix);
+    });
 }
 
 void FrameBuilder::deferTextOnPathOp(const TextOnPathOp& op) {
@@ -767,8 +874,10 @@ void FrameBuilder::deferTextOnPathOp(const TextOnPathOp& op) {
     if (!bakedState) return; // quick rejected
     currentLayer().deferUnmergeableOp(mAllocator, bakedState, textBatchId(*(op.paint)));
 
-    mCaches.fontRenderer.getFontRenderer().precache(
-            op.paint, op.glyphs, op.glyphCount, SkMatrix::I());
+    requestCaches([&op](Caches& caches) {
+        caches.fontRenderer.getFontRenderer().precache(
+                op.paint, op.glyphs, op.glyphCount, SkMatrix::I());
+    });
 }
 
 void FrameBuilder::deferTextureLayerOp(const TextureLayerOp& op) {
@@ -982,6 +1091,13 @@ void FrameBuilder::deferEndUnclippedLayerOp(const EndUnclippedLayerOp& /* ignore
 
 void FrameBuilder::finishDefer() {
     mCaches.fontRenderer.endPrecaching();
+
+    for (auto& layerBuilder : mLayerBuilders) {
+        mCulledOpCount += layerBuilder->cullOccludedOps();
+        if (Properties::sortBatches) {
+            layerBuilder->sortBatchesByState();
+        }
+    }
 }
 
 } // namespace uirenderer
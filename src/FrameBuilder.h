@@ -23,6 +23,10 @@
 #include "RecordedOp.h"
 #include "utils/GLUtils.h"
 
+#include <utils/Mutex.h>
+
+#include <functional>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -67,6 +71,11 @@ public:
     FrameBuilder(const LayerUpdateQueue& layerUpdateQueue,
             const LightGeometry& lightGeometry, Caches& caches);
 
+    /**
+     * Defers every layer update in the queue. If Properties::parallelLayerDeferral is set, the
+     * layers are deferred concurrently on Caches' TaskManager, each into its own reorder context
+     * and allocator, and joined back before this method returns.
+     */
     void deferLayers(const LayerUpdateQueue& layers);
 
     void deferRenderNode(RenderNode& renderNode);
@@ -153,6 +162,9 @@ public:
         }
     }
 
+    // Number of ops removed by occlusion culling before replay, see LayerBuilder::cullOccludedOps()
+    size_t getCulledOpCount() const { return mCulledOpCount; }
+
     void dump() const {
         for (auto&& layer : mLayerBuilders) {
             layer->dump();
@@ -167,6 +179,29 @@ public:
     virtual GLuint getTargetFbo() const override { return 0; }
 
 private:
+    class LayerDeferProcessor;
+    class LayerDeferTask;
+
+    // Creates a FrameBuilder that defers layer updates on behalf of deferLayersConcurrently()
+    FrameBuilder(const LightGeometry& lightGeometry, Caches& caches, Mutex& sharedStateLock);
+
+    void deferLayer(RenderNode& layerNode, const Rect& damage);
+    void deferLayersConcurrently(const LayerUpdateQueue& layers);
+
+    /**
+     * Issues a request against Caches. Caches may only be used on the render thread, so a
+     * FrameBuilder deferring on a worker thread records the request instead, and it is issued
+     * when the worker's layers are joined into the frame.
+     */
+    template <typename CacheRequest>
+    void requestCaches(CacheRequest&& request) {
+        if (CC_LIKELY(!mSharedStateLock)) {
+            request(mCaches);
+        } else {
+            mPendingCacheRequests.emplace_back(std::forward<CacheRequest>(request));
+        }
+    }
+
     void finishDefer();
     enum class ChildrenSelectMode {
         Negative,
@@ -252,6 +287,18 @@ private:
     float mLightRadius;
 
     const bool mDrawFbo0;
+
+    size_t mCulledOpCount = 0;
+
+    // Non-null when deferring on a worker thread, guards state shared with other workers
+    Mutex* mSharedStateLock = nullptr;
+
+    // Cache requests recorded on a worker thread, see requestCaches()
+    std::vector<std::function<void(Caches&)>> mPendingCacheRequests;
+
+    // Builders used to defer layers concurrently. They own the allocators backing some of
+    // mLayerBuilders, so must outlive replay.
+    std::vector<std::unique_ptr<FrameBuilder>> mWorkerBuilders;
 };
 
 }; // namespace uirenderer
@@ -37,17 +37,36 @@ const std::string FrameInfoNames[] = {
     "FrameCompleted",
     "DequeueBufferDuration",
     "QueueBufferDuration",
+    "ReplayStart",
+    "CulledOpCount",
+    "DrawCallCount",
+    "ProgramSwitchCount",
+    "TextureBindCount",
+    "BlendChangeCount",
+    "GlCallCount",
+    "GlCallDuration",
+    "StateChangeCount",
+    "BufferUploadCount",
+    "BufferUploadBytes",
+    "TextureUploadCount",
+    "TextureUploadBytes",
 };
 
 static_assert((sizeof(FrameInfoNames)/sizeof(FrameInfoNames[0]))
         == static_cast<int>(FrameInfoIndex::NumIndexes),
         "size mismatch: FrameInfoNames doesn't match the enum!");
 
-static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 16,
+static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 29,
         "Must update value in FrameMetrics.java#FRAME_STATS_COUNT (and here)");
 
 void FrameInfo::importUiThreadInfo(int64_t* info) {
     memcpy(mFrameInfo, info, UI_THREAD_FRAME_INFO_SIZE * sizeof(int64_t));
+    // ReplayStart and the counters after it aren't written by every frame (eg. ones that don't
+    // draw, or frames drawn by the Skia pipelines), so reset them here
+    for (int i = static_cast<int>(FrameInfoIndex::ReplayStart);
+            i < static_cast<int>(FrameInfoIndex::NumIndexes); i++) {
+        mFrameInfo[i] = 0;
+    }
 }
 
 } /* namespace uirenderer */
@@ -51,6 +51,30 @@ enum class FrameInfoIndex {
     DequeueBufferDuration,
     QueueBufferDuration,
 
+    // Everything below was added after the indexes above, which FrameMetrics and framestats
+    // consumers address by position, so new values go at the end
+
+    // Set by the OpenGL pipeline once the frame is deferred, right before the ops are replayed
+    ReplayStart,
+    // Number of deferred ops not drawn because they were hidden by opaque ops
+    CulledOpCount,
+    // Number of draw calls issued for the frame
+    DrawCallCount,
+    // Number of GL program, texture binding and blend state changes made for the frame
+    ProgramSwitchCount,
+    TextureBindCount,
+    BlendChangeCount,
+    // Only set when GL calls go through debug::GlesAccountingDriver: all GL calls made for the
+    // frame and the time spent in them, state changes, and buffer and texture uploads along
+    // with the bytes they moved
+    GlCallCount,
+    GlCallDuration,
+    StateChangeCount,
+    BufferUploadCount,
+    BufferUploadBytes,
+    TextureUploadCount,
+    TextureUploadBytes,
+
     // Must be the last value!
     // Also must be kept in sync with FrameMetrics.java#FRAME_STATS_COUNT
     NumIndexes
@@ -85,6 +109,11 @@ public:
         return *this;
     }
 
+    UiFrameInfoBuilder& markDrawStart() {
+        set(FrameInfoIndex::DrawStart) = systemTime(CLOCK_MONOTONIC);
+        return *this;
+    }
+
     UiFrameInfoBuilder& addFlag(int frameInfoFlag) {
         set(FrameInfoIndex::Flags) |= static_cast<uint64_t>(frameInfoFlag);
         return *this;
@@ -110,6 +139,10 @@ public:
         set(FrameInfoIndex::IssueDrawCommandsStart) = systemTime(CLOCK_MONOTONIC);
     }
 
+    void markReplayStart() {
+        set(FrameInfoIndex::ReplayStart) = systemTime(CLOCK_MONOTONIC);
+    }
+
     void markSwapBuffers() {
         set(FrameInfoIndex::SwapBuffers) = systemTime(CLOCK_MONOTONIC);
     }
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GlopBatch.h"
+
+#include "ClipArea.h"
+#include "Texture.h"
+#include "renderstate/MeshState.h"
+#include "renderstate/RenderState.h"
+
+#include <string.h>
+
+namespace android {
+namespace uirenderer {
+
+// Returns the number of quads in the mesh, or 0 if it isn't a textured quad mesh that can be read
+static int getTexturedQuadCount(MeshState& meshState, const Glop::Mesh& mesh) {
+    const Glop::Mesh::Vertices& vertices = mesh.vertices;
+    if (vertices.attribFlags != VertexAttribFlags::TextureCoord
+            || vertices.stride != kTextureVertexStride) {
+        return 0;
+    }
+
+    if (mesh.primitiveMode == GL_TRIANGLE_STRIP
+            && mesh.elementCount == 4
+            && !mesh.indices.bufferObject && !mesh.indices.indices) {
+        // unit quad VBO, or a client side UV-mapped quad
+        return (vertices.bufferObject == meshState.getUnitQuadVBO()
+                || (!vertices.bufferObject && vertices.position)) ? 1 : 0;
+    }
+
+    if (mesh.primitiveMode == GL_TRIANGLES
+            && mesh.indices.bufferObject == meshState.getQuadListIBO()
+            && !vertices.bufferObject && vertices.position
+            && mesh.elementCount % 6 == 0) {
+        return mesh.elementCount / 6;
+    }
+    return 0;
+}
+
+static bool fillsAreEqual(const Glop::Fill& a, const Glop::Fill& b) {
+    if (a.program != b.program
+            || a.texture.texture != b.texture.texture
+            || a.texture.filter != b.texture.filter
+            || a.texture.clamp != b.texture.clamp
+            || a.colorEnabled != b.colorEnabled
+            || (a.colorEnabled && !(a.color == b.color))
+            || a.filterMode != b.filterMode) {
+        return false;
+    }
+
+    switch (a.filterMode) {
+    case ProgramDescription::ColorFilterMode::Blend:
+        return a.filter.color == b.filter.color;
+    case ProgramDescription::ColorFilterMode::Matrix:
+        return !memcmp(&a.filter.matrix, &b.filter.matrix, sizeof(a.filter.matrix));
+    default:
+        return true;
+    }
+}
+
+bool GlopBatch::canBatch(const Glop& glop, const ClipBase* clip) const {
+    const Glop::Fill& fill = glop.fill;
+    if (!fill.texture.texture
+            || fill.texture.texture->cleanup // deleted as soon as the op is done with it
+            || fill.texture.textureTransform
+            || fill.skiaShaderData.skiaShaderType != kNone_SkiaShaderType
+            || glop.roundRectClipState) {
+        return false;
+    }
+
+    // stencil clips are only tracked by pointer, and may not outlive the op
+    if (clip && clip->mode != ClipMode::Rectangle) return false;
+
+    // perspective can't be baked into vertices without breaking texture interpolation
+    if (glop.transform.meshTransform().isPerspective()) return false;
+
+    return getTexturedQuadCount(mRenderState.meshState(), glop.mesh) > 0;
+}
+
+bool GlopBatch::isCompatible(const Glop& glop, const ClipBase* clip) const {
+    if (empty()) return true;
+
+    if ((clip != nullptr) != mHasClip
+            || (clip && clip->rect != mClipRect)) {
+        return false;
+    }
+
+    const int offsetFlag = TransformFlags::OffsetByFudgeFactor;
+    return fillsAreEqual(glop.fill, mGlop.fill)
+            && glop.blend.src == mGlop.blend.src
+            && glop.blend.dst == mGlop.blend.dst
+            && (glop.transform.transformFlags & offsetFlag)
+                    == (mGlop.transform.transformFlags & offsetFlag);
+}
+
+void GlopBatch::append(const Glop& glop, const ClipBase* clip) {
+    MeshState& meshState = mRenderState.meshState();
+    if (empty()) {
+        mGlop.fill = glop.fill;
+        mGlop.blend = glop.blend;
+        mGlop.roundRectClipState = nullptr;
+        mGlop.transform.modelView.loadIdentity();
+        mGlop.transform.canvas.loadIdentity();
+        mGlop.transform.transformFlags =
+                glop.transform.transformFlags & TransformFlags::OffsetByFudgeFactor;
+
+        mHasClip = clip != nullptr;
+        if (clip) mClipRect = clip->rect;
+
+        Texture* texture = mGlop.fill.texture.texture;
+        if (!texture->isInUse) {
+            texture->isInUse = this;
+        }
+    }
+
+    const Glop::Mesh::Vertices& vertices = glop.mesh.vertices;
+    const TextureVertex* srcVertices = (vertices.bufferObject == meshState.getUnitQuadVBO())
+            ? kUnitQuadVertices
+            : reinterpret_cast<const TextureVertex*>(vertices.position);
+    const int vertexCount = getTexturedQuadCount(meshState, glop.mesh) * 4;
+
+    // same ordering as Program::set() - canvas transform applied after the model view
+    Matrix4 transform(glop.transform.meshTransform());
+    transform.multiply(glop.transform.modelView);
+
+    size_t start = mVertices.size();
+    mVertices.resize(start + vertexCount);
+    TextureVertex* outVertex = &mVertices[start];
+    for (int i = 0; i < vertexCount; i++) {
+        float x = srcVertices[i].x;
+        float y = srcVertices[i].y;
+        transform.mapPoint(x, y);
+        TextureVertex::set(outVertex++, x, y, srcVertices[i].u, srcVertices[i].v);
+    }
+}
+
+const Glop& GlopBatch::getGlop() {
+    mGlop.mesh.primitiveMode = GL_TRIANGLES;
+    mGlop.mesh.indices = { mRenderState.meshState().getQuadListIBO(), nullptr };
+    mGlop.mesh.elementCount = getQuadCount() * 6;
+
+    MeshState& meshState = mRenderState.meshState();
+    GLintptr offset = meshState.streamVertices(&mVertices[0],
+            mVertices.size() * sizeof(TextureVertex));
+    if (offset >= 0) {
+        mGlop.mesh.vertices = {
+                meshState.getStreamingVBO(),
+                VertexAttribFlags::TextureCoord,
+                reinterpret_cast<const void*>(offset),
+                reinterpret_cast<const void*>(offset + kMeshTextureOffset), nullptr,
+                kTextureVertexStride };
+    } else {
+        mGlop.mesh.vertices = {
+                0,
+                VertexAttribFlags::TextureCoord,
+                &mVertices[0].x, &mVertices[0].u, nullptr,
+                kTextureVertexStride };
+    }
+    return mGlop;
+}
+
+void GlopBatch::clear() {
+    if (!empty() && mGlop.fill.texture.texture->isInUse == this) {
+        mGlop.fill.texture.texture->isInUse = nullptr;
+    }
+    mVertices.clear();
+}
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Glop.h"
+#include "Rect.h"
+#include "Vertex.h"
+#include "utils/Macros.h"
+
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+struct ClipBase;
+class RenderState;
+
+/**
+ * Accumulates consecutive textured quad Glops that share all of their render state, so they can be
+ * issued with a single draw.
+ *
+ * Each appended Glop is reduced to its quads, with the Glop's transforms baked into the vertex
+ * positions. The quads of the whole batch are then drawn as one indexed quad list, with identity
+ * transforms, using the fill, blend and clip of the first Glop.
+ *
+ * While the batch holds quads, it marks their texture in use, so that the TextureCache can't evict
+ * it before the batch is drawn.
+ */
+class GlopBatch {
+    PREVENT_COPY_AND_ASSIGN(GlopBatch);
+public:
+    explicit GlopBatch(RenderState& renderState)
+            : mRenderState(renderState) {}
+    ~GlopBatch() { clear(); }
+
+    /**
+     * Returns true if the Glop draws one or more textured quads, with no state beyond its fill,
+     * blend and a rectangular clip that would prevent drawing it with other Glops.
+     */
+    bool canBatch(const Glop& glop, const ClipBase* clip) const;
+
+    // Returns true if the Glop would be drawn with the same state as the batched Glops
+    bool isCompatible(const Glop& glop, const ClipBase* clip) const;
+
+    // Adds the quads of a batchable, compatible Glop to the batch
+    void append(const Glop& glop, const ClipBase* clip);
+
+    bool empty() const { return mVertices.empty(); }
+    size_t getQuadCount() const { return mVertices.size() / 4; }
+
+    bool hasClip() const { return mHasClip; }
+    const Rect& getClipRect() const { return mClipRect; }
+
+    /**
+     * Returns a Glop drawing every batched quad, from the streaming VBO if it has room for them.
+     * Only valid until the batch is next modified.
+     */
+    const Glop& getGlop();
+
+    void clear();
+
+private:
+    RenderState& mRenderState;
+
+    // Fill, blend and transform flags of the batched Glops, and after getGlop() the batch's mesh
+    Glop mGlop;
+
+    bool mHasClip = false;
+    Rect mClipRect;
+
+    std::vector<TextureVertex> mVertices;
+};
+
+}; // namespace uirenderer
+}; // namespace android
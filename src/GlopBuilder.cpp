@@ -72,6 +72,45 @@ GlopBuilder::GlopBuilder(RenderState& renderState, Caches& caches, Glop* outGlop
 // Mesh
 ////////////////////////////////////////////////////////////////////////////////
 
+/*
+ * Moves client side mesh data into the streaming buffers, where possible, so it isn't uploaded
+ * from client memory at draw time.
+ *
+ * Textured quads are left in client memory, since GlopBatch reads them back to batch them (and
+ * streams the whole batch instead).
+ */
+void GlopBuilder::streamMesh(GLsizeiptr vertexDataSize, GLsizeiptr indexDataSize) {
+    MeshState& meshState = mRenderState.meshState();
+    Glop::Mesh::Vertices& vertices = mOutGlop->mesh.vertices;
+    Glop::Mesh::Indices& indices = mOutGlop->mesh.indices;
+
+    if (!vertices.bufferObject && vertices.position) {
+        GLintptr offset = meshState.streamVertices(vertices.position, vertexDataSize);
+        if (offset >= 0) {
+            // attributes interleaved after the position keep their offset from it
+            const GLbyte* base = static_cast<const GLbyte*>(vertices.position);
+            if (vertices.texCoord) {
+                vertices.texCoord = reinterpret_cast<const void*>(
+                        offset + (static_cast<const GLbyte*>(vertices.texCoord) - base));
+            }
+            if (vertices.color) {
+                vertices.color = reinterpret_cast<const void*>(
+                        offset + (static_cast<const GLbyte*>(vertices.color) - base));
+            }
+            vertices.position = reinterpret_cast<const void*>(offset);
+            vertices.bufferObject = meshState.getStreamingVBO();
+        }
+    }
+
+    if (!indices.bufferObject && indices.indices) {
+        GLintptr offset = meshState.streamIndices(indices.indices, indexDataSize);
+        if (offset >= 0) {
+            indices.indices = reinterpret_cast<const void*>(offset);
+            indices.bufferObject = meshState.getStreamingIBO();
+        }
+    }
+}
+
 GlopBuilder& GlopBuilder::setMeshTexturedIndexedVbo(GLuint vbo, GLsizei elementCount) {
     TRIGGER_STAGE(kMeshStage);
 
@@ -150,6 +189,7 @@ GlopBuilder& GlopBuilder::setMeshIndexedQuads(Vertex* vertexData, int quadCount)
             vertexData, nullptr, nullptr,
             kVertexStride };
     mOutGlop->mesh.elementCount = 6 * quadCount;
+    streamMesh(quadCount * 4 * kVertexStride, 0);
     return *this;
 }
 
@@ -178,6 +218,7 @@ GlopBuilder& GlopBuilder::setMeshColoredTexturedMesh(ColorTextureVertex* vertexD
             &vertexData[0].x, &vertexData[0].u, &vertexData[0].r,
             kColorTextureVertexStride };
     mOutGlop->mesh.elementCount = elementCount;
+    streamMesh(elementCount * kColorTextureVertexStride, 0);
     return *this;
 }
 
@@ -198,6 +239,7 @@ GlopBuilder& GlopBuilder::setMeshVertexBuffer(const VertexBuffer& vertexBuffer)
             alphaVertex ? kAlphaVertexStride : kVertexStride };
     mOutGlop->mesh.elementCount = indices
                 ? vertexBuffer.getIndexCount() : vertexBuffer.getVertexCount();
+    streamMesh(vertexBuffer.getSize(), vertexBuffer.getIndexCount() * sizeof(uint16_t));
     return *this;
 }
 
@@ -114,6 +114,7 @@ private:
     void setFill(int color, float alphaScale,
             SkBlendMode mode, Blend::ModeOrderSwap modeUsage,
             const SkShader* shader, const SkColorFilter* colorFilter);
+    void streamMesh(GLsizeiptr vertexDataSize, GLsizeiptr indexDataSize);
 
     enum StageFlags {
         kInitialStage = 0,
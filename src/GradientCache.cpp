@@ -63,8 +63,7 @@ int GradientCacheEntry::compare(const GradientCacheEntry& lhs, const GradientCac
 ///////////////////////////////////////////////////////////////////////////////
 
 GradientCache::GradientCache(Extensions& extensions)
-        : mCache(LruCache<GradientCacheEntry, Texture*>::kUnlimitedCapacity)
-        , mSize(0)
+        : mCache(CachePolicy::Lru, Properties::gradientCacheSize)
         , mMaxSize(Properties::gradientCacheSize)
         , mUseFloatTexture(extensions.hasFloatTextures())
         , mHasNpot(extensions.hasNPot())
@@ -83,20 +82,29 @@ GradientCache::~GradientCache() {
 ///////////////////////////////////////////////////////////////////////////////
 
 uint32_t GradientCache::getSize() {
-    return mSize;
+    return mCache.getWeight();
 }
 
 uint32_t GradientCache::getMaxSize() {
     return mMaxSize;
 }
 
+void GradientCache::setMaxSize(uint32_t maxSize) {
+    mMaxSize = maxSize;
+    mCache.setMaxWeight(maxSize);
+    mCache.trimToWeight(maxSize);
+}
+
+uint32_t GradientCache::getMinSize() {
+    return mMaxTextureSize * 2 * bytesPerPixel();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Callbacks
 ///////////////////////////////////////////////////////////////////////////////
 
 void GradientCache::operator()(GradientCacheEntry&, Texture*& texture) {
     if (texture) {
-        mSize -= texture->objectSize();
         texture->deleteTexture();
         delete texture;
     }
@@ -157,7 +165,7 @@ Texture* GradientCache::addLinearGradient(GradientCacheEntry& gradient,
     // Assume the cache is always big enough
     const uint32_t size = info.width * 2 * bytesPerPixel();
     while (getSize() + size > mMaxSize) {
-        LOG_ALWAYS_FATAL_IF(!mCache.removeOldest(),
+        LOG_ALWAYS_FATAL_IF(!mCache.evictNext(),
                 "Ran out of things to remove from the cache? getSize() = %" PRIu32
                 ", size = %" PRIu32 ", mMaxSize = %" PRIu32 ", width = %" PRIu32,
                 getSize(), size, mMaxSize, info.width);
@@ -165,12 +173,11 @@ Texture* GradientCache::addLinearGradient(GradientCacheEntry& gradient,
 
     generateTexture(colors, positions, info.width, 2, texture);
 
-    mSize += size;
     LOG_ALWAYS_FATAL_IF((int)size != texture->objectSize(),
             "size != texture->objectSize(), size %" PRIu32 ", objectSize %d"
             " width = %" PRIu32 " bytesPerPixel() = %zu",
             size, texture->objectSize(), info.width, bytesPerPixel());
-    mCache.put(gradient, texture);
+    mCache.put(gradient, texture, size);
 
     return texture;
 }
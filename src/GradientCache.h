@@ -23,10 +23,11 @@
 
 #include <SkShader.h>
 
-#include <utils/LruCache.h>
 #include <utils/Mutex.h>
 
+#include "CacheBudgetArbiter.h"
 #include "FloatColor.h"
+#include "utils/BudgetedCache.h"
 
 namespace android {
 namespace uirenderer {
@@ -103,7 +104,8 @@ inline hash_t hash_type(const GradientCacheEntry& entry) {
  * Any texture added to the cache causing the cache to grow beyond the maximum
  * allowed size will also cause the oldest texture to be kicked out.
  */
-class GradientCache: public OnEntryRemoved<GradientCacheEntry, Texture*> {
+class GradientCache: public OnEntryRemoved<GradientCacheEntry, Texture*>,
+        public CacheBudgetArbiter::Client {
 public:
     explicit GradientCache(Extensions& extensions);
     ~GradientCache();
@@ -127,11 +129,23 @@ public:
     /**
      * Returns the maximum size of the cache in bytes.
      */
-    uint32_t getMaxSize();
+    uint32_t getMaxSize() override;
     /**
      * Returns the current size of the cache in bytes.
      */
-    uint32_t getSize();
+    uint32_t getSize() override;
+    /**
+     * Changes the maximum size of the cache, evicting entries to fit in it.
+     */
+    void setMaxSize(uint32_t maxSize) override;
+    /**
+     * Returns the size of the widest gradient texture, which the cache must always fit.
+     */
+    uint32_t getMinSize() override;
+    /**
+     * Returns the hit, miss and eviction counts since the cache was created.
+     */
+    const CacheStats& getStats() override { return mCache.getStats(); }
 
 private:
     /**
@@ -162,10 +176,9 @@ private:
     void mixFloats(const FloatColor& start, const FloatColor& end,
             float amount, uint8_t*& dst) const;
 
-    LruCache<GradientCacheEntry, Texture*> mCache;
+    BudgetedCache<GradientCacheEntry, Texture*> mCache;
 
-    uint32_t mSize;
-    const uint32_t mMaxSize;
+    uint32_t mMaxSize;
 
     GLint mMaxTextureSize;
     bool mUseFloatTexture;
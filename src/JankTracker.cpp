@@ -27,6 +27,7 @@
 
 #include <cutils/ashmem.h>
 #include <log/log.h>
+#include <utils/Trace.h>
 
 #include "Properties.h"
 #include "utils/TimeUtils.h"
@@ -252,6 +253,9 @@ void JankTracker::setFrameInterval(nsecs_t frameInterval) {
 
 void JankTracker::addFrame(const FrameInfo& frame) {
     mData->totalFrameCount++;
+    if (frame[FrameInfoIndex::GlCallCount]) {
+        addGlStats(frame);
+    }
     // Fast-path for jank-free frames
     int64_t totalDuration = frame.duration(sFrameStart, FrameInfoIndex::FrameCompleted);
     if (mDequeueTimeForgiveness
@@ -297,6 +301,10 @@ void JankTracker::addFrame(const FrameInfo& frame) {
 
     mData->jankFrameCount++;
 
+    if (CC_UNLIKELY(ATRACE_ENABLED() && !Properties::traceJankDumpPath.empty())) {
+        dumpTraceForJank();
+    }
+
     for (int i = 0; i < NUM_BUCKETS; i++) {
         int64_t delta = frame.duration(COMPARISONS[i].start, COMPARISONS[i].end);
         if (delta >= mThresholds[i] && delta < IGNORE_EXCEEDING) {
@@ -344,6 +352,46 @@ void JankTracker::dumpData(int fd, const ProfileDataDescription* description, co
     dprintf(fd, "\n");
 }
 
+void JankTracker::addGlStats(const FrameInfo& frame) {
+    mGlFrameCount++;
+    for (int i = 0; i < kGlStatCount; i++) {
+        const int64_t value = frame[static_cast<int>(FrameInfoIndex::GlCallCount) + i];
+        mGlTotals[i] += value;
+        mGlPeaks[i] = std::max(mGlPeaks[i], value);
+    }
+}
+
+// Writing the trace takes a few milliseconds on the render thread, which could jank the next
+// frames in turn
+static const nsecs_t kTraceDumpInterval = 5_s;
+
+void JankTracker::dumpTraceForJank() {
+    nsecs_t now = systemTime(CLOCK_MONOTONIC);
+    if (mLastTraceDump && now - mLastTraceDump < kTraceDumpInterval) return;
+    mLastTraceDump = now;
+
+    const char* path = Properties::traceJankDumpPath.c_str();
+    if (trace::dump(path)) {
+        ALOGD("Janky frame, wrote trace to %s", path);
+    }
+}
+
+void JankTracker::dumpGlStats(int fd) {
+    if (!mGlFrameCount) return;
+    dprintf(fd, "GL calls of %u frames, per frame (average / max):", mGlFrameCount);
+    for (int i = 0; i < kGlStatCount; i++) {
+        const int index = static_cast<int>(FrameInfoIndex::GlCallCount) + i;
+        if (index == static_cast<int>(FrameInfoIndex::GlCallDuration)) {
+            dprintf(fd, "\n  %s: %.2fms / %.2fms", FrameInfoNames[index].c_str(),
+                    mGlTotals[i] / double(mGlFrameCount) / 1000000.0, mGlPeaks[i] / 1000000.0);
+        } else {
+            dprintf(fd, "\n  %s: %.1f / %" PRId64, FrameInfoNames[index].c_str(),
+                    mGlTotals[i] / double(mGlFrameCount), mGlPeaks[i]);
+        }
+    }
+    dprintf(fd, "\n");
+}
+
 void JankTracker::reset() {
     mData->jankTypeCounts.fill(0);
     mData->frameCounts.fill(0);
@@ -351,6 +399,9 @@ void JankTracker::reset() {
     mData->totalFrameCount = 0;
     mData->jankFrameCount = 0;
     mData->statStartTime = systemTime(CLOCK_MONOTONIC);
+    mGlFrameCount = 0;
+    mGlTotals.fill(0);
+    mGlPeaks.fill(0);
     sFrameStart = Properties::filterOutTestOverhead
             ? FrameInfoIndex::HandleInputStart
             : FrameInfoIndex::IntendedVsync;
@@ -82,7 +82,10 @@ public:
 
     void addFrame(const FrameInfo& frame);
 
-    void dump(int fd) { dumpData(fd, &mDescription, mData); }
+    void dump(int fd) {
+        dumpData(fd, &mDescription, mData);
+        dumpGlStats(fd);
+    }
     void reset();
 
     void rotateStorage();
@@ -96,6 +99,10 @@ private:
     void freeData();
     void setFrameInterval(nsecs_t frameIntervalNanos);
 
+    void addGlStats(const FrameInfo& frame);
+    void dumpGlStats(int fd);
+    void dumpTraceForJank();
+
     static uint32_t findPercentile(const ProfileData* data, int p);
     static void dumpData(int fd, const ProfileDataDescription* description, const ProfileData* data);
 
@@ -111,6 +118,16 @@ private:
     nsecs_t mDequeueTimeForgiveness = 0;
     ProfileData* mData;
     bool mIsMapped = false;
+
+    // Totals and per-frame peaks of the FrameInfo counters from GlesAccountingDriver. They
+    // aren't part of ProfileData so that its size stays in sync with GraphicsStatsService.
+    static const int kGlStatCount = static_cast<int>(FrameInfoIndex::NumIndexes)
+            - static_cast<int>(FrameInfoIndex::GlCallCount);
+    uint32_t mGlFrameCount = 0;
+    std::array<uint64_t, kGlStatCount> mGlTotals;
+    std::array<int64_t, kGlStatCount> mGlPeaks;
+    // When the trace was last written after a janky frame
+    nsecs_t mLastTraceDump = 0;
     ProfileDataDescription mDescription;
 };
 
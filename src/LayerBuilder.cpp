@@ -23,9 +23,18 @@
 
 #include <utils/TypeHelpers.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace android {
 namespace uirenderer {
 
+// Op count at which a LayerBuilder starts tracking op bounds in a BatchSpatialIndex
+static const size_t kSpatialIndexMinOps = 64;
+
+// Maximum number of batches reordered together by sortBatchesByState(), bounding its overlap tests
+static const size_t kMaxSortWindowSize = 32;
+
 class BatchBase {
 public:
     BatchBase(batchid_t batchId, BakedOpState* op, bool merging)
@@ -51,10 +60,34 @@ public:
 
     const std::vector<BakedOpState*>& getOps() const { return mOps; }
 
+    /*
+     * Visits ops from last drawn to first, removing those for which shouldCull returns true.
+     *
+     * Bounds (and so the clip rect of a merged batch) aren't recomputed, since they stay a
+     * superset of the remaining ops' bounds.
+     */
+    template <typename CullPredicate>
+    size_t cullOps(CullPredicate&& shouldCull) {
+        size_t culledCount = 0;
+        for (auto it = mOps.rbegin(); it != mOps.rend(); ++it) {
+            if (shouldCull(*it)) {
+                *it = nullptr;
+                culledCount++;
+            }
+        }
+        if (culledCount) {
+            mOps.erase(std::remove(mOps.begin(), mOps.end(), nullptr), mOps.end());
+        }
+        return culledCount;
+    }
+
     void dump() const {
         ALOGD("    Batch %p, id %d, merging %d, count %d, bounds " RECT_STRING,
                 this, mBatchId, mMerging, (int) mOps.size(), RECT_ARGS(mBounds));
     }
+
+    // Index of this batch within LayerBuilder::mBatches, only maintained with a spatial index
+    int position = -1;
 protected:
     batchid_t mBatchId;
     Rect mBounds;
@@ -74,10 +107,101 @@ public:
     }
 };
 
+/**
+ * Uniform grid over a layer, storing the clipped bounds of every deferred op along with the batch
+ * it was added to. Finding the batches that overlap a new op then only touches the ops in the grid
+ * cells it covers, rather than every op of every batch drawn since the insertion target.
+ *
+ * Ops covering many cells are kept in a separate list instead of being added to each cell, so
+ * that large backgrounds don't make insertion cost proportional to the layer size.
+ */
+class BatchSpatialIndex {
+public:
+    BatchSpatialIndex(uint32_t width, uint32_t height)
+            : mCellWidth(std::max(1.0f, width / (float) kGridSize))
+            , mCellHeight(std::max(1.0f, height / (float) kGridSize))
+            , mCells(kGridSize * kGridSize) {}
+
+    void insert(const BatchBase* batch, const Rect& bounds) {
+        if (bounds.isEmpty()) return; // can never intersect anything
+        int left, top, right, bottom;
+        getCellRange(bounds, &left, &top, &right, &bottom);
+        if ((right - left + 1) * (bottom - top + 1) > kMaxCellsPerEntry) {
+            mLargeEntries.push_back({batch, bounds});
+            return;
+        }
+        for (int y = top; y <= bottom; y++) {
+            for (int x = left; x <= right; x++) {
+                mCells[y * kGridSize + x].push_back({batch, bounds});
+            }
+        }
+    }
+
+    /**
+     * Returns the highest position of a batch containing an op that intersects rect, or -1 if
+     * there is none.
+     */
+    int findLastIntersecting(const Rect& rect) const {
+        int lastPosition = -1;
+        forEachIntersecting(rect, [&lastPosition](const BatchBase* batch) {
+            lastPosition = std::max(lastPosition, batch->position);
+            return false;
+        });
+        return lastPosition;
+    }
+
+    // Returns true if the given batch contains an op that intersects rect
+    bool intersects(const BatchBase* target, const Rect& rect) const {
+        return forEachIntersecting(rect, [target](const BatchBase* batch) {
+            return batch == target;
+        });
+    }
+
+private:
+    static const int kGridSize = 32;
+    static const int kMaxCellsPerEntry = 16;
+
+    struct Entry {
+        const BatchBase* batch;
+        Rect bounds;
+    };
+
+    void getCellRange(const Rect& rect, int* left, int* top, int* right, int* bottom) const {
+        *left = MathUtils::clamp((int) (rect.left / mCellWidth), 0, kGridSize - 1);
+        *top = MathUtils::clamp((int) (rect.top / mCellHeight), 0, kGridSize - 1);
+        *right = MathUtils::clamp((int) (rect.right / mCellWidth), 0, kGridSize - 1);
+        *bottom = MathUtils::clamp((int) (rect.bottom / mCellHeight), 0, kGridSize - 1);
+    }
+
+    // Calls visitor with the batch of every op intersecting rect until it returns true
+    template <typename Visitor>
+    bool forEachIntersecting(const Rect& rect, Visitor visitor) const {
+        for (const Entry& entry : mLargeEntries) {
+            if (entry.bounds.intersects(rect) && visitor(entry.batch)) return true;
+        }
+        int left, top, right, bottom;
+        getCellRange(rect, &left, &top, &right, &bottom);
+        for (int y = top; y <= bottom; y++) {
+            for (int x = left; x <= right; x++) {
+                for (const Entry& entry : mCells[y * kGridSize + x]) {
+                    if (entry.bounds.intersects(rect) && visitor(entry.batch)) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    const float mCellWidth;
+    const float mCellHeight;
+    std::vector<std::vector<Entry>> mCells;
+    std::vector<Entry> mLargeEntries;
+};
+
 class MergingOpBatch : public BatchBase {
 public:
-    MergingOpBatch(batchid_t batchId, BakedOpState* op)
+    MergingOpBatch(batchid_t batchId, BakedOpState* op, mergeid_t mergeId)
             : BatchBase(batchId, op, true)
+            , mMergeId(mergeId)
             , mClipSideFlags(op->computedState.clipSideFlags) {
     }
 
@@ -122,14 +246,17 @@ public:
      * False positives can lead to information from the paints of subsequent merged operations being
      * dropped, so we make simplifying qualifications on the ops that can merge, per op type.
      */
-    bool canMergeWith(BakedOpState* op) const {
+    bool canMergeWith(BakedOpState* op, const BatchSpatialIndex* spatialIndex) const {
         bool isTextBatch = getBatchId() == OpBatchType::Text
                 || getBatchId() == OpBatchType::ColorText;
 
         // Overlapping other operations is only allowed for text without shadow. For other ops,
         // multiDraw isn't guaranteed to overdraw correctly
         if (!isTextBatch || PaintUtils::hasTextShadow(op->op->paint)) {
-            if (intersects(op->computedState.clippedBounds)) return false;
+            const Rect& bounds = op->computedState.clippedBounds;
+            if (spatialIndex ? spatialIndex->intersects(this, bounds) : intersects(bounds)) {
+                return false;
+            }
         }
 
         const BakedOpState* lhs = op;
@@ -190,13 +317,111 @@ public:
         mClipSideFlags |= op->computedState.clipSideFlags;
     }
 
+    mergeid_t getMergeId() const { return mMergeId; }
     int getClipSideFlags() const { return mClipSideFlags; }
     const Rect& getClipRect() const { return mBounds; }
 
 private:
+    mergeid_t mMergeId;
     int mClipSideFlags;
 };
 
+/**
+ * Layer-space rects known to be fully covered by opaque ops, collected while walking a layer's
+ * ops from last drawn to first. Any op whose bounds fit inside one of them is never visible.
+ *
+ * Only the largest few occluders are kept - in practice, a handful of backgrounds and opaque
+ * bitmaps hide nearly everything that's overdrawn.
+ */
+class OcclusionTracker {
+public:
+    void addOccluder(const Rect& opaqueBounds) {
+        // Only trust pixels fully inside the op: snap inward to the pixel grid, then drop the
+        // outermost pixels, which may be antialiased or filtered against the edge
+        Rect occluder(ceilf(opaqueBounds.left), ceilf(opaqueBounds.top),
+                floorf(opaqueBounds.right), floorf(opaqueBounds.bottom));
+        occluder.inset(1);
+        if (occluder.isEmpty()) return;
+
+        if (mOccluders.size() < kMaxOccluders) {
+            mOccluders.push_back(occluder);
+            return;
+        }
+        auto smallest = std::min_element(mOccluders.begin(), mOccluders.end(),
+                [](const Rect& a, const Rect& b) {
+            return a.getWidth() * a.getHeight() < b.getWidth() * b.getHeight();
+        });
+        if (smallest->getWidth() * smallest->getHeight()
+                < occluder.getWidth() * occluder.getHeight()) {
+            *smallest = occluder;
+        }
+    }
+
+    bool isOccluded(const Rect& clippedBounds) const {
+        if (mOccluders.empty()) return false;
+
+        // Antialiased geometry may touch pixels just outside of its bounds
+        Rect drawnBounds(clippedBounds);
+        drawnBounds.outset(1);
+        for (const Rect& occluder : mOccluders) {
+            if (occluder.contains(drawnBounds)) return true;
+        }
+        return false;
+    }
+
+    void clear() {
+        mOccluders.clear();
+    }
+
+private:
+    static const size_t kMaxOccluders = 8;
+    std::vector<Rect> mOccluders;
+};
+
+/*
+ * Returns a key ordering batches by the GL state they're drawn with, most expensive to change
+ * first: batch id (a proxy for the program), then texture, then blend mode. The low bits hold
+ * the batch's original position within its window, so equal states keep their relative order.
+ */
+static uint64_t getBatchSortKey(const BatchBase* batch, size_t windowIndex) {
+    const BakedOpState* bakedState = batch->getOps()[0];
+    const void* textureKey = nullptr;
+    if (batch->isMerging()) {
+        // bitmap generation id for bitmaps, paint color for text
+        textureKey = static_cast<const MergingOpBatch*>(batch)->getMergeId();
+    } else {
+        switch (bakedState->op->opId) {
+        case RecordedOpId::BitmapOp:
+            textureKey = static_cast<const BitmapOp*>(bakedState->op)->bitmap;
+            break;
+        case RecordedOpId::BitmapMeshOp:
+            textureKey = static_cast<const BitmapMeshOp*>(bakedState->op)->bitmap;
+            break;
+        case RecordedOpId::BitmapRectOp:
+            textureKey = static_cast<const BitmapRectOp*>(bakedState->op)->bitmap;
+            break;
+        default:
+            break;
+        }
+    }
+    const uint64_t textureHash = static_cast<uint32_t>(android::hash_type(textureKey));
+    const uint64_t blendMode =
+            static_cast<uint64_t>(PaintUtils::getBlendModeDirect(bakedState->op->paint));
+
+    return (static_cast<uint64_t>(batch->getBatchId()) << 56)
+            | (textureHash << 24)
+            | ((blendMode & 0xFF) << 16)
+            | (windowIndex & 0xFFFF);
+}
+
+// Returns true if any op of a intersects any op of b
+static bool batchesIntersect(const BatchBase* a, const BatchBase* b) {
+    for (const BakedOpState* op : b->getOps()) {
+        if (a->intersects(op->computedState.clippedBounds)) return true;
+    }
+    return false;
+}
+
 LayerBuilder::LayerBuilder(uint32_t width, uint32_t height,
         const Rect& repaintRect, const BeginLayerOp* beginLayerOp, RenderNode* renderNode)
         : width(width)
@@ -207,10 +432,17 @@ LayerBuilder::LayerBuilder(uint32_t width, uint32_t height,
         , beginLayerOp(beginLayerOp)
         , renderNode(renderNode) {}
 
+LayerBuilder::~LayerBuilder() {}
+
 // iterate back toward target to see if anything drawn since should overlap the new op
 // if no target, merging ops still iterate to find similar batch to insert after
 void LayerBuilder::locateInsertIndex(int batchId, const Rect& clippedBounds,
         BatchBase** targetBatch, size_t* insertBatchIndex) const {
+    // With a spatial index, the most recent overlapping batch is known up front, so the walk
+    // back only has to compare batch ids
+    const int overlapPosition = mSpatialIndex
+            ? mSpatialIndex->findLastIntersecting(clippedBounds) : -1;
+
     for (int i = mBatches.size() - 1; i >= 0; i--) {
         BatchBase* overBatch = mBatches[i];
 
@@ -222,7 +454,7 @@ void LayerBuilder::locateInsertIndex(int batchId, const Rect& clippedBounds,
             if (!*targetBatch) break; // found insert position, quit
         }
 
-        if (overBatch->intersects(clippedBounds)) {
+        if (mSpatialIndex ? i == overlapPosition : overBatch->intersects(clippedBounds)) {
             // NOTE: it may be possible to optimize for special cases where two operations
             // of the same batch/paint could swap order, such as with a non-mergeable
             // (clipped) and a mergeable text operation
@@ -232,6 +464,31 @@ void LayerBuilder::locateInsertIndex(int batchId, const Rect& clippedBounds,
     }
 }
 
+void LayerBuilder::onOpBatched(BatchBase* batch, const BakedOpState* op) {
+    mOpCount++;
+    if (mSpatialIndex) {
+        mSpatialIndex->insert(batch, op->computedState.clippedBounds);
+    } else if (CC_UNLIKELY(mOpCount >= kSpatialIndexMinOps)) {
+        // enough ops that per-op overlap tests dominate deferral, so index every op so far
+        mSpatialIndex.reset(new BatchSpatialIndex(width, height));
+        for (size_t i = 0; i < mBatches.size(); i++) {
+            mBatches[i]->position = i;
+            for (const BakedOpState* batchedOp : mBatches[i]->getOps()) {
+                mSpatialIndex->insert(mBatches[i], batchedOp->computedState.clippedBounds);
+            }
+        }
+    }
+}
+
+void LayerBuilder::insertBatch(size_t insertBatchIndex, BatchBase* batch) {
+    mBatches.insert(mBatches.begin() + insertBatchIndex, batch);
+    if (mSpatialIndex) {
+        for (size_t i = insertBatchIndex; i < mBatches.size(); i++) {
+            mBatches[i]->position = i;
+        }
+    }
+}
+
 void LayerBuilder::deferLayerClear(const Rect& rect) {
     mClearRects.push_back(rect);
 }
@@ -301,8 +558,9 @@ void LayerBuilder::deferUnmergeableOp(LinearAllocator& allocator,
         // new non-merging batch
         targetBatch = allocator.create<OpBatch>(batchId, op);
         mBatchLookup[batchId] = targetBatch;
-        mBatches.insert(mBatches.begin() + insertBatchIndex, targetBatch);
+        insertBatch(insertBatchIndex, targetBatch);
     }
+    onOpBatched(targetBatch, op);
 }
 
 void LayerBuilder::deferMergeableOp(LinearAllocator& allocator,
@@ -314,7 +572,7 @@ void LayerBuilder::deferMergeableOp(LinearAllocator& allocator,
     auto getResult = mMergingBatchLookup[batchId].find(mergeId);
     if (getResult != mMergingBatchLookup[batchId].end()) {
         targetBatch = getResult->second;
-        if (!targetBatch->canMergeWith(op)) {
+        if (!targetBatch->canMergeWith(op, mSpatialIndex.get())) {
             targetBatch = nullptr;
         }
     }
@@ -327,11 +585,131 @@ void LayerBuilder::deferMergeableOp(LinearAllocator& allocator,
         targetBatch->mergeOp(op);
     } else  {
         // new merging batch
-        targetBatch = allocator.create<MergingOpBatch>(batchId, op);
+        targetBatch = allocator.create<MergingOpBatch>(batchId, op, mergeId);
         mMergingBatchLookup[batchId].insert(std::make_pair(mergeId, targetBatch));
 
-        mBatches.insert(mBatches.begin() + insertBatchIndex, targetBatch);
+        insertBatch(insertBatchIndex, targetBatch);
+    }
+    onOpBatched(targetBatch, op);
+}
+
+size_t LayerBuilder::cullOccludedOps() {
+    // overdraw visualization must still show the overdrawn ops
+    if (CC_UNLIKELY(Properties::debugOverdraw)) return 0;
+
+    OcclusionTracker occlusion;
+    size_t culledCount = 0;
+    for (auto it = mBatches.rbegin(); it != mBatches.rend(); ++it) {
+        culledCount += (*it)->cullOps([&occlusion](const BakedOpState* bakedState) {
+            switch (bakedState->op->opId) {
+            case RecordedOpId::CopyToLayerOp:
+            case RecordedOpId::FunctorOp:
+                // Reads from, or draws arbitrarily into, the target - so everything drawn before
+                // is observable regardless of what's drawn after
+                occlusion.clear();
+                return false;
+            case RecordedOpId::CopyFromLayerOp:
+            case RecordedOpId::LayerOp:
+                // replaying these also updates or releases the layer they draw, so never skip them
+                return false;
+            default:
+                break;
+            }
+
+            // clippedBounds only cover the glyphs, not the offset and blurred shadow drawn with
+            // them, which may still be visible around the occluder
+            if (PaintUtils::hasTextShadow(bakedState->op->paint)) {
+                return false;
+            }
+            if (occlusion.isOccluded(bakedState->computedState.clippedBounds)) {
+                return true;
+            }
+            if (bakedState->computedState.opaqueOverClippedBounds) {
+                occlusion.addOccluder(bakedState->computedState.clippedBounds);
+            }
+            return false;
+        });
+    }
+
+    if (culledCount) {
+        mBatches.erase(std::remove_if(mBatches.begin(), mBatches.end(),
+                [](const BatchBase* batch) { return batch->getOps().empty(); }),
+                mBatches.end());
+
+        // batch positions and lookups may now reference removed batches
+        mSpatialIndex.reset();
+        for (int i = 0; i < OpBatchType::Count; i++) {
+            mBatchLookup[i] = nullptr;
+            mMergingBatchLookup[i].clear();
+        }
+    }
+    return culledCount;
+}
+
+size_t LayerBuilder::sortBatchesByState() {
+    // overdraw visualization depends on draw order
+    if (CC_UNLIKELY(Properties::debugOverdraw)) return 0;
+
+    std::vector<BatchBase*> window;
+    std::vector<std::pair<uint64_t, BatchBase*>> keyedWindow;
+    size_t movedCount = 0;
+
+    // Sorts the batches in window (which start at mBatches[windowStart]) back into mBatches
+    auto sortWindow = [this, &window, &keyedWindow, &movedCount](size_t windowStart) {
+        if (window.size() > 1) {
+            keyedWindow.clear();
+            for (size_t i = 0; i < window.size(); i++) {
+                keyedWindow.emplace_back(getBatchSortKey(window[i], i), window[i]);
+            }
+            std::sort(keyedWindow.begin(), keyedWindow.end(),
+                    [](const std::pair<uint64_t, BatchBase*>& a,
+                            const std::pair<uint64_t, BatchBase*>& b) {
+                return a.first < b.first;
+            });
+            for (size_t i = 0; i < keyedWindow.size(); i++) {
+                if (mBatches[windowStart + i] != keyedWindow[i].second) movedCount++;
+                mBatches[windowStart + i] = keyedWindow[i].second;
+            }
+        }
+        window.clear();
+    };
+
+    // Batches within a window are pairwise disjoint, so any order of them draws the same pixels.
+    // Windows end at the first batch overlapping one already in it, or at a batch whose effect
+    // isn't limited to its bounds.
+    size_t windowStart = 0;
+    for (size_t i = 0; i < mBatches.size(); i++) {
+        BatchBase* batch = mBatches[i];
+        const batchid_t batchId = batch->getBatchId();
+        if (batchId == OpBatchType::Functor
+                || batchId == OpBatchType::CopyToLayer
+                || batchId == OpBatchType::CopyFromLayer) {
+            sortWindow(windowStart);
+            windowStart = i + 1;
+            continue;
+        }
+
+        bool overlaps = window.size() >= kMaxSortWindowSize;
+        for (size_t j = 0; !overlaps && j < window.size(); j++) {
+            overlaps = batchesIntersect(window[j], batch);
+        }
+        if (overlaps) {
+            sortWindow(windowStart);
+            windowStart = i;
+        }
+        window.push_back(batch);
+    }
+    sortWindow(windowStart);
+
+    if (movedCount) {
+        // batch positions and lookups no longer reflect the batch order
+        mSpatialIndex.reset();
+        for (int i = 0; i < OpBatchType::Count; i++) {
+            mBatchLookup[i] = nullptr;
+            mMergingBatchLookup[i].clear();
+        }
     }
+    return movedCount;
 }
 
 void LayerBuilder::replayBakedOpsImpl(void* arg,
@@ -359,6 +737,8 @@ void LayerBuilder::replayBakedOpsImpl(void* arg,
 
 void LayerBuilder::clear() {
     mBatches.clear();
+    mOpCount = 0;
+    mSpatialIndex.reset();
     for (int i = 0; i < OpBatchType::Count; i++) {
         mBatchLookup[i] = nullptr;
         mMergingBatchLookup[i].clear();
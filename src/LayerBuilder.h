@@ -20,6 +20,7 @@
 #include "Rect.h"
 #include "utils/Macros.h"
 
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -31,6 +32,7 @@ namespace uirenderer {
 class BakedOpState;
 struct BeginLayerOp;
 class BatchBase;
+class BatchSpatialIndex;
 class LinearAllocator;
 struct MergedBakedOpList;
 class MergingOpBatch;
@@ -80,6 +82,8 @@ public:
     LayerBuilder(uint32_t width, uint32_t height,
             const Rect& repaintRect, const BeginLayerOp* beginLayerOp, RenderNode* renderNode);
 
+    ~LayerBuilder();
+
     // iterate back toward target to see if anything drawn since should overlap the new op
     // if no target, merging ops still iterate to find similar batch to insert after
     void locateInsertIndex(int batchId, const Rect& clippedBounds,
@@ -92,6 +96,23 @@ public:
     void deferMergeableOp(LinearAllocator& allocator,
             BakedOpState* op, batchid_t batchId, mergeid_t mergeId);
 
+    /**
+     * Removes ops that are entirely hidden behind opaque ops drawn after them, so they aren't
+     * replayed. Must only be called once deferral into the layer is complete.
+     *
+     * Returns the number of ops removed.
+     */
+    size_t cullOccludedOps();
+
+    /**
+     * Reorders runs of batches that don't overlap each other so that batches drawn with the same
+     * program, texture and blend mode are adjacent, reducing GL state changes during replay. Must
+     * only be called once deferral into the layer is complete.
+     *
+     * Returns the number of batches that changed position.
+     */
+    size_t sortBatchesByState();
+
     void replayBakedOpsImpl(void* arg, BakedOpReceiver* receivers, MergedOpReceiver*) const;
 
     void deferLayerClear(const Rect& dstRect);
@@ -116,10 +137,21 @@ public:
     std::vector<BakedOpState*> activeUnclippedSaveLayers;
 private:
     void onDeferOp(LinearAllocator& allocator, const BakedOpState* bakedState);
+    void onOpBatched(BatchBase* batch, const BakedOpState* op);
+    void insertBatch(size_t insertBatchIndex, BatchBase* batch);
     void flushLayerClears(LinearAllocator& allocator);
 
     std::vector<BatchBase*> mBatches;
 
+    // Number of ops deferred since the last clear(), used to decide when to build mSpatialIndex
+    size_t mOpCount = 0;
+
+    /**
+     * Grid of the clipped bounds of every deferred op, built once the layer holds enough ops that
+     * testing each batch's ops for overlap becomes expensive. Null for small layers.
+     */
+    std::unique_ptr<BatchSpatialIndex> mSpatialIndex;
+
     /**
      * Maps the mergeid_t returned by an op's getMergeId() to the most recently seen
      * MergingDrawBatch of that id. These ids are unique per draw type and guaranteed to not
@@ -24,6 +24,16 @@
 
 #include "Matrix.h"
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MATRIX_SIMD 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MATRIX_SIMD 1
+#else
+#define MATRIX_SIMD 0
+#endif
+
 namespace android {
 namespace uirenderer {
 
@@ -33,6 +43,152 @@ namespace uirenderer {
 
 static const float EPSILON = 0.0000001f;
 
+///////////////////////////////////////////////////////////////////////////////
+// SIMD helpers
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Each lane performs the same operations, in the same order, as the scalar code it replaces
+ * (no fused multiply-adds), so the vector and scalar paths produce the same results.
+ */
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+typedef float32x4_t Float4;
+
+static inline Float4 splatFloat4(float value) {
+    return vdupq_n_f32(value);
+}
+
+static inline Float4 setFloat4(float a, float b, float c, float d) {
+    const float values[4] = { a, b, c, d };
+    return vld1q_f32(values);
+}
+
+static inline Float4 loadFloat4(const float* src) {
+    return vld1q_f32(src);
+}
+
+static inline void storeFloat4(float* dst, Float4 value) {
+    vst1q_f32(dst, value);
+}
+
+static inline Float4 addFloat4(Float4 a, Float4 b) {
+    return vaddq_f32(a, b);
+}
+
+static inline Float4 mulFloat4(Float4 a, Float4 b) {
+    return vmulq_f32(a, b);
+}
+
+static inline Float4 minFloat4(Float4 a, Float4 b) {
+    return vminq_f32(a, b);
+}
+
+static inline Float4 maxFloat4(Float4 a, Float4 b) {
+    return vmaxq_f32(a, b);
+}
+
+// Returns (a[0], a[1], b[2], b[3])
+static inline Float4 blendLowHighFloat4(Float4 a, Float4 b) {
+    return vcombine_f32(vget_low_f32(a), vget_high_f32(b));
+}
+
+// Returns (v[2], v[3], v[0], v[1])
+static inline Float4 swapHalvesFloat4(Float4 v) {
+    return vcombine_f32(vget_high_f32(v), vget_low_f32(v));
+}
+
+static inline float minLanesFloat4(Float4 v) {
+    float32x2_t m = vpmin_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpmin_f32(m, m), 0);
+}
+
+static inline float maxLanesFloat4(Float4 v) {
+    float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpmax_f32(m, m), 0);
+}
+
+// Loads four interleaved x,y points as four x coordinates, and four y coordinates
+static inline void loadPointsFloat4(const float* src, Float4* xs, Float4* ys) {
+    float32x4x2_t points = vld2q_f32(src);
+    *xs = points.val[0];
+    *ys = points.val[1];
+}
+
+static inline void storePointsFloat4(float* dst, Float4 xs, Float4 ys) {
+    float32x4x2_t points = {{ xs, ys }};
+    vst2q_f32(dst, points);
+}
+#elif defined(__SSE2__)
+typedef __m128 Float4;
+
+static inline Float4 splatFloat4(float value) {
+    return _mm_set1_ps(value);
+}
+
+static inline Float4 setFloat4(float a, float b, float c, float d) {
+    return _mm_setr_ps(a, b, c, d);
+}
+
+static inline Float4 loadFloat4(const float* src) {
+    return _mm_loadu_ps(src);
+}
+
+static inline void storeFloat4(float* dst, Float4 value) {
+    _mm_storeu_ps(dst, value);
+}
+
+static inline Float4 addFloat4(Float4 a, Float4 b) {
+    return _mm_add_ps(a, b);
+}
+
+static inline Float4 mulFloat4(Float4 a, Float4 b) {
+    return _mm_mul_ps(a, b);
+}
+
+static inline Float4 minFloat4(Float4 a, Float4 b) {
+    return _mm_min_ps(a, b);
+}
+
+static inline Float4 maxFloat4(Float4 a, Float4 b) {
+    return _mm_max_ps(a, b);
+}
+
+// Returns (a[0], a[1], b[2], b[3])
+static inline Float4 blendLowHighFloat4(Float4 a, Float4 b) {
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 1, 0));
+}
+
+// Returns (v[2], v[3], v[0], v[1])
+static inline Float4 swapHalvesFloat4(Float4 v) {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static inline float minLanesFloat4(Float4 v) {
+    Float4 m = _mm_min_ps(v, swapHalvesFloat4(v));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(m);
+}
+
+static inline float maxLanesFloat4(Float4 v) {
+    Float4 m = _mm_max_ps(v, swapHalvesFloat4(v));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(m);
+}
+
+// Loads four interleaved x,y points as four x coordinates, and four y coordinates
+static inline void loadPointsFloat4(const float* src, Float4* xs, Float4* ys) {
+    Float4 a = _mm_loadu_ps(src);
+    Float4 b = _mm_loadu_ps(src + 4);
+    *xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    *ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+static inline void storePointsFloat4(float* dst, Float4 xs, Float4 ys) {
+    _mm_storeu_ps(dst, _mm_unpacklo_ps(xs, ys));
+    _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(xs, ys));
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // Matrix
 ///////////////////////////////////////////////////////////////////////////////
@@ -370,6 +526,22 @@ void Matrix4::loadRotate(float angle, float x, float y, float z) {
 }
 
 void Matrix4::loadMultiply(const Matrix4& u, const Matrix4& v) {
+#if MATRIX_SIMD
+    // Each column of the result is a combination of the columns of u
+    const Float4 u0 = loadFloat4(&u.data[0]);
+    const Float4 u1 = loadFloat4(&u.data[4]);
+    const Float4 u2 = loadFloat4(&u.data[8]);
+    const Float4 u3 = loadFloat4(&u.data[12]);
+
+    for (int i = 0 ; i < 4 ; i++) {
+        Float4 column = splatFloat4(0);
+        column = addFloat4(column, mulFloat4(u0, splatFloat4(v.get(i, 0))));
+        column = addFloat4(column, mulFloat4(u1, splatFloat4(v.get(i, 1))));
+        column = addFloat4(column, mulFloat4(u2, splatFloat4(v.get(i, 2))));
+        column = addFloat4(column, mulFloat4(u3, splatFloat4(v.get(i, 3))));
+        storeFloat4(&data[i * 4], column);
+    }
+#else
     for (int i = 0 ; i < 4 ; i++) {
         float x = 0;
         float y = 0;
@@ -389,6 +561,7 @@ void Matrix4::loadMultiply(const Matrix4& u, const Matrix4& v) {
         set(i, 2, z);
         set(i, 3, w);
     }
+#endif
 
     mType = kTypeUnknown;
 }
@@ -412,11 +585,23 @@ float Matrix4::mapZ(const Vector3& orig) const {
 }
 
 void Matrix4::mapPoint3d(Vector3& vec) const {
-    //TODO: optimize simple case
+#if MATRIX_SIMD
+    Float4 result = mulFloat4(loadFloat4(&data[0]), splatFloat4(vec.x));
+    result = addFloat4(result, mulFloat4(loadFloat4(&data[4]), splatFloat4(vec.y)));
+    result = addFloat4(result, mulFloat4(loadFloat4(&data[8]), splatFloat4(vec.z)));
+    result = addFloat4(result, loadFloat4(&data[12]));
+
+    float mapped[4];
+    storeFloat4(mapped, result);
+    vec.x = mapped[0];
+    vec.y = mapped[1];
+    vec.z = mapped[2];
+#else
     const Vector3 orig(vec);
     vec.x = orig.x * data[kScaleX] + orig.y * data[kSkewX] + orig.z * data[8] + data[kTranslateX];
     vec.y = orig.x * data[kSkewY] + orig.y * data[kScaleY] + orig.z * data[9] + data[kTranslateY];
     vec.z = orig.x * data[2] + orig.y * data[6] + orig.z * data[kScaleZ] + data[kTranslateZ];
+#endif
 }
 
 #define MUL_ADD_STORE(a, b, c) ((a) = (a) * (b) + (c))
@@ -438,36 +623,119 @@ void Matrix4::mapPoint(float& x, float& y) const {
 }
 
 /**
- * Set the contents of the rect to be the bounding rect around each of the corners, mapped by the
- * matrix.
+ * Maps an array of points at once, choosing the fast path for the matrix type only once.
  *
- * NOTE: an empty rect to an arbitrary matrix isn't guaranteed to have an empty output, since that's
- * important for conservative bounds estimation (e.g. rotate45Matrix.mapRect of Rect(0, 10) should
- * result in non-empty.
+ * Without perspective, the w coordinate of a mapped point is always 1, so the divide done by
+ * mapPoint() can be skipped without changing the result.
  */
-void Matrix4::mapRect(Rect& r) const {
+void Matrix4::mapPoints(Vertex* points, size_t count) const {
     if (isIdentity()) return;
 
+    size_t i = 0;
+    float* coords = reinterpret_cast<float*>(points);
     if (isSimple()) {
-        MUL_ADD_STORE(r.left, data[kScaleX], data[kTranslateX]);
-        MUL_ADD_STORE(r.right, data[kScaleX], data[kTranslateX]);
-        MUL_ADD_STORE(r.top, data[kScaleY], data[kTranslateY]);
-        MUL_ADD_STORE(r.bottom, data[kScaleY], data[kTranslateY]);
-
-        if (r.left > r.right) {
-            float x = r.left;
-            r.left = r.right;
-            r.right = x;
+#if MATRIX_SIMD
+        // two points per vector
+        const Float4 scale = setFloat4(data[kScaleX], data[kScaleY],
+                data[kScaleX], data[kScaleY]);
+        const Float4 translate = setFloat4(data[kTranslateX], data[kTranslateY],
+                data[kTranslateX], data[kTranslateY]);
+        for (; i + 2 <= count; i += 2) {
+            float* point = coords + i * 2;
+            storeFloat4(point, addFloat4(mulFloat4(loadFloat4(point), scale), translate));
         }
+#endif
+        for (; i < count; i++) {
+            MUL_ADD_STORE(points[i].x, data[kScaleX], data[kTranslateX]);
+            MUL_ADD_STORE(points[i].y, data[kScaleY], data[kTranslateY]);
+        }
+        return;
+    }
 
-        if (r.top > r.bottom) {
-            float y = r.top;
-            r.top = r.bottom;
-            r.bottom = y;
+    if (!isPerspective()) {
+#if MATRIX_SIMD
+        const Float4 scaleX = splatFloat4(data[kScaleX]);
+        const Float4 skewX = splatFloat4(data[kSkewX]);
+        const Float4 translateX = splatFloat4(data[kTranslateX]);
+        const Float4 skewY = splatFloat4(data[kSkewY]);
+        const Float4 scaleY = splatFloat4(data[kScaleY]);
+        const Float4 translateY = splatFloat4(data[kTranslateY]);
+        for (; i + 4 <= count; i += 4) {
+            float* point = coords + i * 2;
+            Float4 xs, ys;
+            loadPointsFloat4(point, &xs, &ys);
+            Float4 dx = addFloat4(addFloat4(mulFloat4(xs, scaleX), mulFloat4(ys, skewX)),
+                    translateX);
+            Float4 dy = addFloat4(addFloat4(mulFloat4(xs, skewY), mulFloat4(ys, scaleY)),
+                    translateY);
+            storePointsFloat4(point, dx, dy);
         }
+#endif
+        for (; i < count; i++) {
+            const float x = points[i].x;
+            const float y = points[i].y;
+            points[i].x = x * data[kScaleX] + y * data[kSkewX] + data[kTranslateX];
+            points[i].y = x * data[kSkewY] + y * data[kScaleY] + data[kTranslateY];
+        }
+        return;
+    }
+
+    for (; i < count; i++) {
+        mapPoint(points[i].x, points[i].y);
+    }
+}
 
+static inline void mapSimpleRect(const float* data, Rect& r) {
+#if MATRIX_SIMD
+    const Float4 scale = setFloat4(data[Matrix4::kScaleX], data[Matrix4::kScaleY],
+            data[Matrix4::kScaleX], data[Matrix4::kScaleY]);
+    const Float4 translate = setFloat4(data[Matrix4::kTranslateX], data[Matrix4::kTranslateY],
+            data[Matrix4::kTranslateX], data[Matrix4::kTranslateY]);
+    Float4 ltrb = addFloat4(mulFloat4(setFloat4(r.left, r.top, r.right, r.bottom), scale),
+            translate);
+
+    // A negative scale flips the rect, so sort each edge pair
+    Float4 rblt = swapHalvesFloat4(ltrb);
+    float mapped[4];
+    storeFloat4(mapped, blendLowHighFloat4(minFloat4(ltrb, rblt), maxFloat4(ltrb, rblt)));
+    r.set(mapped[0], mapped[1], mapped[2], mapped[3]);
+#else
+    MUL_ADD_STORE(r.left, data[Matrix4::kScaleX], data[Matrix4::kTranslateX]);
+    MUL_ADD_STORE(r.right, data[Matrix4::kScaleX], data[Matrix4::kTranslateX]);
+    MUL_ADD_STORE(r.top, data[Matrix4::kScaleY], data[Matrix4::kTranslateY]);
+    MUL_ADD_STORE(r.bottom, data[Matrix4::kScaleY], data[Matrix4::kTranslateY]);
+
+    if (r.left > r.right) {
+        float x = r.left;
+        r.left = r.right;
+        r.right = x;
+    }
+
+    if (r.top > r.bottom) {
+        float y = r.top;
+        r.top = r.bottom;
+        r.bottom = y;
+    }
+#endif
+}
+
+static inline void mapGeneralRect(const float* data, Rect& r) {
+#if MATRIX_SIMD
+    if (data[Matrix4::kPerspective0] == 0.0f && data[Matrix4::kPerspective1] == 0.0f
+            && data[Matrix4::kPerspective2] == 1.0f) {
+        // map all four corners at once, skipping the divide since w is always 1
+        const Float4 xs = setFloat4(r.left, r.right, r.right, r.left);
+        const Float4 ys = setFloat4(r.top, r.top, r.bottom, r.bottom);
+        const Float4 dx = addFloat4(addFloat4(mulFloat4(xs, splatFloat4(data[Matrix4::kScaleX])),
+                mulFloat4(ys, splatFloat4(data[Matrix4::kSkewX]))),
+                splatFloat4(data[Matrix4::kTranslateX]));
+        const Float4 dy = addFloat4(addFloat4(mulFloat4(xs, splatFloat4(data[Matrix4::kSkewY])),
+                mulFloat4(ys, splatFloat4(data[Matrix4::kScaleY]))),
+                splatFloat4(data[Matrix4::kTranslateY]));
+        r.set(minLanesFloat4(dx), minLanesFloat4(dy), maxLanesFloat4(dx), maxLanesFloat4(dy));
         return;
     }
+#endif
 
     float vertices[] = {
         r.left, r.top,
@@ -482,9 +750,10 @@ void Matrix4::mapRect(Rect& r) const {
         float px = vertices[i];
         float py = vertices[i + 1];
 
-        x = px * data[kScaleX] + py * data[kSkewX] + data[kTranslateX];
-        y = px * data[kSkewY] + py * data[kScaleY] + data[kTranslateY];
-        z = px * data[kPerspective0] + py * data[kPerspective1] + data[kPerspective2];
+        x = px * data[Matrix4::kScaleX] + py * data[Matrix4::kSkewX] + data[Matrix4::kTranslateX];
+        y = px * data[Matrix4::kSkewY] + py * data[Matrix4::kScaleY] + data[Matrix4::kTranslateY];
+        z = px * data[Matrix4::kPerspective0] + py * data[Matrix4::kPerspective1]
+                + data[Matrix4::kPerspective2];
         if (z) z = 1.0f / z;
 
         vertices[i] = x * z;
@@ -505,6 +774,38 @@ void Matrix4::mapRect(Rect& r) const {
     }
 }
 
+/**
+ * Set the contents of the rect to be the bounding rect around each of the corners, mapped by the
+ * matrix.
+ *
+ * NOTE: an empty rect to an arbitrary matrix isn't guaranteed to have an empty output, since that's
+ * important for conservative bounds estimation (e.g. rotate45Matrix.mapRect of Rect(0, 10) should
+ * result in non-empty.
+ */
+void Matrix4::mapRect(Rect& r) const {
+    if (isIdentity()) return;
+
+    if (isSimple()) {
+        mapSimpleRect(data, r);
+    } else {
+        mapGeneralRect(data, r);
+    }
+}
+
+void Matrix4::mapRects(Rect* rects, size_t count) const {
+    if (isIdentity()) return;
+
+    if (isSimple()) {
+        for (size_t i = 0; i < count; i++) {
+            mapSimpleRect(data, rects[i]);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            mapGeneralRect(data, rects[i]);
+        }
+    }
+}
+
 void Matrix4::decomposeScale(float& sx, float& sy) const {
     float len;
     len = data[mat4::kScaleX] * data[mat4::kScaleX] + data[mat4::kSkewX] * data[mat4::kSkewX];
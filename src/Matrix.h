@@ -211,6 +211,10 @@ public:
     void mapPoint(float& x, float& y) const; // 2d only
     void mapRect(Rect& r) const; // 2d only
 
+    // Batch versions of mapPoint and mapRect, which only resolve the matrix type once
+    void mapPoints(Vertex* points, size_t count) const; // 2d only
+    void mapRects(Rect* rects, size_t count) const; // 2d only
+
     float getTranslateX() const;
     float getTranslateY() const;
 
@@ -177,8 +177,7 @@ static sk_sp<Bitmap> drawPath(const SkPath* path, const SkPaint* paint, PathText
 ///////////////////////////////////////////////////////////////////////////////
 
 PathCache::PathCache()
-        : mCache(LruCache<PathDescription, PathTexture*>::kUnlimitedCapacity)
-        , mSize(0)
+        : mCache(CachePolicy::TwoQueue, Properties::pathCacheSize)
         , mMaxSize(Properties::pathCacheSize) {
     mCache.setOnEntryRemovedListener(this);
 
@@ -198,13 +197,19 @@ PathCache::~PathCache() {
 ///////////////////////////////////////////////////////////////////////////////
 
 uint32_t PathCache::getSize() {
-    return mSize;
+    return mCache.getWeight();
 }
 
 uint32_t PathCache::getMaxSize() {
     return mMaxSize;
 }
 
+void PathCache::setMaxSize(uint32_t maxSize) {
+    mMaxSize = maxSize;
+    mCache.setMaxWeight(maxSize);
+    mCache.trimToWeight(maxSize);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Callbacks
 ///////////////////////////////////////////////////////////////////////////////
@@ -222,23 +227,16 @@ void PathCache::removeTexture(PathTexture* texture) {
         const uint32_t size = texture->width() * texture->height();
 
         // If there is a pending task we must wait for it to return
-        // before attempting our cleanup
+        // before attempting our cleanup. The cache tracked the entry
+        // with no weight until its texture was generated.
         const sp<PathTask>& task = texture->task();
         if (task != nullptr) {
             task->getResult();
             texture->clearTask();
-        } else {
-            // If there is a pending task, the path was not added
-            // to the cache and the size wasn't increased
-            if (size > mSize) {
-                ALOGE("Removing path texture of size %d will leave "
-                        "the cache in an inconsistent state", size);
-            }
-            mSize -= size;
         }
 
         PATH_LOGD("PathCache::delete name, size, mSize = %d, %d, %d",
-                texture->id, size, mSize);
+                texture->id, size, mCache.getWeight());
         if (mDebugEnabled) {
             ALOGD("Shape deleted, size = %d", size);
         }
@@ -252,9 +250,7 @@ void PathCache::purgeCache(uint32_t width, uint32_t height) {
     const uint32_t size = width * height;
     // Don't even try to cache a bitmap that's bigger than the cache
     if (size < mMaxSize) {
-        while (mSize + size > mMaxSize) {
-            mCache.removeOldest();
-        }
+        mCache.trimToWeight(mMaxSize - size);
     }
 }
 
@@ -264,10 +260,10 @@ void PathCache::trim() {
     // It does not represent a reasonable minimum value
     static_assert(DEFAULT_PATH_TEXTURE_CAP > 25, "Path cache texture cap is too small");
 
-    while (mSize > mMaxSize || mCache.size() > DEFAULT_PATH_TEXTURE_CAP) {
+    while (mCache.getWeight() > mMaxSize || mCache.size() > DEFAULT_PATH_TEXTURE_CAP) {
         LOG_ALWAYS_FATAL_IF(!mCache.size(), "Inconsistent mSize! Ran out of items to remove!"
-                " mSize = %u, mMaxSize = %u", mSize, mMaxSize);
-        mCache.removeOldest();
+                " mSize = %u, mMaxSize = %u", mCache.getWeight(), mMaxSize);
+        mCache.evictNext();
     }
 }
 
@@ -295,15 +291,16 @@ void PathCache::generateTexture(const PathDescription& entry, Bitmap& bitmap,
     // Such an entry in mCache will only be temporary, since it will be evicted
     // immediately on trim, or on any other Path entering the cache.
     uint32_t size = texture->width() * texture->height();
-    mSize += size;
+    if (addToCache) {
+        mCache.put(entry, texture, size);
+    } else {
+        mCache.setWeight(entry, size);
+    }
     PATH_LOGD("PathCache::get/create: name, size, mSize = %d, %d, %d",
-            texture->id, size, mSize);
+            texture->id, size, mCache.getWeight());
     if (mDebugEnabled) {
         ALOGD("Shape created, size = %d", size);
     }
-    if (addToCache) {
-        mCache.put(entry, texture);
-    }
 }
 
 void PathCache::clear() {
@@ -346,7 +343,7 @@ void PathCache::clearGarbage() {
     { // scope for the mutex
         Mutex::Autolock l(mLock);
         for (const uint32_t generationID : mGarbage) {
-            LruCache<PathDescription, PathTexture*>::Iterator iter(mCache);
+            BudgetedCache<PathDescription, PathTexture*>::Iterator iter(mCache);
             while (iter.next()) {
                 const PathDescription& key = iter.key();
                 if (key.type == ShapeType::Path && key.shape.path.mGenerationID == generationID) {
@@ -426,7 +423,7 @@ void PathCache::precache(const SkPath* path, const SkPaint* paint) {
         // we do not check the cache limit when inserting these objects.
         // The conversion into GL texture will happen in get(), when a client
         // asks for a path texture. This is also when the cache limit will
-        // be enforced.
+        // be enforced, and the entry given its weight.
         mCache.put(entry, texture);
 
         if (mProcessor == nullptr) {
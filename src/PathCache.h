@@ -17,18 +17,19 @@
 #ifndef ANDROID_HWUI_PATH_CACHE_H
 #define ANDROID_HWUI_PATH_CACHE_H
 
+#include "CacheBudgetArbiter.h"
 #include "Debug.h"
 #include "Texture.h"
 #include "hwui/Bitmap.h"
 #include "thread/Task.h"
 #include "thread/TaskProcessor.h"
+#include "utils/BudgetedCache.h"
 #include "utils/Macros.h"
 #include "utils/Pair.h"
 
 #include <GLES2/gl2.h>
 #include <SkPaint.h>
 #include <SkPath.h>
-#include <utils/LruCache.h>
 #include <utils/Mutex.h>
 
 #include <vector>
@@ -173,7 +174,8 @@ struct PathDescription {
  * Any texture added to the cache causing the cache to grow beyond the maximum
  * allowed size will also cause the oldest texture to be kicked out.
  */
-class PathCache: public OnEntryRemoved<PathDescription, PathTexture*> {
+class PathCache: public OnEntryRemoved<PathDescription, PathTexture*>,
+        public CacheBudgetArbiter::Client {
 public:
     PathCache();
     ~PathCache();
@@ -192,11 +194,19 @@ public:
     /**
      * Returns the maximum size of the cache in bytes.
      */
-    uint32_t getMaxSize();
+    uint32_t getMaxSize() override;
     /**
      * Returns the current size of the cache in bytes.
      */
-    uint32_t getSize();
+    uint32_t getSize() override;
+    /**
+     * Changes the maximum size of the cache, evicting entries to fit in it.
+     */
+    void setMaxSize(uint32_t maxSize) override;
+    /**
+     * Returns the hit, miss and eviction counts since the cache was created.
+     */
+    const CacheStats& getStats() override { return mCache.getStats(); }
 
     PathTexture* getRoundRect(float width, float height, float rx, float ry, const SkPaint* paint);
     PathTexture* getCircle(float radius, const SkPaint* paint);
@@ -270,9 +280,8 @@ private:
         uint32_t mMaxTextureSize;
     };
 
-    LruCache<PathDescription, PathTexture*> mCache;
-    uint32_t mSize;
-    const uint32_t mMaxSize;
+    BudgetedCache<PathDescription, PathTexture*> mCache;
+    uint32_t mMaxSize;
     GLuint mMaxTextureSize;
 
     bool mDebugEnabled;
@@ -23,6 +23,9 @@
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <log/log.h>
+#include <minikin/FontFamily.h>
+#include <minikin/Layout.h>
+#include <utils/Trace.h>
 
 namespace android {
 namespace uirenderer {
@@ -35,6 +38,14 @@ bool Properties::showDirtyRegions = false;
 bool Properties::skipEmptyFrames = true;
 bool Properties::useBufferAge = true;
 bool Properties::enablePartialUpdates = true;
+bool Properties::parallelLayerDeferral = false;
+bool Properties::batchGlops = true;
+bool Properties::sortBatches = false;
+bool Properties::streamMeshes = true;
+bool Properties::parallelGlyphRaster = true;
+bool Properties::pipelinedSync = false;
+bool Properties::glAccounting = false;
+std::string Properties::traceJankDumpPath;
 
 float Properties::textGamma = DEFAULT_TEXT_GAMMA;
 
@@ -47,12 +58,17 @@ int Properties::renderBufferCacheSize = MB(DEFAULT_RENDER_BUFFER_CACHE_SIZE);
 int Properties::tessellationCacheSize = MB(DEFAULT_VERTEX_CACHE_SIZE);
 int Properties::textDropShadowCacheSize = MB(DEFAULT_DROP_SHADOW_CACHE_SIZE);
 int Properties::textureCacheSize = MB(DEFAULT_TEXTURE_CACHE_SIZE);
+int Properties::textureBudget = MB(DEFAULT_TEXTURE_BUDGET);
 
 float Properties::textureCacheFlushRate = DEFAULT_TEXTURE_CACHE_FLUSH_RATE;
 
+int Properties::taskWorkerCount = -1;
+uint64_t Properties::taskWorkerAffinity = 0;
+
 DebugLevel Properties::debugLevel = kDebugDisabled;
 OverdrawColorSet Properties::overdrawColorSet = OverdrawColorSet::Default;
 StencilClipDebug Properties::debugStencilClip = StencilClipDebug::Hide;
+GlyphAtlasPacker Properties::glyphAtlasPacker = GlyphAtlasPacker::Skyline;
 
 float Properties::overrideLightRadius = -1.0f;
 float Properties::overrideLightPosY = -1.0f;
@@ -146,6 +162,36 @@ bool Properties::load() {
     skipEmptyFrames = property_get_bool(PROPERTY_SKIP_EMPTY_DAMAGE, true);
     useBufferAge = property_get_bool(PROPERTY_USE_BUFFER_AGE, true);
     enablePartialUpdates = property_get_bool(PROPERTY_ENABLE_PARTIAL_UPDATES, false);
+    parallelLayerDeferral = property_get_bool(PROPERTY_PARALLEL_LAYER_DEFER, false);
+    batchGlops = property_get_bool(PROPERTY_BATCH_GLOPS, true);
+    sortBatches = property_get_bool(PROPERTY_SORT_BATCHES, false);
+    streamMeshes = property_get_bool(PROPERTY_STREAM_MESHES, true);
+    parallelGlyphRaster = property_get_bool(PROPERTY_PARALLEL_GLYPH_RASTER, true);
+    pipelinedSync = property_get_bool(PROPERTY_PIPELINED_SYNC, false);
+    glAccounting = property_get_bool(PROPERTY_GL_ACCOUNTING, false);
+
+    if (property_get_bool(PROPERTY_TRACE, false)) {
+        android::trace::setEnabled(true);
+    }
+    traceJankDumpPath.clear();
+    if (property_get(PROPERTY_TRACE_JANK_DUMP_PATH, property, "") > 0) {
+        traceJankDumpPath = property;
+    }
+    if (property_get(PROPERTY_SHAPING_CACHE_PATH, property, "") > 0) {
+        minikin::Layout::setShapingCachePath(property);
+    }
+    if (property_get(PROPERTY_COVERAGE_CACHE_PATH, property, "") > 0) {
+        minikin::FontFamily::setCoverageCachePath(property);
+    }
+
+    glyphAtlasPacker = GlyphAtlasPacker::Skyline;
+    if (property_get(PROPERTY_GLYPH_ATLAS_PACKER, property, nullptr) > 0) {
+        if (!strcmp(property, "columns")) {
+            glyphAtlasPacker = GlyphAtlasPacker::Columns;
+        } else if (!strcmp(property, "maxrects")) {
+            glyphAtlasPacker = GlyphAtlasPacker::MaxRects;
+        }
+    }
 
     textGamma = property_get_float(PROPERTY_TEXT_GAMMA, DEFAULT_TEXT_GAMMA);
 
@@ -160,6 +206,14 @@ bool Properties::load() {
     textureCacheSize = MB(property_get_float(PROPERTY_TEXTURE_CACHE_SIZE, DEFAULT_TEXTURE_CACHE_SIZE));
     textureCacheFlushRate = std::max(0.0f, std::min(1.0f,
             property_get_float(PROPERTY_TEXTURE_CACHE_FLUSH_RATE, DEFAULT_TEXTURE_CACHE_FLUSH_RATE)));
+    textureBudget = MB(property_get_float(PROPERTY_TEXTURE_BUDGET, DEFAULT_TEXTURE_BUDGET));
+
+    taskWorkerCount = property_get_int(PROPERTY_TASK_WORKER_COUNT, -1);
+    if (property_get(PROPERTY_TASK_WORKER_AFFINITY, property, "") > 0) {
+        taskWorkerAffinity = strtoull(property, nullptr, 0);
+    } else {
+        taskWorkerAffinity = 0;
+    }
 
     filterOutTestOverhead = property_get_bool(PROPERTY_FILTER_TEST_OVERHEAD, false);
 
@@ -19,6 +19,8 @@
 
 #include <cutils/properties.h>
 
+#include <string>
+
 /**
  * This file contains the list of system properties used to configure libhwui.
  */
@@ -152,6 +154,98 @@ enum DebugLevel {
 
 #define PROPERTY_FILTER_TEST_OVERHEAD "debug.hwui.filter_test_overhead"
 
+/**
+ * Defers independent HW layer updates concurrently on the TaskManager's worker
+ * threads instead of sequentially on the render thread. The accepted values are
+ * "true" and "false". The default value is "false".
+ */
+#define PROPERTY_PARALLEL_LAYER_DEFER "debug.hwui.parallel_layer_defer"
+
+/**
+ * Draws consecutive bitmap quads sharing the same texture and state with a
+ * single draw call. The accepted values are "true" and "false". The default
+ * value is "true".
+ */
+#define PROPERTY_BATCH_GLOPS "debug.hwui.batch_glops"
+
+/**
+ * Reorders deferred batches that don't overlap to group those drawn with the
+ * same program, texture and blend mode. The accepted values are "true" and
+ * "false". The default value is "false".
+ */
+#define PROPERTY_SORT_BATCHES "debug.hwui.sort_batches"
+
+/**
+ * Copies mesh data into ring buffer objects before drawing, rather than
+ * drawing from client memory. Requires OpenGL ES 3.0. The accepted values
+ * are "true" and "false". The default value is "true".
+ */
+#define PROPERTY_STREAM_MESHES "debug.hwui.stream_meshes"
+
+/**
+ * Selects how glyphs are packed into the font cache textures. The accepted
+ * values are "columns", "skyline" and "maxrects". The default value is
+ * "skyline".
+ */
+#define PROPERTY_GLYPH_ATLAS_PACKER "debug.hwui.glyph_atlas_packer"
+
+/**
+ * Rasterizes glyphs missing from the font cache on the TaskManager's worker
+ * threads when precaching large runs of text. The accepted values are "true"
+ * and "false". The default value is "true".
+ */
+#define PROPERTY_PARALLEL_GLYPH_RASTER "debug.hwui.parallel_glyph_raster"
+
+/**
+ * Uploads the immutable bitmaps of a frame after the UI thread has been
+ * released from the sync, so that it can record the next frame while the
+ * render thread uploads and draws. The accepted values are "true" and
+ * "false". The default value is "false".
+ *
+ * Note that in this port RenderThread::queue() runs tasks inline on the
+ * calling thread and DrawFrameTask::unblockUiThread() does nothing, so the
+ * UI thread waits for the whole frame either way: this only moves the
+ * uploads after the sync, and frame latency is not expected to improve.
+ */
+#define PROPERTY_PIPELINED_SYNC "debug.hwui.pipelined_sync"
+
+/**
+ * Counts and times the GL calls of each frame, reporting them in FrameInfo and
+ * the gfxinfo dump. Only has an effect in builds that wrap GL calls, such as
+ * HWUI_ENABLE_OPENGL_VALIDATION ones. The accepted values are "true" and
+ * "false". The default value is "false".
+ */
+#define PROPERTY_GL_ACCOUNTING "debug.hwui.gl_accounting"
+
+/**
+ * Records the trace sections of all threads in per-thread ring buffers, which
+ * can be dumped in the Chrome trace event format. Tracing can also be turned
+ * on at runtime, so "false" doesn't turn it off. The accepted values are
+ * "true" and "false". The default value is "false".
+ */
+#define PROPERTY_TRACE "debug.hwui.trace"
+
+/**
+ * When tracing, the file that the recorded sections are written to after a
+ * janky frame, at most every few seconds. The default is to not write them.
+ */
+#define PROPERTY_TRACE_JANK_DUMP_PATH "debug.hwui.trace_jank_dump_path"
+
+/**
+ * File that the shaping of words is kept in across processes, so that text
+ * seen before doesn't go through HarfBuzz again on a cold start. It is read on
+ * the first layout cache miss and written in the background. The default is to
+ * not keep one.
+ */
+#define PROPERTY_SHAPING_CACHE_PATH "debug.hwui.shaping_cache_path"
+
+/**
+ * File that the Unicode coverage of fonts is kept in across processes, so that
+ * loading a font doesn't parse its cmap table again. Fonts loaded after the
+ * property is read use it. The default is to not keep one.
+ */
+#define PROPERTY_COVERAGE_CACHE_PATH "debug.hwui.coverage_cache_path"
+
 /**
  * Allows to set rendering pipeline mode to OpenGL (default), Skia OpenGL
  * or Vulkan.
@@ -183,6 +277,19 @@ enum DebugLevel {
  */
 #define PROPERTY_ENABLE_GPU_PIXEL_BUFFERS "ro.hwui.use_gpu_pixel_buffers"
 
+/**
+ * Number of TaskManager worker threads. Negative values (the default) size
+ * the pool from the number of available CPUs.
+ */
+#define PROPERTY_TASK_WORKER_COUNT "ro.hwui.task_worker_count"
+
+/**
+ * CPU mask the TaskManager worker threads are pinned to, e.g. "0xf0" to keep
+ * them on the big cores of a big.LITTLE system. Each worker is pinned to one
+ * CPU of the mask. The default, 0, leaves scheduling to the kernel.
+ */
+#define PROPERTY_TASK_WORKER_AFFINITY "ro.hwui.task_worker_affinity"
+
 // These properties are defined in mega-bytes
 #define PROPERTY_TEXTURE_CACHE_SIZE "ro.hwui.texture_cache_size"
 #define PROPERTY_LAYER_CACHE_SIZE "ro.hwui.layer_cache_size"
@@ -194,6 +301,16 @@ enum DebugLevel {
 #define PROPERTY_DROP_SHADOW_CACHE_SIZE "ro.hwui.drop_shadow_cache_size"
 #define PROPERTY_FBO_CACHE_SIZE "ro.hwui.fbo_cache_size"
 
+/**
+ * Total GPU texture memory, in mega-bytes, shared by the texture, path,
+ * gradient and drop shadow caches. Budget moves between these caches
+ * towards those that would gain the most hits from it, and they are
+ * trimmed when the textures tracked by GpuMemoryTracker (including ones
+ * the caches don't own, such as font caches and layers) go over it.
+ * The default, 0, uses the sum of the caches' sizes plus a quarter.
+ */
+#define PROPERTY_TEXTURE_BUDGET "ro.hwui.texture_budget"
+
 // These properties are defined in percentage (range 0..1)
 #define PROPERTY_TEXTURE_CACHE_FLUSH_RATE "ro.hwui.texture_cache_flushrate"
 
@@ -219,6 +336,7 @@ enum DebugLevel {
 #define DEFAULT_GRADIENT_CACHE_SIZE 0.5f
 #define DEFAULT_DROP_SHADOW_CACHE_SIZE 2.0f
 #define DEFAULT_FBO_CACHE_SIZE 0
+#define DEFAULT_TEXTURE_BUDGET 0.0f
 
 #define DEFAULT_TEXTURE_CACHE_FLUSH_RATE 0.6f
 
@@ -253,6 +371,12 @@ enum class StencilClipDebug {
     ShowRegion
 };
 
+enum class GlyphAtlasPacker {
+    Columns,
+    Skyline,
+    MaxRects
+};
+
 enum class RenderPipelineType {
     OpenGL = 0,
     SkiaGL,
@@ -278,6 +402,14 @@ public:
     static bool skipEmptyFrames;
     static bool useBufferAge;
     static bool enablePartialUpdates;
+    static bool parallelLayerDeferral;
+    static bool batchGlops;
+    static bool sortBatches;
+    static bool streamMeshes;
+    static bool parallelGlyphRaster;
+    static bool pipelinedSync;
+    static bool glAccounting;
+    static std::string traceJankDumpPath;
 
     static float textGamma;
 
@@ -291,10 +423,15 @@ public:
     static int textDropShadowCacheSize;
     static int textureCacheSize;
     static float textureCacheFlushRate;
+    static int textureBudget;
+
+    static int taskWorkerCount;
+    static uint64_t taskWorkerAffinity;
 
     static DebugLevel debugLevel;
     static OverdrawColorSet overdrawColorSet;
     static StencilClipDebug debugStencilClip;
+    static GlyphAtlasPacker glyphAtlasPacker;
 
     // Override the value for a subset of properties in this class
     static void overrideProperty(const char* name, const char* value);
@@ -221,25 +221,30 @@ void tessellateShadows(
 
     if (casterVertices2d.size() == 0) return;
 
-    // map 2d caster poly into 3d
+    // map the centroid of the caster into 3d
     const int casterVertexCount = casterVertices2d.size();
+    Vector2 centroid =  ShadowTessellator::centroid2d(
+            reinterpret_cast<const Vector2*>(&casterVertices2d.front()),
+            casterVertexCount);
+    Vector3 centroid3d = {centroid.x, centroid.y, 0};
+    mapPointFakeZ(centroid3d, casterTransformXY, casterTransformZ);
+
+    // map 2d caster poly into 3d, computing z with the true 3d matrix from the unmapped
+    // x,y coordinates before mapping the x,y coordinates all at once
     Vector3 casterPolygon[casterVertexCount];
     float minZ = FLT_MAX;
     float maxZ = -FLT_MAX;
     for (int i = 0; i < casterVertexCount; i++) {
         const Vertex& point2d = casterVertices2d[i];
-        casterPolygon[i] = (Vector3){point2d.x, point2d.y, 0};
-        mapPointFakeZ(casterPolygon[i], casterTransformXY, casterTransformZ);
+        casterPolygon[i].z = casterTransformZ->mapZ((Vector3){point2d.x, point2d.y, 0});
         minZ = std::min(minZ, casterPolygon[i].z);
         maxZ = std::max(maxZ, casterPolygon[i].z);
     }
-
-    // map the centroid of the caster into 3d
-    Vector2 centroid =  ShadowTessellator::centroid2d(
-            reinterpret_cast<const Vector2*>(&casterVertices2d.front()),
-            casterVertexCount);
-    Vector3 centroid3d = {centroid.x, centroid.y, 0};
-    mapPointFakeZ(centroid3d, casterTransformXY, casterTransformZ);
+    casterTransformXY->mapPoints(&casterVertices2d.front(), casterVertexCount);
+    for (int i = 0; i < casterVertexCount; i++) {
+        casterPolygon[i].x = casterVertices2d[i].x;
+        casterPolygon[i].y = casterVertices2d[i].y;
+    }
 
     // if the caster intersects the z=0 plane, lift it in Z so it doesn't
     if (minZ < SHADOW_MIN_CASTER_Z) {
@@ -291,7 +296,7 @@ public:
 
 TessellationCache::TessellationCache()
         : mMaxSize(Properties::tessellationCacheSize)
-        , mCache(LruCache<Description, Buffer*>::kUnlimitedCapacity)
+        , mCache(CachePolicy::Lru)
         , mShadowCache(LruCache<ShadowDescription, Task<vertexBuffer_pair_t*>*>::kUnlimitedCapacity) {
     mCache.setOnEntryRemovedListener(&mBufferRemovedListener);
     mShadowCache.setOnEntryRemovedListener(&mBufferPairRemovedListener);
@@ -307,7 +312,7 @@ TessellationCache::~TessellationCache() {
 ///////////////////////////////////////////////////////////////////////////////
 
 uint32_t TessellationCache::getSize() {
-    LruCache<Description, Buffer*>::Iterator iter(mCache);
+    BudgetedCache<Description, Buffer*>::Iterator iter(mCache);
     uint32_t size = 0;
     while (iter.next()) {
         size += iter.value()->getSize();
@@ -327,8 +332,8 @@ uint32_t TessellationCache::getMaxSize() {
 void TessellationCache::trim() {
     uint32_t size = getSize();
     while (size > mMaxSize) {
-        size -= mCache.peekOldestValue()->getSize();
-        mCache.removeOldest();
+        size -= mCache.peekNextEvicted()->getSize();
+        mCache.evictNext();
     }
     mShadowCache.clear();
 }
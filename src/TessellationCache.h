@@ -22,6 +22,7 @@
 #include "Vector.h"
 #include "VertexBuffer.h"
 #include "thread/TaskProcessor.h"
+#include "utils/BudgetedCache.h"
 #include "utils/Macros.h"
 #include "utils/Pair.h"
 
@@ -194,7 +195,9 @@ private:
     // General tessellation caching
     ///////////////////////////////////////////////////////////////////////////////
     sp<TaskProcessor<VertexBuffer*> > mProcessor;
-    LruCache<Description, Buffer*> mCache;
+    // Buffers are tessellated asynchronously, so entries carry no weight and the
+    // size is computed on demand from the buffers instead.
+    BudgetedCache<Description, Buffer*> mCache;
     class BufferRemovedListener : public OnEntryRemoved<Description, Buffer*> {
         void operator()(Description& description, Buffer*& buffer) override;
     };
@@ -97,8 +97,7 @@ TextDropShadowCache::TextDropShadowCache()
         : TextDropShadowCache(Properties::textDropShadowCacheSize) {}
 
 TextDropShadowCache::TextDropShadowCache(uint32_t maxByteSize)
-        : mCache(LruCache<ShadowText, ShadowTexture*>::kUnlimitedCapacity)
-        , mSize(0)
+        : mCache(CachePolicy::Lru, maxByteSize)
         , mMaxSize(maxByteSize) {
     mCache.setOnEntryRemovedListener(this);
     mDebugEnabled = Properties::debugLevel & kDebugMoreCaches;
@@ -113,21 +112,25 @@ TextDropShadowCache::~TextDropShadowCache() {
 ///////////////////////////////////////////////////////////////////////////////
 
 uint32_t TextDropShadowCache::getSize() {
-    return mSize;
+    return mCache.getWeight();
 }
 
 uint32_t TextDropShadowCache::getMaxSize() {
     return mMaxSize;
 }
 
+void TextDropShadowCache::setMaxSize(uint32_t maxSize) {
+    mMaxSize = maxSize;
+    mCache.setMaxWeight(maxSize);
+    mCache.trimToWeight(maxSize);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Callbacks
 ///////////////////////////////////////////////////////////////////////////////
 
 void TextDropShadowCache::operator()(ShadowText&, ShadowTexture*& texture) {
     if (texture) {
-        mSize -= texture->objectSize();
-
         if (mDebugEnabled) {
             ALOGD("Shadow texture deleted, size = %d", texture->bitmapSize);
         }
@@ -172,10 +175,10 @@ ShadowTexture* TextDropShadowCache::get(const SkPaint* paint, const glyph_t* gly
 
         // Don't even try to cache a bitmap that's bigger than the cache
         if (size < mMaxSize) {
-            while (mSize + size > mMaxSize) {
-                LOG_ALWAYS_FATAL_IF(!mCache.removeOldest(),
+            while (mCache.getWeight() + size > mMaxSize) {
+                LOG_ALWAYS_FATAL_IF(!mCache.evictNext(),
                         "Failed to remove oldest from cache. mSize = %"
-                        PRIu32 ", mCache.size() = %zu", mSize, mCache.size());
+                        PRIu32 ", mCache.size() = %zu", mCache.getWeight(), mCache.size());
             }
         }
 
@@ -192,8 +195,7 @@ ShadowTexture* TextDropShadowCache::get(const SkPaint* paint, const glyph_t* gly
 
             entry.copyTextLocally();
 
-            mSize += texture->objectSize();
-            mCache.put(entry, texture);
+            mCache.put(entry, texture, texture->objectSize());
         } else {
             texture->cleanup = true;
         }
@@ -21,11 +21,12 @@
 
 #include <SkPaint.h>
 
-#include <utils/LruCache.h>
 #include <utils/String16.h>
 
+#include "CacheBudgetArbiter.h"
 #include "font/Font.h"
 #include "Texture.h"
+#include "utils/BudgetedCache.h"
 
 namespace android {
 namespace uirenderer {
@@ -118,7 +119,8 @@ struct ShadowTexture: public Texture {
     float top;
 }; // struct ShadowTexture
 
-class TextDropShadowCache: public OnEntryRemoved<ShadowText, ShadowTexture*> {
+class TextDropShadowCache: public OnEntryRemoved<ShadowText, ShadowTexture*>,
+        public CacheBudgetArbiter::Client {
 public:
     TextDropShadowCache();
     explicit TextDropShadowCache(uint32_t maxByteSize);
@@ -145,17 +147,24 @@ public:
     /**
      * Returns the maximum size of the cache in bytes.
      */
-    uint32_t getMaxSize();
+    uint32_t getMaxSize() override;
     /**
      * Returns the current size of the cache in bytes.
      */
-    uint32_t getSize();
+    uint32_t getSize() override;
+    /**
+     * Changes the maximum size of the cache, evicting entries to fit in it.
+     */
+    void setMaxSize(uint32_t maxSize) override;
+    /**
+     * Returns the hit, miss and eviction counts since the cache was created.
+     */
+    const CacheStats& getStats() override { return mCache.getStats(); }
 
 private:
-    LruCache<ShadowText, ShadowTexture*> mCache;
+    BudgetedCache<ShadowText, ShadowTexture*> mCache;
 
-    uint32_t mSize;
-    const uint32_t mMaxSize;
+    uint32_t mMaxSize;
     FontRenderer* mRenderer = nullptr;
     bool mDebugEnabled;
 }; // class TextDropShadowCache
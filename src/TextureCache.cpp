@@ -33,8 +33,7 @@ namespace uirenderer {
 ///////////////////////////////////////////////////////////////////////////////
 
 TextureCache::TextureCache()
-        : mCache(LruCache<uint32_t, Texture*>::kUnlimitedCapacity)
-        , mSize(0)
+        : mCache(CachePolicy::TwoQueue, Properties::textureCacheSize)
         , mMaxSize(Properties::textureCacheSize)
         , mFlushRate(Properties::textureCacheFlushRate) {
     mCache.setOnEntryRemovedListener(this);
@@ -54,13 +53,19 @@ TextureCache::~TextureCache() {
 ///////////////////////////////////////////////////////////////////////////////
 
 uint32_t TextureCache::getSize() {
-    return mSize;
+    return mCache.getWeight();
 }
 
 uint32_t TextureCache::getMaxSize() {
     return mMaxSize;
 }
 
+void TextureCache::setMaxSize(uint32_t maxSize) {
+    mMaxSize = maxSize;
+    mCache.setMaxWeight(maxSize);
+    mCache.trimToWeight(maxSize);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Callbacks
 ///////////////////////////////////////////////////////////////////////////////
@@ -68,9 +73,8 @@ uint32_t TextureCache::getMaxSize() {
 void TextureCache::operator()(uint32_t&, Texture*& texture) {
     // This will be called already locked
     if (texture) {
-        mSize -= texture->bitmapSize;
         TEXTURE_LOGD("TextureCache::callback: name, removed size, mSize = %d, %d, %d",
-                texture->id, texture->bitmapSize, mSize);
+                texture->id, texture->bitmapSize, mCache.getWeight());
         if (mDebugEnabled) {
             ALOGD("Texture deleted, size = %d", texture->bitmapSize);
         }
@@ -84,7 +88,7 @@ void TextureCache::operator()(uint32_t&, Texture*& texture) {
 ///////////////////////////////////////////////////////////////////////////////
 
 void TextureCache::resetMarkInUse(void* ownerToken) {
-    LruCache<uint32_t, Texture*>::Iterator iter(mCache);
+    BudgetedCache<uint32_t, Texture*>::Iterator iter(mCache);
     while (iter.next()) {
         if (iter.value()->isInUse == ownerToken) {
             iter.value()->isInUse = nullptr;
@@ -137,10 +141,10 @@ Texture* TextureCache::getCachedTexture(Bitmap* bitmap) {
         const uint32_t size = bitmap->rowBytes() * bitmap->height();
         bool canCache = size < mMaxSize;
         // Don't even try to cache a bitmap that's bigger than the cache
-        while (canCache && mSize + size > mMaxSize) {
-            Texture* oldest = mCache.peekOldestValue();
-            if (oldest && !oldest->isInUse) {
-                mCache.removeOldest();
+        while (canCache && mCache.getWeight() + size > mMaxSize) {
+            Texture* victim = mCache.peekNextEvicted();
+            if (victim && !victim->isInUse) {
+                mCache.evictNext();
             } else {
                 canCache = false;
             }
@@ -148,13 +152,12 @@ Texture* TextureCache::getCachedTexture(Bitmap* bitmap) {
 
         if (canCache) {
             texture = createTexture(bitmap);
-            mSize += size;
+            mCache.put(bitmap->getGenerationID(), texture, size);
             TEXTURE_LOGD("TextureCache::get: create texture(%p): name, size, mSize = %d, %d, %d",
-                     bitmap, texture->id, size, mSize);
+                     bitmap, texture->id, size, mCache.getWeight());
             if (mDebugEnabled) {
                 ALOGD("Texture created, size = %d", size);
             }
-            mCache.put(bitmap->getGenerationID(), texture);
         }
     } else if (!texture->isInUse && bitmap->getGenerationID() != texture->generation) {
         // Texture was in the cache but is dirty, re-upload
@@ -208,7 +211,7 @@ void TextureCache::clear() {
         iter.second->deleteTexture();
     }
     mHardwareTextures.clear();
-    TEXTURE_LOGD("TextureCache:clear(), mSize = %d", mSize);
+    TEXTURE_LOGD("TextureCache:clear(), mSize = %d", mCache.getWeight());
 }
 
 void TextureCache::flush() {
@@ -218,12 +221,10 @@ void TextureCache::flush() {
         return;
     }
 
-    uint32_t targetSize = uint32_t(mSize * mFlushRate);
+    uint32_t targetSize = uint32_t(mCache.getWeight() * mFlushRate);
     TEXTURE_LOGD("TextureCache::flush: target size: %d", targetSize);
 
-    while (mSize > targetSize) {
-        mCache.removeOldest();
-    }
+    mCache.trimToWeight(targetSize);
 }
 
 }; // namespace uirenderer
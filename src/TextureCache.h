@@ -21,9 +21,10 @@
 
 #include <cutils/compiler.h>
 
-#include <utils/LruCache.h>
+#include "utils/BudgetedCache.h"
 #include <utils/Mutex.h>
 
+#include "CacheBudgetArbiter.h"
 #include "Debug.h"
 
 #include <vector>
@@ -53,11 +54,13 @@ class Texture;
 ///////////////////////////////////////////////////////////////////////////////
 
 /**
- * A simple LRU texture cache. The cache has a maximum size expressed in bytes.
- * Any texture added to the cache causing the cache to grow beyond the maximum
- * allowed size will also cause the oldest texture to be kicked out.
+ * A texture cache. The cache has a maximum size expressed in bytes. Any texture
+ * added to the cache causing the cache to grow beyond the maximum allowed size
+ * will cause other textures to be kicked out, with a 2Q policy so that bitmaps
+ * drawn once (e.g. while scrolling through a list) don't flush reused ones.
  */
-class TextureCache : public OnEntryRemoved<uint32_t, Texture*> {
+class TextureCache : public OnEntryRemoved<uint32_t, Texture*>,
+        public CacheBudgetArbiter::Client {
 public:
     TextureCache();
     ~TextureCache();
@@ -107,11 +110,19 @@ public:
     /**
      * Returns the maximum size of the cache in bytes.
      */
-    uint32_t getMaxSize();
+    uint32_t getMaxSize() override;
     /**
      * Returns the current size of the cache in bytes.
      */
-    uint32_t getSize();
+    uint32_t getSize() override;
+    /**
+     * Changes the maximum size of the cache, evicting entries to fit in it.
+     */
+    void setMaxSize(uint32_t maxSize) override;
+    /**
+     * Returns the hit, miss and eviction counts since the cache was created.
+     */
+    const CacheStats& getStats() override { return mCache.getStats(); }
 
     /**
      * Partially flushes the cache. The amount of memory freed by a flush
@@ -125,10 +136,9 @@ private:
     Texture* getCachedTexture(Bitmap* bitmap);
     Texture* createTexture(Bitmap* bitmap);
 
-    LruCache<uint32_t, Texture*> mCache;
+    BudgetedCache<uint32_t, Texture*> mCache;
 
-    uint32_t mSize;
-    const uint32_t mMaxSize;
+    uint32_t mMaxSize;
     GLint mMaxTextureSize;
 
     const float mFlushRate;
@@ -84,6 +84,10 @@ public:
     // as this being otherwise wasted work as all the animators will be
     // re-evaluated when the frame is actually drawn
     bool runAnimations = true;
+    // Set by DrawFrameTask when the UI thread is released before textures
+    // are uploaded, in which case only mutable bitmaps are pinned during the
+    // sync and the rest are left to CanvasContext::pinDeferredImages()
+    bool deferImageUploads = false;
 
     // Must not be null during actual usage
     DamageAccumulator* damageAccumulator = nullptr;
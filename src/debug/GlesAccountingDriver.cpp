@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GlesAccountingDriver.h"
+
+#include <log/log.h>
+
+namespace android {
+namespace uirenderer {
+namespace debug {
+
+GlesAccountingDriver* GlesAccountingDriver::sInstance = nullptr;
+
+static constexpr bool isStateChange(GlesCall call) {
+    switch (call) {
+    case GlesCall::glActiveTexture_:
+    case GlesCall::glBindBuffer_:
+    case GlesCall::glBindFramebuffer_:
+    case GlesCall::glBindRenderbuffer_:
+    case GlesCall::glBindTexture_:
+    case GlesCall::glBindVertexArray_:
+    case GlesCall::glBindVertexArrayOES_:
+    case GlesCall::glBlendColor_:
+    case GlesCall::glBlendEquation_:
+    case GlesCall::glBlendEquationSeparate_:
+    case GlesCall::glBlendFunc_:
+    case GlesCall::glBlendFuncSeparate_:
+    case GlesCall::glColorMask_:
+    case GlesCall::glCullFace_:
+    case GlesCall::glDepthFunc_:
+    case GlesCall::glDepthMask_:
+    case GlesCall::glDisable_:
+    case GlesCall::glEnable_:
+    case GlesCall::glFrontFace_:
+    case GlesCall::glScissor_:
+    case GlesCall::glStencilFunc_:
+    case GlesCall::glStencilMask_:
+    case GlesCall::glStencilOp_:
+    case GlesCall::glUseProgram_:
+    case GlesCall::glViewport_:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint32_t bytesPerPixel(GLenum format, GLenum type) {
+    switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+        return 2;
+    default:
+        break;
+    }
+
+    uint32_t channels;
+    switch (format) {
+    case GL_RGBA:
+    case GL_BGRA_EXT:
+        channels = 4;
+        break;
+    case GL_RGB:
+        channels = 3;
+        break;
+    case GL_LUMINANCE_ALPHA:
+    case GL_RG_EXT:
+        channels = 2;
+        break;
+    default:
+        channels = 1;
+        break;
+    }
+
+    switch (type) {
+    case GL_HALF_FLOAT:
+    case GL_HALF_FLOAT_OES:
+        return channels * 2;
+    case GL_FLOAT:
+        return channels * 4;
+    default:
+        return channels;
+    }
+}
+
+static void countTextureUpload(GlesAccountingDriver::State& state, const void* pixels,
+        uint64_t bytes) {
+    // Without pixels or an unpack buffer, the texture is only allocated
+    if (pixels || state.pixelUnpackBufferBound) {
+        state.counters.textureUploads++;
+        state.counters.textureUploadBytes += bytes;
+    }
+}
+
+// What a call counts as, besides being a call. Specialized for the calls that are more than a
+// state change or nothing.
+template <GlesCall call>
+struct Accountant {
+    template <typename... Args>
+    static void account(GlesAccountingDriver::State& state, Args...) {
+        if (isStateChange(call)) {
+            state.counters.stateChanges++;
+        }
+    }
+};
+
+#define DRAW_ACCOUNTANT(api) \
+    template <> \
+    struct Accountant<GlesCall::api##_> { \
+        template <typename... Args> \
+        static void account(GlesAccountingDriver::State& state, Args...) { \
+            state.counters.drawCalls++; \
+        } \
+    };
+
+DRAW_ACCOUNTANT(glDrawArrays)
+DRAW_ACCOUNTANT(glDrawArraysInstanced)
+DRAW_ACCOUNTANT(glDrawElements)
+DRAW_ACCOUNTANT(glDrawElementsInstanced)
+DRAW_ACCOUNTANT(glDrawRangeElements)
+
+#undef DRAW_ACCOUNTANT
+
+template <>
+struct Accountant<GlesCall::glBindBuffer_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLuint buffer) {
+        state.counters.stateChanges++;
+        if (target == GL_PIXEL_UNPACK_BUFFER) {
+            state.pixelUnpackBufferBound = buffer != 0;
+        }
+    }
+};
+
+template <>
+struct Accountant<GlesCall::glBufferData_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLsizeiptr size,
+            const void* data, GLenum usage) {
+        if (data) {
+            state.counters.bufferUploads++;
+            state.counters.bufferUploadBytes += size;
+        }
+    }
+};
+
+template <>
+struct Accountant<GlesCall::glBufferSubData_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLintptr offset,
+            GLsizeiptr size, const void* data) {
+        state.counters.bufferUploads++;
+        state.counters.bufferUploadBytes += size;
+    }
+};
+
+template <>
+struct Accountant<GlesCall::glTexImage2D_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLint level,
+            GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format,
+            GLenum type, const void* pixels) {
+        countTextureUpload(state, pixels,
+                uint64_t(width) * height * bytesPerPixel(format, type));
+    }
+};
+
+template <>
+struct Accountant<GlesCall::glTexSubImage2D_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLint level,
+            GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format,
+            GLenum type, const void* pixels) {
+        countTextureUpload(state, pixels,
+                uint64_t(width) * height * bytesPerPixel(format, type));
+    }
+};
+
+template <>
+struct Accountant<GlesCall::glCompressedTexImage2D_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLint level,
+            GLenum internalformat, GLsizei width, GLsizei height, GLint border,
+            GLsizei imageSize, const void* data) {
+        countTextureUpload(state, data, imageSize);
+    }
+};
+
+template <>
+struct Accountant<GlesCall::glCompressedTexSubImage2D_> {
+    static void account(GlesAccountingDriver::State& state, GLenum target, GLint level,
+            GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format,
+            GLsizei imageSize, const void* data) {
+        countTextureUpload(state, data, imageSize);
+    }
+};
+
+class CallTimer {
+public:
+    explicit CallTimer(GlesCounters& counters)
+            : mCounters(counters)
+            , mStart(systemTime(CLOCK_MONOTONIC)) {
+        mCounters.calls++;
+    }
+    ~CallTimer() {
+        mCounters.callDuration += systemTime(CLOCK_MONOTONIC) - mStart;
+    }
+private:
+    GlesCounters& mCounters;
+    nsecs_t mStart;
+};
+
+GlesAccountingDriver::GlesAccountingDriver(std::unique_ptr<GlesDriver>&& base)
+        : mBase(std::move(base)) {
+    LOG_ALWAYS_FATAL_IF(sInstance, "Only one GlesAccountingDriver can be used at a time");
+    sInstance = this;
+}
+
+GlesAccountingDriver::~GlesAccountingDriver() {
+    sInstance = nullptr;
+}
+
+void GlesAccountingDriver::install() {
+    if (sInstance) return;
+    std::unique_ptr<GlesDriver> base = GlesDriver::replace(nullptr);
+    GlesDriver::replace(std::make_unique<GlesAccountingDriver>(std::move(base)));
+}
+
+void GlesAccountingDriver::beginFrame() {
+    if (!sInstance) return;
+    sInstance->mFrameStartCounters = sInstance->mCounters;
+}
+
+void GlesAccountingDriver::endFrame(FrameInfo& frameInfo) {
+    if (!sInstance) return;
+    const GlesCounters& start = sInstance->mFrameStartCounters;
+    const GlesCounters& now = sInstance->mCounters;
+    frameInfo.set(FrameInfoIndex::GlCallCount) = now.calls - start.calls;
+    frameInfo.set(FrameInfoIndex::GlCallDuration) = now.callDuration - start.callDuration;
+    frameInfo.set(FrameInfoIndex::StateChangeCount) = now.stateChanges - start.stateChanges;
+    frameInfo.set(FrameInfoIndex::BufferUploadCount) = now.bufferUploads - start.bufferUploads;
+    frameInfo.set(FrameInfoIndex::BufferUploadBytes) =
+            now.bufferUploadBytes - start.bufferUploadBytes;
+    frameInfo.set(FrameInfoIndex::TextureUploadCount) = now.textureUploads - start.textureUploads;
+    frameInfo.set(FrameInfoIndex::TextureUploadBytes) =
+            now.textureUploadBytes - start.textureUploadBytes;
+}
+
+#define API_ENTRY(x) GlesAccountingDriver::x##_
+#define CALL_GL_API(x, ...) \
+    CallTimer _timer(mCounters); \
+    Accountant<GlesCall::x##_>::account(mState, ##__VA_ARGS__); \
+    mBase->x##_(__VA_ARGS__)
+
+#define CALL_GL_API_RETURN(x, ...) \
+    CallTimer _timer(mCounters); \
+    Accountant<GlesCall::x##_>::account(mState, ##__VA_ARGS__); \
+    return mBase->x##_(__VA_ARGS__)
+
+#include "gles_stubs.in"
+
+#undef API_ENTRY
+#undef CALL_GL_API
+#undef CALL_GL_API_RETURN
+
+} // namespace debug
+} // namespace uirenderer
+} // namespace android
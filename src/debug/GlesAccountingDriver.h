@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "GlesDriver.h"
+
+#include "FrameInfo.h"
+
+#include <utils/Timers.h>
+
+namespace android {
+namespace uirenderer {
+namespace debug {
+
+// One value per GL entry point, named like the GlesDriver methods
+enum class GlesCall {
+#define GL_ENTRY(ret, api, ...) api##_,
+    #include "gles_decls.in"
+#undef GL_ENTRY
+};
+
+struct GlesCounters {
+    uint64_t calls = 0;
+    nsecs_t callDuration = 0;
+    uint64_t drawCalls = 0;
+    uint64_t stateChanges = 0;
+    uint64_t bufferUploads = 0;
+    uint64_t bufferUploadBytes = 0;
+    uint64_t textureUploads = 0;
+    uint64_t textureUploadBytes = 0;
+};
+
+/**
+ * Forwards every call to another driver, counting and timing them. Draw calls, state changes,
+ * and the buffer and texture uploads along with the bytes they move are counted separately,
+ * and reported per frame through FrameInfo.
+ *
+ * Only GL issued by hwui goes through it, the Skia pipelines call GL from Skia directly.
+ */
+class GlesAccountingDriver : public GlesDriver {
+public:
+    explicit GlesAccountingDriver(std::unique_ptr<GlesDriver>&& base);
+    virtual ~GlesAccountingDriver();
+
+    virtual sk_sp<const GrGLInterface> getSkiaInterface() override {
+        return mBase->getSkiaInterface();
+    }
+
+#define GL_ENTRY(ret, api, ...) virtual ret api##_(__VA_ARGS__) override;
+    #include "gles_decls.in"
+#undef GL_ENTRY
+
+    const GlesCounters& getCounters() const { return mCounters; }
+
+    /**
+     * Wraps the current driver, unless that was already done.
+     */
+    static void install();
+
+    /**
+     * Returns the installed accounting driver, or nullptr.
+     */
+    static GlesAccountingDriver* get() { return sInstance; }
+
+    /**
+     * Mark the start and end of a frame, to export what it did to its FrameInfo. Do nothing if
+     * no accounting driver is installed.
+     */
+    static void beginFrame();
+    static void endFrame(FrameInfo& frameInfo);
+
+    // The counters, and the GL state that decides what some calls count as
+    struct State {
+        GlesCounters counters;
+        // Uploads from a pixel unpack buffer get their pixels from GPU memory
+        bool pixelUnpackBufferBound = false;
+    };
+
+private:
+    std::unique_ptr<GlesDriver> mBase;
+    State mState;
+    GlesCounters& mCounters = mState.counters;
+    GlesCounters mFrameStartCounters;
+
+    static GlesAccountingDriver* sInstance;
+};
+
+} // namespace debug
+} // namespace uirenderer
+} // namespace android
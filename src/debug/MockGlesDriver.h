@@ -29,6 +29,12 @@ public:
     MOCK_METHOD2(glBindBuffer_, void(GLenum target, GLuint buffer));
     MOCK_METHOD4(glBufferData_, void(GLenum target, GLsizeiptr size, const void *data, GLenum usage));
     MOCK_METHOD2(glGenBuffers_, void(GLsizei n, GLuint *buffers));
+    MOCK_METHOD2(glDeleteBuffers_, void(GLsizei n, const GLuint *buffers));
+    MOCK_METHOD4(glMapBufferRange_, void*(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access));
+    MOCK_METHOD1(glUnmapBuffer_, GLboolean(GLenum target));
+    MOCK_METHOD2(glFenceSync_, GLsync(GLenum condition, GLbitfield flags));
+    MOCK_METHOD3(glClientWaitSync_, GLenum(GLsync sync, GLbitfield flags, GLuint64 timeout));
+    MOCK_METHOD1(glDeleteSync_, void(GLsync sync));
 };
 
 } // namespace debug
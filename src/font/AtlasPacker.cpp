@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AtlasPacker.h"
+
+#include "FontUtil.h"
+#include "../Debug.h"
+
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <stb/stb_rect_pack.h>
+
+namespace android {
+namespace uirenderer {
+
+///////////////////////////////////////////////////////////////////////////////
+// Columns
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * CacheBlock is a node in a linked list of current free space areas in a CacheTexture.
+ * Using CacheBlocks enables us to pack the cache from top to bottom as well as left to right.
+ * When we add a glyph to the cache, we see if it fits within one of the existing columns that
+ * have already been started (this is the case if the glyph fits vertically as well as
+ * horizontally, and if its width is sufficiently close to the column width to avoid
+ * sub-optimal packing of small glyphs into wide columns). If there is no column in which the
+ * glyph fits, we check the final node, which is the remaining space in the cache, creating
+ * a new column as appropriate.
+ *
+ * As columns fill up, we remove their CacheBlock from the list to avoid having to check
+ * small blocks in the future.
+ */
+struct CacheBlock {
+    uint16_t mX;
+    uint16_t mY;
+    uint16_t mWidth;
+    uint16_t mHeight;
+    CacheBlock* mNext;
+    CacheBlock* mPrev;
+
+    CacheBlock(uint16_t x, uint16_t y, uint16_t width, uint16_t height):
+            mX(x), mY(y), mWidth(width), mHeight(height), mNext(nullptr), mPrev(nullptr) {
+    }
+
+    static CacheBlock* insertBlock(CacheBlock* head, CacheBlock* newBlock);
+    static CacheBlock* removeBlock(CacheBlock* head, CacheBlock* blockToRemove);
+
+    void output() {
+        CacheBlock* currBlock = this;
+        while (currBlock) {
+            ALOGD("Block: this, x, y, w, h = %p, %d, %d, %d, %d",
+                    currBlock, currBlock->mX, currBlock->mY,
+                    currBlock->mWidth, currBlock->mHeight);
+            currBlock = currBlock->mNext;
+        }
+    }
+};
+
+/**
+ * Insert new block into existing linked list of blocks. Blocks are sorted in increasing-width
+ * order, except for the final block (the remainder space at the right, since we fill from the
+ * left).
+ */
+CacheBlock* CacheBlock::insertBlock(CacheBlock* head, CacheBlock* newBlock) {
+#if DEBUG_FONT_RENDERER
+    ALOGD("insertBlock: this, x, y, w, h = %p, %d, %d, %d, %d",
+            newBlock, newBlock->mX, newBlock->mY,
+            newBlock->mWidth, newBlock->mHeight);
+#endif
+
+    CacheBlock* currBlock = head;
+    CacheBlock* prevBlock = nullptr;
+
+    while (currBlock && currBlock->mY != TEXTURE_BORDER_SIZE) {
+        if (newBlock->mWidth < currBlock->mWidth) {
+            newBlock->mNext = currBlock;
+            newBlock->mPrev = prevBlock;
+            currBlock->mPrev = newBlock;
+
+            if (prevBlock) {
+                prevBlock->mNext = newBlock;
+                return head;
+            } else {
+                return newBlock;
+            }
+        }
+
+        prevBlock = currBlock;
+        currBlock = currBlock->mNext;
+    }
+
+    // new block larger than all others - insert at end (but before the remainder space, if there)
+    newBlock->mNext = currBlock;
+    newBlock->mPrev = prevBlock;
+
+    if (currBlock) {
+        currBlock->mPrev = newBlock;
+    }
+
+    if (prevBlock) {
+        prevBlock->mNext = newBlock;
+        return head;
+    } else {
+        return newBlock;
+    }
+}
+
+CacheBlock* CacheBlock::removeBlock(CacheBlock* head, CacheBlock* blockToRemove) {
+#if DEBUG_FONT_RENDERER
+    ALOGD("removeBlock: this, x, y, w, h = %p, %d, %d, %d, %d",
+            blockToRemove, blockToRemove->mX, blockToRemove->mY,
+            blockToRemove->mWidth, blockToRemove->mHeight);
+#endif
+
+    CacheBlock* newHead = head;
+    CacheBlock* nextBlock = blockToRemove->mNext;
+    CacheBlock* prevBlock = blockToRemove->mPrev;
+
+    if (prevBlock) {
+        prevBlock->mNext = nextBlock;
+    } else {
+        newHead = nextBlock;
+    }
+
+    if (nextBlock) {
+        nextBlock->mPrev = prevBlock;
+    }
+
+    delete blockToRemove;
+
+    return newHead;
+}
+
+/**
+ * Packs glyphs into columns of similar width, each stacking glyphs from top to bottom.
+ */
+class ColumnAtlasPacker : public AtlasPacker {
+public:
+    ColumnAtlasPacker(uint16_t width, uint16_t height)
+            : AtlasPacker(width, height) {
+        reset();
+    }
+
+    ~ColumnAtlasPacker() {
+        clearBlocks();
+    }
+
+    bool pack(uint16_t glyphW, uint16_t glyphH, uint32_t* retOriginX, uint32_t* retOriginY)
+            override {
+        // roundedUpW equals glyphW to the next multiple of CACHE_BLOCK_ROUNDING_SIZE.
+        // This columns for glyphs that are close but not necessarily exactly the same size. It
+        // trades off the loss of a few pixels for some glyphs against the ability to store more
+        // glyphs of varying sizes in one block.
+        uint16_t roundedUpW = (glyphW + CACHE_BLOCK_ROUNDING_SIZE - 1) & -CACHE_BLOCK_ROUNDING_SIZE;
+
+        CacheBlock* cacheBlock = mCacheBlocks;
+        while (cacheBlock) {
+            // Store glyph in this block iff: it fits the block's remaining space and:
+            // it's the remainder space (mY == 0) or there's only enough height for this one glyph
+            // or it's within ROUNDING_SIZE of the block width
+            if (roundedUpW <= cacheBlock->mWidth && glyphH <= cacheBlock->mHeight &&
+                    (cacheBlock->mY == TEXTURE_BORDER_SIZE ||
+                            (cacheBlock->mWidth - roundedUpW < CACHE_BLOCK_ROUNDING_SIZE))) {
+                if (cacheBlock->mHeight - glyphH < glyphH) {
+                    // Only enough space for this glyph - don't bother rounding up the width
+                    roundedUpW = glyphW;
+                }
+
+                *retOriginX = cacheBlock->mX;
+                *retOriginY = cacheBlock->mY;
+
+                // If this is the remainder space, create a new cache block for this column.
+                // Otherwise, adjust the info about this column.
+                if (cacheBlock->mY == TEXTURE_BORDER_SIZE) {
+                    uint16_t oldX = cacheBlock->mX;
+                    // Adjust remainder space dimensions
+                    cacheBlock->mWidth -= roundedUpW;
+                    cacheBlock->mX += roundedUpW;
+
+                    if (mHeight - glyphH >= glyphH) {
+                        // There's enough height left over to create a new CacheBlock
+                        CacheBlock* newBlock = new CacheBlock(oldX, glyphH + TEXTURE_BORDER_SIZE,
+                                roundedUpW, mHeight - glyphH - TEXTURE_BORDER_SIZE);
+#if DEBUG_FONT_RENDERER
+                        ALOGD("fitBitmap: Created new block: this, x, y, w, h = %p, %d, %d, %d, %d",
+                                newBlock, newBlock->mX, newBlock->mY,
+                                newBlock->mWidth, newBlock->mHeight);
+#endif
+                        mCacheBlocks = CacheBlock::insertBlock(mCacheBlocks, newBlock);
+                    }
+                } else {
+                    // Insert into current column and adjust column dimensions
+                    cacheBlock->mY += glyphH;
+                    cacheBlock->mHeight -= glyphH;
+#if DEBUG_FONT_RENDERER
+                    ALOGD("fitBitmap: Added to existing block: this, x, y, w, h = %p, %d, %d, %d, %d",
+                            cacheBlock, cacheBlock->mX, cacheBlock->mY,
+                            cacheBlock->mWidth, cacheBlock->mHeight);
+#endif
+                }
+
+                if (cacheBlock->mHeight < std::min(glyphH, glyphW)) {
+                    // If remaining space in this block is too small to be useful, remove it
+                    mCacheBlocks = CacheBlock::removeBlock(mCacheBlocks, cacheBlock);
+                }
+
+#if DEBUG_FONT_RENDERER
+                ALOGD("fitBitmap: current block list:");
+                mCacheBlocks->output();
+#endif
+                return true;
+            }
+            cacheBlock = cacheBlock->mNext;
+        }
+        return false;
+    }
+
+    void reset() override {
+        // create a new remainder space to start again
+        clearBlocks();
+        mCacheBlocks = new CacheBlock(TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
+                mWidth - TEXTURE_BORDER_SIZE, mHeight - TEXTURE_BORDER_SIZE);
+    }
+
+    uint32_t getFreeArea() const override {
+        uint32_t free = 0;
+        for (CacheBlock* cacheBlock = mCacheBlocks; cacheBlock; cacheBlock = cacheBlock->mNext) {
+            free += cacheBlock->mWidth * cacheBlock->mHeight;
+        }
+        return free;
+    }
+
+private:
+    void clearBlocks() {
+        while (mCacheBlocks != nullptr) {
+            CacheBlock* tmpBlock = mCacheBlocks;
+            mCacheBlocks = mCacheBlocks->mNext;
+            delete tmpBlock;
+        }
+    }
+
+    CacheBlock* mCacheBlocks = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Skyline
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Tracks the lowest free row of every column of the texture (the skyline), placing each glyph
+ * as high up in the texture as it fits, then as far left. Space left beneath the skyline is never
+ * reused.
+ */
+class SkylineAtlasPacker : public AtlasPacker {
+public:
+    SkylineAtlasPacker(uint16_t width, uint16_t height)
+            : AtlasPacker(width, height)
+            , mNodes(width - TEXTURE_BORDER_SIZE) {
+        reset();
+    }
+
+    bool pack(uint16_t width, uint16_t height, uint32_t* outX, uint32_t* outY) override {
+        stbrp_rect rect;
+        rect.id = 0;
+        rect.w = width;
+        rect.h = height;
+        if (!stbrp_pack_rects(&mContext, &rect, 1)) return false;
+
+        *outX = rect.x + TEXTURE_BORDER_SIZE;
+        *outY = rect.y + TEXTURE_BORDER_SIZE;
+        return true;
+    }
+
+    void reset() override {
+        stbrp_init_target(&mContext, mWidth - TEXTURE_BORDER_SIZE, mHeight - TEXTURE_BORDER_SIZE,
+                mNodes.data(), mNodes.size());
+        stbrp_setup_heuristic(&mContext, STBRP_HEURISTIC_Skyline_BL_sortHeight);
+    }
+
+    uint32_t getFreeArea() const override {
+        const uint32_t packHeight = mHeight - TEXTURE_BORDER_SIZE;
+        uint32_t free = 0;
+        // the skyline ends with a sentinel node at the right edge
+        for (const stbrp_node* node = mContext.active_head; node && node->next; node = node->next) {
+            free += (node->next->x - node->x) * (packHeight - std::min<uint32_t>(node->y, packHeight));
+        }
+        return free;
+    }
+
+private:
+    stbrp_context mContext;
+    std::vector<stbrp_node> mNodes;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MaxRects
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Tracks every maximal free rectangle, placing each glyph in the one it fits most tightly (best
+ * short side fit). Free space isn't lost when glyphs are placed around it, at the cost of more
+ * work per glyph.
+ */
+class MaxRectsAtlasPacker : public AtlasPacker {
+public:
+    MaxRectsAtlasPacker(uint16_t width, uint16_t height)
+            : AtlasPacker(width, height) {
+        reset();
+    }
+
+    bool pack(uint16_t width, uint16_t height, uint32_t* outX, uint32_t* outY) override {
+        int bestIndex = -1;
+        int bestShortSide = std::numeric_limits<int>::max();
+        int bestLongSide = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < mFreeRects.size(); i++) {
+            const FreeRect& freeRect = mFreeRects[i];
+            if (freeRect.width < width || freeRect.height < height) continue;
+
+            const int leftoverX = freeRect.width - width;
+            const int leftoverY = freeRect.height - height;
+            const int shortSide = std::min(leftoverX, leftoverY);
+            const int longSide = std::max(leftoverX, leftoverY);
+            if (shortSide < bestShortSide
+                    || (shortSide == bestShortSide && longSide < bestLongSide)) {
+                bestIndex = i;
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+            }
+        }
+        if (bestIndex < 0) return false;
+
+        const FreeRect placed = { mFreeRects[bestIndex].x, mFreeRects[bestIndex].y, width, height };
+        splitFreeRects(placed);
+        mUsedArea += width * height;
+
+        *outX = placed.x;
+        *outY = placed.y;
+        return true;
+    }
+
+    void reset() override {
+        mFreeRects.clear();
+        mFreeRects.push_back({ TEXTURE_BORDER_SIZE, TEXTURE_BORDER_SIZE,
+                (uint16_t) (mWidth - TEXTURE_BORDER_SIZE),
+                (uint16_t) (mHeight - TEXTURE_BORDER_SIZE) });
+        mUsedArea = 0;
+    }
+
+    uint32_t getFreeArea() const override {
+        // Free rects overlap, but together cover all of the unused space
+        return (mWidth - TEXTURE_BORDER_SIZE) * (mHeight - TEXTURE_BORDER_SIZE) - mUsedArea;
+    }
+
+private:
+    struct FreeRect {
+        uint16_t x;
+        uint16_t y;
+        uint16_t width;
+        uint16_t height;
+
+        uint16_t right() const { return x + width; }
+        uint16_t bottom() const { return y + height; }
+
+        bool intersects(const FreeRect& other) const {
+            return x < other.right() && other.x < right()
+                    && y < other.bottom() && other.y < bottom();
+        }
+
+        bool contains(const FreeRect& other) const {
+            return x <= other.x && y <= other.y
+                    && right() >= other.right() && bottom() >= other.bottom();
+        }
+    };
+
+    // Replaces each free rect overlapping placed with the (up to four) maximal rects around it
+    void splitFreeRects(const FreeRect& placed) {
+        mSplitRects.clear();
+        for (size_t i = 0; i < mFreeRects.size();) {
+            const FreeRect freeRect = mFreeRects[i];
+            if (!freeRect.intersects(placed)) {
+                i++;
+                continue;
+            }
+
+            if (placed.x > freeRect.x) {
+                mSplitRects.push_back({ freeRect.x, freeRect.y,
+                        (uint16_t) (placed.x - freeRect.x), freeRect.height });
+            }
+            if (placed.right() < freeRect.right()) {
+                mSplitRects.push_back({ placed.right(), freeRect.y,
+                        (uint16_t) (freeRect.right() - placed.right()), freeRect.height });
+            }
+            if (placed.y > freeRect.y) {
+                mSplitRects.push_back({ freeRect.x, freeRect.y,
+                        freeRect.width, (uint16_t) (placed.y - freeRect.y) });
+            }
+            if (placed.bottom() < freeRect.bottom()) {
+                mSplitRects.push_back({ freeRect.x, placed.bottom(),
+                        freeRect.width, (uint16_t) (freeRect.bottom() - placed.bottom()) });
+            }
+
+            mFreeRects[i] = mFreeRects.back();
+            mFreeRects.pop_back();
+        }
+
+        // Only the new rects can be redundant with each other, or with the untouched free rects
+        for (size_t i = 0; i < mSplitRects.size(); i++) {
+            bool redundant = false;
+            for (size_t j = 0; j < mSplitRects.size() && !redundant; j++) {
+                // of two identical rects, keep the first
+                redundant = i != j && mSplitRects[j].contains(mSplitRects[i])
+                        && (j < i || !mSplitRects[i].contains(mSplitRects[j]));
+            }
+            for (size_t j = 0; j < mFreeRects.size() && !redundant; j++) {
+                redundant = mFreeRects[j].contains(mSplitRects[i]);
+            }
+            if (redundant) continue;
+
+            mFreeRects.erase(std::remove_if(mFreeRects.begin(), mFreeRects.end(),
+                    [this, i](const FreeRect& freeRect) {
+                return mSplitRects[i].contains(freeRect);
+            }), mFreeRects.end());
+            mFreeRects.push_back(mSplitRects[i]);
+        }
+    }
+
+    std::vector<FreeRect> mFreeRects;
+    std::vector<FreeRect> mSplitRects;
+    uint32_t mUsedArea = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AtlasPacker
+///////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<AtlasPacker> AtlasPacker::create(GlyphAtlasPacker type,
+        uint16_t width, uint16_t height) {
+    switch (type) {
+    case GlyphAtlasPacker::Skyline:
+        return std::unique_ptr<AtlasPacker>(new SkylineAtlasPacker(width, height));
+    case GlyphAtlasPacker::MaxRects:
+        return std::unique_ptr<AtlasPacker>(new MaxRectsAtlasPacker(width, height));
+    case GlyphAtlasPacker::Columns:
+    default:
+        return std::unique_ptr<AtlasPacker>(new ColumnAtlasPacker(width, height));
+    }
+}
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HWUI_ATLAS_PACKER_H
+#define ANDROID_HWUI_ATLAS_PACKER_H
+
+#include "Properties.h"
+
+#include <stdint.h>
+#include <memory>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Allocates space for glyphs within a CacheTexture.
+ *
+ * Packers reserve a TEXTURE_BORDER_SIZE strip along the top and left edges of the texture. Each
+ * packed size includes a single border, which the glyph shares with its right and bottom
+ * neighbours, so every glyph ends up surrounded by a border.
+ */
+class AtlasPacker {
+public:
+    static std::unique_ptr<AtlasPacker> create(GlyphAtlasPacker type,
+            uint16_t width, uint16_t height);
+
+    virtual ~AtlasPacker() {}
+
+    /**
+     * Finds space for a width x height rect, returning its top left corner. Returns false if there
+     * is no space for it.
+     */
+    virtual bool pack(uint16_t width, uint16_t height, uint32_t* outX, uint32_t* outY) = 0;
+
+    // Releases all packed space
+    virtual void reset() = 0;
+
+    /**
+     * Returns the area that may still be used by future packing. Space that is free, but too
+     * fragmented to be tracked by the packer, isn't included.
+     */
+    virtual uint32_t getFreeArea() const = 0;
+
+protected:
+    AtlasPacker(uint16_t width, uint16_t height)
+            : mWidth(width)
+            , mHeight(height) {}
+
+    const uint16_t mWidth;
+    const uint16_t mHeight;
+};
+
+}; // namespace uirenderer
+}; // namespace android
+
+#endif // ANDROID_HWUI_ATLAS_PACKER_H
@@ -18,6 +18,7 @@
 #define ANDROID_HWUI_CACHE_TEXTURE_H
 
 #include "PixelBuffer.h"
+#include "font/AtlasPacker.h"
 #include "Rect.h"
 #include "Texture.h"
 #include "Vertex.h"
@@ -26,51 +27,13 @@
 #include <SkGlyph.h>
 #include <utils/Log.h>
 
+#include <memory>
 
 namespace android {
 namespace uirenderer {
 
 class Caches;
 
-/**
- * CacheBlock is a node in a linked list of current free space areas in a CacheTexture.
- * Using CacheBlocks enables us to pack the cache from top to bottom as well as left to right.
- * When we add a glyph to the cache, we see if it fits within one of the existing columns that
- * have already been started (this is the case if the glyph fits vertically as well as
- * horizontally, and if its width is sufficiently close to the column width to avoid
- * sub-optimal packing of small glyphs into wide columns). If there is no column in which the
- * glyph fits, we check the final node, which is the remaining space in the cache, creating
- * a new column as appropriate.
- *
- * As columns fill up, we remove their CacheBlock from the list to avoid having to check
- * small blocks in the future.
- */
-struct CacheBlock {
-    uint16_t mX;
-    uint16_t mY;
-    uint16_t mWidth;
-    uint16_t mHeight;
-    CacheBlock* mNext;
-    CacheBlock* mPrev;
-
-    CacheBlock(uint16_t x, uint16_t y, uint16_t width, uint16_t height):
-            mX(x), mY(y), mWidth(width), mHeight(height), mNext(nullptr), mPrev(nullptr) {
-    }
-
-    static CacheBlock* insertBlock(CacheBlock* head, CacheBlock* newBlock);
-    static CacheBlock* removeBlock(CacheBlock* head, CacheBlock* blockToRemove);
-
-    void output() {
-        CacheBlock* currBlock = this;
-        while (currBlock) {
-            ALOGD("Block: this, x, y, w, h = %p, %d, %d, %d, %d",
-                    currBlock, currBlock->mX, currBlock->mY,
-                    currBlock->mWidth, currBlock->mHeight);
-            currBlock = currBlock->mNext;
-        }
-    }
-};
-
 class CacheTexture {
 public:
     CacheTexture(uint16_t width, uint16_t height, GLenum format, uint32_t maxQuadCount);
@@ -91,6 +54,15 @@ public:
 
     bool fitBitmap(const SkGlyph& glyph, uint32_t* retOriginX, uint32_t* retOriginY);
 
+    /**
+     * Finds space for a glyph of the given size, which includes a single TEXTURE_BORDER_SIZE, as
+     * the glyph shares its border with its neighbours.
+     */
+    bool fitRect(uint16_t glyphW, uint16_t glyphH, uint32_t* retOriginX, uint32_t* retOriginY);
+
+    // Marks the whole texture for upload, after glyphs are moved within the pixel buffer
+    void markDirty();
+
     inline uint16_t getWidth() const {
         return mWidth;
     }
@@ -180,6 +152,15 @@ public:
 
     uint32_t calculateFreeMemory() const;
 
+    // Fraction of the texture covered by glyphs, including their borders
+    float getOccupancy() const;
+
+    /**
+     * Fraction of the space consumed by the packer that isn't covered by glyphs, and so is wasted
+     * until the texture is reset.
+     */
+    float getFragmentation() const;
+
 private:
     void setDirty(bool dirty);
 
@@ -194,7 +175,8 @@ private:
     uint32_t mCurrentQuad = 0;
     uint32_t mMaxQuadCount;
     Caches& mCaches;
-    CacheBlock* mCacheBlocks;
+    std::unique_ptr<AtlasPacker> mPacker;
+    uint32_t mGlyphArea = 0;
     bool mHasUnpackRowLength;
     Rect mDirtyRect;
 };
@@ -48,6 +48,8 @@ struct CachedGlyphInfo {
     int8_t mLsbDelta;
     int8_t mRsbDelta;
     CacheTexture* mCacheTexture;
+    // Frame in which the glyph was last looked up, so cold glyphs can be evicted first
+    uint32_t mLastUsedFrame;
 };
 
 }; // namespace uirenderer
@@ -24,8 +24,12 @@
 #include <SkGlyphCache.h>
 #include <SkUtils.h>
 
+#include <algorithm>
+
 #include "FontUtil.h"
 #include "Font.h"
+#include "GlyphRasterTask.h"
+#include "../Caches.h"
 #include "../Debug.h"
 #include "../FontRenderer.h"
 #include "../PixelBuffer.h"
@@ -288,6 +292,7 @@ CachedGlyphInfo* Font::getCachedGlyph(const SkPaint* paint, glyph_t textUnit, bo
         cachedGlyph = cacheGlyph(paint, textUnit, precaching);
     }
 
+    cachedGlyph->mLastUsedFrame = mState->mFrameCount;
     return cachedGlyph;
 }
 
@@ -355,11 +360,15 @@ void Font::measure(const SkPaint* paint, const glyph_t* glyphs,
     render(paint, glyphs, numGlyphs, 0, 0, MEASURE, nullptr, 0, 0, bounds, positions);
 }
 
+// Minimum number of glyphs rasterized by each task when precaching in parallel
+static const size_t kMinGlyphsPerRasterTask = 8;
+
 void Font::precache(const SkPaint* paint, const glyph_t* glyphs, int numGlyphs) {
     if (numGlyphs == 0 || glyphs == nullptr) {
         return;
     }
 
+    std::vector<glyph_t> missingGlyphs;
     int glyphsCount = 0;
     while (glyphsCount < numGlyphs) {
         glyph_t glyph = *(glyphs++);
@@ -369,9 +378,61 @@ void Font::precache(const SkPaint* paint, const glyph_t* glyphs, int numGlyphs)
             break;
         }
 
-        getCachedGlyph(paint, glyph, true);
+        CachedGlyphInfo* cachedGlyph = mCachedGlyphs.valueFor(glyph);
+        if (cachedGlyph && cachedGlyph->mIsValid) {
+            cachedGlyph->mLastUsedFrame = mState->mFrameCount;
+        } else {
+            missingGlyphs.push_back(glyph);
+        }
         glyphsCount++;
     }
+
+    if (Properties::parallelGlyphRaster
+            && missingGlyphs.size() >= 2 * kMinGlyphsPerRasterTask
+            && Caches::getInstance().tasks.canRunTasks()) {
+        precacheInParallel(paint, missingGlyphs);
+    } else {
+        for (glyph_t glyph : missingGlyphs) {
+            getCachedGlyph(paint, glyph, true);
+        }
+    }
+}
+
+void Font::precacheInParallel(const SkPaint* paint, std::vector<glyph_t>& glyphs) {
+    ATRACE_NAME("precacheGlyphs");
+    std::sort(glyphs.begin(), glyphs.end());
+    glyphs.erase(std::unique(glyphs.begin(), glyphs.end()), glyphs.end());
+
+    TaskManager& taskManager = Caches::getInstance().tasks;
+    const size_t taskCount = std::max<size_t>(1, std::min<size_t>(taskManager.getWorkerCount(),
+            glyphs.size() / kMinGlyphsPerRasterTask));
+    if (!mState->mGlyphRasterProcessor.get()) {
+        mState->mGlyphRasterProcessor = new GlyphRasterProcessor(Caches::getInstance());
+    }
+
+    // Rasterize contiguous ranges of the missing glyphs on the workers...
+    std::vector<sp<GlyphRasterTask> > tasks;
+    for (size_t i = 0; i < taskCount; i++) {
+        std::vector<glyph_t> taskGlyphs(glyphs.begin() + glyphs.size() * i / taskCount,
+                glyphs.begin() + glyphs.size() * (i + 1) / taskCount);
+        tasks.push_back(new GlyphRasterTask(paint, mDescription.mLookupTransform,
+                std::move(taskGlyphs)));
+        mState->mGlyphRasterProcessor->add(tasks.back());
+    }
+
+    // ...then copy them into the cache textures, in order, as each task completes
+    for (const sp<GlyphRasterTask>& task : tasks) {
+        task->getResult();
+        for (size_t i = 0; i < task->glyphs.size(); i++) {
+            const SkGlyph& skiaGlyph = task->skiaGlyphs[i];
+            CachedGlyphInfo* cachedGlyph = mCachedGlyphs.valueFor(task->glyphs[i]);
+            if (!cachedGlyph) {
+                cachedGlyph = addCachedGlyph(task->glyphs[i], skiaGlyph);
+            }
+            updateGlyphCache(paint, skiaGlyph, nullptr, cachedGlyph, true);
+            cachedGlyph->mLastUsedFrame = mState->mFrameCount;
+        }
+    }
 }
 
 void Font::render(const SkPaint* paint, const glyph_t* glyphs,
@@ -435,8 +496,8 @@ void Font::updateGlyphCache(const SkPaint* paint, const SkGlyph& skiaGlyph,
     uint32_t startX = 0;
     uint32_t startY = 0;
 
-    // Get the bitmap for the glyph
-    if (!skiaGlyph.fImage) {
+    // Get the bitmap for the glyph, unless it was already rasterized off the render thread
+    if (!skiaGlyph.fImage && skiaGlyphCache) {
         skiaGlyphCache->findImage(skiaGlyph);
     }
     mState->cacheBitmap(skiaGlyph, glyph, &startX, &startY, precaching);
@@ -468,20 +529,24 @@ void Font::updateGlyphCache(const SkPaint* paint, const SkGlyph& skiaGlyph,
 }
 
 CachedGlyphInfo* Font::cacheGlyph(const SkPaint* paint, glyph_t glyph, bool precaching) {
-    CachedGlyphInfo* newGlyph = new CachedGlyphInfo();
-    mCachedGlyphs.add(glyph, newGlyph);
-
     SkSurfaceProps surfaceProps(0, kUnknown_SkPixelGeometry);
     SkAutoGlyphCacheNoGamma autoCache(*paint, &surfaceProps, &mDescription.mLookupTransform);
     const SkGlyph& skiaGlyph = GET_METRICS(autoCache.getCache(), glyph);
-    newGlyph->mIsValid = false;
-    newGlyph->mGlyphIndex = skiaGlyph.fID;
+    CachedGlyphInfo* newGlyph = addCachedGlyph(glyph, skiaGlyph);
 
     updateGlyphCache(paint, skiaGlyph, autoCache.getCache(), newGlyph, precaching);
 
     return newGlyph;
 }
 
+CachedGlyphInfo* Font::addCachedGlyph(glyph_t glyph, const SkGlyph& skiaGlyph) {
+    CachedGlyphInfo* newGlyph = new CachedGlyphInfo();
+    mCachedGlyphs.add(glyph, newGlyph);
+    newGlyph->mIsValid = false;
+    newGlyph->mGlyphIndex = skiaGlyph.fID;
+    return newGlyph;
+}
+
 Font* Font::create(FontRenderer* state, const SkPaint* paint, const SkMatrix& matrix) {
     FontDescription description(paint, matrix);
     Font* font = state->mActiveFonts.get(description);
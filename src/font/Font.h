@@ -100,6 +100,7 @@ public:
 
 private:
     friend class FontRenderer;
+    friend class TestUtils;
 
     Font(FontRenderer* state, const Font::FontDescription& desc);
 
@@ -113,6 +114,7 @@ private:
     };
 
     void precache(const SkPaint* paint, const glyph_t* glyphs, int numGlyphs);
+    void precacheInParallel(const SkPaint* paint, std::vector<glyph_t>& glyphs);
 
     void render(const SkPaint* paint, const glyph_t* glyphs,
             int numGlyphs, int x, int y, RenderMode mode, uint8_t *bitmap,
@@ -124,6 +126,7 @@ private:
     void invalidateTextureCache(CacheTexture* cacheTexture = nullptr);
 
     CachedGlyphInfo* cacheGlyph(const SkPaint* paint, glyph_t glyph, bool precaching);
+    CachedGlyphInfo* addCachedGlyph(glyph_t glyph, const SkGlyph& skiaGlyph);
     void updateGlyphCache(const SkPaint* paint, const SkGlyph& skiaGlyph,
             SkGlyphCache* skiaGlyphCache, CachedGlyphInfo* glyph, bool precaching);
 
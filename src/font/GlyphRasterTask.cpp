@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GlyphRasterTask.h"
+
+#include "../Caches.h"
+
+#include <SkGlyphCache.h>
+#include <SkSurfaceProps.h>
+#include <utils/Trace.h>
+
+namespace android {
+namespace uirenderer {
+
+GlyphRasterProcessor::GlyphRasterProcessor(Caches& caches)
+        : TaskProcessor<bool>(&caches.tasks) {
+}
+
+void GlyphRasterProcessor::onProcess(const sp<Task<bool> >& task) {
+    GlyphRasterTask* t = static_cast<GlyphRasterTask*>(task.get());
+    ATRACE_NAME("glyphPrecache");
+
+    // Each thread detaches its own SkGlyphCache, so workers never contend for one
+    SkSurfaceProps surfaceProps(0, kUnknown_SkPixelGeometry);
+    SkAutoGlyphCacheNoGamma autoCache(t->paint, &surfaceProps, &t->lookupTransform);
+    SkGlyphCache* skiaGlyphCache = autoCache.getCache();
+
+    // The images are copied out, as the SkGlyphCache may be purged once it's released
+    std::vector<size_t> imageOffsets;
+    imageOffsets.reserve(t->glyphs.size());
+    t->skiaGlyphs.reserve(t->glyphs.size());
+    for (glyph_t glyph : t->glyphs) {
+        const SkGlyph& skiaGlyph = GET_METRICS(skiaGlyphCache, glyph);
+        const uint8_t* image = (const uint8_t*) skiaGlyphCache->findImage(skiaGlyph);
+        imageOffsets.push_back(t->images.size());
+        if (image) {
+            t->images.insert(t->images.end(), image, image + skiaGlyph.computeImageSize());
+        }
+        t->skiaGlyphs.push_back(skiaGlyph);
+    }
+
+    for (size_t i = 0; i < t->skiaGlyphs.size(); i++) {
+        SkGlyph& skiaGlyph = t->skiaGlyphs[i];
+        skiaGlyph.fImage = skiaGlyph.fImage ? t->images.data() + imageOffsets[i] : nullptr;
+    }
+
+    t->setResult(true);
+}
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HWUI_GLYPH_RASTER_TASK_H
+#define ANDROID_HWUI_GLYPH_RASTER_TASK_H
+
+#include "FontUtil.h"
+#include "thread/Task.h"
+#include "thread/TaskProcessor.h"
+
+#include <SkGlyph.h>
+#include <SkMatrix.h>
+#include <SkPaint.h>
+
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+class Caches;
+
+/**
+ * Rasterizes a set of glyphs off the render thread, into a staging buffer owned by the task.
+ */
+class GlyphRasterTask: public Task<bool> {
+public:
+    GlyphRasterTask(const SkPaint* paint, const SkMatrix& lookupTransform,
+            std::vector<glyph_t>&& glyphs)
+            : paint(*paint)
+            , lookupTransform(lookupTransform)
+            , glyphs(std::move(glyphs)) {
+    }
+
+    // copied, since input paint may not be immutable
+    const SkPaint paint;
+    const SkMatrix lookupTransform;
+    const std::vector<glyph_t> glyphs;
+
+    // Once the result is available, holds the metrics of each glyph, with fImage pointing
+    // into images instead of into the SkGlyphCache
+    std::vector<SkGlyph> skiaGlyphs;
+    std::vector<uint8_t> images;
+};
+
+class GlyphRasterProcessor: public TaskProcessor<bool> {
+public:
+    explicit GlyphRasterProcessor(Caches& caches);
+    ~GlyphRasterProcessor() { }
+
+    virtual void onProcess(const sp<Task<bool> >& task) override;
+};
+
+}; // namespace uirenderer
+}; // namespace android
+
+#endif // ANDROID_HWUI_GLYPH_RASTER_TASK_H
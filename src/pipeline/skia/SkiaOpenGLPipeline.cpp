@@ -63,7 +63,7 @@ bool SkiaOpenGLPipeline::draw(const Frame& frame, const SkRect& screenDirty,
         const Rect& contentDrawBounds, bool opaque,
         const BakedOpRenderer::LightInfo& lightInfo,
         const std::vector<sp<RenderNode>>& renderNodes,
-        FrameInfoVisualizer* profiler) {
+        FrameInfoVisualizer* profiler, FrameInfo* currentFrameInfo) {
 
     mEglManager.damageFrame(frame, dirty);
 
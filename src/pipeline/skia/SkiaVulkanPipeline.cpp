@@ -69,7 +69,7 @@ bool SkiaVulkanPipeline::draw(const Frame& frame, const SkRect& screenDirty,
         const Rect& contentDrawBounds, bool opaque,
         const BakedOpRenderer::LightInfo& lightInfo,
         const std::vector<sp<RenderNode>>& renderNodes,
-        FrameInfoVisualizer* profiler) {
+        FrameInfoVisualizer* profiler, FrameInfo* currentFrameInfo) {
 
     sk_sp<SkSurface> backBuffer = mVkSurface->getBackBufferSurface();
     if (backBuffer.get() == nullptr) {
@@ -123,18 +123,21 @@ void Blend::setFactors(GLenum srcMode, GLenum dstMode) {
         if (mEnabled) {
             glDisable(GL_BLEND);
             mEnabled = false;
+            mChangeCount++;
         }
     } else {
         // enable blending
         if (!mEnabled) {
             glEnable(GL_BLEND);
             mEnabled = true;
+            mChangeCount++;
         }
 
         if (srcMode != mSrcMode || dstMode != mDstMode) {
             glBlendFunc(srcMode, dstMode);
             mSrcMode = srcMode;
             mDstMode = dstMode;
+            mChangeCount++;
         }
     }
 }
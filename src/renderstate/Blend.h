@@ -40,6 +40,9 @@ public:
             GLenum* outSrc, GLenum* outDst);
     void setFactors(GLenum src, GLenum dst);
 
+    // Number of times setFactors() has enabled, disabled or changed the function of blending
+    uint64_t getChangeCount() const { return mChangeCount; }
+
     void dump();
 private:
     Blend();
@@ -47,6 +50,7 @@ private:
     bool mEnabled;
     GLenum mSrcMode;
     GLenum mDstMode;
+    uint64_t mChangeCount = 0;
 };
 
 } /* namespace uirenderer */
@@ -20,6 +20,10 @@
 namespace android {
 namespace uirenderer {
 
+// Size of each per-frame segment of the streaming buffers
+static const GLsizeiptr kStreamingVertexSegmentSize = 512 * 1024;
+static const GLsizeiptr kStreamingIndexSegmentSize = 64 * 1024;
+
 MeshState::MeshState()
         : mCurrentIndicesBuffer(0)
         , mCurrentPixelBuffer(0)
@@ -55,6 +59,9 @@ MeshState::MeshState()
 }
 
 MeshState::~MeshState() {
+    mStreamingVertices.reset();
+    mStreamingIndices.reset();
+
     glDeleteBuffers(1, &mUnitQuadBuffer);
     mCurrentBuffer = 0;
 
@@ -110,9 +117,36 @@ void MeshState::deleteMeshBuffer(GLuint buffer) {
         // Reflect this in our cached value.
         mCurrentBuffer = 0;
     }
+    if (buffer == mCurrentIndicesBuffer) {
+        mCurrentIndicesBuffer = 0;
+    }
     glDeleteBuffers(1, &buffer);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Streaming
+///////////////////////////////////////////////////////////////////////////////
+
+void MeshState::initStreaming(bool persistent) {
+    mStreamingVertices.reset(new StreamingBuffer(*this, GL_ARRAY_BUFFER,
+            kStreamingVertexSegmentSize, persistent));
+    mStreamingIndices.reset(new StreamingBuffer(*this, GL_ELEMENT_ARRAY_BUFFER,
+            kStreamingIndexSegmentSize, persistent));
+}
+
+GLintptr MeshState::streamVertices(const void* data, GLsizeiptr size) {
+    return mStreamingVertices ? mStreamingVertices->write(data, size) : -1;
+}
+
+GLintptr MeshState::streamIndices(const void* data, GLsizeiptr size) {
+    return mStreamingIndices ? mStreamingIndices->write(data, size) : -1;
+}
+
+void MeshState::onFrameCompleted() {
+    if (mStreamingVertices) mStreamingVertices->advance();
+    if (mStreamingIndices) mStreamingIndices->advance();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vertices
 ///////////////////////////////////////////////////////////////////////////////
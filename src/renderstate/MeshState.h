@@ -17,6 +17,7 @@
 #define RENDERSTATE_MESHSTATE_H
 
 #include "Vertex.h"
+#include "renderstate/StreamingBuffer.h"
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
@@ -75,6 +76,33 @@ public:
     void updateMeshBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
     void deleteMeshBuffer(GLuint);
 
+    ///////////////////////////////////////////////////////////////////////////////
+    // Streaming
+    ///////////////////////////////////////////////////////////////////////////////
+
+    /**
+     * Creates the streaming vertex and index buffers. Until called, stream*() always fail.
+     */
+    void initStreaming(bool persistent);
+
+    /**
+     * Copies vertex data into the streaming VBO, and binds it. Returns the offset to draw the
+     * vertices from, or -1 if they must be drawn from client memory.
+     */
+    GLintptr streamVertices(const void* data, GLsizeiptr size);
+
+    /**
+     * Copies index data into the streaming IBO, and binds it. Returns the offset to draw the
+     * indices from, or -1 if they must be drawn from client memory.
+     */
+    GLintptr streamIndices(const void* data, GLsizeiptr size);
+
+    /**
+     * Signals that all draws of the frame have been issued, so streamed data written after this
+     * may go into storage that isn't used by them.
+     */
+    void onFrameCompleted();
+
     ///////////////////////////////////////////////////////////////////////////////
     // Vertices
     ///////////////////////////////////////////////////////////////////////////////
@@ -111,6 +139,8 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     GLuint getUnitQuadVBO() { return mUnitQuadBuffer; }
     GLuint getQuadListIBO() { return mQuadListIndices; }
+    GLuint getStreamingVBO() { return mStreamingVertices ? mStreamingVertices->getBuffer() : 0; }
+    GLuint getStreamingIBO() { return mStreamingIndices ? mStreamingIndices->getBuffer() : 0; }
 private:
     MeshState();
 
@@ -129,6 +159,9 @@ private:
 
     // Global index buffer
     GLuint mQuadListIndices;
+
+    std::unique_ptr<StreamingBuffer> mStreamingVertices;
+    std::unique_ptr<StreamingBuffer> mStreamingIndices;
 };
 
 } /* namespace uirenderer */
@@ -138,23 +138,55 @@ void OffscreenBufferPool::clear() {
     mSize = 0;
 }
 
+bool OffscreenBufferPool::canReuse(uint32_t textureWidth, uint32_t textureHeight,
+        uint32_t layerWidth, uint32_t layerHeight) {
+    const uint32_t idealWidth = OffscreenBuffer::computeIdealDimension(layerWidth);
+    const uint32_t idealHeight = OffscreenBuffer::computeIdealDimension(layerHeight);
+    if (textureWidth < idealWidth || textureHeight < idealHeight) return false;
+
+    const uint64_t idealArea = uint64_t(idealWidth) * idealHeight;
+    return uint64_t(textureWidth) * textureHeight <= idealArea * (1.0f + kMaxReuseWaste);
+}
+
+void OffscreenBufferPool::recordReuse(OffscreenBuffer* layer,
+        const uint32_t width, const uint32_t height) {
+    const uint32_t idealSize = OffscreenBuffer::computeIdealDimension(width)
+            * OffscreenBuffer::computeIdealDimension(height) * 4;
+    mFrameStats.hits++;
+    mFrameStats.wastedBytes += layer->getSizeInBytes() - idealSize;
+}
+
 OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
         const uint32_t width, const uint32_t height) {
     OffscreenBuffer* layer = nullptr;
 
-    Entry entry(width, height);
-    auto iter = mPool.find(entry);
+    // Find the smallest reusable entry. Entries are sorted by width, so stop once even the
+    // narrowest height would make the area too large.
+    const Entry ideal(width, height);
+    const uint64_t maxArea = uint64_t(ideal.width) * ideal.height * (1.0f + kMaxReuseWaste);
+    auto bestIter = mPool.end();
+    uint64_t bestArea = 0;
+    for (auto iter = mPool.lower_bound(Entry(width, 0));
+            iter != mPool.end() && uint64_t(iter->width) * ideal.height <= maxArea; iter++) {
+        const uint64_t area = uint64_t(iter->width) * iter->height;
+        if (iter->height >= ideal.height && area <= maxArea
+                && (bestIter == mPool.end() || area < bestArea)) {
+            bestIter = iter;
+            bestArea = area;
+        }
+    }
 
-    if (iter != mPool.end()) {
-        entry = *iter;
-        mPool.erase(iter);
+    if (bestIter != mPool.end()) {
+        layer = bestIter->layer;
+        mPool.erase(bestIter);
 
-        layer = entry.layer;
         layer->viewportWidth = width;
         layer->viewportHeight = height;
         mSize -= layer->getSizeInBytes();
+        recordReuse(layer, width, height);
     } else {
         layer = new OffscreenBuffer(renderState, Caches::getInstance(), width, height);
+        mFrameStats.misses++;
     }
 
     return layer;
@@ -163,11 +195,11 @@ OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
 OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
         const uint32_t width, const uint32_t height) {
     RenderState& renderState = layer->renderState;
-    if (layer->texture.width() == OffscreenBuffer::computeIdealDimension(width)
-            && layer->texture.height() == OffscreenBuffer::computeIdealDimension(height)) {
+    if (canReuse(layer->texture.width(), layer->texture.height(), width, height)) {
         // resize in place
         layer->viewportWidth = width;
         layer->viewportHeight = height;
+        recordReuse(layer, width, height);
 
         // entire area will be repainted (and may be smaller) so clear usage region
         layer->region.clear();
@@ -177,28 +209,43 @@ OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
     return get(renderState, width, height);
 }
 
+void OffscreenBufferPool::frameCompleted() {
+    mTotalStats.hits += mFrameStats.hits;
+    mTotalStats.misses += mFrameStats.misses;
+    mLastFrameStats = mFrameStats;
+    mFrameStats = Stats();
+}
+
 void OffscreenBufferPool::dump() {
     for (auto entry : mPool) {
         ALOGD("  Layer size %dx%d", entry.width, entry.height);
     }
+    ALOGD("  Last frame: %u hits, %u misses, %u bytes wasted",
+            mLastFrameStats.hits, mLastFrameStats.misses, mLastFrameStats.wastedBytes);
+    ALOGD("  Total: %u hits, %u misses", mTotalStats.hits, mTotalStats.misses);
 }
 
 void OffscreenBufferPool::putOrDelete(OffscreenBuffer* layer) {
     const uint32_t size = layer->getSizeInBytes();
     // Don't even try to cache a layer that's bigger than the cache
     if (size < mMaxSize) {
-        // TODO: Use an LRU
+        // Evict the least recently returned layers
         while (mSize + size > mMaxSize) {
-            OffscreenBuffer* victim = mPool.begin()->layer;
+            auto victimIter = mPool.begin();
+            for (auto iter = mPool.begin(); iter != mPool.end(); iter++) {
+                if (iter->putIndex < victimIter->putIndex) victimIter = iter;
+            }
+            OffscreenBuffer* victim = victimIter->layer;
             mSize -= victim->getSizeInBytes();
             delete victim;
-            mPool.erase(mPool.begin());
+            mPool.erase(victimIter);
         }
 
         // clear region, since it's no longer valid
         layer->region.clear();
 
         Entry entry(layer);
+        entry.putIndex = mPutCount++;
 
         mPool.insert(entry);
         mSize += size;
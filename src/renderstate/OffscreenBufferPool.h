@@ -83,9 +83,26 @@ public:
 
 /**
  * Pool of OffscreenBuffers allocated, but not currently in use.
+ *
+ * Buffers are reused if their texture is at least as large as the requested size (rounded up to
+ * LAYER_SIZE), and no more than kMaxReuseWaste larger in area. Of those, the smallest is chosen.
+ * This lets layers whose size changes slightly each frame (e.g. during a size animation) keep
+ * recycling the same few textures instead of allocating new ones.
  */
 class OffscreenBufferPool {
 public:
+    // Fraction of a requested (rounded up) area that a reused texture may exceed it by
+    static constexpr float kMaxReuseWaste = 0.5f;
+
+    struct Stats {
+        // requests served without allocating a new buffer
+        uint32_t hits = 0;
+        // requests that allocated a new buffer
+        uint32_t misses = 0;
+        // texture bytes of reused buffers, beyond the rounded up size requested
+        uint32_t wastedBytes = 0;
+    };
+
     OffscreenBufferPool();
     ~OffscreenBufferPool();
 
@@ -114,10 +131,24 @@ public:
 
     size_t getCount() { return mPool.size(); }
 
+    /**
+     * Ends the current frame's stats, so they're reported by getLastFrameStats() and dump().
+     */
+    void frameCompleted();
+
+    const Stats& getFrameStats() { return mFrameStats; }
+    const Stats& getLastFrameStats() { return mLastFrameStats; }
+
     /**
      * Prints out the content of the pool.
      */
     void dump();
+
+    /**
+     * Returns true if a texture of the given size may be reused for a layer of the given size.
+     */
+    static bool canReuse(uint32_t textureWidth, uint32_t textureHeight,
+            uint32_t layerWidth, uint32_t layerHeight);
 private:
     struct Entry {
         Entry() {}
@@ -149,12 +180,21 @@ private:
         OffscreenBuffer* layer = nullptr;
         uint32_t width = 0;
         uint32_t height = 0;
+        // order in which the entry was returned to the pool, for LRU eviction
+        uint32_t putIndex = 0;
     }; // struct Entry
 
+    void recordReuse(OffscreenBuffer* layer, uint32_t width, uint32_t height);
+
     std::multiset<Entry> mPool;
 
     uint32_t mSize = 0;
     uint32_t mMaxSize;
+    uint32_t mPutCount = 0;
+
+    Stats mFrameStats;
+    Stats mLastFrameStats;
+    Stats mTotalStats; // hits and misses only
 }; // class OffscreenBufferCache
 
 }; // namespace uirenderer
@@ -56,6 +56,10 @@ void RenderState::onGLContextCreated() {
         mCaches = &Caches::createInstance(*this);
     }
     mCaches->init();
+
+    if (Properties::streamMeshes && mCaches->extensions().hasMapBufferRange()) {
+        mMeshState->initStreaming(mCaches->extensions().hasBufferStorage());
+    }
 }
 
 static void layerLostGlContext(Layer* layer) {
@@ -422,13 +426,16 @@ void RenderState::render(const Glop& glop, const Matrix4& orthoMatrix) {
             }
 
             glDrawElements(mesh.primitiveMode, drawCount, GL_UNSIGNED_SHORT, nullptr);
+            mDrawCallCount++;
             elementsCount -= drawCount;
             vertexData += (drawCount / 6) * 4 * vertices.stride;
         }
     } else if (indices.bufferObject || indices.indices) {
         glDrawElements(mesh.primitiveMode, mesh.elementCount, GL_UNSIGNED_SHORT, indices.indices);
+        mDrawCallCount++;
     } else {
         glDrawArrays(mesh.primitiveMode, 0, mesh.elementCount);
+        mDrawCallCount++;
     }
 
     GL_CHECKPOINT(MODERATE);
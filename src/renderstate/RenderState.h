@@ -104,6 +104,9 @@ public:
 
     void render(const Glop& glop, const Matrix4& orthoMatrix);
 
+    // Total number of draw calls issued by render(), used to compute per frame draw counts
+    uint64_t getDrawCallCount() const { return mDrawCallCount; }
+
     Blend& blend() { return *mBlend; }
     MeshState& meshState() { return *mMeshState; }
     Scissor& scissor() { return *mScissor; }
@@ -140,6 +143,8 @@ private:
     GLsizei mViewportHeight;
     GLuint mFramebuffer;
 
+    uint64_t mDrawCallCount = 0;
+
     pthread_t mThreadId;
 };
 
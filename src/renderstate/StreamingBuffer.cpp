@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "renderstate/StreamingBuffer.h"
+
+#include "renderstate/MeshState.h"
+
+#include <log/log.h>
+#include <string.h>
+
+namespace android {
+namespace uirenderer {
+
+// Every write starts at a multiple of this, which satisfies the alignment of all vertex formats
+static const GLsizeiptr kWriteAlignment = 16;
+
+// How long to wait for the GPU to release a segment of persistent storage, which can't be orphaned
+static const GLuint64 kFenceTimeoutNs = 1000000000;
+
+#ifdef GL_EXT_buffer_storage
+static const GLbitfield kPersistentFlags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+#endif
+
+StreamingBuffer::StreamingBuffer(MeshState& meshState, GLenum target, GLsizeiptr segmentSize,
+        bool persistent)
+        : mMeshState(meshState)
+        , mTarget(target)
+        , mSegmentSize(segmentSize)
+#ifdef GL_EXT_buffer_storage
+        , mPersistent(persistent) {
+#else
+        , mPersistent(false) {
+#endif
+}
+
+StreamingBuffer::~StreamingBuffer() {
+    deleteFences();
+    if (mBuffer) {
+        // also releases any persistent mapping
+        mMeshState.deleteMeshBuffer(mBuffer);
+    }
+}
+
+void StreamingBuffer::bind() {
+    if (mTarget == GL_ARRAY_BUFFER) {
+        mMeshState.bindMeshBuffer(mBuffer);
+    } else {
+        mMeshState.bindIndicesBuffer(mBuffer);
+    }
+}
+
+bool StreamingBuffer::allocateStorage() {
+    if (!mBuffer) {
+        glGenBuffers(1, &mBuffer);
+    }
+    bind();
+
+    const GLsizeiptr size = mSegmentSize * kSegmentCount;
+    if (mPersistent) {
+#ifdef GL_EXT_buffer_storage
+        glBufferStorageEXT(mTarget, size, nullptr, kPersistentFlags);
+        mMappedStorage = (uint8_t*) glMapBufferRange(mTarget, 0, size, kPersistentFlags);
+        if (!mMappedStorage) {
+            ALOGW("Failed to map streaming buffer storage, drawing from client memory");
+            return false;
+        }
+#endif
+    } else {
+        glBufferData(mTarget, size, nullptr, GL_STREAM_DRAW);
+    }
+    mAllocationCount++;
+    return true;
+}
+
+void StreamingBuffer::deleteFences() {
+    for (GLsync& fence : mFences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+GLintptr StreamingBuffer::write(const void* data, GLsizeiptr size) {
+    if (mFailed) return -1;
+
+    const GLsizeiptr alignedSize = (size + kWriteAlignment - 1) & ~(kWriteAlignment - 1);
+    if (size <= 0 || alignedSize > mSegmentSize - mSegmentUsed) return -1;
+
+    if (!mAllocationCount && !allocateStorage()) {
+        mFailed = true;
+        return -1;
+    }
+
+    const GLintptr offset = mSegment * mSegmentSize + mSegmentUsed;
+    bind();
+    if (mMappedStorage) {
+        memcpy(mMappedStorage + offset, data, size);
+    } else {
+        // Segments are never written while the GPU may read them, so no need to synchronize
+        void* dst = glMapBufferRange(mTarget, offset, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!dst) {
+            ALOGW("Failed to map streaming buffer range, drawing from client memory");
+            mFailed = true;
+            return -1;
+        }
+        memcpy(dst, data, size);
+        if (glUnmapBuffer(mTarget) == GL_FALSE) {
+            // contents were lost (e.g. to a display mode change), though the buffer is still usable
+            return -1;
+        }
+    }
+    mSegmentUsed += alignedSize;
+    return offset;
+}
+
+void StreamingBuffer::advance() {
+    // nothing in the segment is in use yet, so keep writing to it
+    if (mFailed || !mSegmentUsed) return;
+
+    mFences[mSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mSegment = (mSegment + 1) % kSegmentCount;
+    mSegmentUsed = 0;
+
+    GLsync fence = mFences[mSegment];
+    if (!fence) return;
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        if (mPersistent) {
+            // immutable storage can't be orphaned, so wait for the GPU to finish with the segment
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+        } else {
+            // Orphan the storage, which GL keeps alive until the draws reading it complete. As this
+            // releases every segment, all of the fences are now irrelevant.
+            deleteFences();
+            bind();
+            glBufferData(mTarget, mSegmentSize * kSegmentCount, nullptr, GL_STREAM_DRAW);
+            mAllocationCount++;
+            return;
+        }
+    }
+    glDeleteSync(fence);
+    mFences[mSegment] = nullptr;
+
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        ALOGW("Streaming buffer segment not released by GPU (%#x), drawing from client memory",
+                status);
+        mFailed = true;
+    }
+}
+
+} /* namespace uirenderer */
+} /* namespace android */
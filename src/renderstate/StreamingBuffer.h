@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RENDERSTATE_STREAMINGBUFFER_H
+#define RENDERSTATE_STREAMINGBUFFER_H
+
+#include "utils/Macros.h"
+
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+
+namespace android {
+namespace uirenderer {
+
+class MeshState;
+
+/**
+ * Ring buffer object that mesh data is copied into right before it's drawn, instead of being drawn
+ * from client memory.
+ *
+ * The buffer is split into kSegmentCount segments, and each frame writes into one segment. When a
+ * frame completes, a fence is inserted after its draws and writing moves to the next segment. If
+ * the GPU hasn't finished reading the next segment yet, the buffer's storage is orphaned instead
+ * of waiting, so new data never overwrites data still in use, and writes never need to synchronize.
+ *
+ * With GL_EXT_buffer_storage, the buffer is mapped once for its whole lifetime. Otherwise, each
+ * write maps just its range, unsynchronized.
+ */
+class StreamingBuffer {
+    PREVENT_COPY_AND_ASSIGN(StreamingBuffer);
+public:
+    static const int kSegmentCount = 3;
+
+    /**
+     * target is GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER. Buffer storage isn't allocated until
+     * the first write.
+     */
+    StreamingBuffer(MeshState& meshState, GLenum target, GLsizeiptr segmentSize,
+            bool persistent);
+    ~StreamingBuffer();
+
+    /**
+     * Copies data into the current segment, and binds the buffer to the target.
+     *
+     * Returns the offset of the data within the buffer, or -1 if the data doesn't fit in what's
+     * left of the segment, or the buffer can't be written to. The data must then be drawn from
+     * client memory instead.
+     */
+    GLintptr write(const void* data, GLsizeiptr size);
+
+    /**
+     * Fences the draws issued since the last call, and moves writing to the next segment.
+     */
+    void advance();
+
+    GLuint getBuffer() const { return mBuffer; }
+
+    // Number of times the storage was allocated, either initially or to orphan in-use storage
+    int getAllocationCount() const { return mAllocationCount; }
+
+private:
+    bool allocateStorage();
+    void deleteFences();
+    void bind();
+
+    MeshState& mMeshState;
+    const GLenum mTarget;
+    const GLsizeiptr mSegmentSize;
+    const bool mPersistent;
+
+    GLuint mBuffer = 0;
+
+    // Set once writes fail, after which the buffer is no longer used
+    bool mFailed = false;
+
+    // Persistent mapping of the whole buffer, if any
+    uint8_t* mMappedStorage = nullptr;
+
+    GLsync mFences[kSegmentCount] = {};
+    int mSegment = 0;
+    GLsizeiptr mSegmentUsed = 0;
+    int mAllocationCount = 0;
+};
+
+} /* namespace uirenderer */
+} /* namespace android */
+
+#endif // RENDERSTATE_STREAMINGBUFFER_H
@@ -102,6 +102,7 @@ void TextureState::bindTexture(GLuint texture) {
     if (mBoundTextures[mTextureUnit] != texture) {
         glBindTexture(GL_TEXTURE_2D, texture);
         mBoundTextures[mTextureUnit] = texture;
+        mBindCount++;
     }
 }
 
@@ -113,6 +114,7 @@ void TextureState::bindTexture(GLenum target, GLuint texture) {
         // target=GL_TEXTURE_EXTERNAL_OES, don't cache this target
         // since the cached state could be stale
         glBindTexture(target, texture);
+        mBindCount++;
     }
 }
 
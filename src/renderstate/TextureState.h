@@ -77,6 +77,9 @@ public:
      */
     void unbindTexture(GLuint texture);
 
+    // Number of glBindTexture calls made through bindTexture()
+    uint64_t getBindCount() const { return mBindCount; }
+
     Texture* getShadowLutTexture() { return mShadowLutTexture.get(); }
 
 private:
@@ -90,6 +93,8 @@ private:
     // Caches texture bindings for the GL_TEXTURE_2D target
     GLuint mBoundTextures[kTextureUnitsCount];
 
+    uint64_t mBindCount = 0;
+
     std::unique_ptr<Texture> mShadowLutTexture;
 };
 
@@ -22,12 +22,16 @@
 #include "LayerUpdateQueue.h"
 #include "Properties.h"
 #include "RenderThread.h"
+#include "hwui/Bitmap.h"
 #include "hwui/Canvas.h"
 #include "renderstate/RenderState.h"
 #include "renderstate/Stencil.h"
 #include "OpenGLPipeline.h"
 #include "utils/GLUtils.h"
 #include "utils/TimeUtils.h"
+#ifdef HWUI_GLES_WRAP_ENABLED
+#include "debug/GlesAccountingDriver.h"
+#endif
 
 #include <cutils/properties.h>
 #include <private/hwui/DrawGlInfo.h>
@@ -293,6 +297,9 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
     mCurrentFrameInfo->importUiThreadInfo(uiFrameInfo);
     mCurrentFrameInfo->set(FrameInfoIndex::SyncQueued) = syncQueued;
     mCurrentFrameInfo->markSyncStart();
+#ifdef HWUI_GLES_WRAP_ENABLED
+    debug::GlesAccountingDriver::beginFrame();
+#endif
 
     info.damageAccumulator = &mDamageAccumulator;
     info.layerUpdateQueue = &mLayerUpdateQueue;
@@ -380,7 +387,8 @@ void CanvasContext::draw() {
     SkRect windowDirty = computeDirtyRect(frame, &dirty);
 
     bool drew = mRenderPipeline->draw(frame, windowDirty, dirty, mLightGeometry, &mLayerUpdateQueue,
-                                      mContentDrawBounds, mOpaque, mLightInfo, mRenderNodes, &(profiler()));
+                                      mContentDrawBounds, mOpaque, mLightInfo, mRenderNodes, &(profiler()),
+                                      mCurrentFrameInfo);
 
     // waitOnFences();
 
@@ -446,6 +454,9 @@ void CanvasContext::draw() {
     }
 #endif
 
+#ifdef HWUI_GLES_WRAP_ENABLED
+    debug::GlesAccountingDriver::endFrame(*mCurrentFrameInfo);
+#endif
     mJankTracker.addFrame(*mCurrentFrameInfo);
     mRenderThread.jankTracker().addFrame(*mCurrentFrameInfo);
     if (CC_UNLIKELY(mFrameMetricsReporter.get() != nullptr)) {
@@ -453,13 +464,6 @@ void CanvasContext::draw() {
     }
 
     GpuMemoryTracker::onFrameCompleted();
-#ifdef BUGREPORT_FONT_CACHE_USAGE
-    auto renderType = Properties::getRenderPipelineType();
-    if (RenderPipelineType::OpenGL == renderType) {
-        Caches& caches = Caches::getInstance();
-        caches.fontRenderer.getFontRenderer().historyTracker().frameCompleted();
-    }
-#endif
 
 }
 
@@ -558,6 +562,29 @@ void CanvasContext::trimMemory(RenderThread& thread, int level) {
     }
 }
 
+bool CanvasContext::deferPinImages(LsaVector<sk_sp<Bitmap>>& images) {
+    for (auto& bitmap : images) {
+        if (!bitmap->isImmutable()) {
+            return mRenderPipeline->pinImages(images);
+        }
+    }
+    if (!images.empty()) {
+        mDeferredImages.push_back(&images);
+    }
+    return true;
+}
+
+void CanvasContext::pinDeferredImages() {
+    if (mDeferredImages.empty()) return;
+    ATRACE_CALL();
+    for (auto images : mDeferredImages) {
+        // Images that don't fit in the cache are uploaded when drawn instead, which is safe
+        // as their pixels can't change
+        if (!mRenderPipeline->pinImages(*images)) break;
+    }
+    mDeferredImages.clear();
+}
+
 DeferredLayerUpdater* CanvasContext::createTextureLayer() {
     return mRenderPipeline->createTextureLayer();
 }
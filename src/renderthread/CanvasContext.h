@@ -91,10 +91,30 @@ public:
         return mRenderPipeline->pinImages(images);
     }
 
+    /**
+     * Pins the images now if any of them is mutable, as the UI thread could
+     * change their pixels once released from the sync. Otherwise they are
+     * left for pinDeferredImages(), and are kept alive by the display list
+     * that owns them until the next sync.
+     *
+     * @return false if the images were pinned now and did not fit in the GPU
+     *         cache, true otherwise.
+     */
+    bool deferPinImages(LsaVector<sk_sp<Bitmap>>& images);
+
+    /**
+     * Pins the images left by deferPinImages() since the last sync. Runs once
+     * the UI thread has been released, right before drawing.
+     */
+    void pinDeferredImages();
+
     /**
      * Unpin any image that had be previously pinned to the GPU cache
      */
-    void unpinImages() { mRenderPipeline->unpinImages(); }
+    void unpinImages() {
+        mDeferredImages.clear();
+        mRenderPipeline->unpinImages();
+    }
 
     /**
      * Destroy any layers that have been attached to the provided RenderNode removing
@@ -252,6 +272,12 @@ private:
 
     std::set<RenderNode*> mPrefetchedLayers;
 
+    // Bitmap lists of the synced display lists, waiting to be pinned. These point into the
+    // display lists, which the UI thread may replace or free once released from the sync, so
+    // they are only valid until the next sync: DrawFrameTask::syncFrameState() calls
+    // unpinImages(), which clears them, before preparing the tree again.
+    std::vector<LsaVector<sk_sp<Bitmap>>*> mDeferredImages;
+
     // Stores the bounds of the main content.
     Rect mContentDrawBounds;
 
@@ -21,6 +21,7 @@
 
 #include "../DeferredLayerUpdater.h"
 #include "../DisplayList.h"
+#include "../Properties.h"
 #include "../RenderNode.h"
 #include "CanvasContext.h"
 #include "RenderThread.h"
@@ -66,6 +67,7 @@ void DrawFrameTask::run() {
     bool canDrawThisFrame = true;
     {
         TreeInfo info(TreeInfo::MODE_FULL, *mContext);
+        info.deferImageUploads = Properties::pipelinedSync;
         canUnblockUiThread = syncFrameState(info);
         canDrawThisFrame = info.out.canDrawThisFrame;
     }
@@ -79,6 +81,9 @@ void DrawFrameTask::run() {
     }
 
     if (CC_LIKELY(canDrawThisFrame)) {
+        // With a pipelined sync, the UI thread records the next frame while this one uploads,
+        // on platforms where the render thread runs apart from the UI thread
+        context->pinDeferredImages();
         context->draw();
     } else {
         // wait on fences so tasks don't overlap next frame
@@ -60,7 +60,7 @@ bool OpenGLPipeline::draw(const Frame& frame, const SkRect& screenDirty, const S
         const Rect& contentDrawBounds, bool opaque,
         const BakedOpRenderer::LightInfo& lightInfo,
         const std::vector< sp<RenderNode> >& renderNodes,
-        FrameInfoVisualizer* profiler) {
+        FrameInfoVisualizer* profiler, FrameInfo* currentFrameInfo) {
 
     mEglManager.damageFrame(frame, dirty);
 
@@ -75,17 +75,35 @@ bool OpenGLPipeline::draw(const Frame& frame, const SkRect& screenDirty, const S
 
     frameBuilder.deferRenderNodeScene(renderNodes, contentDrawBounds);
 
-    BakedOpRenderer renderer(caches, mRenderThread.renderState(),
-            opaque, lightInfo);
+    RenderState& renderState = mRenderThread.renderState();
+    const uint64_t startDrawCallCount = renderState.getDrawCallCount();
+    const uint64_t startProgramSwitchCount = caches.getProgramSwitchCount();
+    const uint64_t startTextureBindCount = caches.textureState().getBindCount();
+    const uint64_t startBlendChangeCount = renderState.blend().getChangeCount();
+    currentFrameInfo->markReplayStart();
+    BakedOpRenderer renderer(caches, renderState, opaque, lightInfo);
     frameBuilder.replayBakedOps<BakedOpDispatcher>(renderer);
+    currentFrameInfo->set(FrameInfoIndex::CulledOpCount) = frameBuilder.getCulledOpCount();
     ProfileRenderer profileRenderer(renderer);
     profiler->draw(profileRenderer);
+    currentFrameInfo->set(FrameInfoIndex::DrawCallCount) =
+            renderState.getDrawCallCount() - startDrawCallCount;
+    currentFrameInfo->set(FrameInfoIndex::ProgramSwitchCount) =
+            caches.getProgramSwitchCount() - startProgramSwitchCount;
+    currentFrameInfo->set(FrameInfoIndex::TextureBindCount) =
+            caches.textureState().getBindCount() - startTextureBindCount;
+    currentFrameInfo->set(FrameInfoIndex::BlendChangeCount) =
+            renderState.blend().getChangeCount() - startBlendChangeCount;
     drew = renderer.didDraw();
+    renderState.meshState().onFrameCompleted();
 
     // post frame cleanup
     caches.clearGarbage();
     caches.pathCache.trim();
     caches.tessellationCache.trim();
+    caches.fontRenderer.getFontRenderer().frameCompleted();
+    caches.budgetArbiter.frameCompleted();
+    renderState.layerPool().frameCompleted();
 
 #if DEBUG_MEMORY_USAGE
     caches.dumpMemoryUsage();
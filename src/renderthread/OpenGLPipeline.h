@@ -39,7 +39,7 @@ public:
             const Rect& contentDrawBounds, bool opaque,
             const BakedOpRenderer::LightInfo& lightInfo,
             const std::vector< sp<RenderNode> >& renderNodes,
-            FrameInfoVisualizer* profiler) override;
+            FrameInfoVisualizer* profiler, FrameInfo* currentFrameInfo) override;
     bool swapBuffers(const Frame& frame, bool drew, const SkRect& screenDirty,
             FrameInfo* currentFrameInfo, bool* requireSwap) override;
     bool copyLayerInto(DeferredLayerUpdater* layer, SkBitmap* bitmap) override;
@@ -27,7 +27,9 @@
 #include "renderstate/RenderState.h"
 #include "utils/Macros.h"
 #include "utils/TimeUtils.h"
+#include <minikin/Layout.h>
 #include <sys/syscall.h>
+#include <utils/Trace.h>
 
 namespace android {
 namespace uirenderer {
@@ -459,6 +461,7 @@ CREATE_BRIDGE2(dumpGraphicsMemory, int fd, RenderThread* thread) {
     }
     fprintf(file, "\nPipeline=FrameBuilder\n");
     fflush(file);
+    minikin::Layout::dumpCacheStats(args->fd);
     return nullptr;
 }
 
@@ -698,6 +701,14 @@ void RenderProxy::disableVsync() {
     Properties::disableVsync = true;
 }
 
+void RenderProxy::setTracingEnabled(bool enabled) {
+    trace::setEnabled(enabled);
+}
+
+bool RenderProxy::dumpTrace(const char* path) {
+    return trace::dump(path);
+}
+
 void RenderProxy::post(RenderTask* task) {
     task->run();
 }
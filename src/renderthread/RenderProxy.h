@@ -110,6 +110,10 @@ public:
     uint32_t frameTimePercentile(int p);
     ANDROID_API static void dumpGraphicsMemory(int fd);
 
+    // Trace sections are recorded by each thread, these don't go through the RenderThread
+    ANDROID_API static void setTracingEnabled(bool enabled);
+    ANDROID_API static bool dumpTrace(const char* path);
+
     ANDROID_API static void rotateProcessStatsBuffer();
     ANDROID_API static void setProcessStatsBuffer(int fd);
     // ANDROID_API int getRenderThreadTid();
@@ -16,11 +16,15 @@
 
 #include "RenderThread.h"
 
+#include "../Properties.h"
 #include "../renderstate/RenderState.h"
 #include "CanvasContext.h"
 #include "EglManager.h"
 #include "RenderProxy.h"
 #include "utils/FatVector.h"
+#ifdef HWUI_GLES_WRAP_ENABLED
+#include "debug/GlesAccountingDriver.h"
+#endif
 
 #include <sys/resource.h>
 #include <utils/Condition.h>
@@ -39,9 +43,64 @@ static const size_t EVENT_BUFFER_SIZE = 100;
 // Slight delay to give the UI time to push us a new frame before we replay
 static const nsecs_t DISPATCH_FRAME_CALLBACKS_DELAY = milliseconds_to_nanoseconds(4);
 
-TaskQueue::TaskQueue() : mHead(nullptr), mTail(nullptr) {}
+TaskQueue::TaskQueue()
+        : mHead(nullptr)
+        , mTail(nullptr)
+        , mIncoming(nullptr)
+        , mIncomingAtFront(nullptr) {}
+
+void TaskQueue::push(std::atomic<RenderTask*>& stack, RenderTask* task) {
+    // Since the RenderTask itself forms the linked list it is not allowed
+    // to have the same task queued twice. Only the render thread can see
+    // all of the queue, so this only catches some of the cases.
+    RenderTask* top = stack.load(std::memory_order_relaxed);
+    LOG_ALWAYS_FATAL_IF(task->mNext || top == task, "Task is already in the queue!");
+    do {
+        task->mNext = top;
+    } while (!stack.compare_exchange_weak(top, task,
+            std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Takes all the tasks pushed onto the stack, and returns them in the order they were pushed
+RenderTask* TaskQueue::takeAll(std::atomic<RenderTask*>& stack) {
+    if (!stack.load(std::memory_order_relaxed)) return nullptr;
+
+    RenderTask* task = stack.exchange(nullptr, std::memory_order_acquire);
+    RenderTask* reversed = nullptr;
+    while (task) {
+        RenderTask* next = task->mNext;
+        task->mNext = reversed;
+        reversed = task;
+        task = next;
+    }
+    return reversed;
+}
+
+void TaskQueue::drainIncoming() {
+    RenderTask* task = takeAll(mIncoming);
+    while (task) {
+        RenderTask* next = task->mNext;
+        task->mNext = nullptr;
+        insert(task);
+        task = next;
+    }
+
+    // Each task queued at the front goes ahead of those queued at the
+    // front before it, so add them in the order they were queued
+    task = takeAll(mIncomingAtFront);
+    while (task) {
+        RenderTask* next = task->mNext;
+        task->mNext = mHead;
+        mHead = task;
+        if (!mTail) {
+            mTail = task;
+        }
+        task = next;
+    }
+}
 
 RenderTask* TaskQueue::next() {
+    drainIncoming();
     RenderTask* ret = mHead;
     if (ret) {
         mHead = ret->mNext;
@@ -54,13 +113,19 @@ RenderTask* TaskQueue::next() {
 }
 
 RenderTask* TaskQueue::peek() {
+    drainIncoming();
     return mHead;
 }
 
 void TaskQueue::queue(RenderTask* task) {
-    // Since the RenderTask itself forms the linked list it is not allowed
-    // to have the same task queued twice
-    LOG_ALWAYS_FATAL_IF(task->mNext || mTail == task, "Task is already in the queue!");
+    push(mIncoming, task);
+}
+
+void TaskQueue::queueAtFront(RenderTask* task) {
+    push(mIncomingAtFront, task);
+}
+
+void TaskQueue::insert(RenderTask* task) {
     if (mTail) {
         // Fast path if we can just append
         if (mTail->mRunAt <= task->mRunAt) {
@@ -91,17 +156,9 @@ void TaskQueue::queue(RenderTask* task) {
     }
 }
 
-void TaskQueue::queueAtFront(RenderTask* task) {
-    LOG_ALWAYS_FATAL_IF(task->mNext || mHead == task, "Task is already in the queue!");
-    if (mTail) {
-        task->mNext = mHead;
-        mHead = task;
-    } else {
-        mTail = mHead = task;
-    }
-}
-
 void TaskQueue::remove(RenderTask* task) {
+    drainIncoming();
+
     // TaskQueue is strict here to enforce that users are keeping track of
     // their RenderTasks due to how their memory is managed
     LOG_ALWAYS_FATAL_IF(!task->mNext && mTail != task,
@@ -117,6 +174,7 @@ void TaskQueue::remove(RenderTask* task) {
             previous = previous->mNext;
         }
         previous->mNext = task->mNext;
+        task->mNext = nullptr;
         if (mTail == task) {
             mTail = previous;
         }
@@ -188,6 +246,11 @@ void RenderThread::initThreadLocals() {
     nsecs_t frameIntervalNanos = static_cast<nsecs_t>(1000000000 / mDisplayInfo.fps);
     mTimeLord.setFrameInterval(frameIntervalNanos);
     initializeDisplayEventReceiver();
+#ifdef HWUI_GLES_WRAP_ENABLED
+    if (Properties::glAccounting) {
+        debug::GlesAccountingDriver::install();
+    }
+#endif
     mEglManager = new EglManager(*this);
     mRenderState = new RenderState(*this);
     mJankTracker = new JankTracker(mDisplayInfo);
@@ -283,7 +346,6 @@ void RenderThread::queueAndWait(RenderTask* task) {
 }
 
 void RenderThread::queueAtFront(RenderTask* task) {
-    AutoMutex _lock(mLock);
     mQueue.queueAtFront(task);
 }
 
@@ -293,7 +355,6 @@ void RenderThread::queueAt(RenderTask* task, nsecs_t runAtNs) {
 }
 
 void RenderThread::remove(RenderTask* task) {
-    AutoMutex _lock(mLock);
     mQueue.remove(task);
 }
 
@@ -315,7 +376,6 @@ void RenderThread::pushBackFrameCallback(IFrameCallback* callback) {
 }
 
 RenderTask* RenderThread::nextTask(nsecs_t* nextWakeup) {
-    AutoMutex _lock(mLock);
     RenderTask* next = mQueue.peek();
     if (!next) {
         mNextWakeup = LLONG_MAX;
@@ -26,6 +26,7 @@
 #include <ui/DisplayInfo.h>
 #include <utils/Thread.h>
 
+#include <atomic>
 #include <memory>
 #include <set>
 
@@ -42,6 +43,13 @@ class CanvasContext;
 class DispatchFrameCallbacks;
 class EglManager;
 
+/**
+ * Tasks ordered by mRunAt, and then in the order they were queued.
+ *
+ * Any thread can queue tasks without taking a lock: they are pushed onto lock-free stacks,
+ * which the render thread moves into the ordered list the next time it looks at the queue.
+ * next(), peek() and remove() must only be called by the render thread.
+ */
 class TaskQueue {
 public:
     TaskQueue();
@@ -53,8 +61,19 @@ public:
     void remove(RenderTask* task);
 
 private:
+    static void push(std::atomic<RenderTask*>& stack, RenderTask* task);
+    static RenderTask* takeAll(std::atomic<RenderTask*>& stack);
+
+    void drainIncoming();
+    void insert(RenderTask* task);
+
+    // Only accessed by the render thread
     RenderTask* mHead;
     RenderTask* mTail;
+
+    // Tasks queued since the render thread last drained them, most recent first
+    std::atomic<RenderTask*> mIncoming;
+    std::atomic<RenderTask*> mIncomingAtFront;
 };
 
 // Mimics android.view.Choreographer.FrameCallback
@@ -115,8 +134,6 @@ private:
     // set to this time
     RenderTask* nextTask(nsecs_t* nextWakeup);
 
-    Mutex mLock;
-
     nsecs_t mNextWakeup;
     TaskQueue mQueue;
 
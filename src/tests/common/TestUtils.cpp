@@ -18,6 +18,7 @@
 
 #include "hwui/Paint.h"
 #include "DeferredLayerUpdater.h"
+#include "FontRenderer.h"
 
 #include <renderthread/EglManager.h>
 #include <renderthread/OpenGLPipeline.h>
@@ -158,6 +159,15 @@ std::unique_ptr<uint16_t[]> TestUtils::asciiToUtf16(const char* str) {
     return utf16;
 }
 
+CachedGlyphInfo* TestUtils::getCachedGlyph(FontRenderer& fontRenderer, glyph_t glyph) {
+    return fontRenderer.mCurrentFont->mCachedGlyphs.valueFor(glyph);
+}
+
+bool TestUtils::compactCacheTexture(FontRenderer& fontRenderer, CacheTexture* cacheTexture,
+        uint32_t minLastUsedFrame) {
+    return fontRenderer.compactCacheTexture(cacheTexture, minLastUsedFrame);
+}
+
 SkColor TestUtils::getColor(const sk_sp<SkSurface>& surface, int x, int y) {
     SkPixmap pixmap;
     if (!surface->peekPixels(&pixmap)) {
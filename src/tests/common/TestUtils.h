@@ -36,6 +36,10 @@
 namespace android {
 namespace uirenderer {
 
+class CacheTexture;
+class FontRenderer;
+struct CachedGlyphInfo;
+
 #define EXPECT_MATRIX_APPROX_EQ(a, b) \
     EXPECT_TRUE(TestUtils::matricesAreApproxEqual(a, b))
 
@@ -339,6 +343,12 @@ public:
 
     static std::unique_ptr<uint16_t[]> asciiToUtf16(const char* str);
 
+    // Returns the glyph as cached for the current font, or null if it was never cached
+    static CachedGlyphInfo* getCachedGlyph(FontRenderer& fontRenderer, glyph_t glyph);
+
+    static bool compactCacheTexture(FontRenderer& fontRenderer, CacheTexture* cacheTexture,
+            uint32_t minLastUsedFrame);
+
     class MockFunctor : public Functor {
      public:
          virtual status_t operator ()(int what, void* data) {
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameReport.h"
+
+#include "FrameInfo.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+// Changes smaller than these are noise, whatever the threshold
+static const int64_t kMinTimeRegression = 20000;
+static const int64_t kMinCountRegression = 2;
+static const int64_t kMinBytesRegression = 16 * 1024;
+
+static const struct {
+    const char* name;
+    // Whether growing is the regression; for culled ops it's shrinking, as more gets drawn
+    bool higherIsWorse;
+    int64_t minRegression;
+} kMetrics[] = {
+    { "record", true, kMinTimeRegression },
+    { "sync", true, kMinTimeRegression },
+    { "defer", true, kMinTimeRegression },
+    { "replay", true, kMinTimeRegression },
+    { "total", true, kMinTimeRegression },
+    { "drawCalls", true, kMinCountRegression },
+    { "programSwitches", true, kMinCountRegression },
+    { "textureBinds", true, kMinCountRegression },
+    { "blendChanges", true, kMinCountRegression },
+    { "culledOps", false, kMinCountRegression },
+    { "glCalls", true, kMinCountRegression },
+    { "glCallTime", true, kMinTimeRegression },
+    { "stateChanges", true, kMinCountRegression },
+    { "bufferUploads", true, kMinCountRegression },
+    { "bufferUploadBytes", true, kMinBytesRegression },
+    { "textureUploads", true, kMinCountRegression },
+    { "textureUploadBytes", true, kMinBytesRegression },
+};
+
+static_assert((sizeof(kMetrics) / sizeof(kMetrics[0])) == FrameReport::MetricCount,
+        "kMetrics doesn't match the Metric enum!");
+
+const int FrameReport::kPercentiles[] = { 50, 90, 95, 99 };
+const size_t FrameReport::kPercentileCount = sizeof(kPercentiles) / sizeof(kPercentiles[0]);
+
+// Percentiles compared against a baseline; the tail ones are too noisy to fail a run on
+static const int kComparedPercentiles[] = { 50, 90 };
+
+void FrameReport::Observer::notify(const int64_t* buffer) {
+    FrameInfo frame;
+    for (int i = 0; i < static_cast<int>(FrameInfoIndex::NumIndexes); i++) {
+        frame.set(static_cast<FrameInfoIndex>(i)) = buffer[i];
+    }
+
+    FrameMetrics metrics;
+    metrics[Record] = frame.duration(FrameInfoIndex::DrawStart, FrameInfoIndex::SyncQueued);
+    metrics[Sync] = frame.duration(FrameInfoIndex::SyncStart,
+            FrameInfoIndex::IssueDrawCommandsStart);
+    metrics[Defer] = frame.duration(FrameInfoIndex::IssueDrawCommandsStart,
+            FrameInfoIndex::ReplayStart);
+    metrics[Replay] = frame.duration(FrameInfoIndex::ReplayStart, FrameInfoIndex::SwapBuffers);
+    metrics[Total] = frame.duration(FrameInfoIndex::SyncStart, FrameInfoIndex::FrameCompleted);
+    metrics[DrawCalls] = frame[FrameInfoIndex::DrawCallCount];
+    metrics[ProgramSwitches] = frame[FrameInfoIndex::ProgramSwitchCount];
+    metrics[TextureBinds] = frame[FrameInfoIndex::TextureBindCount];
+    metrics[BlendChanges] = frame[FrameInfoIndex::BlendChangeCount];
+    metrics[CulledOps] = frame[FrameInfoIndex::CulledOpCount];
+    metrics[GlCalls] = frame[FrameInfoIndex::GlCallCount];
+    metrics[GlCallTime] = frame[FrameInfoIndex::GlCallDuration];
+    metrics[StateChanges] = frame[FrameInfoIndex::StateChangeCount];
+    metrics[BufferUploads] = frame[FrameInfoIndex::BufferUploadCount];
+    metrics[BufferUploadBytes] = frame[FrameInfoIndex::BufferUploadBytes];
+    metrics[TextureUploads] = frame[FrameInfoIndex::TextureUploadCount];
+    metrics[TextureUploadBytes] = frame[FrameInfoIndex::TextureUploadBytes];
+
+    AutoMutex _lock(mLock);
+    mFrames->push_back(metrics);
+}
+
+sp<FrameReport::Observer> FrameReport::observeScene(const std::string& name) {
+    return new Observer(&mScenes[name]);
+}
+
+static int64_t findPercentile(std::vector<int64_t>& values, int percentile) {
+    if (values.empty()) return 0;
+    size_t index = std::min(values.size() - 1, values.size() * percentile / 100);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static int64_t findPercentile(const std::vector<FrameReport::FrameMetrics>& frames,
+        int metric, int percentile) {
+    std::vector<int64_t> values;
+    values.reserve(frames.size());
+    for (auto& frame : frames) {
+        values.push_back(frame[metric]);
+    }
+    return findPercentile(values, percentile);
+}
+
+bool FrameReport::writeJson(const char* path) const {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open '%s' for writing\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"scenes\": [");
+    bool firstScene = true;
+    for (auto& scene : mScenes) {
+        fprintf(file, "%s\n    {\n      \"name\": \"%s\",\n      \"frames\": [",
+                firstScene ? "" : ",", scene.first.c_str());
+        firstScene = false;
+
+        for (size_t i = 0; i < scene.second.size(); i++) {
+            fprintf(file, "%s\n        {", i ? "," : "");
+            for (int metric = 0; metric < MetricCount; metric++) {
+                fprintf(file, "%s\"%s\": %" PRId64, metric ? ", " : "", kMetrics[metric].name,
+                        scene.second[i][metric]);
+            }
+            fprintf(file, "}");
+        }
+
+        fprintf(file, "\n      ],\n      \"summary\": {");
+        for (int metric = 0; metric < MetricCount; metric++) {
+            fprintf(file, "%s\n        \"%s\": {", metric ? "," : "", kMetrics[metric].name);
+            for (size_t p = 0; p < kPercentileCount; p++) {
+                fprintf(file, "%s\"%dth\": %" PRId64, p ? ", " : "", kPercentiles[p],
+                        findPercentile(scene.second, metric, kPercentiles[p]));
+            }
+            fprintf(file, "}");
+        }
+        fprintf(file, "\n      }\n    }");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+// Just enough JSON to read back a report written by writeJson
+struct JsonValue {
+    enum class Type {
+        Null,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    Type type = Type::Null;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* get(const char* key) const {
+        for (auto& member : object) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    JsonParser(const char* begin, const char* end) : mPos(begin), mEnd(end) {}
+
+    bool parse(JsonValue& value) {
+        if (!parseValue(value)) return false;
+        skipSpace();
+        return mPos == mEnd;
+    }
+
+private:
+    void skipSpace() {
+        while (mPos < mEnd && (*mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t')) {
+            mPos++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (mPos < mEnd && *mPos == c) {
+            mPos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(const char* literal) {
+        size_t length = strlen(literal);
+        if (size_t(mEnd - mPos) < length || strncmp(mPos, literal, length)) return false;
+        mPos += length;
+        return true;
+    }
+
+    bool parseString(std::string& string) {
+        if (!consume('"')) return false;
+        while (mPos < mEnd && *mPos != '"') {
+            if (*mPos == '\\') {
+                if (++mPos == mEnd) return false;
+                switch (*mPos) {
+                case 'n': string += '\n'; break;
+                case 't': string += '\t'; break;
+                case 'u':
+                    // Not written by reports, keep a placeholder
+                    if (mEnd - mPos < 5) return false;
+                    mPos += 4;
+                    string += '?';
+                    break;
+                default: string += *mPos; break;
+                }
+            } else {
+                string += *mPos;
+            }
+            mPos++;
+        }
+        return consume('"');
+    }
+
+    bool parseValue(JsonValue& value) {
+        skipSpace();
+        if (mPos == mEnd) return false;
+
+        if (*mPos == '{') {
+            mPos++;
+            value.type = JsonValue::Type::Object;
+            if (consume('}')) return true;
+            do {
+                value.object.emplace_back();
+                if (!parseString(value.object.back().first) || !consume(':')
+                        || !parseValue(value.object.back().second)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+        if (*mPos == '[') {
+            mPos++;
+            value.type = JsonValue::Type::Array;
+            if (consume(']')) return true;
+            do {
+                value.array.emplace_back();
+                if (!parseValue(value.array.back())) return false;
+            } while (consume(','));
+            return consume(']');
+        }
+        if (*mPos == '"') {
+            value.type = JsonValue::Type::String;
+            return parseString(value.string);
+        }
+        if (consumeLiteral("null")) return true;
+        if (consumeLiteral("true")) {
+            value.type = JsonValue::Type::Number;
+            value.number = 1;
+            return true;
+        }
+        if (consumeLiteral("false")) {
+            value.type = JsonValue::Type::Number;
+            return true;
+        }
+
+        // strtod could read past the end of the buffer, which is always terminated
+        char* numberEnd = nullptr;
+        value.number = strtod(mPos, &numberEnd);
+        if (numberEnd == mPos || numberEnd > mEnd) return false;
+        value.type = JsonValue::Type::Number;
+        mPos = numberEnd;
+        return true;
+    }
+
+    const char* mPos;
+    const char* mEnd;
+};
+
+static bool readBaseline(const char* path, JsonValue& baseline) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open baseline '%s'\n", path);
+        return false;
+    }
+    std::string contents;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, read);
+    }
+    fclose(file);
+
+    JsonParser parser(contents.c_str(), contents.c_str() + contents.size());
+    if (!parser.parse(baseline) || !baseline.get("scenes")) {
+        fprintf(stderr, "Failed to parse baseline '%s'\n", path);
+        return false;
+    }
+    return true;
+}
+
+int FrameReport::compareWithBaseline(const char* path, float threshold) const {
+    JsonValue baseline;
+    if (!readBaseline(path, baseline)) return -1;
+
+    int regressions = 0;
+    for (auto& baselineScene : baseline.get("scenes")->array) {
+        const JsonValue* name = baselineScene.get("name");
+        const JsonValue* summary = baselineScene.get("summary");
+        if (!name || !summary) continue;
+        auto scene = mScenes.find(name->string);
+        if (scene == mScenes.end() || scene->second.empty()) continue;
+
+        for (int metric = 0; metric < MetricCount; metric++) {
+            const JsonValue* percentiles = summary->get(kMetrics[metric].name);
+            if (!percentiles) continue;
+            for (int percentile : kComparedPercentiles) {
+                std::string key = std::to_string(percentile) + "th";
+                const JsonValue* baselineValue = percentiles->get(key.c_str());
+                if (!baselineValue) continue;
+
+                const int64_t expected = static_cast<int64_t>(baselineValue->number);
+                const int64_t actual = findPercentile(scene->second, metric, percentile);
+                // Compared as the amount by which the metric got worse
+                const int64_t worse = kMetrics[metric].higherIsWorse
+                        ? actual - expected : expected - actual;
+                if (worse > expected * threshold && worse > kMetrics[metric].minRegression) {
+                    fprintf(stderr, "REGRESSION %s %s %s: %" PRId64 " (baseline %" PRId64 ")\n",
+                            name->string.c_str(), kMetrics[metric].name, key.c_str(),
+                            actual, expected);
+                    regressions++;
+                }
+            }
+        }
+    }
+    return regressions;
+}
+
+} // namespace test
+} // namespace uirenderer
+} // namespace android
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "FrameMetricsObserver.h"
+
+#include <utils/Mutex.h>
+#include <utils/StrongPointer.h>
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+/**
+ * Collects the per-frame stages and GL counters of each scene a macrobench run draws, and
+ * writes them out as JSON along with percentile summaries. A previously written report can be
+ * used as a baseline, to flag the scenes whose percentiles regressed.
+ *
+ * Times are in nanoseconds. Defer and replay are only split by the OpenGL pipeline, they are 0
+ * with the Skia pipelines.
+ */
+class FrameReport {
+public:
+    enum Metric {
+        Record = 0,  // DrawStart to SyncQueued, on the UI thread
+        Sync,        // SyncStart to IssueDrawCommandsStart
+        Defer,       // IssueDrawCommandsStart to ReplayStart
+        Replay,      // ReplayStart to SwapBuffers
+        Total,       // SyncStart to FrameCompleted
+        DrawCalls,
+        ProgramSwitches,
+        TextureBinds,
+        BlendChanges,
+        CulledOps,
+        // Only counted when GL calls go through GlesAccountingDriver, as in headless runs
+        GlCalls,
+        GlCallTime,  // Spent in the GL calls themselves
+        StateChanges,
+        BufferUploads,
+        BufferUploadBytes,
+        TextureUploads,
+        TextureUploadBytes,
+        MetricCount,
+    };
+
+    typedef std::array<int64_t, MetricCount> FrameMetrics;
+
+    class Observer : public FrameMetricsObserver {
+    public:
+        explicit Observer(std::vector<FrameMetrics>* frames) : mFrames(frames) {}
+        void notify(const int64_t* buffer) override;
+    private:
+        Mutex mLock;
+        std::vector<FrameMetrics>* mFrames;
+    };
+
+    static const int kPercentiles[];
+    static const size_t kPercentileCount;
+
+    /**
+     * Returns an observer to add to the scene's RenderProxy. The frames of a scene run several
+     * times are reported together.
+     */
+    sp<Observer> observeScene(const std::string& name);
+
+    bool writeJson(const char* path) const;
+
+    /**
+     * Compares the percentiles of every scene also found in the baseline, printing the ones
+     * that got worse by more than the given fraction: for most metrics that's growing, for
+     * culled ops it's shrinking. Returns the number of regressions, or -1 if the baseline
+     * couldn't be read.
+     */
+    int compareWithBaseline(const char* path, float threshold) const;
+
+private:
+    // Ordered so that the output is stable between runs
+    std::map<std::string, std::vector<FrameMetrics>> mScenes;
+};
+
+} // namespace test
+} // namespace uirenderer
+} // namespace android
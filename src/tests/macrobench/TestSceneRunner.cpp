@@ -19,6 +19,7 @@
 #include "tests/common/TestContext.h"
 #include "tests/common/TestScene.h"
 #include "tests/common/scenes/TestSceneBase.h"
+#include "tests/macrobench/FrameReport.h"
 #include "renderthread/RenderProxy.h"
 #include "renderthread/RenderTask.h"
 
@@ -111,7 +112,7 @@ void outputBenchmarkReport(const TestScene::Info& info, const TestScene::Options
 }
 
 void run(const TestScene::Info& info, const TestScene::Options& opts,
-        benchmark::BenchmarkReporter* reporter) {
+        benchmark::BenchmarkReporter* reporter, FrameReport* frameReport) {
     // Switch to the real display
     gDisplay = getBuiltInDisplay();
 
@@ -155,6 +156,11 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
     }
 
     proxy->resetProfileInfo();
+    sp<FrameReport::Observer> frameObserver;
+    if (frameReport) {
+        frameObserver = frameReport->observeScene(info.name);
+        proxy->addFrameMetricsObserver(frameObserver.get());
+    }
     proxy->fence();
 
     ModifiedMovingAverage<double> avgMs(opts.reportFrametimeWeight);
@@ -165,7 +171,7 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
         nsecs_t vsync = systemTime(CLOCK_MONOTONIC);
         {
             ATRACE_NAME("UI-Draw Frame");
-            UiFrameInfoBuilder(proxy->frameInfo()).setVsync(vsync, vsync);
+            UiFrameInfoBuilder(proxy->frameInfo()).setVsync(vsync, vsync).markDrawStart();
             scene->doFrame(i);
             proxy->syncAndDrawFrame();
         }
@@ -180,6 +186,9 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
     }
     proxy->fence();
     nsecs_t end = systemTime(CLOCK_MONOTONIC);
+    if (frameObserver.get()) {
+        proxy->removeFrameMetricsObserver(frameObserver.get());
+    }
 
     if (reporter) {
         outputBenchmarkReport(info, opts, reporter, proxy.get(),
@@ -16,10 +16,16 @@
 
 #include "tests/common/LeakChecker.h"
 #include "tests/common/TestScene.h"
+#include "tests/macrobench/FrameReport.h"
 
 #include "hwui/Typeface.h"
 #include "protos/hwui.pb.h"
 #include "Properties.h"
+#if HWUI_NULL_GPU
+#include "debug/GlesAccountingDriver.h"
+#include "debug/GlesDriver.h"
+#include "debug/NullGlesDriver.h"
+#endif
 
 #include <benchmark/benchmark.h>
 #include <../src/sysinfo.h>
@@ -30,6 +36,7 @@
 #include <unordered_map>
 #include <vector>
 #include <pthread.h>
+#include <utils/Trace.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -44,9 +51,13 @@ static int gRepeatCount = 1;
 static std::vector<TestScene::Info> gRunTests;
 static TestScene::Options gOpts;
 std::unique_ptr<benchmark::BenchmarkReporter> gBenchmarkReporter;
+static const char* gJsonPath = nullptr;
+static const char* gBaselinePath = nullptr;
+static float gRegressionThreshold = 0.1f;
+static const char* gTracePath = nullptr;
 
 void run(const TestScene::Info& info, const TestScene::Options& opts,
-        benchmark::BenchmarkReporter* reporter);
+        benchmark::BenchmarkReporter* reporter, FrameReport* frameReport);
 
 static void printHelp() {
     printf(R"(
@@ -68,6 +79,17 @@ OPTIONS:
   --onscreen           Render tests on device screen. By default tests
                        are offscreen rendered
   --benchmark_format   Set output format. Possible values are tabular, json, csv
+  --frame-report=file  Write the record, sync, defer and replay times and GL
+                       counters of every frame to file as JSON, along with
+                       their percentiles
+  --baseline=file      Compare the percentiles of each test against a report
+                       previously written with --frame-report, and exit with
+                       an error if any of them regressed
+  --regression-threshold=percent How much a percentile may grow over the
+                       baseline before it's a regression. Default is 10
+  --trace=file         Record the trace sections of every thread, and write
+                       the most recent ones to file in the Chrome trace event
+                       format once the tests are done
 )");
 }
 
@@ -157,6 +179,10 @@ enum {
     BenchmarkFormat,
     Onscreen,
     Offscreen,
+    FrameReportFile,
+    Baseline,
+    RegressionThreshold,
+    Trace,
 };
 }
 
@@ -171,6 +197,10 @@ static const struct option LONG_OPTIONS[] = {
     { "benchmark_format", required_argument, nullptr, LongOpts::BenchmarkFormat },
     { "onscreen", no_argument, nullptr, LongOpts::Onscreen },
     { "offscreen", no_argument, nullptr, LongOpts::Offscreen },
+    { "frame-report", required_argument, nullptr, LongOpts::FrameReportFile },
+    { "baseline", required_argument, nullptr, LongOpts::Baseline },
+    { "regression-threshold", required_argument, nullptr, LongOpts::RegressionThreshold },
+    { "trace", required_argument, nullptr, LongOpts::Trace },
     { 0, 0, 0, 0 }
 };
 
@@ -262,6 +292,26 @@ void parseOptions(int argc, char* argv[]) {
             gOpts.renderOffscreen = true;
             break;
 
+        case LongOpts::FrameReportFile:
+            gJsonPath = optarg;
+            break;
+
+        case LongOpts::Baseline:
+            gBaselinePath = optarg;
+            break;
+
+        case LongOpts::RegressionThreshold:
+            gRegressionThreshold = atof(optarg) / 100.0f;
+            if (gRegressionThreshold <= 0) {
+                fprintf(stderr, "Invalid regression threshold '%s'\n", optarg);
+                error = true;
+            }
+            break;
+
+        case LongOpts::Trace:
+            gTracePath = optarg;
+            break;
+
         case 'h':
             printHelp();
             exit(EXIT_SUCCESS);
@@ -306,6 +356,13 @@ int main(int argc, char* argv[]) {
 
     Typeface::setRobotoTypefaceForTest();
 
+#if HWUI_NULL_GPU
+    // Headless runs draw every scene through the full pipeline without issuing any GL, but
+    // still count the calls that would have been made
+    debug::GlesDriver::replace(std::make_unique<debug::NullGlesDriver>());
+    debug::GlesAccountingDriver::install();
+#endif
+
     parseOptions(argc, argv);
     if (!gBenchmarkReporter && gOpts.renderOffscreen) {
         gBenchmarkReporter.reset(new benchmark::ConsoleReporter());
@@ -327,9 +384,20 @@ int main(int argc, char* argv[]) {
         gBenchmarkReporter->ReportContext(context);
     }
 
+    std::unique_ptr<FrameReport> frameReport;
+    if (gJsonPath || gBaselinePath) {
+        frameReport.reset(new FrameReport());
+    }
+
+    if (gTracePath) {
+        // The RenderThread runs its tasks on this thread too
+        trace::setThreadName("UI thread");
+        trace::setEnabled(true);
+    }
+
     for (int i = 0; i < gRepeatCount; i++) {
         for (auto&& test : gRunTests) {
-            run(test, gOpts, gBenchmarkReporter.get());
+            run(test, gOpts, gBenchmarkReporter.get(), frameReport.get());
         }
     }
 
@@ -337,6 +405,23 @@ int main(int argc, char* argv[]) {
         gBenchmarkReporter->Finalize();
     }
 
+    int result = EXIT_SUCCESS;
+    if (gTracePath && !trace::dump(gTracePath)) {
+        result = EXIT_FAILURE;
+    }
+    if (gJsonPath && !frameReport->writeJson(gJsonPath)) {
+        result = EXIT_FAILURE;
+    }
+    if (gBaselinePath) {
+        int regressions = frameReport->compareWithBaseline(gBaselinePath, gRegressionThreshold);
+        if (regressions > 0) {
+            fprintf(stderr, "%d regressions against %s\n", regressions, gBaselinePath);
+        }
+        if (regressions) {
+            result = EXIT_FAILURE;
+        }
+    }
+
     LeakChecker::checkForLeaks();
-    return 0;
+    return result;
 }
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "utils/Blur.h"
+
+#include <memory>
+
+using namespace android;
+using namespace android::uirenderer;
+
+static std::unique_ptr<uint8_t[]> createTextImage(int width, int height) {
+    std::unique_ptr<uint8_t[]> image(new uint8_t[width * height]);
+    // horizontal stripes of "glyphs", like a line of text
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            image[y * width + x] = ((x / 6) % 2 && (y / 10) % 2) ? 255 : 0;
+        }
+    }
+    return image;
+}
+
+/**
+ * Gaussian blur of a range(0) x range(0) / 4 image, such as a text shadow, with radius range(1).
+ */
+void BM_Blur_gaussian(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = width / 4;
+    const int radius = state.range(1);
+    std::unique_ptr<uint8_t[]> image = createTextImage(width, height);
+    std::unique_ptr<uint8_t[]> scratch(new uint8_t[width * height]);
+    std::unique_ptr<float[]> weights(new float[2 * radius + 1]);
+    Blur::generateGaussianWeights(weights.get(), radius);
+
+    while (state.KeepRunning()) {
+        Blur::horizontal(weights.get(), radius, image.get(), scratch.get(), width, height);
+        Blur::vertical(weights.get(), radius, scratch.get(), image.get(), width, height);
+        benchmark::DoNotOptimize(image.get());
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+BENCHMARK(BM_Blur_gaussian)->RangeMultiplier(4)->Ranges({{128, 2048}, {2, 32}});
+
+/**
+ * Triple box approximation of the same blur, whose cost doesn't depend on the radius.
+ */
+void BM_Blur_tripleBox(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = width / 4;
+    const int radius = state.range(1);
+    std::unique_ptr<uint8_t[]> image = createTextImage(width, height);
+
+    while (state.KeepRunning()) {
+        Blur::tripleBox(radius, image.get(), width, height);
+        benchmark::DoNotOptimize(image.get());
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+BENCHMARK(BM_Blur_tripleBox)->RangeMultiplier(4)->Ranges({{128, 2048}, {2, 32}});
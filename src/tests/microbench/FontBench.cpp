@@ -17,10 +17,15 @@
 #include <benchmark/benchmark.h>
 
 #include "GammaFontRenderer.h"
+#include "font/AtlasPacker.h"
 #include "tests/common/TestUtils.h"
 
+#include <SkGraphics.h>
 #include <SkPaint.h>
 
+#include <random>
+#include <vector>
+
 using namespace android;
 using namespace android::uirenderer;
 
@@ -48,3 +53,106 @@ void BM_FontRenderer_precache_cachehits(benchmark::State& state) {
     });
 }
 BENCHMARK(BM_FontRenderer_precache_cachehits);
+
+/**
+ * Precaches a run of range(0) distinct, large glyphs, as in a page of CJK text, into an empty
+ * font cache, with Skia's glyph cache purged as well, so every glyph must be rasterized.
+ * range(1) selects serial (0) or parallel (1) rasterization.
+ */
+void BM_FontRenderer_precache_coldcache(benchmark::State& state) {
+    TestUtils::runOnRenderThread([&state](renderthread::RenderThread& thread) {
+        const int glyphCount = state.range(0);
+        ScopedProperty<bool> parallel(Properties::parallelGlyphRaster, state.range(1) != 0);
+        state.SetLabel(state.range(1) ? "parallel" : "serial");
+
+        SkPaint paint;
+        paint.setTextSize(40);
+        paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+
+        std::vector<glyph_t> glyphs;
+        for (int i = 0; i < glyphCount; i++) {
+            glyphs.push_back(i + 1);
+        }
+
+        while (state.KeepRunning()) {
+            state.PauseTiming();
+            SkGraphics::PurgeFontCache();
+            std::unique_ptr<GammaFontRenderer> gammaFontRenderer(new GammaFontRenderer());
+            FontRenderer& fontRenderer = gammaFontRenderer->getFontRenderer();
+            fontRenderer.setFont(&paint, SkMatrix::I());
+            state.ResumeTiming();
+
+            fontRenderer.precache(&paint, glyphs.data(), glyphs.size(), SkMatrix::I());
+
+            state.PauseTiming();
+            gammaFontRenderer.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * glyphCount);
+    });
+}
+BENCHMARK(BM_FontRenderer_precache_coldcache)
+        ->Args({64, 0})->Args({64, 1})
+        ->Args({512, 0})->Args({512, 1});
+
+static const char* sPackerNames[] = { "columns", "skyline", "maxrects" };
+
+/**
+ * Packs synthetic glyphs into a 1024x512 atlas, resetting the atlas each time it fills up.
+ * range(0) selects the GlyphAtlasPacker, and range(1) the workload: Latin (0), with small glyphs
+ * of varying aspect ratio, or CJK (1), with large, nearly square glyphs.
+ *
+ * The label reports how many glyphs a MB of atlas holds before it fills up.
+ */
+void BM_AtlasPacker_insert(benchmark::State& state) {
+    const uint16_t width = 1024;
+    const uint16_t height = 512;
+    const bool cjk = state.range(1) != 0;
+    std::unique_ptr<AtlasPacker> packer = AtlasPacker::create(
+            static_cast<GlyphAtlasPacker>(state.range(0)), width, height);
+
+    // glyph sizes include the border, as in CacheTexture::fitBitmap()
+    std::mt19937 random(42);
+    std::vector<std::pair<uint16_t, uint16_t>> sizes(4096);
+    for (auto& size : sizes) {
+        if (cjk) {
+            size.first = 18 + random() % 8;
+            size.second = 18 + random() % 8;
+        } else {
+            size.first = 4 + random() % 12;
+            size.second = 10 + random() % 14;
+        }
+    }
+
+    size_t next = 0;
+    uint32_t packed = 0;
+    uint32_t fills = 0;
+    uint32_t filledGlyphs = 0;
+    while (state.KeepRunning()) {
+        const auto& size = sizes[next++ % sizes.size()];
+        uint32_t x, y;
+        if (!packer->pack(size.first, size.second, &x, &y)) {
+            fills++;
+            filledGlyphs += packed;
+            packed = 0;
+            packer->reset();
+            packer->pack(size.first, size.second, &x, &y);
+        }
+        packed++;
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    char label[64];
+    if (fills) {
+        float glyphsPerMB = filledGlyphs / (float) fills * (1024 * 1024) / (width * height);
+        snprintf(label, sizeof(label), "%s %s, %.0f glyphs/MB", sPackerNames[state.range(0)],
+                cjk ? "cjk" : "latin", glyphsPerMB);
+    } else {
+        snprintf(label, sizeof(label), "%s %s", sPackerNames[state.range(0)],
+                cjk ? "cjk" : "latin");
+    }
+    state.SetLabel(label);
+}
+BENCHMARK(BM_AtlasPacker_insert)
+        ->Args({0, 0})->Args({1, 0})->Args({2, 0})
+        ->Args({0, 1})->Args({1, 1})->Args({2, 1});
@@ -23,11 +23,13 @@
 #include "LayerUpdateQueue.h"
 #include "RecordedOp.h"
 #include "RecordingCanvas.h"
+#include "renderstate/OffscreenBufferPool.h"
 #include "tests/common/TestContext.h"
 #include "tests/common/TestScene.h"
 #include "tests/common/TestUtils.h"
 #include "Vector.h"
 
+#include <memory>
 #include <vector>
 
 using namespace android;
@@ -91,6 +93,40 @@ void BM_FrameBuilder_deferAndRender(benchmark::State& state) {
 }
 BENCHMARK(BM_FrameBuilder_deferAndRender);
 
+/**
+ * Long op lists, as recorded by RecyclerView-style scenes. Small rects and bitmaps are scattered
+ * over the layer so that later ops overlap earlier ones once the layer is covered, exercising
+ * batch insertion with range(0) ops in total.
+ */
+void BM_FrameBuilder_defer_manyOps(benchmark::State& state) {
+    TestUtils::runOnRenderThread([&state](RenderThread& thread) {
+        const int opCount = state.range(0);
+        auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 1000, 1000,
+                [opCount](RenderProperties& props, RecordingCanvas& canvas) {
+            sk_sp<Bitmap> bitmap(TestUtils::createBitmap(10, 10));
+            SkPaint paint;
+            for (int i = 0; i < opCount / 2; i++) {
+                // large prime stride, so consecutive ops land far apart
+                int cell = (i * 7919) % 2500;
+                float x = (cell % 50) * 20;
+                float y = (cell / 50) * 20;
+                canvas.drawRect(x, y, x + 15, y + 15, paint);
+                canvas.drawBitmap(*bitmap, x + 5, y + 5, nullptr);
+            }
+        });
+        TestUtils::syncHierarchyPropertiesAndDisplayList(node);
+
+        while (state.KeepRunning()) {
+            FrameBuilder frameBuilder(SkRect::MakeWH(1000, 1000), 1000, 1000,
+                    sLightGeometry, Caches::getInstance());
+            frameBuilder.deferRenderNode(*node);
+            benchmark::DoNotOptimize(&frameBuilder);
+        }
+        state.SetItemsProcessed(state.iterations() * opCount);
+    });
+}
+BENCHMARK(BM_FrameBuilder_defer_manyOps)->Arg(5000)->Arg(10000)->Arg(25000)->Arg(50000);
+
 static sp<RenderNode> getSyncedSceneNode(const char* sceneName) {
     gDisplay = getBuiltInDisplay(); // switch to real display if present
 
@@ -149,3 +185,56 @@ void BM_FrameBuilder_deferAndRender_scene(benchmark::State& state) {
     });
 }
 BENCHMARK(BM_FrameBuilder_deferAndRender_scene)->DenseRange(0, SCENES.size() - 1);
+
+/**
+ * Multi-layer scene: a set of HW layers that are all fully damaged every frame. range(0) is the
+ * layer count, and range(1) selects serial (0) or concurrent (1) layer deferral.
+ */
+void BM_FrameBuilder_defer_scene_layers(benchmark::State& state) {
+    TestUtils::runOnRenderThread([&state](RenderThread& thread) {
+        const int layerCount = state.range(0);
+        ScopedProperty<bool> parallel(Properties::parallelLayerDeferral, state.range(1) != 0);
+        state.SetLabel(state.range(1) ? "parallel" : "serial");
+
+        std::vector<sp<RenderNode>> nodes;
+        std::vector<std::unique_ptr<OffscreenBuffer>> layers;
+        for (int i = 0; i < layerCount; i++) {
+            auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+                    [](RenderProperties& props, RecordingCanvas& canvas) {
+                props.mutateLayerProperties().setType(LayerType::RenderLayer);
+                sk_sp<Bitmap> bitmap(TestUtils::createBitmap(10, 10));
+                SkPaint paint;
+                for (int j = 0; j < 100; j++) {
+                    canvas.save(SaveFlags::MatrixClip);
+                    canvas.translate((j % 10) * 20, (j / 10) * 20);
+                    canvas.drawRect(0, 0, 10, 10, paint);
+                    canvas.drawBitmap(*bitmap, 5, 5, nullptr);
+                    canvas.restore();
+                }
+            });
+            layers.emplace_back(new OffscreenBuffer(thread.renderState(),
+                    Caches::getInstance(), 200, 200));
+            *(node->getLayerHandle()) = layers.back().get();
+            TestUtils::syncHierarchyPropertiesAndDisplayList(node);
+            nodes.push_back(node);
+        }
+
+        LayerUpdateQueue layerUpdateQueue; // Note: enqueue damage post-sync, so bounds are valid
+        for (auto& node : nodes) {
+            layerUpdateQueue.enqueueLayerWithDamage(node.get(), Rect(200, 200));
+        }
+
+        while (state.KeepRunning()) {
+            FrameBuilder frameBuilder(layerUpdateQueue, sLightGeometry, Caches::getInstance());
+            benchmark::DoNotOptimize(&frameBuilder);
+        }
+
+        // clean up layer pointers, so we can safely destruct RenderNodes
+        for (auto& node : nodes) {
+            *(node->getLayerHandle()) = nullptr;
+        }
+    });
+}
+BENCHMARK(BM_FrameBuilder_defer_scene_layers)
+        ->Args({4, 0})->Args({4, 1})
+        ->Args({16, 0})->Args({16, 1});
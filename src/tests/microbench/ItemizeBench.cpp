@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "hwui/MinikinSkia.h"
+#include "hwui/Typeface.h"
+
+#include <minikin/FontCollection.h>
+
+#include <SkStream.h>
+#include <SkTypeface.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+using namespace android;
+
+// Fallback fonts to add after the default typeface, where they exist
+static const char* kFallbackFonts[] = {
+        "/system/fonts/NotoSansCJK-Regular.ttc",
+        "/system/fonts/NotoColorEmoji.ttf",
+        "/system/fonts/NotoSansSymbols-Regular-Subsetted.ttf",
+        "/System/Library/Fonts/PingFang.ttc",
+        "/System/Library/Fonts/Apple Color Emoji.ttc",
+        "/System/Library/Fonts/Apple Symbols.ttf",
+};
+
+// Chinese, Japanese and Korean, with emoji, some of them with modifiers or presentation selectors
+static const char16_t kMixedText[] =
+        u"今天天气很好，我们去公园散步吧！\U0001F600\U0001F44D\U0001F3FD 東京の桜はとても綺麗です。"
+        u"❤️ 서울에서 만나요 \U0001F389\U0001F382 Hello world, 你好世界！"
+        u"☺︎ ありがとう\U0001F64F 감사합니다 \U0001F1EF\U0001F1F5\U0001F1F0\U0001F1F7";
+
+static std::shared_ptr<minikin::FontFamily> buildFamily(const char* fileName) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    std::unique_ptr<SkMemoryStream> fontData(new SkMemoryStream(data, st.st_size));
+    sk_sp<SkTypeface> typeface = SkTypeface::MakeFromStream(fontData.release());
+    if (typeface == nullptr) {
+        munmap(data, st.st_size);
+        return nullptr;
+    }
+    std::shared_ptr<minikin::MinikinFont> font = std::make_shared<MinikinFontSkia>(
+            std::move(typeface), data, st.st_size, 0, std::vector<minikin::FontVariation>());
+    return std::make_shared<minikin::FontFamily>(
+            std::vector<minikin::Font>({minikin::Font(std::move(font), minikin::FontStyle())}));
+}
+
+static std::vector<std::shared_ptr<minikin::FontFamily>> buildFallbackFamilies() {
+    const minikin::FontCollection& defaultCollection =
+            *Typeface::resolveDefault(nullptr)->fFontCollection;
+    std::vector<std::shared_ptr<minikin::FontFamily>> families;
+    for (size_t i = 0; i < defaultCollection.getFamilyCount(); i++) {
+        families.push_back(defaultCollection.getFamilyAt(i));
+    }
+    for (const char* fileName : kFallbackFonts) {
+        std::shared_ptr<minikin::FontFamily> family = buildFamily(fileName);
+        if (family) {
+            families.push_back(family);
+        }
+    }
+    return families;
+}
+
+static std::vector<uint16_t> mixedText() {
+    const size_t length = sizeof(kMixedText) / sizeof(kMixedText[0]) - 1;
+    return std::vector<uint16_t>(kMixedText, kMixedText + length);
+}
+
+/**
+ * Itemizes mixed CJK and emoji text with a collection that has already itemized it, so the
+ * family of every character is memoized.
+ */
+void BM_FontCollection_itemize(benchmark::State& state) {
+    minikin::FontCollection collection(buildFallbackFamilies());
+    const std::vector<uint16_t> text = mixedText();
+    std::vector<minikin::FontCollection::Run> runs;
+    collection.itemize(text.data(), text.size(), minikin::FontStyle(), &runs);
+
+    while (state.KeepRunning()) {
+        runs.clear();
+        collection.itemize(text.data(), text.size(), minikin::FontStyle(), &runs);
+        benchmark::DoNotOptimize(runs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_FontCollection_itemize);
+
+/**
+ * Same as above, with a new collection every time, so the family of every character is chosen
+ * by scoring the families that have it.
+ */
+void BM_FontCollection_itemize_cold(benchmark::State& state) {
+    const std::vector<std::shared_ptr<minikin::FontFamily>> families = buildFallbackFamilies();
+    const std::vector<uint16_t> text = mixedText();
+    std::vector<minikin::FontCollection::Run> runs;
+    std::unique_ptr<minikin::FontCollection> collection;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        collection.reset(new minikin::FontCollection(families));
+        runs.clear();
+        state.ResumeTiming();
+        collection->itemize(text.data(), text.size(), minikin::FontStyle(), &runs);
+        benchmark::DoNotOptimize(runs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_FontCollection_itemize_cold);
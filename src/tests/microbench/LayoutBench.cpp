@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "hwui/MinikinUtils.h"
+#include "hwui/Paint.h"
+#include "tests/common/TestUtils.h"
+
+#include <minikin/Layout.h>
+
+#include <memory>
+#include <string>
+#include <string.h>
+#include <unistd.h>
+
+using namespace android;
+using namespace android::uirenderer;
+
+static const char* kParagraph =
+        "The quick brown fox jumps over the lazy dog, while a sphinx of black quartz judges "
+        "my vow. Pack my box with five dozen liquor jugs, and how vexingly quick daft zebras "
+        "jump. Bright vixens jump; dozy fowl quack. Jackdaws love my big sphinx of quartz.";
+
+/**
+ * Every thread measures the same paragraph, as several UI threads and background text
+ * prefetching would, so the words are laid out once and then come from the layout cache. The
+ * items per second should grow about linearly with the thread count, up to the core count.
+ */
+void BM_Layout_measureText(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        minikin::Layout::purgeCaches();
+    }
+    Paint paint;
+    paint.setTextSize(20);
+    const size_t length = strlen(kParagraph);
+    std::unique_ptr<uint16_t[]> text = TestUtils::asciiToUtf16(kParagraph);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(MinikinUtils::measureText(&paint, minikin::kBidi_Force_LTR,
+                nullptr, text.get(), 0, length, length, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Layout_measureText)->ThreadRange(1, 8)->UseRealTime();
+
+/**
+ * Same as above, with a text size of its own per thread, so that threads don't share cache
+ * entries.
+ */
+void BM_Layout_measureText_distinct(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        minikin::Layout::purgeCaches();
+    }
+    Paint paint;
+    paint.setTextSize(20 + state.thread_index);
+    const size_t length = strlen(kParagraph);
+    std::unique_ptr<uint16_t[]> text = TestUtils::asciiToUtf16(kParagraph);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(MinikinUtils::measureText(&paint, minikin::kBidi_Force_LTR,
+                nullptr, text.get(), 0, length, length, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Layout_measureText_distinct)->ThreadRange(1, 8)->UseRealTime();
+
+/**
+ * The paragraph laid out from empty caches, as on a cold start, by shaping every word.
+ */
+void BM_Layout_measureText_cold(benchmark::State& state) {
+    Paint paint;
+    paint.setTextSize(20);
+    const size_t length = strlen(kParagraph);
+    std::unique_ptr<uint16_t[]> text = TestUtils::asciiToUtf16(kParagraph);
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        minikin::Layout::purgeCaches();
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(MinikinUtils::measureText(&paint, minikin::kBidi_Force_LTR,
+                nullptr, text.get(), 0, length, length, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Layout_measureText_cold);
+
+/**
+ * Same as above, with the words read back from a shaping cache file written by an earlier run.
+ */
+void BM_Layout_measureText_coldShapingCache(benchmark::State& state) {
+    Paint paint;
+    paint.setTextSize(20);
+    const size_t length = strlen(kParagraph);
+    std::unique_ptr<uint16_t[]> text = TestUtils::asciiToUtf16(kParagraph);
+    const std::string path = "/data/local/tmp/hwui_bench_shaping_cache";
+    unlink(path.c_str());
+    minikin::Layout::setShapingCachePath(path);
+    minikin::Layout::purgeCaches();
+    MinikinUtils::measureText(&paint, minikin::kBidi_Force_LTR, nullptr, text.get(), 0, length,
+            length, nullptr);
+    minikin::Layout::flushShapingCache();
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        minikin::Layout::purgeCaches();
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(MinikinUtils::measureText(&paint, minikin::kBidi_Force_LTR,
+                nullptr, text.get(), 0, length, length, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    minikin::Layout::setShapingCachePath("");
+    unlink(path.c_str());
+}
+BENCHMARK(BM_Layout_measureText_coldShapingCache);
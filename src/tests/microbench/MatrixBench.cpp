@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "Matrix.h"
+#include "Rect.h"
+
+#include <SkMatrix.h>
+
+#include <string>
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer;
+
+enum class MatrixType {
+    Identity = 0,
+    Translate,
+    Scale,
+    Affine,
+    Perspective,
+};
+
+static const char* sMatrixTypeNames[] = { "identity", "translate", "scale", "affine",
+        "perspective" };
+
+static Matrix4 createMatrix(MatrixType type) {
+    Matrix4 matrix;
+    switch (type) {
+    case MatrixType::Identity:
+        break;
+    case MatrixType::Translate:
+        matrix.loadTranslate(10, 20, 0);
+        break;
+    case MatrixType::Scale:
+        matrix.loadTranslate(10, 20, 0);
+        matrix.scale(2, 3, 1);
+        break;
+    case MatrixType::Affine:
+        matrix.loadTranslate(10, 20, 0);
+        matrix.rotate(30, 0, 0, 1);
+        break;
+    case MatrixType::Perspective: {
+        SkMatrix perspective;
+        perspective.setAll(1, 0.2f, 5, 0.1f, 1, 7, 0.001f, 0.002f, 1);
+        matrix.load(perspective);
+        break;
+    }
+    }
+    return matrix;
+}
+
+static void matrixTypeArgs(benchmark::internal::Benchmark* b) {
+    for (int type = 0; type <= static_cast<int>(MatrixType::Perspective); type++) {
+        b->Arg(type);
+    }
+}
+
+static void mapPointsArgs(benchmark::internal::Benchmark* b) {
+    for (int type = 0; type <= static_cast<int>(MatrixType::Perspective); type++) {
+        for (int count : { 16, 256 }) {
+            b->Args({type, count, 0});
+            b->Args({type, count, 1});
+        }
+    }
+}
+
+void BM_Matrix4_loadMultiply(benchmark::State& state) {
+    Matrix4 a = createMatrix(MatrixType::Affine);
+    Matrix4 b = createMatrix(MatrixType::Scale);
+    Matrix4 result;
+    while (state.KeepRunning()) {
+        result.loadMultiply(a, b);
+        benchmark::DoNotOptimize(&result);
+    }
+}
+BENCHMARK(BM_Matrix4_loadMultiply);
+
+void BM_Matrix4_mapPoint3d(benchmark::State& state) {
+    Matrix4 matrix = createMatrix(MatrixType::Affine);
+    Vector3 point = {1, 2, 3};
+    while (state.KeepRunning()) {
+        matrix.mapPoint3d(point);
+        benchmark::DoNotOptimize(&point);
+    }
+}
+BENCHMARK(BM_Matrix4_mapPoint3d);
+
+/**
+ * Maps a single rect, with a range(0) MatrixType, as done for each op's bounds.
+ */
+void BM_Matrix4_mapRect(benchmark::State& state) {
+    MatrixType type = static_cast<MatrixType>(state.range(0));
+    Matrix4 matrix = createMatrix(type);
+    Rect rect(10, 20, 30, 40);
+    while (state.KeepRunning()) {
+        Rect mapped(rect);
+        matrix.mapRect(mapped);
+        benchmark::DoNotOptimize(&mapped);
+    }
+    state.SetLabel(sMatrixTypeNames[state.range(0)]);
+}
+BENCHMARK(BM_Matrix4_mapRect)->Apply(matrixTypeArgs);
+
+/**
+ * Maps an array of 64 rects at once, with a range(0) MatrixType.
+ */
+void BM_Matrix4_mapRects(benchmark::State& state) {
+    MatrixType type = static_cast<MatrixType>(state.range(0));
+    Matrix4 matrix = createMatrix(type);
+    std::vector<Rect> rects;
+    for (int i = 0; i < 64; i++) {
+        rects.emplace_back(i, i * 2, i + 10, i * 2 + 20);
+    }
+    std::vector<Rect> mapped(rects.size());
+    while (state.KeepRunning()) {
+        mapped = rects;
+        matrix.mapRects(mapped.data(), mapped.size());
+        benchmark::DoNotOptimize(mapped.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rects.size());
+    state.SetLabel(sMatrixTypeNames[state.range(0)]);
+}
+BENCHMARK(BM_Matrix4_mapRects)->Apply(matrixTypeArgs);
+
+/**
+ * Maps range(1) points, such as a tessellated shadow caster outline, with a range(0) MatrixType,
+ * either one at a time or with one batch call.
+ */
+void BM_Matrix4_mapPoints(benchmark::State& state) {
+    MatrixType type = static_cast<MatrixType>(state.range(0));
+    Matrix4 matrix = createMatrix(type);
+    const bool batch = state.range(2);
+    std::vector<Vertex> points;
+    for (int i = 0; i < state.range(1); i++) {
+        points.push_back(Vertex{i * 0.5f, i * 0.25f});
+    }
+    std::vector<Vertex> mapped(points.size());
+    while (state.KeepRunning()) {
+        mapped = points;
+        if (batch) {
+            matrix.mapPoints(mapped.data(), mapped.size());
+        } else {
+            for (Vertex& point : mapped) {
+                matrix.mapPoint(point.x, point.y);
+            }
+        }
+        benchmark::DoNotOptimize(mapped.data());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+    state.SetLabel(std::string(sMatrixTypeNames[state.range(0)]) + (batch ? " batch" : " single"));
+}
+BENCHMARK(BM_Matrix4_mapPoints)->Apply(mapPointsArgs);
@@ -86,3 +86,43 @@ void BM_TaskManager_enqueueRunDeleteTask(benchmark::State& state) {
     state.PauseTiming();
 }
 BENCHMARK(BM_TaskManager_enqueueRunDeleteTask);
+
+class BusyTask : public Task<int> {};
+
+class BusyProcessor : public TaskProcessor<int> {
+public:
+    explicit BusyProcessor(TaskManager* manager)
+            : TaskProcessor(manager) {}
+    virtual ~BusyProcessor() {}
+    virtual void onProcess(const sp<Task<int> >& task) override {
+        // Roughly the cost of tessellating a small path
+        int value = 0;
+        for (int i = 0; i < 20000; i++) {
+            value = value * 31 + i;
+            benchmark::DoNotOptimize(value);
+        }
+        task->setResult(value);
+    }
+};
+
+// Throughput of a burst of equally sized tasks, for worker counts from 1 to N
+void BM_TaskManager_scaling(benchmark::State& state) {
+    const int kTaskCount = 256;
+    TaskManager taskManager(state.range(0));
+    sp<BusyProcessor> processor(new BusyProcessor(&taskManager));
+    std::vector<sp<BusyTask> > tasks;
+    tasks.reserve(kTaskCount);
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < kTaskCount; i++) {
+            tasks.emplace_back(new BusyTask);
+            processor->add(tasks.back());
+        }
+        for (sp<BusyTask>& task : tasks) {
+            benchmark::DoNotOptimize(task->getResult());
+        }
+        tasks.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * kTaskCount);
+}
+BENCHMARK(BM_TaskManager_scaling)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "renderthread/RenderThread.h"
+
+#include <utils/Mutex.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer::renderthread;
+
+class TrivialRenderTask : public RenderTask {
+public:
+    void run() override {}
+};
+
+// The queue as it was before being made lock-free: a list guarded by a mutex, which every
+// producer and the render thread take
+class LockedTaskQueue {
+public:
+    void queue(RenderTask* task) {
+        AutoMutex _lock(mLock);
+        if (mTail) {
+            mTail->mNext = task;
+        } else {
+            mHead = task;
+        }
+        mTail = task;
+    }
+
+    RenderTask* next() {
+        AutoMutex _lock(mLock);
+        RenderTask* ret = mHead;
+        if (ret) {
+            mHead = ret->mNext;
+            if (!mHead) {
+                mTail = nullptr;
+            }
+            ret->mNext = nullptr;
+        }
+        return ret;
+    }
+
+private:
+    Mutex mLock;
+    RenderTask* mHead = nullptr;
+    RenderTask* mTail = nullptr;
+};
+
+// Several UI threads post tasks as fast as they can, while the render thread runs them
+template <class Queue>
+static void runProducers(benchmark::State& state) {
+    const int kTasksPerProducer = 10000;
+    const int producerCount = state.range(0);
+    std::vector<std::vector<TrivialRenderTask>> tasks(producerCount,
+            std::vector<TrivialRenderTask>(kTasksPerProducer));
+
+    while (state.KeepRunning()) {
+        Queue queue;
+        std::atomic<bool> start(false);
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < producerCount; producer++) {
+            producers.emplace_back([&queue, &tasks, &start, producer]() {
+                while (!start.load(std::memory_order_acquire)) {}
+                for (TrivialRenderTask& task : tasks[producer]) {
+                    queue.queue(&task);
+                }
+            });
+        }
+
+        start.store(true, std::memory_order_release);
+        for (int received = 0; received < producerCount * kTasksPerProducer;) {
+            if (RenderTask* task = queue.next()) {
+                task->run();
+                received++;
+            }
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * producerCount * kTasksPerProducer);
+}
+
+void BM_TaskQueue_producers(benchmark::State& state) {
+    runProducers<TaskQueue>(state);
+}
+BENCHMARK(BM_TaskQueue_producers)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+void BM_TaskQueue_producersLocked(benchmark::State& state) {
+    runProducers<LockedTaskQueue>(state);
+}
+BENCHMARK(BM_TaskQueue_producersLocked)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
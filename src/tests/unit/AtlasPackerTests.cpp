@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "Rect.h"
+#include "font/AtlasPacker.h"
+#include "font/FontUtil.h"
+
+#include <vector>
+
+using namespace android::uirenderer;
+
+static const GlyphAtlasPacker sPackerTypes[] = {
+        GlyphAtlasPacker::Columns, GlyphAtlasPacker::Skyline, GlyphAtlasPacker::MaxRects };
+
+TEST(AtlasPacker, pack_noOverlap) {
+    for (GlyphAtlasPacker type : sPackerTypes) {
+        auto packer = AtlasPacker::create(type, 256, 128);
+        const uint32_t initialFreeArea = packer->getFreeArea();
+
+        std::vector<Rect> packed;
+        for (int i = 0; i < 1000; i++) {
+            uint16_t width = 4 + (i * 7) % 13;
+            uint16_t height = 8 + (i * 5) % 17;
+            uint32_t x, y;
+            if (!packer->pack(width, height, &x, &y)) break;
+
+            Rect rect(x, y, x + width, y + height);
+            EXPECT_GE(rect.left, TEXTURE_BORDER_SIZE);
+            EXPECT_GE(rect.top, TEXTURE_BORDER_SIZE);
+            EXPECT_LE(rect.right, 256);
+            EXPECT_LE(rect.bottom, 128);
+            for (const Rect& other : packed) {
+                ASSERT_FALSE(rect.intersects(other)) << "packer " << (int) type << " overlapped";
+            }
+            packed.push_back(rect);
+        }
+        EXPECT_GT(packed.size(), 50u);
+        EXPECT_LT(packer->getFreeArea(), initialFreeArea);
+
+        packer->reset();
+        EXPECT_EQ(initialFreeArea, packer->getFreeArea());
+    }
+}
+
+TEST(AtlasPacker, pack_tooLarge) {
+    for (GlyphAtlasPacker type : sPackerTypes) {
+        auto packer = AtlasPacker::create(type, 64, 64);
+        uint32_t x, y;
+        EXPECT_FALSE(packer->pack(65, 10, &x, &y));
+        EXPECT_FALSE(packer->pack(10, 65, &x, &y));
+        EXPECT_TRUE(packer->pack(10, 10, &x, &y));
+    }
+}
@@ -16,12 +16,16 @@
 
 #include <gtest/gtest.h>
 
+#include <BakedOpDispatcher.h>
 #include <BakedOpRenderer.h>
+#include <FrameBuilder.h>
+#include <RecordingCanvas.h>
 #include <tests/common/TestUtils.h>
 
 using namespace android::uirenderer;
 
 const BakedOpRenderer::LightInfo sLightInfo = { 128, 128 };
+const FrameBuilder::LightGeometry sLightGeometry = { {100, 100, 100}, 50};
 
 RENDERTHREAD_OPENGL_PIPELINE_TEST(BakedOpRenderer, startRepaintLayer_clear) {
     BakedOpRenderer renderer(Caches::getInstance(), renderThread.renderState(), true, sLightInfo);
@@ -52,3 +56,29 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(BakedOpRenderer, startRepaintLayer_clear) {
         renderer.endLayer();
     }
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(BakedOpRenderer, batchedBitmapDraws) {
+    sk_sp<Bitmap> bitmap(TestUtils::createBitmap(10, 10));
+    auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [&bitmap](RenderProperties& props, RecordingCanvas& canvas) {
+        // overlapping draws of one bitmap can't be merged, so each is dispatched separately
+        for (int i = 0; i < 10; i++) {
+            canvas.drawBitmap(*bitmap, i * 5, 0, nullptr);
+        }
+    });
+
+    auto countDrawCalls = [&renderThread, &node](bool batchGlops) {
+        ScopedProperty<bool> batchProp(Properties::batchGlops, batchGlops);
+        FrameBuilder frameBuilder(SkRect::MakeWH(200, 200), 200, 200,
+                sLightGeometry, Caches::getInstance());
+        frameBuilder.deferRenderNode(*TestUtils::getSyncedNode(node));
+
+        RenderState& renderState = renderThread.renderState();
+        BakedOpRenderer renderer(Caches::getInstance(), renderState, true, sLightInfo);
+        const uint64_t startCount = renderState.getDrawCallCount();
+        frameBuilder.replayBakedOps<BakedOpDispatcher>(renderer);
+        return renderState.getDrawCallCount() - startCount;
+    };
+    EXPECT_EQ(10u, countDrawCalls(false));
+    EXPECT_EQ(1u, countDrawCalls(true)) << "Quads of the same bitmap should be drawn together";
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "utils/Blur.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+using namespace android::uirenderer;
+
+// Draws opaque rects of varying sizes, some touching the image edges, like a run of glyphs
+static std::vector<uint8_t> createTestImage(int width, int height) {
+    std::vector<uint8_t> image(width * height, 0);
+    uint32_t seed = 1;
+    for (int i = 0; i < 20; i++) {
+        seed = seed * 1103515245 + 12345;
+        int left = (seed >> 8) % width;
+        int top = (seed >> 16) % height;
+        int right = std::min(width, left + 1 + (int) ((seed >> 4) % (width / 4 + 2)));
+        int bottom = std::min(height, top + 1 + (int) ((seed >> 12) % (height / 3 + 2)));
+        for (int y = top; y < bottom; y++) {
+            for (int x = left; x < right; x++) {
+                image[y * width + x] = 255;
+            }
+        }
+    }
+    return image;
+}
+
+// The original scalar gaussian blur, clamping each tap to the image
+static void referenceBlur(const float* weights, int radius, const uint8_t* source,
+        uint8_t* dest, int width, int height) {
+    std::vector<uint8_t> scratch(width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float blurredPixel = 0.0f;
+            for (int r = -radius; r <= radius; r++) {
+                int validX = std::min(std::max(x + r, 0), width - 1);
+                blurredPixel += (float) source[y * width + validX] * weights[r + radius];
+            }
+            scratch[y * width + x] = (uint8_t) blurredPixel;
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float blurredPixel = 0.0f;
+            for (int r = -radius; r <= radius; r++) {
+                int validY = std::min(std::max(y + r, 0), height - 1);
+                blurredPixel += (float) scratch[validY * width + x] * weights[r + radius];
+            }
+            dest[y * width + x] = (uint8_t) blurredPixel;
+        }
+    }
+}
+
+static void gaussianBlur(float radius, const uint8_t* source, uint8_t* dest,
+        int width, int height) {
+    int intRadius = Blur::convertRadiusToInt(radius);
+    std::vector<float> weights(2 * intRadius + 1);
+    Blur::generateGaussianWeights(weights.data(), radius);
+    std::vector<uint8_t> scratch(width * height);
+    Blur::horizontal(weights.data(), intRadius, source, scratch.data(), width, height);
+    Blur::vertical(weights.data(), intRadius, scratch.data(), dest, width, height);
+}
+
+TEST(Blur, gaussian_matchesReference) {
+    for (int radius : { 1, 4, 11, 25 }) {
+        // widths that aren't multiples of the SIMD width, and narrower than the kernel
+        for (int width : { 3, 37, 130 }) {
+            const int height = width / 2 + 3;
+            std::vector<uint8_t> image = createTestImage(width, height);
+            std::vector<float> weights(2 * radius + 1);
+            Blur::generateGaussianWeights(weights.data(), radius);
+
+            std::vector<uint8_t> expected(width * height);
+            referenceBlur(weights.data(), radius, image.data(), expected.data(), width, height);
+            std::vector<uint8_t> actual(width * height);
+            gaussianBlur(radius, image.data(), actual.data(), width, height);
+
+            // a fused multiply-add in the scalar path may round the last bit differently
+            for (int i = 0; i < width * height; i++) {
+                ASSERT_LE(abs(expected[i] - actual[i]), 1)
+                        << "radius " << radius << ", width " << width << ", pixel " << i;
+            }
+        }
+    }
+}
+
+TEST(Blur, tripleBox_approximatesGaussian) {
+    for (int radius : { 12, 25, 40 }) {
+        for (int width : { 5, 64, 301 }) {
+            const int height = width / 2 + 3;
+            std::vector<uint8_t> image = createTestImage(width, height);
+            std::vector<uint8_t> expected(width * height);
+            gaussianBlur(radius, image.data(), expected.data(), width, height);
+            Blur::tripleBox(radius, image.data(), width, height);
+
+            int maxError = 0;
+            int totalError = 0;
+            for (int i = 0; i < width * height; i++) {
+                int error = abs(expected[i] - image[i]);
+                maxError = std::max(maxError, error);
+                totalError += error;
+            }
+            EXPECT_LE(maxError, 12) << "radius " << radius << ", width " << width;
+            EXPECT_LE(totalError, 3 * width * height) << "radius " << radius << ", width " << width;
+        }
+    }
+}
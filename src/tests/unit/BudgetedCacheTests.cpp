@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "utils/BudgetedCache.h"
+
+#include <set>
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer;
+
+typedef BudgetedCache<uint32_t, uint32_t*> TestCache;
+
+class RemovedRecorder : public OnEntryRemoved<uint32_t, uint32_t*> {
+public:
+    void operator()(uint32_t& key, uint32_t*& value) override {
+        removedKeys.push_back(key);
+        EXPECT_EQ(key, *value);
+    }
+    std::vector<uint32_t> removedKeys;
+};
+
+static uint32_t sValues[1000];
+
+static void putEntry(TestCache& cache, uint32_t key, uint32_t weight) {
+    sValues[key] = key;
+    cache.put(key, &sValues[key], weight);
+}
+
+TEST(BudgetedCache, putGetRemove) {
+    RemovedRecorder recorder;
+    TestCache cache(CachePolicy::Lru, 100);
+    cache.setOnEntryRemovedListener(&recorder);
+
+    putEntry(cache, 1, 10);
+    putEntry(cache, 2, 20);
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(30u, cache.getWeight());
+    EXPECT_FALSE(cache.put(1, &sValues[1], 10)) << "key already present";
+
+    EXPECT_EQ(&sValues[2], cache.get(2));
+    EXPECT_EQ(nullptr, cache.get(3));
+    EXPECT_EQ(1u, cache.getStats().hits);
+    EXPECT_EQ(1u, cache.getStats().misses);
+
+    EXPECT_TRUE(cache.remove(1));
+    EXPECT_FALSE(cache.remove(1));
+    EXPECT_EQ(20u, cache.getWeight());
+    EXPECT_EQ(std::vector<uint32_t>({1}), recorder.removedKeys);
+
+    EXPECT_TRUE(cache.setWeight(2, 50));
+    EXPECT_EQ(50u, cache.getWeight());
+
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.getWeight());
+    EXPECT_EQ(std::vector<uint32_t>({1, 2}), recorder.removedKeys);
+}
+
+TEST(BudgetedCache, lru_evictsLeastRecentlyUsedToFitWeight) {
+    RemovedRecorder recorder;
+    TestCache cache(CachePolicy::Lru, 100);
+    cache.setOnEntryRemovedListener(&recorder);
+
+    putEntry(cache, 1, 40);
+    putEntry(cache, 2, 40);
+    cache.get(1);
+    EXPECT_EQ(&sValues[2], cache.peekNextEvicted());
+
+    putEntry(cache, 3, 40);
+    EXPECT_EQ(std::vector<uint32_t>({2}), recorder.removedKeys);
+    EXPECT_EQ(80u, cache.getWeight());
+    EXPECT_EQ(1u, cache.getStats().evictions);
+
+    // too heavy to ever fit, so added without evicting anything
+    putEntry(cache, 4, 200);
+    EXPECT_EQ(3u, cache.size());
+    cache.trimToWeight(100);
+    EXPECT_EQ(std::vector<uint32_t>({2, 1, 3, 4}), recorder.removedKeys);
+}
+
+TEST(BudgetedCache, twoQueue_scanResistant) {
+    TestCache lru(CachePolicy::Lru, 1000);
+    TestCache twoQueue(CachePolicy::TwoQueue, 1000);
+
+    // working set of 50 entries, each used over several frames and evicted once along the way
+    for (TestCache* cache : { &lru, &twoQueue }) {
+        for (uint32_t frame = 0; frame < 5; frame++) {
+            for (uint32_t key = 0; key < 50; key++) {
+                if (!cache->get(key)) putEntry(*cache, key, 10);
+            }
+            // some one-off entries between frames
+            for (uint32_t key = 100 + frame * 40; key < 140 + frame * 40; key++) {
+                putEntry(*cache, key, 10);
+            }
+        }
+    }
+
+    // scroll through 600 one-off entries, each used a few times, using the working set meanwhile
+    for (TestCache* cache : { &lru, &twoQueue }) {
+        for (uint32_t key = 300; key < 900; key++) {
+            putEntry(*cache, key, 10);
+            cache->get(key);
+            cache->get(key);
+            if (key % 100 == 0) {
+                cache->get(key % 50);
+            }
+        }
+    }
+
+    uint32_t lruHits = 0;
+    uint32_t twoQueueHits = 0;
+    for (uint32_t key = 0; key < 50; key++) {
+        if (lru.get(key)) lruHits++;
+        if (twoQueue.get(key)) twoQueueHits++;
+    }
+    EXPECT_LT(lruHits, 10u) << "LRU is expected to be flushed by the scroll";
+    EXPECT_EQ(50u, twoQueueHits) << "2Q should keep the working set";
+    EXPECT_LE(twoQueue.getWeight(), 1000u);
+}
+
+TEST(BudgetedCache, iterator) {
+    TestCache cache(CachePolicy::TwoQueue, 100);
+    for (uint32_t key = 0; key < 30; key++) {
+        putEntry(cache, key, 10);
+    }
+    EXPECT_EQ(10u, cache.size());
+
+    std::set<uint32_t> keys;
+    TestCache::Iterator iter(cache);
+    while (iter.next()) {
+        EXPECT_EQ(iter.key(), *iter.value());
+        keys.insert(iter.key());
+    }
+    EXPECT_EQ(10u, keys.size());
+    EXPECT_EQ(20u, *keys.begin());
+}
+
+TEST(BudgetedCache, manyEntries) {
+    TestCache cache(CachePolicy::TwoQueue);
+    for (uint32_t key = 0; key < 1000; key++) {
+        putEntry(cache, key, 1);
+    }
+    for (uint32_t key = 0; key < 1000; key += 2) {
+        EXPECT_TRUE(cache.remove(key));
+    }
+    for (uint32_t key = 0; key < 1000; key++) {
+        EXPECT_EQ(key % 2 ? &sValues[key] : nullptr, cache.get(key));
+    }
+    EXPECT_EQ(500u, cache.size());
+    EXPECT_EQ(500u, cache.getWeight());
+}
+
+TEST(BudgetedCache, ghostHits) {
+    TestCache cache(CachePolicy::Lru, 100);
+    for (uint32_t key = 0; key < 20; key++) {
+        putEntry(cache, key, 10);
+    }
+    EXPECT_EQ(10u, cache.getStats().evictions);
+    EXPECT_EQ(nullptr, cache.get(0));
+    putEntry(cache, 0, 10);
+    EXPECT_EQ(1u, cache.getStats().ghostHits) << "key 0 was evicted, so a larger budget would hit";
+    putEntry(cache, 100, 10);
+    EXPECT_EQ(1u, cache.getStats().ghostHits);
+
+    cache.setMaxWeight(50);
+    EXPECT_EQ(100u, cache.getWeight()) << "setMaxWeight doesn't trim";
+    cache.trimToWeight(cache.getMaxWeight());
+    EXPECT_EQ(50u, cache.getWeight());
+    putEntry(cache, 101, 10);
+    EXPECT_EQ(50u, cache.getWeight());
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "CacheBudgetArbiter.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+class TestCache : public CacheBudgetArbiter::Client {
+public:
+    explicit TestCache(uint32_t maxSize, uint32_t minSize = 0)
+            : mCache(CachePolicy::Lru, maxSize)
+            , mMinSize(minSize) {
+    }
+
+    // Draws keys [0, count) of the given size, as a frame with that working set would
+    void drawFrame(uint32_t count, uint32_t size) {
+        for (uint32_t key = 0; key < count; key++) {
+            if (!mCache.get(key)) {
+                mCache.put(key, 1, size);
+            }
+        }
+    }
+
+    uint32_t getSize() override { return mCache.getWeight(); }
+    uint32_t getMaxSize() override { return mCache.getMaxWeight(); }
+    void setMaxSize(uint32_t maxSize) override {
+        mCache.setMaxWeight(maxSize);
+        mCache.trimToWeight(maxSize);
+    }
+    uint32_t getMinSize() override { return mMinSize; }
+    const CacheStats& getStats() override { return mCache.getStats(); }
+
+private:
+    BudgetedCache<uint32_t, int> mCache;
+    uint32_t mMinSize;
+};
+
+TEST(CacheBudgetArbiter, derivedTotalBudget) {
+    TestCache first(1000);
+    TestCache second(600);
+    CacheBudgetArbiter arbiter;
+    arbiter.addClient("first", &first);
+    arbiter.addClient("second", &second);
+    EXPECT_EQ(2000u, arbiter.getTotalBudget());
+
+    CacheBudgetArbiter fixedArbiter(5000);
+    fixedArbiter.addClient("first", &first);
+    EXPECT_EQ(5000u, fixedArbiter.getTotalBudget());
+}
+
+TEST(CacheBudgetArbiter, rebalance_movesBudgetToMarginalHits) {
+    TestCache thrashing(1000);
+    TestCache idle(1000);
+    CacheBudgetArbiter arbiter;
+    arbiter.addClient("thrashing", &thrashing);
+    arbiter.addClient("idle", &idle);
+
+    // a working set of 1500 bytes can't fit in 1000, so every use misses and hits a ghost,
+    // while a working set of 200 bytes always hits
+    for (uint32_t frame = 0; frame < 20 * CacheBudgetArbiter::kFramesPerWindow; frame++) {
+        thrashing.drawFrame(15, 100);
+        idle.drawFrame(2, 100);
+        arbiter.frameCompleted(thrashing.getSize() + idle.getSize());
+    }
+
+    EXPECT_GE(thrashing.getMaxSize(), 1500u);
+    EXPECT_LT(idle.getMaxSize(), 1000u);
+    EXPECT_GE(idle.getMaxSize(), 250u);
+    EXPECT_EQ(2000u, thrashing.getMaxSize() + idle.getMaxSize());
+    EXPECT_EQ(200u, idle.getSize());
+
+    String8 log;
+    arbiter.dump(log);
+    EXPECT_NE(-1, log.find("from idle to thrashing"));
+}
+
+TEST(CacheBudgetArbiter, pressure_trimsLowestHitsPerByte) {
+    TestCache hot(1000);
+    TestCache cold(1000);
+    CacheBudgetArbiter arbiter(2000);
+    arbiter.addClient("hot", &hot);
+    arbiter.addClient("cold", &cold);
+
+    for (uint32_t frame = 0; frame < CacheBudgetArbiter::kFramesPerWindow; frame++) {
+        hot.drawFrame(8, 100);
+        if (frame == 0) cold.drawFrame(8, 100);
+        arbiter.frameCompleted(hot.getSize() + cold.getSize());
+    }
+    EXPECT_EQ(800u, cold.getSize());
+
+    // textures owned by neither cache push the total 300 bytes over budget
+    arbiter.frameCompleted(hot.getSize() + cold.getSize() + 700);
+    EXPECT_EQ(500u, cold.getMaxSize()) << "cold cache should be trimmed first";
+    EXPECT_EQ(500u, cold.getSize());
+    EXPECT_EQ(1000u, hot.getMaxSize());
+    EXPECT_EQ(800u, hot.getSize());
+
+    // 350 bytes over budget: the cold cache goes down to its minimum, freeing 300 bytes since
+    // its entries are 100 bytes each, and the hot cache is trimmed for the rest
+    arbiter.frameCompleted(hot.getSize() + cold.getSize() + 1050);
+    EXPECT_EQ(250u, cold.getMaxSize());
+    EXPECT_EQ(200u, cold.getSize());
+    EXPECT_EQ(750u, hot.getMaxSize());
+
+    // once the other textures are gone, the budget is given back
+    for (uint32_t frame = 0; frame < 4 * CacheBudgetArbiter::kFramesPerWindow; frame++) {
+        hot.drawFrame(8, 100);
+        arbiter.frameCompleted(hot.getSize() + cold.getSize());
+    }
+    EXPECT_EQ(2000u, hot.getMaxSize() + cold.getMaxSize());
+    EXPECT_EQ(800u, hot.getSize());
+}
+
+TEST(CacheBudgetArbiter, minSize_neverTrimmedOrRebalancedBelow) {
+    TestCache bigEntries(1000, 600);
+    TestCache thrashing(1000);
+    CacheBudgetArbiter arbiter(2000);
+    arbiter.addClient("bigEntries", &bigEntries);
+    arbiter.addClient("thrashing", &thrashing);
+
+    // the other cache would take budget down to a quarter of the base budget, if it could
+    for (uint32_t frame = 0; frame < 20 * CacheBudgetArbiter::kFramesPerWindow; frame++) {
+        bigEntries.drawFrame(1, 600);
+        thrashing.drawFrame(15, 100);
+        arbiter.frameCompleted(bigEntries.getSize() + thrashing.getSize());
+    }
+    EXPECT_EQ(600u, bigEntries.getMaxSize());
+    EXPECT_EQ(1400u, thrashing.getMaxSize());
+
+    // and so would textures owned by neither cache
+    arbiter.frameCompleted(bigEntries.getSize() + thrashing.getSize() + 5000);
+    EXPECT_EQ(600u, bigEntries.getMaxSize());
+    EXPECT_EQ(600u, bigEntries.getSize());
+}
@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include "AnimationContext.h"
+#include "Caches.h"
 #include "IContextFactory.h"
 #include "renderthread/CanvasContext.h"
 #include "tests/common/TestUtils.h"
@@ -53,3 +54,32 @@ RENDERTHREAD_TEST(CanvasContext, invokeFunctor) {
         ASSERT_EQ(functor.getLastMode(), DrawGlInfo::kModeProcess);
     }
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(CanvasContext, deferPinImages) {
+    auto rootNode = TestUtils::createNode(0, 0, 200, 400, nullptr);
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, rootNode.get(), &contextFactory));
+    TextureCache& textureCache = Caches::getInstance().textureCache;
+    const uint32_t initialSize = textureCache.getSize();
+
+    // immutable bitmaps wait for pinDeferredImages()
+    LsaVector<sk_sp<Bitmap>> immutableImages;
+    immutableImages.push_back(TestUtils::createBitmap(20, 20));
+    immutableImages.back()->setImmutable();
+    EXPECT_TRUE(canvasContext->deferPinImages(immutableImages));
+    EXPECT_EQ(initialSize, textureCache.getSize());
+
+    // a mutable bitmap is pinned right away
+    LsaVector<sk_sp<Bitmap>> mutableImages;
+    mutableImages.push_back(TestUtils::createBitmap(10, 10));
+    EXPECT_TRUE(canvasContext->deferPinImages(mutableImages));
+    const uint32_t mutableSize = textureCache.getSize();
+    EXPECT_LT(initialSize, mutableSize);
+
+    canvasContext->pinDeferredImages();
+    EXPECT_LT(mutableSize, textureCache.getSize());
+
+    canvasContext->unpinImages();
+    canvasContext->destroy();
+}
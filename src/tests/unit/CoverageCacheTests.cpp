@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "hwui/Typeface.h"
+
+#include <minikin/FontCollection.h>
+#include <minikin/FontFamily.h>
+#include <minikin/SparseBitSet.h>
+
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace android;
+
+// Defined in GraphicsStatsServiceTests.cpp
+std::string findRootPath();
+
+// A new family of the first font of the default typeface, which computes its coverage
+static std::shared_ptr<minikin::FontFamily> buildFamily() {
+    const minikin::FontCollection& collection =
+            *Typeface::resolveDefault(nullptr)->fFontCollection;
+    std::shared_ptr<minikin::MinikinFont> font = collection.getFamilyAt(0)->getFont(0);
+    std::vector<minikin::Font> fonts;
+    fonts.push_back(minikin::Font(std::move(font), minikin::FontStyle()));
+    return std::make_shared<minikin::FontFamily>(std::move(fonts));
+}
+
+static void expectSameBits(const minikin::SparseBitSet& expected,
+        const minikin::SparseBitSet& actual) {
+    uint32_t expectedBit = expected.nextSetBit(0);
+    uint32_t actualBit = actual.nextSetBit(0);
+    while (expectedBit != minikin::SparseBitSet::kNotFound && expectedBit == actualBit) {
+        expectedBit = expected.nextSetBit(expectedBit + 1);
+        actualBit = actual.nextSetBit(actualBit + 1);
+    }
+    EXPECT_EQ(expectedBit, actualBit) << "coverage differs";
+}
+
+TEST(CoverageCache, roundTrip) {
+    std::string path = findRootPath() + "/test_coverage_cache";
+    unlink(path.c_str());
+    minikin::FontFamily::setCoverageCachePath(path);
+
+    // Parsed from the cmap table, then added to the file
+    const uint64_t hits = minikin::FontFamily::getCoverageCacheHitCount();
+    std::shared_ptr<minikin::FontFamily> parsed = buildFamily();
+    EXPECT_EQ(hits, minikin::FontFamily::getCoverageCacheHitCount());
+    EXPECT_GT(parsed->getCoverage().length(), 0u);
+    minikin::FontFamily::flushCoverageCache();
+    EXPECT_EQ(0, access(path.c_str(), R_OK));
+
+    // Found in the file, as a new process would
+    minikin::FontFamily::setCoverageCachePath("");
+    minikin::FontFamily::setCoverageCachePath(path);
+    std::shared_ptr<minikin::FontFamily> found = buildFamily();
+    EXPECT_EQ(hits + 1, minikin::FontFamily::getCoverageCacheHitCount());
+    expectSameBits(parsed->getCoverage(), found->getCoverage());
+    EXPECT_EQ(parsed->hasVSTable(), found->hasVSTable());
+    for (uint32_t ch : { 0x20u, 'A', 0xE9u, 0x2764u, 0x1F600u }) {
+        EXPECT_EQ(parsed->hasGlyph(ch, 0), found->hasGlyph(ch, 0));
+        EXPECT_EQ(parsed->hasGlyph(ch, 0xFE0F), found->hasGlyph(ch, 0xFE0F));
+    }
+
+    minikin::FontFamily::setCoverageCachePath("");
+    unlink(path.c_str());
+}
@@ -17,8 +17,12 @@
 #include <gtest/gtest.h>
 
 #include "GammaFontRenderer.h"
+#include "font/CacheTexture.h"
+#include "font/CachedGlyphInfo.h"
 #include "tests/common/TestUtils.h"
 
+#include <algorithm>
+
 using namespace android::uirenderer;
 
 static bool isZero(uint8_t* data, int size) {
@@ -53,3 +57,96 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(FontRenderer, DISABLED_renderDropShadow) {
         delete result.image;
     }
 }
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(FontRenderer, compactCacheTexture) {
+    SkPaint paint;
+    paint.setTextSize(40);
+    paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+    GammaFontRenderer gammaFontRenderer;
+    FontRenderer& fontRenderer = gammaFontRenderer.getFontRenderer();
+    fontRenderer.setFont(&paint, SkMatrix::I());
+
+    // Fill the cache textures with glyphs in frame 0...
+    std::vector<glyph_t> glyphs;
+    for (glyph_t glyph = 1; glyph <= 200; glyph++) {
+        glyphs.push_back(glyph);
+    }
+    fontRenderer.precache(&paint, glyphs.data(), glyphs.size(), SkMatrix::I());
+
+    // ...then use every other one again in frame 1, leaving the rest cold
+    fontRenderer.frameCompleted();
+    std::vector<glyph_t> hotGlyphs;
+    for (glyph_t glyph : glyphs) {
+        if (glyph % 2 == 0) hotGlyphs.push_back(glyph);
+    }
+    fontRenderer.precache(&paint, hotGlyphs.data(), hotGlyphs.size(), SkMatrix::I());
+
+    // Copy out the pixels of the hot glyphs, to check they move along with their coordinates
+    std::vector<CacheTexture*> cacheTextures;
+    std::vector<std::vector<uint8_t>> hotImages;
+    for (glyph_t glyph : hotGlyphs) {
+        CachedGlyphInfo* cachedGlyph = TestUtils::getCachedGlyph(fontRenderer, glyph);
+        ASSERT_NE(nullptr, cachedGlyph);
+        ASSERT_TRUE(cachedGlyph->mIsValid);
+        std::vector<uint8_t> image;
+        CacheTexture* cacheTexture = cachedGlyph->mCacheTexture;
+        if (cacheTexture) {
+            if (std::find(cacheTextures.begin(), cacheTextures.end(), cacheTexture)
+                    == cacheTextures.end()) {
+                cacheTextures.push_back(cacheTexture);
+            }
+            const uint8_t* cacheBuffer = cacheTexture->getPixelBuffer()->map();
+            const uint32_t rowSize = cachedGlyph->mBitmapWidth
+                    * PixelBuffer::formatSize(cacheTexture->getFormat());
+            for (uint32_t y = 0; y < cachedGlyph->mBitmapHeight; y++) {
+                const uint8_t* row = &cacheBuffer[cacheTexture->getOffset(
+                        cachedGlyph->mStartX, cachedGlyph->mStartY + y)];
+                image.insert(image.end(), row, row + rowSize);
+            }
+        }
+        hotImages.push_back(std::move(image));
+    }
+    ASSERT_FALSE(cacheTextures.empty());
+
+    bool evicted = false;
+    for (CacheTexture* cacheTexture : cacheTextures) {
+        evicted |= TestUtils::compactCacheTexture(fontRenderer, cacheTexture, 1);
+    }
+    EXPECT_TRUE(evicted);
+
+    // The cold glyphs are gone from the textures...
+    for (glyph_t glyph : glyphs) {
+        if (glyph % 2 == 0) continue;
+        CachedGlyphInfo* cachedGlyph = TestUtils::getCachedGlyph(fontRenderer, glyph);
+        ASSERT_NE(nullptr, cachedGlyph);
+        if (cachedGlyph->mCacheTexture) {
+            EXPECT_FALSE(cachedGlyph->mIsValid) << "glyph " << glyph << " should be evicted";
+        }
+    }
+
+    // ...and the hot ones were repacked, with their texture coordinates following them
+    for (size_t i = 0; i < hotGlyphs.size(); i++) {
+        CachedGlyphInfo* cachedGlyph = TestUtils::getCachedGlyph(fontRenderer, hotGlyphs[i]);
+        CacheTexture* cacheTexture = cachedGlyph->mCacheTexture;
+        if (!cacheTexture) continue;
+        ASSERT_TRUE(cachedGlyph->mIsValid) << "glyph " << hotGlyphs[i] << " should survive";
+
+        const float width = cacheTexture->getWidth();
+        const float height = cacheTexture->getHeight();
+        EXPECT_FLOAT_EQ(cachedGlyph->mStartX / width, cachedGlyph->mBitmapMinU);
+        EXPECT_FLOAT_EQ(cachedGlyph->mStartY / height, cachedGlyph->mBitmapMinV);
+        EXPECT_FLOAT_EQ((cachedGlyph->mStartX + cachedGlyph->mBitmapWidth) / width,
+                cachedGlyph->mBitmapMaxU);
+        EXPECT_FLOAT_EQ((cachedGlyph->mStartY + cachedGlyph->mBitmapHeight) / height,
+                cachedGlyph->mBitmapMaxV);
+
+        const uint8_t* cacheBuffer = cacheTexture->getPixelBuffer()->map();
+        const uint32_t rowSize = cachedGlyph->mBitmapWidth
+                * PixelBuffer::formatSize(cacheTexture->getFormat());
+        for (uint32_t y = 0; y < cachedGlyph->mBitmapHeight; y++) {
+            EXPECT_EQ(0, memcmp(&hotImages[i][y * rowSize], &cacheBuffer[cacheTexture->getOffset(
+                    cachedGlyph->mStartX, cachedGlyph->mStartY + y)], rowSize))
+                    << "glyph " << hotGlyphs[i] << " row " << y << " moved incorrectly";
+        }
+    }
+}
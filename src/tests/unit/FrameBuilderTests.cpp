@@ -25,6 +25,8 @@
 #include <RecordingCanvas.h>
 #include <tests/common/TestUtils.h>
 
+#include <SkBlurDrawLooper.h>
+
 #include <unordered_map>
 
 namespace android {
@@ -254,6 +256,47 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, simpleBatching) {
             << "Expect number of ops = 2 * loop count";
 }
 
+RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, manyOpsBatching) {
+    // Enough ops for the LayerBuilder to track op bounds spatially
+    const int LOOPS = 100;
+    class ManyOpsBatchingTestRenderer : public TestRendererBase {
+    public:
+        void onBitmapOp(const BitmapOp& op, const BakedOpState& state) override {
+            int index = mIndex++;
+            EXPECT_TRUE(index >= LOOPS && index < 2 * LOOPS) << "Bitmaps should be above all rects";
+        }
+        void onRectOp(const RectOp& op, const BakedOpState& state) override {
+            int index = mIndex++;
+            EXPECT_TRUE(index < LOOPS || index == 2 * LOOPS)
+                    << "Rects should be below all bitmaps, except the one drawn over a bitmap";
+        }
+    };
+
+    auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        sk_sp<Bitmap> bitmap(TestUtils::createBitmap(10, 10,
+                kAlpha_8_SkColorType)); // Disable merging by using alpha 8 bitmap
+
+        // Same pattern as simpleBatching, laid out on a grid
+        for (int i = 0; i < LOOPS; i++) {
+            canvas.save(SaveFlags::MatrixClip);
+            canvas.translate((i % 10) * 20, (i / 10) * 20);
+            canvas.drawRect(0, 0, 10, 10, SkPaint());
+            canvas.drawBitmap(*bitmap, 5, 0, nullptr);
+            canvas.restore();
+        }
+        // Overlaps the first bitmap, so can't join the rect batch
+        canvas.drawRect(6, 1, 8, 3, SkPaint());
+    });
+    FrameBuilder frameBuilder(SkRect::MakeWH(200, 200), 200, 200,
+            sLightGeometry, Caches::getInstance());
+    frameBuilder.deferRenderNode(*TestUtils::getSyncedNode(node));
+
+    ManyOpsBatchingTestRenderer renderer;
+    frameBuilder.replayBakedOps<TestDispatcher>(renderer);
+    EXPECT_EQ(2 * LOOPS + 1, renderer.getIndex());
+}
+
 RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, deferRenderNode_translateClip) {
     class DeferRenderNodeTranslateClipTestRenderer : public TestRendererBase {
     public:
@@ -489,6 +532,131 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, avoidOverdraw_bitmaps) {
     EXPECT_EQ(2, renderer.getIndex()) << "Expect exactly two ops";
 }
 
+RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, occlusionCulling) {
+    static sk_sp<Bitmap> opaqueBitmap(TestUtils::createBitmap(100, 100,
+            SkColorType::kRGB_565_SkColorType));
+    static sk_sp<Bitmap> transpBitmap(TestUtils::createBitmap(50, 50,
+            SkColorType::kAlpha_8_SkColorType));
+    class OcclusionCullingTestRenderer : public TestRendererBase {
+    public:
+        void onRectOp(const RectOp& op, const BakedOpState& state) override {
+            EXPECT_EQ(0, mIndex++);
+            EXPECT_EQ(Rect(200, 200), op.unmappedBounds)
+                    << "Only the background should remain, the small rect is hidden";
+        }
+        void onBitmapOp(const BitmapOp& op, const BakedOpState& state) override {
+            switch(mIndex++) {
+            case 1:
+                EXPECT_EQ(opaqueBitmap.get(), op.bitmap);
+                break;
+            case 2:
+                EXPECT_EQ(transpBitmap.get(), op.bitmap);
+                break;
+            default:
+                ADD_FAILURE() << "Only two bitmaps expected.";
+            }
+        }
+    };
+
+    auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        canvas.drawRect(0, 0, 200, 200, SkPaint());
+        canvas.drawRect(50, 50, 60, 60, SkPaint()); // hidden by opaque bitmap
+
+        // opaque bitmap doesn't cover the whole layer, so layer isn't cleared
+        canvas.drawBitmap(*opaqueBitmap, 20, 20, nullptr);
+        canvas.drawBitmap(*transpBitmap, 30, 30, nullptr);
+    });
+    FrameBuilder frameBuilder(SkRect::MakeWH(200, 200), 200, 200,
+            sLightGeometry, Caches::getInstance());
+    frameBuilder.deferRenderNode(*TestUtils::getSyncedNode(node));
+
+    OcclusionCullingTestRenderer renderer;
+    frameBuilder.replayBakedOps<TestDispatcher>(renderer);
+    EXPECT_EQ(3, renderer.getIndex());
+    EXPECT_EQ(1u, frameBuilder.getCulledOpCount());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, occlusionCulling_textShadow) {
+    class TextShadowCullingTestRenderer : public TestRendererBase {
+    public:
+        void onTextOp(const TextOp& op, const BakedOpState& state) override {
+            EXPECT_EQ(0, mIndex++);
+        }
+        void onMergedTextOps(const MergedBakedOpList& opList) override {
+            EXPECT_EQ(0, mIndex++);
+        }
+        void onRectOp(const RectOp& op, const BakedOpState& state) override {
+            EXPECT_EQ(1, mIndex++);
+        }
+    };
+
+    auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        SkPaint paint;
+        paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+        paint.setTextSize(20);
+        // shadow drawn well below and right of the glyphs, outside of the rect
+        paint.setLooper(SkBlurDrawLooper::Make(SK_ColorBLACK, 2, 100, 100));
+        TestUtils::drawUtf8ToCanvas(&canvas, "A", paint, 20, 40);
+        canvas.drawRect(0, 0, 100, 100, SkPaint()); // hides the glyphs, not their shadow
+    });
+    FrameBuilder frameBuilder(SkRect::MakeWH(200, 200), 200, 200,
+            sLightGeometry, Caches::getInstance());
+    frameBuilder.deferRenderNode(*TestUtils::getSyncedNode(node));
+
+    TextShadowCullingTestRenderer renderer;
+    frameBuilder.replayBakedOps<TestDispatcher>(renderer);
+    EXPECT_EQ(2, renderer.getIndex());
+    EXPECT_EQ(0u, frameBuilder.getCulledOpCount());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, sortBatches) {
+    static sk_sp<Bitmap> bitmap(TestUtils::createBitmap(10, 10));
+    class SortBatchesTestRenderer : public TestRendererBase {
+    public:
+        explicit SortBatchesTestRenderer(bool sorted) : mSorted(sorted) {}
+        void onRectOp(const RectOp& op, const BakedOpState& state) override {
+            if (mIndex == 0) {
+                EXPECT_FALSE(mSorted);
+                EXPECT_EQ(Rect(10, 10), op.unmappedBounds);
+            } else if (mIndex == 1) {
+                EXPECT_TRUE(mSorted);
+                EXPECT_EQ(Rect(10, 10), op.unmappedBounds);
+            } else {
+                EXPECT_EQ(2, mIndex);
+                EXPECT_EQ(Rect(50, 0, 60, 10), op.unmappedBounds);
+            }
+            mIndex++;
+        }
+        void onBitmapOp(const BitmapOp& op, const BakedOpState& state) override {
+            EXPECT_EQ(mSorted ? 0 : 1, mIndex++);
+        }
+    private:
+        bool mSorted;
+    };
+
+    auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 100, 100,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        canvas.drawRect(0, 0, 10, 10, SkPaint());
+        canvas.drawBitmap(*bitmap, 50, 0, nullptr);
+        // overlaps the bitmap, so can't join the first rect's batch during deferral
+        canvas.drawRect(50, 0, 60, 10, SkPaint());
+    });
+
+    for (bool sorted : { false, true }) {
+        ScopedProperty<bool> sortBatches(Properties::sortBatches, sorted);
+        FrameBuilder frameBuilder(SkRect::MakeWH(100, 100), 100, 100,
+                sLightGeometry, Caches::getInstance());
+        frameBuilder.deferRenderNode(*TestUtils::getSyncedNode(node));
+
+        // sorting moves the bitmap before the first rect, so the two rects are drawn together
+        SortBatchesTestRenderer renderer(sorted);
+        frameBuilder.replayBakedOps<TestDispatcher>(renderer);
+        EXPECT_EQ(3, renderer.getIndex());
+    }
+}
+
 RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, clippedMerging) {
     class ClippedMergingTestRenderer : public TestRendererBase {
     public:
@@ -1487,6 +1655,76 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, hwLayer_complex) {
 }
 
 
+RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, hwLayer_parallelDefer) {
+    /* Two independent layers, deferred concurrently, still play back in queue order:
+     * - startRepaintLayer(first), rect(white), endLayer
+     * - startRepaintLayer(second), rect(grey), endLayer
+     */
+    class HwLayerParallelTestRenderer : public TestRendererBase {
+    public:
+        void startRepaintLayer(OffscreenBuffer* offscreenBuffer, const Rect& repaintRect) override {
+            int index = mIndex++;
+            if (index == 0) {
+                EXPECT_EQ(100u, offscreenBuffer->viewportWidth);
+            } else if (index == 3) {
+                EXPECT_EQ(200u, offscreenBuffer->viewportWidth);
+            } else { ADD_FAILURE(); }
+        }
+        void onRectOp(const RectOp& op, const BakedOpState& state) override {
+            int index = mIndex++;
+            if (index == 1) {
+                EXPECT_EQ(SK_ColorWHITE, op.paint->getColor());
+            } else if (index == 4) {
+                EXPECT_EQ(SK_ColorDKGRAY, op.paint->getColor());
+            } else { ADD_FAILURE(); }
+        }
+        void endLayer() override {
+            int index = mIndex++;
+            EXPECT_TRUE(index == 2 || index == 5);
+        }
+    };
+
+    ScopedProperty<bool> parallel(Properties::parallelLayerDeferral, true);
+
+    auto first = TestUtils::createNode<RecordingCanvas>(0, 0, 100, 100,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        props.mutateLayerProperties().setType(LayerType::RenderLayer);
+        SkPaint paint;
+        paint.setColor(SK_ColorWHITE);
+        canvas.drawRect(0, 0, 100, 100, paint);
+    });
+    OffscreenBuffer firstLayer(renderThread.renderState(), Caches::getInstance(), 100, 100);
+    *(first->getLayerHandle()) = &firstLayer;
+
+    auto second = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 200,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        props.mutateLayerProperties().setType(LayerType::RenderLayer);
+        SkPaint paint;
+        paint.setColor(SK_ColorDKGRAY);
+        canvas.drawRect(0, 0, 200, 200, paint);
+    });
+    OffscreenBuffer secondLayer(renderThread.renderState(), Caches::getInstance(), 200, 200);
+    *(second->getLayerHandle()) = &secondLayer;
+
+    TestUtils::syncHierarchyPropertiesAndDisplayList(first);
+    TestUtils::syncHierarchyPropertiesAndDisplayList(second);
+
+    LayerUpdateQueue layerUpdateQueue; // Note: enqueue damage post-sync, so bounds are valid
+    layerUpdateQueue.enqueueLayerWithDamage(first.get(), Rect(100, 100));
+    layerUpdateQueue.enqueueLayerWithDamage(second.get(), Rect(200, 200));
+
+    FrameBuilder frameBuilder(layerUpdateQueue, sLightGeometry, Caches::getInstance());
+
+    HwLayerParallelTestRenderer renderer;
+    frameBuilder.replayBakedOps<TestDispatcher>(renderer);
+    EXPECT_EQ(6, renderer.getIndex());
+
+    // clean up layer pointers, so we can safely destruct RenderNodes
+    *(first->getLayerHandle()) = nullptr;
+    *(second->getLayerHandle()) = nullptr;
+}
+
+
 RENDERTHREAD_OPENGL_PIPELINE_TEST(FrameBuilder, buildLayer) {
     class BuildLayerTestRenderer : public TestRendererBase {
     public:
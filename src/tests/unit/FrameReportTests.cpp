@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <FrameInfo.h>
+#include <tests/macrobench/FrameReport.h>
+
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::test;
+
+// Defined in GraphicsStatsServiceTests.cpp
+std::string findRootPath();
+
+static const char* kBaseline = R"({
+  "scenes": [
+    {
+      "name": "scene",
+      "summary": {
+        "drawCalls": {"50th": 10, "90th": 10},
+        "blendChanges": {"50th": 0, "90th": 0},
+        "culledOps": {"50th": 5, "90th": 5}
+      }
+    },
+    {
+      "name": "otherScene",
+      "summary": {
+        "drawCalls": {"50th": 0, "90th": 0}
+      }
+    }
+  ]
+})";
+
+static std::string writeBaseline() {
+    std::string path = findRootPath() + "/test_frame_report_baseline.json";
+    FILE* file = fopen(path.c_str(), "w");
+    EXPECT_NE(nullptr, file);
+    if (file) {
+        fputs(kBaseline, file);
+        fclose(file);
+    }
+    return path;
+}
+
+static void addFrames(FrameReport& report, int64_t drawCalls, int64_t blendChanges,
+        int64_t culledOps) {
+    int64_t buffer[static_cast<int>(FrameInfoIndex::NumIndexes)] = {};
+    buffer[static_cast<int>(FrameInfoIndex::DrawCallCount)] = drawCalls;
+    buffer[static_cast<int>(FrameInfoIndex::BlendChangeCount)] = blendChanges;
+    buffer[static_cast<int>(FrameInfoIndex::CulledOpCount)] = culledOps;
+    sp<FrameReport::Observer> observer = report.observeScene("scene");
+    for (int i = 0; i < 10; i++) {
+        observer->notify(buffer);
+    }
+}
+
+TEST(FrameReport, compareWithBaseline_unchanged) {
+    std::string path = writeBaseline();
+    FrameReport report;
+    addFrames(report, 10, 0, 5);
+    EXPECT_EQ(0, report.compareWithBaseline(path.c_str(), 0.1f));
+    unlink(path.c_str());
+}
+
+TEST(FrameReport, compareWithBaseline_higherIsWorse) {
+    std::string path = writeBaseline();
+    FrameReport report;
+    addFrames(report, 20, 0, 5);
+    EXPECT_EQ(2, report.compareWithBaseline(path.c_str(), 0.1f))
+            << "drawCalls should regress at both compared percentiles";
+    unlink(path.c_str());
+}
+
+TEST(FrameReport, compareWithBaseline_culledOps) {
+    std::string path = writeBaseline();
+    FrameReport report;
+    addFrames(report, 10, 0, 50);
+    EXPECT_EQ(0, report.compareWithBaseline(path.c_str(), 0.1f))
+            << "culling more ops isn't a regression";
+
+    FrameReport fewerCulled;
+    addFrames(fewerCulled, 10, 0, 0);
+    EXPECT_EQ(2, fewerCulled.compareWithBaseline(path.c_str(), 0.1f));
+    unlink(path.c_str());
+}
+
+TEST(FrameReport, compareWithBaseline_countFloor) {
+    std::string path = writeBaseline();
+    FrameReport report;
+    addFrames(report, 10, 1, 5);
+    EXPECT_EQ(0, report.compareWithBaseline(path.c_str(), 0.1f))
+            << "a count growing from a baseline of 0 by less than the floor is noise";
+
+    FrameReport moreBlends;
+    addFrames(moreBlends, 10, 5, 5);
+    EXPECT_EQ(2, moreBlends.compareWithBaseline(path.c_str(), 0.1f));
+    unlink(path.c_str());
+}
+
+TEST(FrameReport, compareWithBaseline_missingBaseline) {
+    FrameReport report;
+    addFrames(report, 10, 0, 5);
+    std::string path = findRootPath() + "/test_frame_report_missing.json";
+    unlink(path.c_str());
+    EXPECT_EQ(-1, report.compareWithBaseline(path.c_str(), 0.1f));
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <debug/GlesAccountingDriver.h>
+#include <debug/NullGlesDriver.h>
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::debug;
+
+TEST(GlesAccountingDriver, counters) {
+    GlesAccountingDriver driver(std::make_unique<NullGlesDriver>());
+    EXPECT_EQ(&driver, GlesAccountingDriver::get());
+
+    driver.glEnable_(GL_BLEND);
+    driver.glBlendFunc_(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    driver.glUniform1f_(0, 1.0f);
+    driver.glDrawArrays_(GL_TRIANGLES, 0, 6);
+    driver.glDrawElements_(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+
+    uint8_t data[64 * 64 * 4] = {};
+    driver.glBufferData_(GL_ARRAY_BUFFER, 256, nullptr, GL_DYNAMIC_DRAW);
+    driver.glBufferSubData_(GL_ARRAY_BUFFER, 0, 128, data);
+
+    // allocating a texture isn't an upload, filling it is
+    driver.glTexImage2D_(GL_TEXTURE_2D, 0, GL_RGBA, 64, 64, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+            nullptr);
+    driver.glTexSubImage2D_(GL_TEXTURE_2D, 0, 0, 0, 64, 64, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    driver.glTexSubImage2D_(GL_TEXTURE_2D, 0, 0, 0, 16, 16, GL_RGB, GL_UNSIGNED_SHORT_5_6_5,
+            data);
+
+    const GlesCounters& counters = driver.getCounters();
+    EXPECT_EQ(10u, counters.calls);
+    EXPECT_EQ(2u, counters.drawCalls);
+    EXPECT_EQ(2u, counters.stateChanges);
+    EXPECT_EQ(1u, counters.bufferUploads);
+    EXPECT_EQ(128u, counters.bufferUploadBytes);
+    EXPECT_EQ(2u, counters.textureUploads);
+    EXPECT_EQ(64u * 64 * 4 + 16 * 16 * 2, counters.textureUploadBytes);
+}
+
+TEST(GlesAccountingDriver, pixelUnpackBuffer) {
+    GlesAccountingDriver driver(std::make_unique<NullGlesDriver>());
+
+    // with a pixel unpack buffer bound, the pixels pointer is an offset into it
+    driver.glBindBuffer_(GL_PIXEL_UNPACK_BUFFER, 1);
+    driver.glTexSubImage2D_(GL_TEXTURE_2D, 0, 0, 0, 8, 8, GL_ALPHA, GL_UNSIGNED_BYTE, nullptr);
+    driver.glBindBuffer_(GL_PIXEL_UNPACK_BUFFER, 0);
+    driver.glTexSubImage2D_(GL_TEXTURE_2D, 0, 0, 0, 8, 8, GL_ALPHA, GL_UNSIGNED_BYTE, nullptr);
+
+    EXPECT_EQ(1u, driver.getCounters().textureUploads);
+    EXPECT_EQ(64u, driver.getCounters().textureUploadBytes);
+    EXPECT_EQ(2u, driver.getCounters().stateChanges);
+}
+
+TEST(GlesAccountingDriver, frameInfo) {
+    GlesAccountingDriver driver(std::make_unique<NullGlesDriver>());
+    driver.glDrawArrays_(GL_TRIANGLES, 0, 3);
+
+    FrameInfo frameInfo;
+    GlesAccountingDriver::beginFrame();
+    driver.glBindTexture_(GL_TEXTURE_2D, 1);
+    uint8_t data[4] = {};
+    driver.glTexSubImage2D_(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    GlesAccountingDriver::endFrame(frameInfo);
+
+    EXPECT_EQ(2, frameInfo[FrameInfoIndex::GlCallCount]);
+    EXPECT_EQ(1, frameInfo[FrameInfoIndex::StateChangeCount]);
+    EXPECT_EQ(1, frameInfo[FrameInfoIndex::TextureUploadCount]);
+    EXPECT_EQ(4, frameInfo[FrameInfoIndex::TextureUploadBytes]);
+    EXPECT_EQ(0, frameInfo[FrameInfoIndex::BufferUploadCount]);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "hwui/MinikinUtils.h"
+#include "hwui/Paint.h"
+#include "tests/common/TestUtils.h"
+
+#include <minikin/Layout.h>
+
+#include <memory>
+#include <string>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace android;
+using namespace android::uirenderer;
+
+// Defined in GraphicsStatsServiceTests.cpp
+std::string findRootPath();
+
+static float measure(Paint& paint, const char* text) {
+    const size_t length = strlen(text);
+    std::unique_ptr<uint16_t[]> utf16 = TestUtils::asciiToUtf16(text);
+    return MinikinUtils::measureText(&paint, minikin::kBidi_Force_LTR, nullptr, utf16.get(),
+            0, length, length, nullptr);
+}
+
+TEST(LayoutCache, hitsAndMisses) {
+    minikin::Layout::purgeCaches();
+    Paint paint;
+    paint.setTextSize(20);
+    minikin::LayoutCacheStats before = minikin::Layout::getCacheStats();
+    EXPECT_EQ(0u, before.entries);
+    EXPECT_EQ(0u, before.bytes);
+
+    // Three words and two spaces, the second of which is already cached
+    float advance = measure(paint, "cached word layout");
+    minikin::LayoutCacheStats missed = minikin::Layout::getCacheStats();
+    EXPECT_EQ(before.misses + 4, missed.misses);
+    EXPECT_EQ(before.hits + 1, missed.hits);
+    EXPECT_GT(missed.bytes, 0u);
+
+    EXPECT_EQ(advance, measure(paint, "cached word layout"));
+    minikin::LayoutCacheStats hit = minikin::Layout::getCacheStats();
+    EXPECT_EQ(missed.misses, hit.misses);
+    EXPECT_EQ(missed.hits + 5, hit.hits);
+    EXPECT_EQ(missed.bytes, hit.bytes);
+}
+
+TEST(LayoutCache, memoryBudget) {
+    minikin::Layout::purgeCaches();
+    Paint paint;
+    paint.setTextSize(20);
+    // Many more distinct words than the budget holds
+    for (int i = 0; i < 50000; i++) {
+        measure(paint, ("word" + std::to_string(i)).c_str());
+    }
+    minikin::LayoutCacheStats stats = minikin::Layout::getCacheStats();
+    EXPECT_GT(stats.entries, 0u);
+    EXPECT_LE(stats.bytes, stats.maxBytes);
+    EXPECT_GT(stats.rejections + stats.evictions, 0u);
+    minikin::Layout::purgeCaches();
+}
+
+TEST(LayoutCache, shapingCacheFile) {
+    std::string path = findRootPath() + "/test_shaping_cache";
+    unlink(path.c_str());
+    minikin::Layout::setShapingCachePath(path);
+    minikin::Layout::purgeCaches();
+    Paint paint;
+    paint.setTextSize(20);
+    float advance = measure(paint, "shaped once");
+    minikin::Layout::flushShapingCache();
+
+    // Two words and a space, read back from the file once the layout cache is empty
+    minikin::Layout::purgeCaches();
+    uint64_t fileHits = minikin::Layout::getCacheStats().fileHits;
+    EXPECT_EQ(advance, measure(paint, "shaped once"));
+    EXPECT_EQ(fileHits + 3, minikin::Layout::getCacheStats().fileHits);
+
+    minikin::Layout::setShapingCachePath("");
+    unlink(path.c_str());
+}
+
+TEST(LayoutCache, shapingCacheFile_damagedRecord) {
+    std::string path = findRootPath() + "/test_shaping_cache";
+    unlink(path.c_str());
+    minikin::Layout::setShapingCachePath(path);
+    minikin::Layout::purgeCaches();
+    Paint paint;
+    paint.setTextSize(20);
+    float advance = measure(paint, "shaped once");
+    minikin::Layout::flushShapingCache();
+
+    // Flip a bit of the last record in the file, as a partial write or bad storage would
+    FILE* file = fopen(path.c_str(), "r+");
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(0, fseek(file, -1, SEEK_END));
+    int last = fgetc(file);
+    ASSERT_EQ(0, fseek(file, -1, SEEK_END));
+    fputc(last ^ 1, file);
+    fclose(file);
+
+    // The damaged word is shaped again rather than read back
+    minikin::Layout::setShapingCachePath("");
+    minikin::Layout::setShapingCachePath(path);
+    minikin::Layout::purgeCaches();
+    uint64_t fileHits = minikin::Layout::getCacheStats().fileHits;
+    EXPECT_EQ(advance, measure(paint, "shaped once"));
+    EXPECT_EQ(fileHits + 2, minikin::Layout::getCacheStats().fileHits);
+
+    minikin::Layout::setShapingCachePath("");
+    unlink(path.c_str());
+}
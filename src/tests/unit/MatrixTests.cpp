@@ -19,6 +19,8 @@
 #include "Matrix.h"
 #include "Rect.h"
 
+#include <vector>
+
 using namespace android::uirenderer;
 
 TEST(Matrix, mapRect_emptyScaleSkew) {
@@ -48,3 +50,80 @@ TEST(Matrix, mapRect_emptyRotate) {
     EXPECT_FALSE(lineRect.isEmpty())
         << "Empty 'line' rect doesn't remain empty when rotated.";
 }
+
+static std::vector<Matrix4> createTestMatrices() {
+    std::vector<Matrix4> matrices;
+    Matrix4 matrix;
+    matrices.push_back(matrix); // identity
+    matrix.loadTranslate(10.5f, -20, 0);
+    matrices.push_back(matrix);
+    matrix.scale(-2, 3, 1);
+    matrices.push_back(matrix);
+    matrix.rotate(30, 0, 0, 1);
+    matrices.push_back(matrix);
+    SkMatrix perspective;
+    perspective.setAll(1, 0.2f, 5, 0.1f, 1, 7, 0.001f, 0.002f, 1);
+    matrices.push_back(Matrix4(perspective));
+    return matrices;
+}
+
+TEST(Matrix, mapPoints_matchesMapPoint) {
+    std::vector<Vertex> points;
+    for (int i = 0; i < 11; i++) {
+        points.push_back(Vertex{i * 17.25f - 40, i * -3.5f + 12});
+    }
+    for (const Matrix4& matrix : createTestMatrices()) {
+        std::vector<Vertex> mapped(points);
+        matrix.mapPoints(mapped.data(), mapped.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            float x = points[i].x;
+            float y = points[i].y;
+            matrix.mapPoint(x, y);
+            EXPECT_FLOAT_EQ(x, mapped[i].x) << "point " << i << ", matrix " << matrix;
+            EXPECT_FLOAT_EQ(y, mapped[i].y) << "point " << i << ", matrix " << matrix;
+        }
+    }
+}
+
+TEST(Matrix, mapRects_matchesMapRect) {
+    std::vector<Rect> rects = { Rect(10, 20, 30, 40), Rect(-5, 0, 5, 100), Rect(0, 100),
+            Rect(15, 20, 15, 100) };
+    for (const Matrix4& matrix : createTestMatrices()) {
+        std::vector<Rect> mapped(rects);
+        matrix.mapRects(mapped.data(), mapped.size());
+        for (size_t i = 0; i < rects.size(); i++) {
+            Rect expected(rects[i]);
+            matrix.mapRect(expected);
+            EXPECT_EQ(expected, mapped[i]) << "rect " << i << ", matrix " << matrix;
+        }
+    }
+}
+
+TEST(Matrix, mapRect_negativeScale) {
+    Matrix4 matrix;
+    matrix.loadScale(-2, -1, 1);
+    Rect rect(10, 20, 30, 40);
+    matrix.mapRect(rect);
+    EXPECT_EQ(Rect(-60, -40, -20, -20), rect);
+}
+
+TEST(Matrix, loadMultiply) {
+    Matrix4 translate;
+    translate.loadTranslate(10, 20, 0);
+    Matrix4 scale;
+    scale.loadScale(2, 3, 1);
+
+    Matrix4 result;
+    result.loadMultiply(translate, scale);
+    float x = 1;
+    float y = 1;
+    result.mapPoint(x, y);
+    EXPECT_EQ(12, x);
+    EXPECT_EQ(23, y);
+
+    Vector3 point = {1, 1, 5};
+    result.mapPoint3d(point);
+    EXPECT_EQ(12, point.x);
+    EXPECT_EQ(23, point.y);
+    EXPECT_EQ(5, point.z);
+}
@@ -34,3 +34,67 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(MeshState, genOrUpdate) {
     GLuint buffer = 0;
     renderThread.renderState().meshState().genOrUpdateMeshBuffer(&buffer, 10, nullptr, GL_DYNAMIC_DRAW);
 }
+
+// Sets up the mock driver to back the streaming buffer with storage, with fences never signaled
+// if busyFences is set
+static void expectStreamingCalls(debug::MockGlesDriver& mockGlDriver, uint8_t* storage,
+        bool busyFences) {
+    EXPECT_CALL(mockGlDriver, glGenBuffers_(1, _)).WillOnce(SetArgPointee<1>(36));
+    EXPECT_CALL(mockGlDriver, glBindBuffer_(GL_ARRAY_BUFFER, _)).Times(AnyNumber());
+    EXPECT_CALL(mockGlDriver, glMapBufferRange_(GL_ARRAY_BUFFER, _, _, _))
+            .WillRepeatedly(Invoke([storage](GLenum, GLintptr offset, GLsizeiptr, GLbitfield) {
+                return storage + offset;
+            }));
+    EXPECT_CALL(mockGlDriver, glUnmapBuffer_(GL_ARRAY_BUFFER)).WillRepeatedly(Return(GL_TRUE));
+    EXPECT_CALL(mockGlDriver, glFenceSync_(GL_SYNC_GPU_COMMANDS_COMPLETE, 0))
+            .WillRepeatedly(Return(reinterpret_cast<GLsync>(1)));
+    EXPECT_CALL(mockGlDriver, glClientWaitSync_(_, _, _))
+            .WillRepeatedly(Return(busyFences ? GL_TIMEOUT_EXPIRED : GL_ALREADY_SIGNALED));
+    EXPECT_CALL(mockGlDriver, glDeleteSync_(_)).Times(AnyNumber());
+    EXPECT_CALL(mockGlDriver, glDeleteBuffers_(1, Pointee(36)));
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(MeshState, streamingBuffer_reusesStorage) {
+    debug::ScopedReplaceDriver<debug::MockGlesDriver> driverRef;
+    auto& mockGlDriver = driverRef.get();
+    uint8_t storage[StreamingBuffer::kSegmentCount * 64];
+    expectStreamingCalls(mockGlDriver, storage, false);
+
+    // storage is only allocated once, however many frames are streamed
+    EXPECT_CALL(mockGlDriver, glBufferData_(GL_ARRAY_BUFFER, sizeof(storage), nullptr, _));
+
+    StreamingBuffer buffer(renderThread.renderState().meshState(), GL_ARRAY_BUFFER, 64, false);
+    const float data[] = { 1, 2, 3 };
+    for (int frame = 0; frame < 2 * StreamingBuffer::kSegmentCount; frame++) {
+        const GLintptr segmentStart = (frame % StreamingBuffer::kSegmentCount) * 64;
+        EXPECT_EQ(segmentStart, buffer.write(data, sizeof(data)));
+        EXPECT_EQ(segmentStart + 16, buffer.write(data, sizeof(data))) << "writes are aligned";
+        EXPECT_EQ(0, memcmp(data, storage + segmentStart + 16, sizeof(data)));
+        buffer.advance();
+    }
+    EXPECT_EQ(1, buffer.getAllocationCount());
+    EXPECT_EQ(36u, buffer.getBuffer());
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(MeshState, streamingBuffer_orphansBusyStorage) {
+    debug::ScopedReplaceDriver<debug::MockGlesDriver> driverRef;
+    auto& mockGlDriver = driverRef.get();
+    uint8_t storage[StreamingBuffer::kSegmentCount * 64];
+    expectStreamingCalls(mockGlDriver, storage, true);
+
+    // initial allocation, then once more on wrapping back to the still in use first segment
+    EXPECT_CALL(mockGlDriver, glBufferData_(GL_ARRAY_BUFFER, sizeof(storage), nullptr, _))
+            .Times(2);
+
+    StreamingBuffer buffer(renderThread.renderState().meshState(), GL_ARRAY_BUFFER, 64, false);
+    const float data[] = { 1, 2, 3 };
+    for (int frame = 0; frame <= StreamingBuffer::kSegmentCount; frame++) {
+        EXPECT_LE(0, buffer.write(data, sizeof(data)));
+        buffer.advance();
+    }
+    EXPECT_EQ(2, buffer.getAllocationCount());
+
+    // doesn't fit in a segment, so must be drawn from client memory
+    uint8_t largeData[65] = {};
+    EXPECT_EQ(-1, buffer.write(largeData, sizeof(largeData)));
+}
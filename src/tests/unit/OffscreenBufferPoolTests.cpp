@@ -153,3 +153,97 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, clear) {
 
     EXPECT_EQ(0, GpuMemoryTracker::getInstanceCount(GpuObjectType::OffscreenBuffer));
 }
+
+TEST(OffscreenBufferPool, canReuse) {
+    EXPECT_TRUE(OffscreenBufferPool::canReuse(64u, 64u, 60u, 55u));
+    EXPECT_TRUE(OffscreenBufferPool::canReuse(128u, 192u, 100u, 100u)) << "within waste bound";
+    EXPECT_FALSE(OffscreenBufferPool::canReuse(128u, 256u, 100u, 100u)) << "too much waste";
+    EXPECT_FALSE(OffscreenBufferPool::canReuse(128u, 128u, 130u, 100u)) << "too small";
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, getBestFit) {
+    OffscreenBufferPool pool;
+    auto large = pool.get(renderThread.renderState(), 192u, 192u);
+    auto medium = pool.get(renderThread.renderState(), 128u, 192u);
+    auto tooLarge = pool.get(renderThread.renderState(), 256u, 256u);
+    EXPECT_EQ(3u, pool.getFrameStats().misses);
+    pool.putOrDelete(large);
+    pool.putOrDelete(tooLarge);
+    pool.putOrDelete(medium);
+
+    // smallest texture that fits is chosen, even though it isn't an exact match
+    auto layer = pool.get(renderThread.renderState(), 100u, 150u);
+    EXPECT_EQ(medium, layer);
+    EXPECT_EQ(1u, pool.getFrameStats().hits);
+    EXPECT_EQ(0u, pool.getFrameStats().wastedBytes);
+    pool.putOrDelete(layer);
+
+    layer = pool.get(renderThread.renderState(), 150u, 150u);
+    EXPECT_EQ(large, layer);
+    EXPECT_EQ(2u, pool.getFrameStats().hits);
+    EXPECT_EQ(0u, pool.getFrameStats().wastedBytes);
+    pool.putOrDelete(layer);
+
+    layer = pool.get(renderThread.renderState(), 100u, 100u);
+    EXPECT_EQ(medium, layer) << "128x192 may be reused for a 128x128 layer";
+    EXPECT_EQ(128u * 64u * 4u, pool.getFrameStats().wastedBytes);
+    pool.putOrDelete(layer);
+
+    layer = pool.get(renderThread.renderState(), 64u, 64u);
+    EXPECT_NE(medium, layer) << "too much waste to reuse any texture for a 64x64 layer";
+    EXPECT_NE(large, layer);
+    EXPECT_NE(tooLarge, layer);
+    EXPECT_EQ(4u, pool.getFrameStats().misses);
+    pool.putOrDelete(layer);
+
+    pool.frameCompleted();
+    EXPECT_EQ(3u, pool.getLastFrameStats().hits);
+    EXPECT_EQ(4u, pool.getLastFrameStats().misses);
+    EXPECT_EQ(0u, pool.getFrameStats().hits);
+    EXPECT_EQ(0u, pool.getFrameStats().misses);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, putOrDelete_evictsLeastRecent) {
+    // room for two 128x128 layers
+    ScopedProperty<int> poolSize(Properties::layerPoolSize, 2 * 128 * 128 * 4);
+    OffscreenBufferPool pool;
+
+    auto first = pool.get(renderThread.renderState(), 128u, 128u);
+    auto second = pool.get(renderThread.renderState(), 100u, 100u);
+    auto small = pool.get(renderThread.renderState(), 64u, 64u);
+    pool.putOrDelete(first);
+    pool.putOrDelete(small);
+    pool.putOrDelete(second); // evicts first, even though small is smaller
+    EXPECT_EQ(2u, pool.getCount());
+    EXPECT_EQ(uint32_t(128 * 128 * 4 + 64 * 64 * 4), pool.getSize());
+
+    EXPECT_EQ(second, pool.get(renderThread.renderState(), 128u, 128u));
+    EXPECT_EQ(small, pool.get(renderThread.renderState(), 64u, 64u));
+    EXPECT_EQ(2u, pool.getFrameStats().hits);
+    EXPECT_EQ(3u, pool.getFrameStats().misses);
+    pool.putOrDelete(second);
+    pool.putOrDelete(small);
+}
+
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, resize_sizeAnimationSteadyState) {
+    OffscreenBufferPool pool;
+
+    // Mimics HwLayerSizeAnimation, which shrinks a 200x200 layer by one pixel per frame
+    auto layer = pool.get(renderThread.renderState(), 200u, 200u);
+    for (int cycle = 0; cycle < 3; cycle++) {
+        uint32_t misses = 0;
+        for (uint32_t frame = 0; frame < 150; frame++) {
+            uint32_t size = 200 - frame;
+            layer = pool.resize(layer, size, size);
+            EXPECT_EQ(size, layer->viewportWidth);
+            EXPECT_TRUE(OffscreenBufferPool::canReuse(layer->texture.width(),
+                    layer->texture.height(), size, size));
+            pool.frameCompleted();
+            misses += pool.getLastFrameStats().misses;
+        }
+        if (cycle > 0) {
+            EXPECT_EQ(0u, misses) << "no allocations expected after first cycle";
+        }
+    }
+    pool.putOrDelete(layer);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <minikin/SparseBitSet.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace minikin;
+
+static std::vector<uint32_t> randomRanges(std::mt19937& random) {
+    std::vector<uint32_t> ranges;
+    uint32_t start = random() % 512;
+    while (start < 0x30000) {
+        const uint32_t end = start + 1 + random() % 512;
+        ranges.push_back(start);
+        ranges.push_back(end);
+        start = end + 1 + random() % 4096;
+    }
+    return ranges;
+}
+
+TEST(SparseBitSet, serialize) {
+    std::mt19937 random(1);
+    std::vector<uint32_t> ranges = randomRanges(random);
+    SparseBitSet set(ranges.data(), ranges.size() / 2);
+    const size_t size = set.serializedSize();
+    ASSERT_EQ(0u, size % 4);
+    std::shared_ptr<uint32_t> buffer(new uint32_t[size / 4], std::default_delete<uint32_t[]>());
+    uint8_t* data = reinterpret_cast<uint8_t*>(buffer.get());
+    set.serialize(data);
+
+    SparseBitSet read;
+    ASSERT_TRUE(read.initFromBuffer(buffer, data, size));
+    EXPECT_EQ(set.length(), read.length());
+    for (uint32_t ch = 0; ch < set.length() + 256; ch++) {
+        ASSERT_EQ(set.get(ch), read.get(ch)) << ch;
+    }
+    for (uint32_t ch = 0; ch < set.length() + 256; ch += 61) {
+        ASSERT_EQ(set.nextSetBit(ch), read.nextSetBit(ch)) << ch;
+    }
+
+    // Damaged data leaves the set empty
+    EXPECT_FALSE(read.initFromBuffer(buffer, data, size - 4));
+    EXPECT_EQ(0u, read.length());
+    EXPECT_FALSE(read.get(ranges[0]));
+    data[0] ^= 1;
+    EXPECT_FALSE(read.initFromBuffer(buffer, data, size));
+}
+
+TEST(SparseBitSet, getCoverageMasks) {
+    std::mt19937 random(2);
+    std::vector<std::unique_ptr<SparseBitSet>> sets;
+    std::vector<const SparseBitSet*> setPointers;
+    for (size_t i = 0; i < SparseBitSet::kMaxMaskSets - 1; i++) {
+        std::vector<uint32_t> ranges = randomRanges(random);
+        sets.emplace_back(new SparseBitSet(ranges.data(), ranges.size() / 2));
+        setPointers.push_back(sets.back().get());
+    }
+    sets.emplace_back(new SparseBitSet());
+    setPointers.push_back(sets.back().get());
+
+    // BMP characters, surrogate pairs and unpaired surrogates
+    std::vector<uint16_t> text;
+    for (int i = 0; i < 4096; i++) {
+        if (i % 8 == 0) {
+            const uint32_t ch = 0x10000 + random() % 0x20000;
+            text.push_back(0xD800 + ((ch - 0x10000) >> 10));
+            text.push_back(0xDC00 + (ch & 0x3FF));
+        } else if (i % 97 == 0) {
+            text.push_back(0xDC00 + random() % 0x400);
+        } else {
+            text.push_back(random() % 0x10000);
+        }
+    }
+    std::vector<uint32_t> masks(text.size());
+    SparseBitSet::getCoverageMasks(setPointers.data(), setPointers.size(), text.data(),
+            text.size(), masks.data());
+
+    for (size_t i = 0; i < text.size(); i++) {
+        uint32_t ch = text[i];
+        const bool isPair = (ch & 0xFC00) == 0xD800 && i + 1 < text.size()
+                && (text[i + 1] & 0xFC00) == 0xDC00;
+        if (isPair) {
+            ch = 0x10000 + ((ch - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+        }
+        uint32_t expected = 0;
+        for (size_t j = 0; j < setPointers.size(); j++) {
+            expected |= setPointers[j]->get(ch) ? 1u << j : 0;
+        }
+        ASSERT_EQ(expected, masks[i]) << i;
+        if (isPair) {
+            ASSERT_EQ(0u, masks[++i]);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "renderthread/RenderThread.h"
+
+#include <thread>
+#include <vector>
+
+using namespace android;
+using namespace android::uirenderer::renderthread;
+
+class TestTask : public RenderTask {
+public:
+    TestTask(int producer = 0, int sequence = 0, nsecs_t runAt = 0)
+            : producer(producer)
+            , sequence(sequence) {
+        mRunAt = runAt;
+    }
+    void run() override {}
+
+    int producer;
+    int sequence;
+};
+
+static std::vector<int> drainSequences(TaskQueue& queue) {
+    std::vector<int> sequences;
+    while (RenderTask* task = queue.next()) {
+        sequences.push_back(static_cast<TestTask*>(task)->sequence);
+    }
+    return sequences;
+}
+
+TEST(TaskQueue, order) {
+    TaskQueue queue;
+    TestTask tasks[] = { {0, 0, 10}, {0, 1, 5}, {0, 2, 10}, {0, 3, 0}, {0, 4, 7} };
+    for (TestTask& task : tasks) {
+        queue.queue(&task);
+    }
+    EXPECT_EQ(std::vector<int>({3, 1, 4, 0, 2}), drainSequences(queue));
+    EXPECT_EQ(nullptr, queue.peek());
+}
+
+TEST(TaskQueue, queueAtFront) {
+    TaskQueue queue;
+    TestTask tasks[] = { {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4} };
+    queue.queue(&tasks[0]);
+    queue.queueAtFront(&tasks[1]);
+    EXPECT_EQ(&tasks[1], queue.peek());
+
+    // queued at the front after the queue was last looked at, but still ahead of everything
+    queue.queue(&tasks[2]);
+    queue.queueAtFront(&tasks[3]);
+    queue.queueAtFront(&tasks[4]);
+    EXPECT_EQ(std::vector<int>({4, 3, 1, 0, 2}), drainSequences(queue));
+}
+
+TEST(TaskQueue, remove) {
+    TaskQueue queue;
+    TestTask tasks[] = { {0, 0}, {0, 1}, {0, 2} };
+    for (TestTask& task : tasks) {
+        queue.queue(&task);
+    }
+    queue.remove(&tasks[2]);
+    queue.remove(&tasks[0]);
+    EXPECT_EQ(std::vector<int>({1}), drainSequences(queue));
+
+    // removed tasks can be queued again
+    queue.queue(&tasks[2]);
+    EXPECT_EQ(std::vector<int>({2}), drainSequences(queue));
+}
+
+TEST(TaskQueue, multipleProducers) {
+    const int kProducerCount = 4;
+    const int kTaskCount = 20000;
+    TaskQueue queue;
+    std::vector<std::vector<TestTask>> tasks(kProducerCount);
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducerCount; producer++) {
+        tasks[producer].reserve(kTaskCount);
+        for (int i = 0; i < kTaskCount; i++) {
+            tasks[producer].emplace_back(producer, i);
+        }
+        producers.emplace_back([&queue, &tasks, producer]() {
+            for (TestTask& task : tasks[producer]) {
+                queue.queue(&task);
+            }
+        });
+    }
+
+    // each producer's tasks come out in the order it queued them
+    std::vector<int> nextSequence(kProducerCount, 0);
+    int received = 0;
+    while (received < kProducerCount * kTaskCount) {
+        if (RenderTask* task = queue.next()) {
+            TestTask* testTask = static_cast<TestTask*>(task);
+            int expected = nextSequence[testTask->producer]++;
+            // not ASSERT_EQ, which would return before the producers are joined
+            EXPECT_EQ(expected, testTask->sequence);
+            if (testTask->sequence != expected) break;
+            received++;
+        }
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(nullptr, queue.next());
+}
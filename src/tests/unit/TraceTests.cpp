@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/Trace.h>
+
+#include <stdio.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace android;
+
+// Defined in GraphicsStatsServiceTests.cpp
+std::string findRootPath();
+
+static std::string dumpTrace() {
+    std::string path = findRootPath() + "/test_trace.json";
+    EXPECT_TRUE(trace::dump(path.c_str()));
+
+    std::string contents;
+    FILE* file = fopen(path.c_str(), "r");
+    if (file) {
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+    }
+    unlink(path.c_str());
+    return contents;
+}
+
+static int countEvents(const std::string& trace, char phase, int tid) {
+    std::string event = std::string("{\"ph\":\"") + phase + "\",\"pid\":"
+            + std::to_string(getpid()) + ",\"tid\":" + std::to_string(tid) + ",";
+    int count = 0;
+    for (size_t pos = trace.find(event); pos != std::string::npos;
+            pos = trace.find(event, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST(Trace, disabled) {
+    trace::setEnabled(false);
+    int tid = 0;
+    std::thread thread([&tid]() {
+        tid = syscall(SYS_gettid);
+        ATRACE_NAME("untraced");
+    });
+    thread.join();
+
+    std::string trace = dumpTrace();
+    EXPECT_EQ(std::string::npos, trace.find("untraced"));
+    EXPECT_EQ(0, countEvents(trace, 'B', tid));
+}
+
+TEST(Trace, threads) {
+    trace::setEnabled(true);
+    int tid = 0;
+    std::thread thread([&tid]() {
+        tid = syscall(SYS_gettid);
+        trace::setThreadName("traceTestThread");
+        ATRACE_NAME("outer \"section\"");
+        {
+            ATRACE_CALL();
+        }
+    });
+    thread.join();
+    trace::setEnabled(false);
+
+    std::string trace = dumpTrace();
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"traceTestThread\"}"));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"outer \\\"section\\\"\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"operator()\""));
+    EXPECT_EQ(2, countEvents(trace, 'B', tid));
+    EXPECT_EQ(2, countEvents(trace, 'E', tid));
+}
+
+TEST(Trace, overwrittenSections) {
+    trace::setEnabled(true);
+    int tid = 0;
+    std::thread thread([&tid]() {
+        tid = syscall(SYS_gettid);
+        ATRACE_NAME("overwritten");
+        // More than fit in the buffer, pushing out the begin of the outer section
+        for (int i = 0; i < 10000; i++) {
+            ATRACE_NAME("inner");
+        }
+    });
+    thread.join();
+    trace::setEnabled(false);
+
+    // The end of the overwritten section is left out, so that every end has its begin
+    std::string trace = dumpTrace();
+    EXPECT_EQ(std::string::npos, trace.find("overwritten"));
+    int begins = countEvents(trace, 'B', tid);
+    EXPECT_GT(begins, 1000);
+    EXPECT_EQ(begins, countEvents(trace, 'E', tid));
+}
@@ -17,32 +17,64 @@
 #include "TaskManager.h"
 #include "Task.h"
 #include "TaskProcessor.h"
+#include "Properties.h"
 #include "utils/MathUtils.h"
 
+#include <algorithm>
+#include <log/log.h>
+#include <utils/Trace.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace android {
 namespace uirenderer {
 
+// Upper bound on the number of worker threads picked automatically
+static const int kMaxDefaultWorkerCount = 8;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Manager
 ///////////////////////////////////////////////////////////////////////////////
 
-TaskManager::TaskManager() {
-    // Get the number of available CPUs. This value does not change over time.
-    int cpuCount = sysconf(_SC_NPROCESSORS_CONF);
-
-    // Really no point in making more than 2 of these worker threads, but
-    // we do want to limit ourselves to 1 worker thread on dual-core devices.
-    int workerCount = cpuCount > 2 ? 2 : 1;
-    for (int i = 0; i < workerCount; i++) {
-        String8 name;
-        name.appendFormat("hwuiTask%d", i + 1);
-        mThreads.push_back(new WorkerThread(name));
+TaskManager::TaskManager()
+        : mQueuedTaskCount(0)
+        , mNextThread(0) {
+    int workerCount = Properties::taskWorkerCount;
+    if (workerCount < 0) {
+        // Get the number of available CPUs. This value does not change over time.
+        int cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+
+        // Leave a core each for the UI thread and the render thread, but always
+        // keep at least one worker so that work can be moved off the render thread.
+        workerCount = std::max(1, std::min(cpuCount - 2, kMaxDefaultWorkerCount));
     }
+    createThreads(workerCount, Properties::taskWorkerAffinity);
+}
+
+TaskManager::TaskManager(int workerCount, uint64_t affinityMask)
+        : mQueuedTaskCount(0)
+        , mNextThread(0) {
+    createThreads(workerCount, affinityMask);
 }
 
 TaskManager::~TaskManager() {
-    for (size_t i = 0; i < mThreads.size(); i++) {
-        mThreads[i]->exit();
+    stop();
+}
+
+void TaskManager::createThreads(int workerCount, uint64_t affinityMask) {
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < 64; cpu++) {
+        if (affinityMask & (1ULL << cpu)) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    for (int i = 0; i < workerCount; i++) {
+        String8 name;
+        name.appendFormat("hwuiTask%d", i + 1);
+        int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        mThreads.push_back(new WorkerThread(*this, i, name, cpu));
     }
 }
 
@@ -54,23 +86,18 @@ void TaskManager::stop() {
     for (size_t i = 0; i < mThreads.size(); i++) {
         mThreads[i]->exit();
     }
+    for (size_t i = 0; i < mThreads.size(); i++) {
+        mThreads[i]->join();
+    }
 }
 
 bool TaskManager::addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBase>& processor) {
     if (mThreads.size() > 0) {
         TaskWrapper wrapper(task, processor);
 
-        size_t minQueueSize = INT_MAX;
-        sp<WorkerThread> thread;
-
-        for (size_t i = 0; i < mThreads.size(); i++) {
-            if (mThreads[i]->getTaskCount() < minQueueSize) {
-                thread = mThreads[i];
-                minQueueSize = mThreads[i]->getTaskCount();
-            }
-        }
-
-        return thread->addTask(wrapper);
+        // Distribute tasks round-robin, idle workers will rebalance by stealing
+        size_t index = mNextThread.fetch_add(1, std::memory_order_relaxed) % mThreads.size();
+        return mThreads[index]->addTask(wrapper);
     }
     return false;
 }
@@ -81,22 +108,64 @@ bool TaskManager::addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBa
 
 status_t TaskManager::WorkerThread::readyToRun() {
     setpriority(PRIO_PROCESS, 0, PRIORITY_FOREGROUND);
+#if defined(__linux__)
+    if (mCpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(mCpu, &cpuSet);
+        if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet)) {
+            ALOGW("Failed to pin %s to cpu %d", mName.string(), mCpu);
+        }
+    }
+#endif
     return NO_ERROR;
 }
 
-bool TaskManager::WorkerThread::threadLoop() {
-    mSignal.wait();
-    std::vector<TaskWrapper> tasks;
-    {
-        Mutex::Autolock l(mLock);
-        tasks.swap(mTasks);
+bool TaskManager::WorkerThread::popTask(TaskWrapper* outTask) {
+    Mutex::Autolock l(mLock);
+    if (mTasks.empty()) return false;
+    *outTask = mTasks.front();
+    mTasks.pop_front();
+    return true;
+}
+
+bool TaskManager::WorkerThread::stealTask(TaskWrapper* outTask) {
+    Mutex::Autolock l(mLock);
+    if (mTasks.empty()) return false;
+    // Take from the opposite end of the owner so the two rarely compete for
+    // the same task, and the owner keeps running its tasks in queue order
+    *outTask = mTasks.back();
+    mTasks.pop_back();
+    return true;
+}
+
+bool TaskManager::WorkerThread::findTask(TaskWrapper* outTask) {
+    if (!popTask(outTask)) {
+        const std::vector<sp<WorkerThread> >& threads = mManager.mThreads;
+        bool found = false;
+        for (size_t i = 1; i < threads.size() && !found; i++) {
+            found = threads[(mIndex + i) % threads.size()]->stealTask(outTask);
+        }
+        if (!found) return false;
     }
+    mManager.mQueuedTaskCount--;
+    return true;
+}
 
-    for (size_t i = 0; i < tasks.size(); i++) {
-        const TaskWrapper& task = tasks[i];
+bool TaskManager::WorkerThread::threadLoop() {
+    // Drain everything reachable before sleeping, which also guarantees that
+    // tasks queued before exit() are run before the thread goes away
+    TaskWrapper task;
+    while (findTask(&task)) {
+        ATRACE_NAME("Run task");
         task.mProcessor->process(task.mTask);
+        task = TaskWrapper();
     }
 
+    Mutex::Autolock l(mManager.mIdleLock);
+    while (mManager.mQueuedTaskCount <= 0 && !exitPending()) {
+        mManager.mIdleCondition.wait(mManager.mIdleLock);
+    }
     return true;
 }
 
@@ -107,23 +176,25 @@ bool TaskManager::WorkerThread::addTask(const TaskWrapper& task) {
         return false;
     }
 
+    // Counted before it's published, so that a worker taking it right away never brings the
+    // count below zero
+    {
+        Mutex::Autolock l(mManager.mIdleLock);
+        mManager.mQueuedTaskCount++;
+    }
     {
         Mutex::Autolock l(mLock);
         mTasks.push_back(task);
     }
-    mSignal.signal();
+    mManager.mIdleCondition.signal();
 
     return true;
 }
 
-size_t TaskManager::WorkerThread::getTaskCount() const {
-    Mutex::Autolock l(mLock);
-    return mTasks.size();
-}
-
 void TaskManager::WorkerThread::exit() {
     requestExit();
-    mSignal.signal();
+    Mutex::Autolock l(mManager.mIdleLock);
+    mManager.mIdleCondition.broadcast();
 }
 
 }; // namespace uirenderer
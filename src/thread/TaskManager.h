@@ -17,12 +17,13 @@
 #ifndef ANDROID_HWUI_TASK_MANAGER_H
 #define ANDROID_HWUI_TASK_MANAGER_H
 
+#include <utils/Condition.h>
 #include <utils/Mutex.h>
 #include <utils/String8.h>
 #include <utils/Thread.h>
 
-#include "Signal.h"
-
+#include <atomic>
+#include <deque>
 #include <vector>
 
 namespace android {
@@ -36,9 +37,32 @@ template <typename T>
 class TaskProcessor;
 class TaskProcessorBase;
 
+/**
+ * Pool of worker threads used to run Tasks off the render thread.
+ *
+ * Every worker owns a deque of pending tasks. New tasks are distributed
+ * round-robin across the deques; a worker runs the tasks queued on its own
+ * deque in FIFO order and, once that deque is empty, steals the most recently
+ * queued task from another worker before going to sleep. This keeps all the
+ * workers busy when a single producer queues a burst of tasks (path, shadow
+ * or tessellation precaching) without having to inspect every queue on the
+ * producer side.
+ */
 class TaskManager {
 public:
+    /**
+     * Creates a task manager sized from Properties::taskWorkerCount and
+     * Properties::taskWorkerAffinity, falling back to a worker count derived
+     * from the number of available CPUs.
+     */
     TaskManager();
+
+    /**
+     * Creates a task manager with exactly workerCount worker threads. If
+     * affinityMask is non-zero, worker i is pinned to the i-th CPU set in
+     * the mask (wrapping around when there are more workers than CPUs).
+     */
+    explicit TaskManager(int workerCount, uint64_t affinityMask = 0);
     ~TaskManager();
 
     /**
@@ -49,8 +73,14 @@ public:
     bool canRunTasks() const;
 
     /**
-     * Stops all allocated threads. Adding tasks will start
-     * the threads again as necessary.
+     * Returns the number of worker threads owned by this task manager.
+     */
+    size_t getWorkerCount() const { return mThreads.size(); }
+
+    /**
+     * Stops all allocated threads and waits for them to exit. Tasks that
+     * were already queued are run before the threads exit. Adding tasks
+     * will start the threads again as necessary.
      */
     void stop();
 
@@ -65,6 +95,8 @@ private:
 
     bool addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBase>& processor);
 
+    void createThreads(int workerCount, uint64_t affinityMask);
+
     struct TaskWrapper {
         TaskWrapper(): mTask(), mProcessor() { }
 
@@ -78,27 +110,42 @@ private:
 
     class WorkerThread: public Thread {
     public:
-        explicit WorkerThread(const String8& name): mSignal(Condition::WAKE_UP_ONE), mName(name) { }
+        WorkerThread(TaskManager& manager, size_t index, const String8& name, int cpu)
+                : mManager(manager), mIndex(index), mName(name), mCpu(cpu) { }
 
         bool addTask(const TaskWrapper& task);
-        size_t getTaskCount() const;
         void exit();
 
+        // Removes the oldest task queued on this worker, used by the owner
+        bool popTask(TaskWrapper* outTask);
+        // Removes the newest task queued on this worker, used by thieves
+        bool stealTask(TaskWrapper* outTask);
+
     private:
         virtual status_t readyToRun() override;
         virtual bool threadLoop() override;
 
-        // Lock for the list of tasks
-        mutable Mutex mLock;
-        std::vector<TaskWrapper> mTasks;
+        bool findTask(TaskWrapper* outTask);
+
+        TaskManager& mManager;
+        const size_t mIndex;
 
-        // Signal used to wake up the thread when a new
-        // task is available in the list
-        mutable Signal mSignal;
+        // Lock for the deque of tasks
+        Mutex mLock;
+        std::deque<TaskWrapper> mTasks;
 
         const String8 mName;
+        // CPU this thread is pinned to, or -1 if it may run anywhere
+        const int mCpu;
     };
 
+    // Number of tasks queued but not yet picked up by any worker. Idle
+    // workers sleep on mIdleCondition until this becomes non-zero.
+    std::atomic<int> mQueuedTaskCount;
+    std::atomic<uint32_t> mNextThread;
+    Mutex mIdleLock;
+    Condition mIdleCondition;
+
     std::vector<sp<WorkerThread> > mThreads;
 };
 
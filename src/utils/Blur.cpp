@@ -15,13 +15,93 @@
  */
 
 #include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
 
 #include "Blur.h"
 #include "MathUtils.h"
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BLUR_SIMD 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BLUR_SIMD 1
+#else
+#define BLUR_SIMD 0
+#endif
+
 namespace android {
 namespace uirenderer {
 
+/**
+ * The gaussian passes blur four adjacent pixels at once. Each lane performs the same operations,
+ * in the same order, as the scalar code, so both produce the same pixels.
+ */
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+typedef float32x4_t Float4;
+
+static inline Float4 splatFloat4(float value) {
+    return vdupq_n_f32(value);
+}
+
+static inline Float4 loadFloat4(const float* src) {
+    return vld1q_f32(src);
+}
+
+static inline Float4 loadBytes4(const uint8_t* src) {
+    uint32_t bytes;
+    memcpy(&bytes, src, sizeof(bytes));
+    uint8x8_t bytes8 = vreinterpret_u8_u32(vdup_n_u32(bytes));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(bytes8))));
+}
+
+// Not fused, to round like the scalar code
+static inline Float4 mulAddFloat4(Float4 sum, Float4 a, Float4 b) {
+    return vaddq_f32(sum, vmulq_f32(a, b));
+}
+
+// Truncates, like a cast from float
+static inline void storeBytes4(uint8_t* dst, Float4 value) {
+    uint16x4_t value16 = vmovn_u32(vcvtq_u32_f32(value));
+    uint8x8_t value8 = vqmovn_u16(vcombine_u16(value16, value16));
+    uint32_t bytes = vget_lane_u32(vreinterpret_u32_u8(value8), 0);
+    memcpy(dst, &bytes, sizeof(bytes));
+}
+#elif defined(__SSE2__)
+typedef __m128 Float4;
+
+static inline Float4 splatFloat4(float value) {
+    return _mm_set1_ps(value);
+}
+
+static inline Float4 loadFloat4(const float* src) {
+    return _mm_loadu_ps(src);
+}
+
+static inline Float4 loadBytes4(const uint8_t* src) {
+    int32_t bytes;
+    memcpy(&bytes, src, sizeof(bytes));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i value = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero));
+}
+
+static inline Float4 mulAddFloat4(Float4 sum, Float4 a, Float4 b) {
+    return _mm_add_ps(sum, _mm_mul_ps(a, b));
+}
+
+// Truncates, like a cast from float
+static inline void storeBytes4(uint8_t* dst, Float4 value) {
+    __m128i value32 = _mm_cvttps_epi32(value);
+    __m128i value16 = _mm_packs_epi32(value32, value32);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(value16, value16));
+    memcpy(dst, &bytes, sizeof(bytes));
+}
+#endif
+
 // This constant approximates the scaling done in the software path's
 // "high quality" mode, in SkBlurMask::Blur() (1 / sqrt(3)).
 static const float BLUR_SIGMA_SCALE = 0.57735f;
@@ -93,90 +173,205 @@ void Blur::generateGaussianWeights(float* weights, float radius) {
 
 void Blur::horizontal(float* weights, int32_t radius,
         const uint8_t* source, uint8_t* dest, int32_t width, int32_t height) {
-    float blurredPixel = 0.0f;
-    float currentPixel = 0.0f;
+    const int32_t kernelSize = 2 * radius + 1;
 
-    for (int32_t y = 0; y < height; y ++) {
+    // Each row is widened to floats and padded with copies of its edge pixels, so that the
+    // kernel never needs to be clamped
+    const int32_t paddedWidth = width + 2 * radius;
+    std::unique_ptr<float[]> row(new float[paddedWidth]);
 
+    for (int32_t y = 0; y < height; y++) {
         const uint8_t* input = source + y * width;
         uint8_t* output = dest + y * width;
 
-        for (int32_t x = 0; x < width; x ++) {
-            blurredPixel = 0.0f;
-            const float* gPtr = weights;
-            // Optimization for non-border pixels
-            if (x > radius && x < (width - radius)) {
-                const uint8_t *i = input + (x - radius);
-                for (int r = -radius; r <= radius; r ++) {
-                    currentPixel = (float) (*i);
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                    i++;
-                }
-            } else {
-                for (int32_t r = -radius; r <= radius; r ++) {
-                    // Stepping left and right away from the pixel
-                    int validW = x + r;
-                    if (validW < 0) {
-                        validW = 0;
-                    }
-                    if (validW > width - 1) {
-                        validW = width - 1;
-                    }
-
-                    currentPixel = (float) input[validW];
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                }
+        for (int32_t x = 0; x < paddedWidth; x++) {
+            row[x] = input[MathUtils::clamp(x - radius, 0, width - 1)];
+        }
+
+        int32_t x = 0;
+#if BLUR_SIMD
+        for (; x + 4 <= width; x += 4) {
+            Float4 blurredPixels = splatFloat4(0.0f);
+            const float* i = &row[x];
+            for (int32_t k = 0; k < kernelSize; k++) {
+                blurredPixels = mulAddFloat4(blurredPixels, loadFloat4(i + k),
+                        splatFloat4(weights[k]));
             }
-            *output = (uint8_t)blurredPixel;
-            output ++;
+            storeBytes4(output + x, blurredPixels);
+        }
+#endif
+        for (; x < width; x++) {
+            float blurredPixel = 0.0f;
+            const float* i = &row[x];
+            for (int32_t k = 0; k < kernelSize; k++) {
+                blurredPixel += i[k] * weights[k];
+            }
+            output[x] = (uint8_t) blurredPixel;
         }
     }
 }
 
 void Blur::vertical(float* weights, int32_t radius,
         const uint8_t* source, uint8_t* dest, int32_t width, int32_t height) {
-    float blurredPixel = 0.0f;
-    float currentPixel = 0.0f;
+    const int32_t kernelSize = 2 * radius + 1;
+
+    // Rows under the kernel, with rows past the top and bottom edges clamped to the edge rows
+    std::unique_ptr<const uint8_t*[]> rows(new const uint8_t*[kernelSize]);
 
-    for (int32_t y = 0; y < height; y ++) {
+    for (int32_t y = 0; y < height; y++) {
         uint8_t* output = dest + y * width;
 
-        for (int32_t x = 0; x < width; x ++) {
-            blurredPixel = 0.0f;
-            const float* gPtr = weights;
-            const uint8_t* input = source + x;
-            // Optimization for non-border pixels
-            if (y > radius && y < (height - radius)) {
-                const uint8_t *i = input + ((y - radius) * width);
-                for (int32_t r = -radius; r <= radius; r ++) {
-                    currentPixel = (float) (*i);
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                    i += width;
-                }
-            } else {
-                for (int32_t r = -radius; r <= radius; r ++) {
-                    int validH = y + r;
-                    // Clamp to zero and width
-                    if (validH < 0) {
-                        validH = 0;
-                    }
-                    if (validH > height - 1) {
-                        validH = height - 1;
-                    }
-
-                    const uint8_t *i = input + validH * width;
-                    currentPixel = (float) (*i);
-                    blurredPixel += currentPixel * gPtr[0];
-                    gPtr++;
-                }
+        for (int32_t k = 0; k < kernelSize; k++) {
+            rows[k] = source + MathUtils::clamp(y + k - radius, 0, height - 1) * width;
+        }
+
+        int32_t x = 0;
+#if BLUR_SIMD
+        for (; x + 4 <= width; x += 4) {
+            Float4 blurredPixels = splatFloat4(0.0f);
+            for (int32_t k = 0; k < kernelSize; k++) {
+                blurredPixels = mulAddFloat4(blurredPixels, loadBytes4(rows[k] + x),
+                        splatFloat4(weights[k]));
             }
-            *output = (uint8_t) blurredPixel;
-            output++;
+            storeBytes4(output + x, blurredPixels);
         }
+#endif
+        for (; x < width; x++) {
+            float blurredPixel = 0.0f;
+            for (int32_t k = 0; k < kernelSize; k++) {
+                blurredPixel += (float) rows[k][x] * weights[k];
+            }
+            output[x] = (uint8_t) blurredPixel;
+        }
+    }
+}
+
+/**
+ * Computes the radii of three box blurs which, applied in succession, approximate a gaussian
+ * blur of the given sigma. Boxes of two sizes are used, to match the gaussian's variance
+ * closely (see "Fast Almost-Gaussian Filtering", Kovesi).
+ */
+static void generateBoxRadii(float sigma, int32_t* boxRadii) {
+    const int32_t boxCount = 3;
+    const float variance12 = 12.0f * sigma * sigma;
+    int32_t lowerSize = floorf(sqrtf(variance12 / boxCount + 1.0f));
+    if (lowerSize % 2 == 0) {
+        lowerSize--;
+    }
+    const int32_t upperSize = lowerSize + 2;
+    const int32_t lowerCount = roundf(
+            (variance12 - boxCount * lowerSize * lowerSize - 4 * boxCount * lowerSize
+                    - 3 * boxCount) / (-4.0f * lowerSize - 4.0f));
+    for (int32_t i = 0; i < boxCount; i++) {
+        boxRadii[i] = ((i < lowerCount ? lowerSize : upperSize) - 1) / 2;
+    }
+}
+
+// Fixed point reciprocal of a box's size, so averaging a box is a multiply and a shift
+static uint32_t boxScale(int32_t boxRadius) {
+    return ((1 << 16) + boxRadius) / (2 * boxRadius + 1);
+}
+
+static inline uint8_t boxAverage(uint32_t sum, uint32_t scale) {
+    return (sum * scale + (1 << 15)) >> 16;
+}
+
+/**
+ * Box blurs outCount values of a row, starting at outStart, clamping reads past the row's ends.
+ */
+static void boxRow(int32_t boxRadius, const uint8_t* input, int32_t inCount,
+        uint8_t* output, int32_t outStart, int32_t outCount) {
+    const uint32_t scale = boxScale(boxRadius);
+    uint32_t sum = 0;
+    for (int32_t x = outStart - boxRadius; x <= outStart + boxRadius; x++) {
+        sum += input[MathUtils::clamp(x, 0, inCount - 1)];
+    }
+
+    const int32_t outEnd = outStart + outCount;
+    // within [clampedStart, clampedEnd), the box neither starts before nor ends past the row
+    const int32_t clampedStart = std::min(std::max(outStart, boxRadius), outEnd);
+    const int32_t clampedEnd = std::max(std::min(outEnd, inCount - boxRadius - 1), clampedStart);
+    int32_t x = outStart;
+    for (; x < clampedStart; x++) {
+        *output++ = boxAverage(sum, scale);
+        sum += input[std::min(x + boxRadius + 1, inCount - 1)] - input[std::max(x - boxRadius, 0)];
+    }
+    for (; x < clampedEnd; x++) {
+        *output++ = boxAverage(sum, scale);
+        sum += input[x + boxRadius + 1] - input[x - boxRadius];
+    }
+    for (; x < outEnd; x++) {
+        *output++ = boxAverage(sum, scale);
+        sum += input[std::min(x + boxRadius + 1, inCount - 1)]
+                - input[MathUtils::clamp(x - boxRadius, 0, inCount - 1)];
+    }
+}
+
+/**
+ * Box blurs outRows rows of an image, starting at outStart, clamping reads past the image's top
+ * and bottom. Each column keeps a running sum, updated a whole row at a time so the loops
+ * vectorize.
+ */
+static void boxColumns(int32_t boxRadius, const uint8_t* input, int32_t inRows,
+        uint8_t* output, int32_t outStart, int32_t outRows, int32_t width, uint32_t* sums) {
+    const uint32_t scale = boxScale(boxRadius);
+    memset(sums, 0, width * sizeof(uint32_t));
+    for (int32_t y = outStart - boxRadius; y <= outStart + boxRadius; y++) {
+        const uint8_t* row = input + MathUtils::clamp(y, 0, inRows - 1) * width;
+        for (int32_t x = 0; x < width; x++) {
+            sums[x] += row[x];
+        }
+    }
+    for (int32_t y = outStart; y < outStart + outRows; y++) {
+        for (int32_t x = 0; x < width; x++) {
+            output[x] = boxAverage(sums[x], scale);
+        }
+        output += width;
+
+        const uint8_t* added = input + std::min(y + boxRadius + 1, inRows - 1) * width;
+        const uint8_t* removed = input + MathUtils::clamp(y - boxRadius, 0, inRows - 1) * width;
+        for (int32_t x = 0; x < width; x++) {
+            sums[x] += added[x] - removed[x];
+        }
+    }
+}
+
+void Blur::tripleBox(float radius, uint8_t* image, int32_t width, int32_t height) {
+    int32_t boxRadii[3];
+    generateBoxRadii(legacyConvertRadiusToSigma(radius), boxRadii);
+
+    // Like the gaussian passes, the blur must behave as if the image's edge pixels extended
+    // forever. Clamping in each box pass would instead extend the partially blurred edges, so
+    // the image is first padded by the support of all three boxes.
+    const int32_t padding = boxRadii[0] + boxRadii[1] + boxRadii[2];
+
+    const int32_t paddedWidth = width + 2 * padding;
+    std::unique_ptr<uint8_t[]> rowA(new uint8_t[paddedWidth]);
+    std::unique_ptr<uint8_t[]> rowB(new uint8_t[paddedWidth]);
+    for (int32_t y = 0; y < height; y++) {
+        uint8_t* row = image + y * width;
+        for (int32_t x = 0; x < paddedWidth; x++) {
+            rowA[x] = row[MathUtils::clamp(x - padding, 0, width - 1)];
+        }
+        boxRow(boxRadii[0], rowA.get(), paddedWidth, rowB.get(), 0, paddedWidth);
+        boxRow(boxRadii[1], rowB.get(), paddedWidth, rowA.get(), 0, paddedWidth);
+        boxRow(boxRadii[2], rowA.get(), paddedWidth, row, padding, width);
+    }
+
+    const int32_t paddedHeight = height + 2 * padding;
+    std::unique_ptr<uint8_t[]> imageA(new uint8_t[paddedHeight * width]);
+    std::unique_ptr<uint8_t[]> imageB(new uint8_t[paddedHeight * width]);
+    std::unique_ptr<uint32_t[]> sums(new uint32_t[width]);
+    for (int32_t y = 0; y < paddedHeight; y++) {
+        memcpy(&imageA[y * width], image + MathUtils::clamp(y - padding, 0, height - 1) * width,
+                width);
     }
+    boxColumns(boxRadii[0], imageA.get(), paddedHeight, imageB.get(), 0, paddedHeight,
+            width, sums.get());
+    boxColumns(boxRadii[1], imageB.get(), paddedHeight, imageA.get(), 0, paddedHeight,
+            width, sums.get());
+    boxColumns(boxRadii[2], imageA.get(), paddedHeight, image, padding, height,
+            width, sums.get());
 }
 
 }; // namespace uirenderer
@@ -39,6 +39,14 @@ public:
         uint8_t* dest, int32_t width, int32_t height);
     static void vertical(float* weights, int32_t radius, const uint8_t* source,
         uint8_t* dest, int32_t width, int32_t height);
+
+    // Radius from which tripleBox() is used instead of the gaussian passes, as its cost doesn't
+    // depend on the radius
+    static const uint32_t kMinTripleBoxRadius = 12;
+
+    // Approximates the gaussian blur of the given radius with three successive box blurs in each
+    // direction, blurring the image in place
+    static void tripleBox(float radius, uint8_t* image, int32_t width, int32_t height);
 };
 
 }; // namespace uirenderer
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HWUI_BUDGETED_CACHE_H
+#define ANDROID_HWUI_BUDGETED_CACHE_H
+
+#include <utils/LruCache.h> // OnEntryRemoved
+#include <utils/TypeHelpers.h> // hash_type
+
+#include <stdint.h>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+enum class CachePolicy {
+    // Evicts the least recently used entry.
+    Lru,
+    // 2Q: new entries wait in a probation FIFO, where uses don't reorder them, so a burst of uses
+    // (e.g. a list item drawn for the few frames it's on screen) counts as one. Evicted entries
+    // are remembered for a while, and go to the protected LRU if put back. Entries that aren't
+    // reused, such as the contents of a long list being scrolled through, are therefore evicted
+    // before the working set.
+    TwoQueue,
+};
+
+struct CacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t evictions = 0;
+    // Puts of recently evicted keys, i.e. misses that a larger budget would have turned into hits
+    uint32_t ghostHits = 0;
+};
+
+/**
+ * Cache whose capacity is a budget of weight (typically bytes), rather than a number of entries.
+ *
+ * Entries live in a pool of nodes, indexed by an open addressing hash table, and linked into the
+ * eviction queues by index. This avoids a heap allocation per entry, and the pointer chasing of
+ * bucketed hash sets.
+ *
+ * The OnEntryRemoved listener is called for each entry removed, evicted or cleared, after its
+ * weight has been removed from the cache. The listener must not modify the cache.
+ */
+template <typename TKey, typename TValue>
+class BudgetedCache {
+public:
+    static const uint32_t kUnlimitedWeight = UINT32_MAX;
+
+    typedef CacheStats Stats;
+
+    explicit BudgetedCache(CachePolicy policy, uint32_t maxWeight = kUnlimitedWeight)
+            : mPolicy(policy)
+            , mMaxWeight(maxWeight) {
+        resetSlots(kMinSlotCount);
+    }
+
+    ~BudgetedCache() {
+        clear();
+    }
+
+    void setOnEntryRemovedListener(OnEntryRemoved<TKey, TValue>* listener) {
+        mListener = listener;
+    }
+
+    size_t size() const { return mProbation.count + mProtected.count; }
+    uint32_t getWeight() const { return mWeight; }
+    uint32_t getMaxWeight() const { return mMaxWeight; }
+    const Stats& getStats() const { return mStats; }
+
+    /**
+     * Changes the budget used by put(). Doesn't evict anything, so callers should trim the cache
+     * afterwards if needed.
+     */
+    void setMaxWeight(uint32_t maxWeight) { mMaxWeight = maxWeight; }
+
+    /**
+     * Returns the value for the key, or a null value if it isn't in the cache. Counts as a use of
+     * the entry for eviction.
+     */
+    const TValue& get(const TKey& key) {
+        uint32_t index = find(key, hashKey(key));
+        if (index == kNone || mNodes[index].queue == Queue::Ghost) {
+            mStats.misses++;
+            return mNullValue;
+        }
+
+        mStats.hits++;
+        if (mNodes[index].queue == Queue::Protected) {
+            unlink(Queue::Protected, index);
+            link(Queue::Protected, index);
+        }
+        return mNodes[index].value;
+    }
+
+    /**
+     * Adds an entry, first evicting entries until its weight fits in the budget. Entries heavier
+     * than the whole budget are added without evicting anything, so callers may decide whether to
+     * cache them temporarily. Returns false, and doesn't add anything, if the key is present.
+     */
+    bool put(const TKey& key, const TValue& value, uint32_t weight = 0) {
+        const hash_t hash = hashKey(key);
+        uint32_t index = find(key, hash);
+        bool wasGhost = false;
+        if (index != kNone) {
+            if (mNodes[index].queue != Queue::Ghost) return false;
+
+            // Recently evicted, so skip probation this time
+            wasGhost = true;
+            mStats.ghostHits++;
+            unlink(Queue::Ghost, index);
+            eraseSlot(index);
+            freeNode(index);
+        }
+
+        if (weight <= mMaxWeight) {
+            while (mMaxWeight - weight < mWeight && evictNext()) {}
+        }
+
+        index = allocNode(key, value, weight, hash);
+        insertSlot(index);
+        link(mPolicy == CachePolicy::Lru || wasGhost ? Queue::Protected : Queue::Probation, index);
+        return true;
+    }
+
+    /**
+     * Updates the weight of an entry, e.g. once its content has been generated. Doesn't evict
+     * anything, so callers should trim the cache afterwards if needed.
+     */
+    bool setWeight(const TKey& key, uint32_t weight) {
+        uint32_t index = find(key, hashKey(key));
+        if (index == kNone || mNodes[index].queue == Queue::Ghost) return false;
+
+        Node& node = mNodes[index];
+        List& list = getList(node.queue);
+        list.weight = list.weight - node.weight + weight;
+        mWeight = mWeight - node.weight + weight;
+        node.weight = weight;
+        return true;
+    }
+
+    bool remove(const TKey& key) {
+        uint32_t index = find(key, hashKey(key));
+        if (index == kNone) return false;
+
+        if (mNodes[index].queue == Queue::Ghost) {
+            unlink(Queue::Ghost, index);
+            eraseSlot(index);
+            freeNode(index);
+            return false;
+        }
+        removeNode(index);
+        return true;
+    }
+
+    /**
+     * Returns the value of the entry evictNext() would evict, or a null value if the cache is
+     * empty.
+     */
+    const TValue& peekNextEvicted() const {
+        uint32_t index = findVictim();
+        return index == kNone ? mNullValue : mNodes[index].value;
+    }
+
+    /**
+     * Evicts one entry, chosen by the cache's policy. Returns false if the cache is empty.
+     */
+    bool evictNext() {
+        uint32_t index = findVictim();
+        if (index == kNone) return false;
+
+        // Remember the key for a while, so that it's promoted if put back soon
+        mStats.evictions++;
+        Node& node = mNodes[index];
+        unlink(node.queue, index);
+        if (mListener) {
+            (*mListener)(node.key, node.value);
+        }
+        node.value = mNullValue;
+        node.weight = 0;
+        link(Queue::Ghost, index);
+
+        const size_t maxGhostCount = size() > kMinGhostCount ? size() : kMinGhostCount;
+        while (mGhosts.count > maxGhostCount) {
+            uint32_t oldest = mGhosts.oldest;
+            unlink(Queue::Ghost, oldest);
+            eraseSlot(oldest);
+            freeNode(oldest);
+        }
+        return true;
+    }
+
+    /**
+     * Evicts entries until the weight of the cache is at most the given weight.
+     */
+    void trimToWeight(uint32_t weight) {
+        while (mWeight > weight && evictNext()) {}
+    }
+
+    void clear() {
+        if (mListener) {
+            for (uint32_t index = mProbation.oldest; index != kNone; index = mNodes[index].next) {
+                (*mListener)(mNodes[index].key, mNodes[index].value);
+            }
+            for (uint32_t index = mProtected.oldest; index != kNone; index = mNodes[index].next) {
+                (*mListener)(mNodes[index].key, mNodes[index].value);
+            }
+        }
+        mNodes.clear();
+        mFreeNode = kNone;
+        mProbation = List();
+        mProtected = List();
+        mGhosts = List();
+        mWeight = 0;
+        resetSlots(kMinSlotCount);
+    }
+
+    // To be used like:
+    // while (it.next()) {
+    //   it.value(); it.key();
+    // }
+    class Iterator {
+    public:
+        explicit Iterator(const BudgetedCache<TKey, TValue>& cache)
+                : mCache(cache) {
+        }
+
+        bool next() {
+            do {
+                mIndex++;
+            } while (mIndex < mCache.mNodes.size() && !mCache.isResident(mIndex));
+            return mIndex < mCache.mNodes.size();
+        }
+
+        const TValue& value() const { return mCache.mNodes[mIndex].value; }
+        const TKey& key() const { return mCache.mNodes[mIndex].key; }
+
+    private:
+        const BudgetedCache<TKey, TValue>& mCache;
+        size_t mIndex = SIZE_MAX;
+    };
+
+private:
+    static const uint32_t kNone = UINT32_MAX;
+    static const uint32_t kDeletedSlot = UINT32_MAX - 1;
+    static const uint32_t kMinSlotCount = 16;
+    static const uint32_t kMinGhostCount = 16;
+
+    enum class Queue : uint8_t {
+        Free,
+        Probation,
+        Protected,
+        Ghost,
+    };
+
+    struct Node {
+        Node(const TKey& key, const TValue& value, uint32_t weight, hash_t hash)
+                : key(key)
+                , value(value)
+                , weight(weight)
+                , hash(hash) {
+        }
+
+        TKey key;
+        TValue value;
+        uint32_t weight;
+        hash_t hash;
+        uint32_t prev = kNone;
+        uint32_t next = kNone; // also links the free list
+        Queue queue = Queue::Free;
+    };
+
+    struct List {
+        uint32_t oldest = kNone;
+        uint32_t youngest = kNone;
+        uint32_t count = 0;
+        uint32_t weight = 0;
+    };
+
+    static hash_t hashKey(const TKey& key) {
+        // Finds both android::hash_type() for basic types, and hash_type() overloads declared
+        // alongside key types
+        using android::hash_type;
+        return hash_type(key);
+    }
+
+    bool isResident(size_t index) const {
+        return mNodes[index].queue == Queue::Probation || mNodes[index].queue == Queue::Protected;
+    }
+
+    List& getList(Queue queue) {
+        switch (queue) {
+        case Queue::Probation: return mProbation;
+        case Queue::Protected: return mProtected;
+        default: return mGhosts;
+        }
+    }
+
+    void link(Queue queue, uint32_t index) {
+        List& list = getList(queue);
+        Node& node = mNodes[index];
+        node.queue = queue;
+        node.prev = list.youngest;
+        node.next = kNone;
+        if (list.youngest != kNone) {
+            mNodes[list.youngest].next = index;
+        } else {
+            list.oldest = index;
+        }
+        list.youngest = index;
+        list.count++;
+        list.weight += node.weight;
+        if (queue != Queue::Ghost) mWeight += node.weight;
+    }
+
+    void unlink(Queue queue, uint32_t index) {
+        List& list = getList(queue);
+        Node& node = mNodes[index];
+        if (node.prev != kNone) {
+            mNodes[node.prev].next = node.next;
+        } else {
+            list.oldest = node.next;
+        }
+        if (node.next != kNone) {
+            mNodes[node.next].prev = node.prev;
+        } else {
+            list.youngest = node.prev;
+        }
+        list.count--;
+        list.weight -= node.weight;
+        if (queue != Queue::Ghost) mWeight -= node.weight;
+        node.prev = node.next = kNone;
+        node.queue = Queue::Free;
+    }
+
+    uint32_t findVictim() const {
+        if (mPolicy == CachePolicy::TwoQueue && mProbation.count) {
+            // Probation may use a quarter of the budget before protected entries are evicted
+            const uint32_t budget = mMaxWeight == kUnlimitedWeight ? mWeight : mMaxWeight;
+            if (mProtected.count == 0 || mProbation.weight > budget / 4) {
+                return mProbation.oldest;
+            }
+        }
+        return mProtected.oldest != kNone ? mProtected.oldest : mProbation.oldest;
+    }
+
+    void removeNode(uint32_t index) {
+        unlink(mNodes[index].queue, index);
+        eraseSlot(index);
+        if (mListener) {
+            (*mListener)(mNodes[index].key, mNodes[index].value);
+        }
+        freeNode(index);
+    }
+
+    uint32_t allocNode(const TKey& key, const TValue& value, uint32_t weight, hash_t hash) {
+        if (mFreeNode == kNone) {
+            mNodes.emplace_back(key, value, weight, hash);
+            return mNodes.size() - 1;
+        }
+        uint32_t index = mFreeNode;
+        Node& node = mNodes[index];
+        mFreeNode = node.next;
+        node.key = key;
+        node.value = value;
+        node.weight = weight;
+        node.hash = hash;
+        node.next = kNone;
+        return index;
+    }
+
+    void freeNode(uint32_t index) {
+        // release anything held by the key and value now, rather than when the node is reused
+        Node& node = mNodes[index];
+        node.key = TKey();
+        node.value = mNullValue;
+        node.queue = Queue::Free;
+        node.next = mFreeNode;
+        mFreeNode = index;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Open addressing, with linear probing. Slots hold node indices.
+    ///////////////////////////////////////////////////////////////////////////////
+
+    uint32_t slotFor(hash_t hash) const {
+        // Fibonacci hashing, so sequential keys (e.g. generation IDs) spread out
+        return (uint32_t(hash) * 2654435769u) >> mSlotShift;
+    }
+
+    uint32_t find(const TKey& key, hash_t hash) const {
+        const uint32_t mask = mSlots.size() - 1;
+        for (uint32_t slot = slotFor(hash); ; slot = (slot + 1) & mask) {
+            uint32_t index = mSlots[slot];
+            if (index == kNone) return kNone;
+            if (index != kDeletedSlot && mNodes[index].hash == hash && mNodes[index].key == key) {
+                return index;
+            }
+        }
+    }
+
+    void insertSlot(uint32_t index) {
+        // keep at most 3/4 of the slots used (including deleted), so probe sequences stay short
+        if ((mUsedSlotCount + 1) * 4 > mSlots.size() * 3) {
+            const uint32_t liveCount = size() + mGhosts.count;
+            resetSlots(liveCount * 2 >= mSlots.size() ? mSlots.size() * 2 : mSlots.size());
+            for (uint32_t i = 0; i < mNodes.size(); i++) {
+                if (i != index && mNodes[i].queue != Queue::Free) placeSlot(i);
+            }
+        }
+        placeSlot(index);
+    }
+
+    void placeSlot(uint32_t index) {
+        const uint32_t mask = mSlots.size() - 1;
+        uint32_t slot = slotFor(mNodes[index].hash);
+        while (mSlots[slot] != kNone && mSlots[slot] != kDeletedSlot) {
+            slot = (slot + 1) & mask;
+        }
+        if (mSlots[slot] == kNone) mUsedSlotCount++;
+        mSlots[slot] = index;
+    }
+
+    void eraseSlot(uint32_t index) {
+        const uint32_t mask = mSlots.size() - 1;
+        uint32_t slot = slotFor(mNodes[index].hash);
+        while (mSlots[slot] != index) {
+            slot = (slot + 1) & mask;
+        }
+        mSlots[slot] = kDeletedSlot;
+    }
+
+    void resetSlots(uint32_t slotCount) {
+        mSlots.assign(slotCount, kNone);
+        mSlotShift = 32 - __builtin_ctz(slotCount);
+        mUsedSlotCount = 0;
+    }
+
+    const CachePolicy mPolicy;
+    uint32_t mMaxWeight;
+    OnEntryRemoved<TKey, TValue>* mListener = nullptr;
+
+    std::vector<Node> mNodes;
+    uint32_t mFreeNode = kNone;
+
+    std::vector<uint32_t> mSlots;
+    uint32_t mSlotShift = 0;
+    uint32_t mUsedSlotCount = 0;
+
+    List mProbation;
+    List mProtected;
+    List mGhosts;
+
+    uint32_t mWeight = 0;
+    Stats mStats;
+    const TValue mNullValue = TValue();
+};
+
+template <typename TKey, typename TValue>
+const uint32_t BudgetedCache<TKey, TValue>::kUnlimitedWeight;
+template <typename TKey, typename TValue>
+const uint32_t BudgetedCache<TKey, TValue>::kNone;
+template <typename TKey, typename TValue>
+const uint32_t BudgetedCache<TKey, TValue>::kDeletedSlot;
+template <typename TKey, typename TValue>
+const uint32_t BudgetedCache<TKey, TValue>::kMinSlotCount;
+template <typename TKey, typename TValue>
+const uint32_t BudgetedCache<TKey, TValue>::kMinGhostCount;
+
+}; // namespace uirenderer
+}; // namespace android
+
+#endif // ANDROID_HWUI_BUDGETED_CACHE_H
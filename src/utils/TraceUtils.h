@@ -19,7 +19,7 @@
 #include <utils/Trace.h>
 
 #define ATRACE_FORMAT(fmt, ...) \
-    TraceUtils::TraceEnder __traceEnder = (TraceUtils::atraceFormatBegin(fmt, ##__VA_ARGS__), TraceUtils::TraceEnder())
+    TraceUtils::TraceEnder __traceEnder(TraceUtils::atraceFormatBegin(fmt, ##__VA_ARGS__))
 
 #define ATRACE_FORMAT_BEGIN(fmt, ...) \
     TraceUtils::atraceFormatBegin(fmt, ##__VA_ARGS__)
@@ -31,10 +31,14 @@ class TraceUtils {
 public:
     class TraceEnder {
     public:
-        ~TraceEnder() {  }
+        explicit TraceEnder(bool began) : mBegan(began) {}
+        ~TraceEnder() { if (mBegan) android::trace::end(); }
+    private:
+        const bool mBegan;
     };
 
-    static void atraceFormatBegin(const char* fmt, ...) {
+    static bool atraceFormatBegin(const char* fmt, ...) {
+        if (!ATRACE_ENABLED()) return false;
 
         const int BUFFER_SIZE = 256;
         va_list ap;
@@ -44,6 +48,8 @@ public:
         vsnprintf(buf, BUFFER_SIZE, fmt, ap);
         va_end(ap);
 
+        android::trace::begin(buf);
+        return true;
     }
 
 }; // class TraceUtils
@@ -15,10 +15,210 @@
  */
 
 #include <utils/Trace.h>
-#include <utils/misc.h>
+#include <utils/Timers.h>
 
-static void traceInit() __attribute__((constructor));
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
 
-static void traceInit() {
-    ::android::add_sysprop_change_callback(atrace_update_tags, 0);
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace android {
+namespace trace {
+
+std::atomic<bool> gEnabled(false);
+
+namespace {
+
+enum EventType : char {
+    kBegin = 'B',
+    kEnd = 'E',
+};
+
+struct Event {
+    nsecs_t time;
+    EventType type;
+    char name[kMaxNameLength + 1];
+};
+
+// 64 bytes per event, so 256KB per thread that ever traced
+static const uint64_t kEventsPerThread = 4096;
+
+/*
+ * Only the owning thread writes to its buffer, like a seqlock: count is both the number of
+ * published events and the slot being written. An event is written after a release fence, so
+ * that a dump seeing any of it also sees the count that marks its slot as in progress, then
+ * published by bumping count; a dump copies the published events and then reads count again,
+ * to drop the ones the owner may have overwritten in the meantime.
+ */
+struct ThreadBuffer {
+    pid_t tid;
+    char threadName[32];  // guarded by gBuffersLock
+    std::atomic<uint64_t> count;
+    Event events[kEventsPerThread];
+};
+
+std::mutex gBuffersLock;
+// Never freed, so that the sections of threads that exited are still dumped
+std::vector<ThreadBuffer*> gBuffers;
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+
+ThreadBuffer* threadBuffer() {
+    if (!tBuffer) {
+        ThreadBuffer* buffer = new ThreadBuffer();
+#ifdef __linux__
+        buffer->tid = syscall(SYS_gettid);
+#else
+        // Only used to tell threads apart in the trace
+        static std::atomic<pid_t> sNextTid(1);
+        buffer->tid = sNextTid.fetch_add(1, std::memory_order_relaxed);
+#endif
+        if (pthread_getname_np(pthread_self(), buffer->threadName,
+                sizeof(buffer->threadName))) {
+            snprintf(buffer->threadName, sizeof(buffer->threadName), "%d", buffer->tid);
+        }
+        buffer->count.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(gBuffersLock);
+        gBuffers.push_back(buffer);
+        tBuffer = buffer;
+    }
+    return tBuffer;
 }
+
+void record(EventType type, const char* name) {
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t index = buffer->count.load(std::memory_order_relaxed);
+    // Orders the count that marks this slot as in progress before the writes that reuse it
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = buffer->events[index % kEventsPerThread];
+    event.time = systemTime(SYSTEM_TIME_MONOTONIC);
+    event.type = type;
+    if (name) {
+        strncpy(event.name, name, kMaxNameLength);
+        event.name[kMaxNameLength] = '\0';
+    } else {
+        event.name[0] = '\0';
+    }
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void writeEscaped(FILE* file, const char* string) {
+    for (const char* c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+}
+
+// Copies out the events of a buffer that weren't overwritten while being copied, oldest first
+void snapshot(ThreadBuffer* buffer, std::vector<Event>& events) {
+    uint64_t end = buffer->count.load(std::memory_order_acquire);
+    uint64_t start = end > kEventsPerThread ? end - kEventsPerThread : 0;
+    events.resize(end - start);
+    for (uint64_t i = start; i < end; i++) {
+        events[i - start] = buffer->events[i % kEventsPerThread];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // The owner may have been writing event count while it was copied, and reused the slots
+    // of the ones before it
+    uint64_t written = buffer->count.load(std::memory_order_relaxed) + 1;
+    if (written > start + kEventsPerThread) {
+        uint64_t lost = std::min(written - kEventsPerThread - start,
+                static_cast<uint64_t>(events.size()));
+        events.erase(events.begin(), events.begin() + lost);
+    }
+}
+
+} // namespace
+
+void setEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void begin(const char* name) {
+    record(kBegin, name);
+}
+
+void end() {
+    record(kEnd, nullptr);
+}
+
+void setThreadName(const char* name) {
+    ThreadBuffer* buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(gBuffersLock);
+    strncpy(buffer->threadName, name, sizeof(buffer->threadName) - 1);
+    buffer->threadName[sizeof(buffer->threadName) - 1] = '\0';
+}
+
+bool dump(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open '%s' for writing\n", path);
+        return false;
+    }
+
+    std::vector<ThreadBuffer*> buffers;
+    std::vector<std::string> threadNames;
+    {
+        std::lock_guard<std::mutex> lock(gBuffersLock);
+        buffers = gBuffers;
+        for (ThreadBuffer* buffer : buffers) {
+            threadNames.push_back(buffer->threadName);
+        }
+    }
+
+    const int pid = getpid();
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    std::vector<Event> events;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        const int tid = buffers[i]->tid;
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"name\":\"", first ? "" : ",", pid, tid);
+        writeEscaped(file, threadNames[i].c_str());
+        fprintf(file, "\"}}");
+        first = false;
+
+        snapshot(buffers[i], events);
+        int depth = 0;
+        for (const Event& event : events) {
+            if (event.type == kEnd) {
+                // Its begin was overwritten
+                if (!depth) continue;
+                depth--;
+            } else {
+                depth++;
+            }
+            // Timestamps are in microseconds, keep the nanoseconds as decimals
+            fprintf(file, ",\n{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%lld.%03lld",
+                    event.type, pid, tid, static_cast<long long>(event.time / 1000),
+                    static_cast<long long>(event.time % 1000));
+            if (event.type == kBegin) {
+                fprintf(file, ",\"name\":\"");
+                writeEscaped(file, event.name);
+                fprintf(file, "\"");
+            }
+            fprintf(file, "}");
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+} // namespace trace
+} // namespace android
@@ -17,22 +17,55 @@
 #ifndef ANDROID_TRACE_H
 #define ANDROID_TRACE_H
 
-#include <stdio.h>
+#include <atomic>
 
 namespace android {
 
+/*
+ * There is no atrace on this port, so trace sections are recorded in process instead: every
+ * thread appends to its own ring buffer, without locks, and the most recent sections of all
+ * threads can be written out in the Chrome trace event format, to be opened in
+ * chrome://tracing or Perfetto.
+ *
+ * Recording is off until enabled, at which point it costs a clock read and a copy of the name
+ * per section boundary.
+ */
+namespace trace {
+
+extern std::atomic<bool> gEnabled;
+
+inline bool isEnabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled);
+
+// Record whether or not tracing is enabled. Names are copied, and truncated to kMaxNameLength
+static const int kMaxNameLength = 47;
+void begin(const char* name);
+void end();
+
+// Names the calling thread in dumps, instead of its kernel name
+void setThreadName(const char* name);
+
+// Writes the recorded sections of every thread to path as Chrome trace JSON
+bool dump(const char* path);
+
+} // namespace trace
+
 class ScopedTrace {
 public:
-    inline ScopedTrace(const char* name) : mName(name) {
-        printf("+++%s \n", mName);
+    inline ScopedTrace(const char* name) : mTracing(trace::isEnabled()) {
+        if (mTracing) trace::begin(name);
     }
 
     inline ~ScopedTrace() {
-        printf("---%s \n", mName);
+        if (mTracing) trace::end();
     }
 
 private:
-    const char* mName;
+    // A section that began must end, even if tracing is turned off in between
+    const bool mTracing;
 };
 };
 
@@ -40,5 +73,8 @@ private:
 #define PASTE(x, y) _PASTE(x,y)
 #define ATRACE_NAME(name) android::ScopedTrace PASTE(___tracer, __LINE__) (name)
 #define ATRACE_CALL() ATRACE_NAME(__FUNCTION__)
+#define ATRACE_BEGIN(name) do { if (ATRACE_ENABLED()) android::trace::begin(name); } while (0)
+#define ATRACE_END() do { if (ATRACE_ENABLED()) android::trace::end(); } while (0)
+#define ATRACE_ENABLED() android::trace::isEnabled()
 
 #endif // ANDROID_TRACE_H